@@ -41,6 +41,9 @@ PHP_ARG_ENABLE(event-debug, whether Event debugging support enabled,
 PHP_ARG_ENABLE(event-sockets, whether to enable sockets support in Event,
 [  --enable-event-sockets Enable sockets support in Event], yes, no)
 
+PHP_ARG_ENABLE(event-stats, whether to enable connection statistics in Event,
+[  --disable-event-stats  Disable I/O statistics of EventBufferEvent], yes, no)
+
 if test "$PHP_EVENT_CORE" != "no"; then
 
   OLD_LDFLAGS=$LDFLAGS
@@ -82,6 +85,12 @@ if test "$PHP_EVENT_CORE" != "no"; then
   fi
   dnl }}}
 
+  dnl {{{ --enable-event-stats
+  if test "$PHP_EVENT_STATS" != "no"; then
+    AC_DEFINE(PHP_EVENT_STATS, 1, [Enable I/O statistics of EventBufferEvent])
+  fi
+  dnl }}}
+
   dnl {{{ Include libevent headers
   AC_MSG_CHECKING([for include/event2/event.h])
   EVENT_DIR=
@@ -142,7 +151,10 @@ if test "$PHP_EVENT_CORE" != "no"; then
     $PHP_EVENT_SUBDIR/classes/event_config.c \
     $PHP_EVENT_SUBDIR/classes/buffer_event.c \
     $PHP_EVENT_SUBDIR/classes/buffer.c \
-    $PHP_EVENT_SUBDIR/classes/event_util.c"
+    $PHP_EVENT_SUBDIR/classes/event_util.c \
+    $PHP_EVENT_SUBDIR/classes/idle_reaper.c \
+    $PHP_EVENT_SUBDIR/classes/shared_payload.c \
+    $PHP_EVENT_SUBDIR/classes/worker_pool.c"
   dnl }}}
 
   dnl {{{ --with-event-pthreads
@@ -234,6 +246,15 @@ if test "$PHP_EVENT_CORE" != "no"; then
     AC_DEFINE(HAVE_SOCKETS, 1, [Whether sockets extension is enabled])
   fi
 
+  dnl {{{ accept4() for batched accept in EventListener
+  AC_CHECK_FUNCS([accept4])
+  dnl }}}
+
+  dnl {{{ EventWorkerPool and SO_REUSEPORT load balancing
+  AC_CHECK_FUNCS([fork sched_setaffinity])
+  AC_CHECK_HEADERS([linux/filter.h])
+  dnl }}}
+
   PHP_ADD_MAKEFILE_FRAGMENT
 fi
 
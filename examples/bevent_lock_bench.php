@@ -0,0 +1,60 @@
+<?php
+/*
+ * Measures the overhead of the bufferevent locks in the callbacks.
+ *
+ * Usage:
+ * $ php bevent_lock_bench.php [round_trips = 200000]
+ *
+ * Bounces a byte between the ends of a buffer event pair, first on a default
+ * event base, then on an event base created with EventBase::NOLOCK. With
+ * --with-event-pthreads the buffer events of the default base are thread-safe,
+ * and every read callback is wrapped in bufferevent_lock() and
+ * bufferevent_unlock(). The buffer events of a NOLOCK base have no lock, and
+ * the callbacks skip the calls. Without pthreads support both runs take the
+ * same path.
+ */
+
+$round_trips = isset($argv[1]) ? max(1, (int) $argv[1]) : 200000;
+
+function bench($base, $round_trips) {
+	$pair = EventBufferEvent::createPair($base);
+	$left = $round_trips;
+
+	$pair[0]->setCallbacks(function ($bev) use ($base, &$left) {
+		$bev->read(1);
+		if (--$left > 0) {
+			$bev->write('x');
+		} else {
+			$base->exit();
+		}
+	}, NULL, NULL);
+	$pair[1]->setCallbacks(function ($bev) {
+		$bev->write($bev->read(1));
+	}, NULL, NULL);
+	$pair[0]->enable(Event::READ | Event::WRITE);
+	$pair[1]->enable(Event::READ | Event::WRITE);
+
+	$start = microtime(true);
+	$pair[0]->write('x');
+	$base->loop();
+	$elapsed = microtime(true) - $start;
+
+	$pair[0]->free();
+	$pair[1]->free();
+
+	return $elapsed;
+}
+
+$cfg = new EventConfig();
+$cfg->setFlags(EventBase::NOLOCK);
+
+$runs = array(
+	'default' => new EventBase(),
+	'NOLOCK'  => new EventBase($cfg),
+);
+
+foreach ($runs as $name => $base) {
+	$elapsed = bench($base, $round_trips);
+	printf("%-8s %d callbacks in %.3f s, %.0f callbacks/s\n",
+		$name, 2 * $round_trips, $elapsed, 2 * $round_trips / $elapsed);
+}
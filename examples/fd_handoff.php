@@ -0,0 +1,82 @@
+<?php
+/*
+ * Hands connections off to another process with EventUtil::sendFds() and
+ * measures the rate.
+ *
+ * Usage:
+ * $ php fd_handoff.php [connections = 10000 [fds_per_message = 64]]
+ *
+ * The parent creates socket pairs and passes one end of every pair to the
+ * child over a Unix domain socket. The child reads the socket with an
+ * EventBufferEvent in the descriptor passing mode, takes over every received
+ * connection with a buffer event of its own, as a worker would, and reports
+ * the number of connections back when all of them arrived.
+ *
+ * Requires the pcntl extension.
+ */
+
+$total = isset($argv[1]) ? (int) $argv[1] : 10000;
+$batch = isset($argv[2]) ? max(1, min((int) $argv[2], 253)) : 64;
+
+list($parent, $child) = stream_socket_pair(STREAM_PF_UNIX, STREAM_SOCK_STREAM, STREAM_IPPROTO_IP);
+
+$pid = pcntl_fork();
+if ($pid == -1) {
+	exit("Failed to fork\n");
+}
+
+if ($pid == 0) {
+	fclose($parent);
+
+	$base     = new EventBase();
+	$received = 0;
+
+	$bev = new EventBufferEvent($base, $child, 0,
+		function ($bev) use ($base, $total, &$received) {
+			$bev->read(4096);
+
+			foreach ($bev->fetchFds() as $fd) {
+				$conn = new EventBufferEvent($base, $fd, EventBufferEvent::OPT_CLOSE_ON_FREE);
+				$conn->free();
+				++$received;
+			}
+
+			if ($received >= $total) {
+				$base->exit();
+			}
+		});
+	$bev->setFdPassing(true);
+	$bev->enable(Event::READ);
+
+	$base->dispatch();
+
+	fwrite($child, "$received\n");
+	exit(0);
+}
+
+fclose($child);
+
+$start = microtime(true);
+
+for ($sent = 0; $sent < $total; $sent += $n) {
+	$n      = min($batch, $total - $sent);
+	$ours   = [];
+	$theirs = [];
+
+	for ($i = 0; $i < $n; ++$i) {
+		list($ours[], $theirs[]) = stream_socket_pair(STREAM_PF_UNIX, STREAM_SOCK_STREAM, STREAM_IPPROTO_IP);
+	}
+
+	if (EventUtil::sendFds($parent, $theirs, "x") === false) {
+		exit("Failed to send descriptors\n");
+	}
+	/* The descriptors are closed here, the child holds its own copies */
+}
+
+$count   = (int) fgets($parent);
+$elapsed = microtime(true) - $start;
+
+printf("%d connections handed off in %.3f s, %.0f per second\n",
+	$count, $elapsed, $count / $elapsed);
+
+pcntl_waitpid($pid, $status);
@@ -19,6 +19,8 @@
 #include "../src/util.h"
 #include "../src/priv.h"
 #include "zend_exceptions.h"
+#include "idle_reaper.h"
+#include "shared_payload.h"
 
 /* {{{ proto EventBase EventBase::__construct([EventConfig cfg = null]); */
 PHP_METHOD(EventBase, __construct)
@@ -39,7 +41,8 @@ PHP_METHOD(EventBase, __construct)
 	} else {
 		PHP_EVENT_FETCH_CONFIG(cfg, zcfg);
 
-		b->base = event_base_new_with_config(cfg->ptr);
+		b->base   = event_base_new_with_config(cfg->ptr);
+		b->nolock = (cfg->flags & EVENT_BASE_FLAG_NOLOCK) ? 1 : 0;
 		if (!b->base) {
 			zend_throw_exception_ex(php_event_get_exception(), 0 TSRMLS_CC,
 					"EventBase cannot be constructed with the provided configuration. "
@@ -415,6 +418,143 @@ PHP_METHOD(EventBase, resume)
 /* }}} */
 #endif
 
+/* {{{ proto EventIdleReaper EventBase::createIdleReaper(double idle, callable on_idle[, mixed arg = NULL]);
+ * Creates an idle reaper. on_idle(EventBufferEvent bev, mixed arg) is invoked
+ * for each added bufferevent having no I/O activity for at least idle seconds.
+ * The bufferevent is removed from the reaper before the callback is invoked. */
+PHP_METHOD(EventBase, createIdleReaper)
+{
+	zval                    *zbase = getThis();
+	php_event_base_t        *b;
+	php_event_idle_reaper_t *r;
+	double                   idle;
+	zend_fcall_info          fci   = empty_fcall_info;
+	zend_fcall_info_cache    fcc   = empty_fcall_info_cache;
+	zval                    *arg   = NULL;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "df|z!",
+				&idle, &fci, &fcc, &arg) == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_BASE(b, zbase);
+	if (!b->base) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "Event base is not initialized");
+		RETURN_FALSE;
+	}
+
+	PHP_EVENT_INIT_CLASS_OBJECT(return_value, php_event_idle_reaper_ce);
+	PHP_EVENT_FETCH_IDLE_REAPER(r, return_value);
+
+	if (php_event_idle_reaper_init(r, zbase, idle, &fci, &fcc, arg TSRMLS_CC) == FAILURE) {
+		zval_dtor(return_value);
+		RETURN_FALSE;
+	}
+}
+/* }}} */
+
+/* {{{ proto int EventBase::broadcast(array bevents, mixed payload[, int max_output = 0[, array &skipped = NULL]]);
+ * Appends payload to the output buffers of the bufferevents. payload is either
+ * a string, or an EventSharedPayload object. The data is stored once, and added
+ * to every buffer by reference.
+ *
+ * If max_output is positive, the bufferevents having at least max_output bytes
+ * pending in the output buffer are skipped. The keys of the skipped
+ * bufferevents are stored in skipped, so slow subscribers may be dropped by the
+ * caller.
+ *
+ * Returns the number of bufferevents the payload is added to. */
+PHP_METHOD(EventBase, broadcast)
+{
+	zval                      *zbase      = getThis();
+	php_event_base_t          *b;
+	zval                      *zbevents;
+	zval                      *zpayload;
+	long                       max_output = 0;
+	zval                      *zskipped   = NULL;
+	zval                     **ppzbev;
+	HashTable                 *ht;
+	HashPosition               pos;
+	char                      *key;
+	uint                       key_len;
+	ulong                      idx;
+	php_event_bevent_t        *bev;
+	php_event_shared_block_t  *blk;
+	struct evbuffer           *output;
+	long                       count      = 0;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "az|lz",
+				&zbevents, &zpayload, &max_output, &zskipped) == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_BASE(b, zbase);
+	if (!b->base) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "Event base is not initialized");
+		RETURN_FALSE;
+	}
+
+	if (Z_TYPE_P(zpayload) == IS_OBJECT
+			&& instanceof_function(Z_OBJCE_P(zpayload), php_event_shared_payload_ce TSRMLS_CC)) {
+		php_event_shared_payload_t *p;
+
+		PHP_EVENT_FETCH_SHARED_PAYLOAD(p, zpayload);
+		if (!p->block) {
+			php_error_docref(NULL TSRMLS_CC, E_WARNING, "Shared payload is not initialized");
+			RETURN_FALSE;
+		}
+		blk = p->block;
+		blk->refcount++;
+	} else if (Z_TYPE_P(zpayload) == IS_STRING) {
+		blk = php_event_shared_block_new(Z_STRVAL_P(zpayload), Z_STRLEN_P(zpayload));
+	} else {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "Expected string or EventSharedPayload payload");
+		RETURN_FALSE;
+	}
+
+	if (zskipped) {
+		zval_dtor(zskipped);
+		array_init(zskipped);
+	}
+
+	ht = Z_ARRVAL_P(zbevents);
+	for (zend_hash_internal_pointer_reset_ex(ht, &pos);
+			zend_hash_get_current_data_ex(ht, (void **) &ppzbev, &pos) == SUCCESS;
+			zend_hash_move_forward_ex(ht, &pos)) {
+		if (Z_TYPE_PP(ppzbev) != IS_OBJECT
+				|| !instanceof_function(Z_OBJCE_PP(ppzbev), php_event_bevent_ce TSRMLS_CC)) {
+			php_error_docref(NULL TSRMLS_CC, E_WARNING, "Expected EventBufferEvent objects only");
+			continue;
+		}
+
+		PHP_EVENT_FETCH_BEVENT(bev, *ppzbev);
+		if (!bev->bevent) {
+			continue;
+		}
+
+		output = bufferevent_get_output(bev->bevent);
+
+		if ((max_output > 0 && evbuffer_get_length(output) >= (size_t) max_output)
+				|| php_event_shared_block_add(output, blk) == FAILURE) {
+			if (zskipped) {
+				if (zend_hash_get_current_key_ex(ht, &key, &key_len, &idx, 0, &pos) == HASH_KEY_IS_STRING) {
+					add_next_index_stringl(zskipped, key, key_len - 1, 1);
+				} else {
+					add_next_index_long(zskipped, (long) idx);
+				}
+			}
+			continue;
+		}
+
+		++count;
+	}
+
+	php_event_shared_block_release(blk);
+
+	RETVAL_LONG(count);
+}
+/* }}} */
+
 /*
  * Local variables:
  * tab-width: 4
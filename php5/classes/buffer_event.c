@@ -18,6 +18,11 @@
 #include "../src/common.h"
 #include "../src/util.h"
 #include "../src/priv.h"
+#include "idle_reaper.h"
+#include "buffer_event.h"
+#ifdef HAVE_EVENT_OPENSSL_LIB
+# include "ssl_context.h"
+#endif
 
 extern const zend_function_entry php_event_dns_base_ce_functions[];
 extern zend_class_entry *php_event_dns_base_ce;
@@ -33,6 +38,40 @@ extern zend_class_entry *php_event_dns_base_ce;
     }                                               \
 }
 
+#ifdef HAVE_EVENT_PTHREADS_LIB
+/* Bufferevents created without BEV_OPT_THREADSAFE have no lock. Don't waste
+ * calls on them in the callbacks. */
+# define _bevent_lock(bev, bevent)                 \
+	do {                                           \
+		if ((bev)->lock && (bevent)) {             \
+			bufferevent_lock(bevent);              \
+		}                                          \
+	} while (0)
+# define _bevent_unlock(bev, bevent)               \
+	do {                                           \
+		if ((bev)->lock && (bevent)) {             \
+			bufferevent_unlock(bevent);            \
+		}                                          \
+	} while (0)
+#else
+# define _bevent_lock(bev, bevent)
+# define _bevent_unlock(bev, bevent)
+#endif
+
+/* {{{ _bevent_opt_threadsafe
+ * Adds BEV_OPT_THREADSAFE to the bufferevent options, unless the base is
+ * created with EventBase::NOLOCK, i.e. is never shared between threads. */
+static zend_always_inline int _bevent_opt_threadsafe(php_event_base_t *base, int options)
+{
+#ifdef HAVE_EVENT_PTHREADS_LIB
+	if (!base->nolock) {
+		options |= BEV_OPT_THREADSAFE;
+	}
+#endif
+	return options;
+}
+/* }}} */
+
 /* {{{ bevent_rw_cb
  * Is called from the bufferevent read and write callbacks */
 static zend_always_inline void bevent_rw_cb(struct bufferevent *bevent, php_event_bevent_t *bev, zend_fcall_info *pfci, zend_fcall_info_cache *pfcc)
@@ -57,11 +96,7 @@ static zend_always_inline void bevent_rw_cb(struct bufferevent *bevent, php_even
 	PHP_EVENT_TSRMLS_FETCH_FROM_CTX(bev->thread_ctx);
 
 	if (ZEND_FCI_INITIALIZED(*pfci)) {
-#ifdef HAVE_EVENT_PTHREADS_LIB
-		if (bevent) {
-			bufferevent_lock(bevent);
-		}
-#endif
+		_bevent_lock(bev, bevent);
 		/* Setup callback args */
 
 		arg_self = bev->self;
@@ -102,21 +137,49 @@ static zend_always_inline void bevent_rw_cb(struct bufferevent *bevent, php_even
 
 		zval_ptr_dtor(&arg_data);
 
-#ifdef HAVE_EVENT_PTHREADS_LIB
-		if (bevent) {
-			bufferevent_unlock(bevent);
-		}
-#endif
+		_bevent_unlock(bev, bevent);
         zval_ptr_dtor(&arg_self);
 	}
 }
 /* }}} */
 
+/* {{{ _bevent_coalesce_defer
+ * Returns non-zero, if the read callback is to be deferred by the read
+ * coalescing. Arms the max_delay timer on the first deferred read. */
+static zend_always_inline int _bevent_coalesce_defer(php_event_bevent_t *bev, struct bufferevent *bevent)
+{
+	size_t len;
+
+	if (!bev->coalesce.min_bytes) {
+		return 0;
+	}
+
+	len = evbuffer_get_length(bufferevent_get_input(bevent));
+	if (len >= bev->coalesce.min_bytes) {
+		evtimer_del(bev->coalesce.timer);
+		return 0;
+	}
+
+	if (len && !evtimer_pending(bev->coalesce.timer, NULL)) {
+		evtimer_add(bev->coalesce.timer, &bev->coalesce.tv);
+	}
+
+	return 1;
+}
+/* }}} */
+
 /* {{{ bevent_read_cb */
 static void bevent_read_cb(struct bufferevent *bevent, void *ptr)
 {
 	php_event_bevent_t *bev = (php_event_bevent_t *) ptr;
 
+	if (_bevent_coalesce_defer(bev, bevent)) {
+		return;
+	}
+
+#ifdef PHP_EVENT_STATS
+	bev->stats.read_calls++;
+#endif
 	bevent_rw_cb(bevent, bev, bev->fci_read, bev->fcc_read);
 }
 /* }}} */
@@ -126,12 +189,73 @@ static void bevent_write_cb(struct bufferevent *bevent, void *ptr)
 {
 	php_event_bevent_t *bev = (php_event_bevent_t *) ptr;
 
+#ifdef PHP_EVENT_STATS
+	bev->stats.write_calls++;
+#endif
 	bevent_rw_cb(bevent, bev, bev->fci_write, bev->fcc_write);
 }
 /* }}} */
 
-/* {{{ bevent_event_cb */
-static void bevent_event_cb(struct bufferevent *bevent, short events, void *ptr)
+/* {{{ bevent_coalesce_timer_cb
+ * Releases the deferred read callback when max_delay expires */
+static void bevent_coalesce_timer_cb(evutil_socket_t fd, short what, void *arg)
+{
+	php_event_bevent_t *bev = (php_event_bevent_t *) arg;
+
+	if (!bev->bevent || !bev->fci_read
+			|| !evbuffer_get_length(bufferevent_get_input(bev->bevent))) {
+		return;
+	}
+#ifdef PHP_EVENT_STATS
+	bev->stats.read_calls++;
+#endif
+	bevent_rw_cb(bev->bevent, bev, bev->fci_read, bev->fcc_read);
+}
+/* }}} */
+
+/* {{{ _bevent_is_closed
+ * Returns non-zero, if the events close the connection. A timeout disables
+ * the timed out direction, so it closes the connection, unless the event
+ * callback has enabled the direction again. */
+static zend_always_inline int _bevent_is_closed(php_event_bevent_t *bev, short events)
+{
+	short what;
+
+	if (events & (BEV_EVENT_EOF | BEV_EVENT_ERROR)) {
+		return 1;
+	}
+
+	if (events & BEV_EVENT_TIMEOUT) {
+		if (!bev->bevent) {
+			return 1;
+		}
+		what = (events & BEV_EVENT_READING) ? EV_READ : EV_WRITE;
+		return !(bufferevent_get_enabled(bev->bevent) & what);
+	}
+
+	return 0;
+}
+/* }}} */
+
+/* {{{ _bevent_release_owned
+ * Drops the reference an object created by an EventListener holds to itself,
+ * when the connection is closed, or timed out. The object may be destroyed here. */
+static zend_always_inline void _bevent_release_owned(php_event_bevent_t *bev, short events)
+{
+	zval *self;
+
+	if (bev->owned && _bevent_is_closed(bev, events)) {
+		bev->owned = 0;
+		php_event_bevent_conn_closed(bev);
+		self = bev->self;
+		bev->self = NULL;
+		zval_ptr_dtor(&self);
+	}
+}
+/* }}} */
+
+/* {{{ _bevent_event_cb */
+static void _bevent_event_cb(struct bufferevent *bevent, short events, void *ptr)
 {
 	php_event_bevent_t    *bev  = (php_event_bevent_t *) ptr;
 	zend_fcall_info       *pfci = bev->fci_event;
@@ -144,6 +268,19 @@ static void bevent_event_cb(struct bufferevent *bevent, short events, void *ptr)
 	php_event_base_t *b;
 	PHP_EVENT_TSRM_DECL
 
+#ifdef PHP_EVENT_STATS
+	if ((events & BEV_EVENT_CONNECTED) && !bev->stats.connected) {
+		bev->stats.connected = php_event_bevent_stats_now(bevent);
+	}
+	/* The callback is installed for the statistics even if there is no
+	 * userspace callback */
+#endif
+	/* ..and to release an object created by EventListener */
+	if (!pfci) {
+		_bevent_release_owned(bev, events);
+		return;
+	}
+
 	PHP_EVENT_ASSERT(pfci && pfcc);
 	PHP_EVENT_ASSERT(bevent);
 	PHP_EVENT_ASSERT(bev->bevent == bevent);
@@ -155,10 +292,9 @@ static void bevent_event_cb(struct bufferevent *bevent, short events, void *ptr)
 	PHP_EVENT_TSRMLS_FETCH_FROM_CTX(bev->thread_ctx);
 
 	if (ZEND_FCI_INITIALIZED(*pfci)) {
-#ifdef HAVE_EVENT_PTHREADS_LIB
-		if (bevent) {
-			bufferevent_lock(bevent);
-		}
+		_bevent_lock(bev, bevent);
+#ifdef PHP_EVENT_STATS
+		bev->stats.event_calls++;
 #endif
 
 		/* Setup callback args */
@@ -208,12 +344,56 @@ static void bevent_event_cb(struct bufferevent *bevent, short events, void *ptr)
 		zval_ptr_dtor(&arg_data);
 
 		PHP_EVENT_ASSERT(bevent);
-#ifdef HAVE_EVENT_PTHREADS_LIB
-		if (bevent) {
-			bufferevent_unlock(bevent);
-		}
-#endif
+		_bevent_unlock(bev, bevent);
+		/* arg_self keeps the object alive up to here */
+		_bevent_release_owned(bev, events);
 		zval_ptr_dtor(&arg_self);
+		return;
+	}
+
+	_bevent_release_owned(bev, events);
+}
+/* }}} */
+
+/* {{{ bevent_event_cb
+ * Delivers the input held back by the read coalescing before EOF, or an
+ * error, is reported. Otherwise the event callback, which usually frees the
+ * buffer event, would lose the tail of the stream. */
+static void bevent_event_cb(struct bufferevent *bevent, short events, void *ptr)
+{
+	php_event_bevent_t *bev   = (php_event_bevent_t *) ptr;
+	zval               *zself = NULL;
+
+	if (!(events & (BEV_EVENT_EOF | BEV_EVENT_ERROR)) || !bev->coalesce.timer) {
+		_bevent_event_cb(bevent, events, ptr);
+		return;
+	}
+
+	evtimer_del(bev->coalesce.timer);
+
+	if (!bev->coalesce.min_bytes || !bev->fci_read
+			|| !evbuffer_get_length(bufferevent_get_input(bevent))) {
+		_bevent_event_cb(bevent, events, ptr);
+		return;
+	}
+
+	/* The read callback may free the buffer event and release the object */
+	if (bev->self) {
+		zself = bev->self;
+		Z_ADDREF_P(zself);
+	}
+
+#ifdef PHP_EVENT_STATS
+	bev->stats.read_calls++;
+#endif
+	bevent_rw_cb(bevent, bev, bev->fci_read, bev->fcc_read);
+
+	if (bev->bevent == bevent) {
+		_bevent_event_cb(bevent, events, ptr);
+	}
+
+	if (zself) {
+		zval_ptr_dtor(&zself);
 	}
 }
 /* }}} */
@@ -288,9 +468,7 @@ static void _create_ssl_filter(INTERNAL_FUNCTION_PARAMETERS, zend_bool deprecate
 	/* Attach ectx to ssl for callbacks */
 	SSL_set_ex_data(ssl, php_event_ssl_data_index, ectx);
 
-#ifdef HAVE_EVENT_PTHREADS_LIB
-	options |= BEV_OPT_THREADSAFE;
-#endif
+	options = _bevent_opt_threadsafe(base, options);
 	bevent = bufferevent_openssl_filter_new(base->base,
     		bev_underlying->bevent,
     		ssl, state, options);
@@ -300,6 +478,16 @@ static void _create_ssl_filter(INTERNAL_FUNCTION_PARAMETERS, zend_bool deprecate
 		RETURN_FALSE;
 	}
 	bev->bevent = bevent;
+	bev->lock = (options & BEV_OPT_THREADSAFE) ? 1 : 0;
+#ifdef PHP_EVENT_STATS
+	php_event_bevent_stats_attach(bev);
+#endif
+#ifdef PHP_EVENT_SSL_RECORD_SIZING
+	if (ectx->dynamic_records) {
+		php_event_bevent_record_sizing_attach(bev, PHP_EVENT_SSL_RECORD_SMALL,
+				PHP_EVENT_SSL_RECORD_BOOST_AFTER, PHP_EVENT_SSL_RECORD_IDLE);
+	}
+#endif
 
 	bev->self = return_value;
 	Z_ADDREF_P(return_value);
@@ -309,6 +497,365 @@ static void _create_ssl_filter(INTERNAL_FUNCTION_PARAMETERS, zend_bool deprecate
 }/*}}}*/
 #endif
 
+/* {{{ php_event_bevent_from_template
+ * Wraps an accepted socket into a new EventBufferEvent object configured
+ * according to the template. The object is released when the connection is
+ * closed, or EventBufferEvent::free() is called. The connection is counted
+ * in conns, if not NULL. */
+int php_event_bevent_from_template(zval *zbev, zval *zbase, evutil_socket_t fd, php_event_bevent_template_t *t, php_event_conn_counter_t *conns TSRMLS_DC)
+{
+	php_event_base_t        *base;
+	php_event_bevent_t      *bev;
+	struct bufferevent      *bevent;
+	long                     options;
+#ifdef HAVE_EVENT_OPENSSL_LIB
+	php_event_ssl_context_t *ectx    = NULL;
+	SSL                     *ssl;
+#endif
+
+	PHP_EVENT_FETCH_BASE(base, zbase);
+
+	/* Nobody else owns the socket */
+	options = _bevent_opt_threadsafe(base, t->options | BEV_OPT_CLOSE_ON_FREE);
+
+#ifdef HAVE_EVENT_OPENSSL_LIB
+	if (t->ctx) {
+		PHP_EVENT_FETCH_SSL_CONTEXT(ectx, t->ctx);
+		if (UNEXPECTED(ectx->ctx == NULL)) {
+			return FAILURE;
+		}
+		ssl = SSL_new(ectx->ctx);
+		if (UNEXPECTED(!ssl)) {
+			return FAILURE;
+		}
+		/* Attach ectx to ssl for callbacks */
+		SSL_set_ex_data(ssl, php_event_ssl_data_index, ectx);
+
+		bevent = bufferevent_openssl_socket_new(base->base, fd, ssl,
+				BUFFEREVENT_SSL_ACCEPTING, options);
+	} else
+#endif
+	{
+		bevent = bufferevent_socket_new(base->base, fd, options);
+	}
+	if (bevent == NULL) {
+		return FAILURE;
+	}
+
+	PHP_EVENT_INIT_CLASS_OBJECT(zbev, php_event_bevent_ce);
+	PHP_EVENT_FETCH_BEVENT(bev, zbev);
+
+	bev->bevent = bevent;
+	bev->lock = (options & BEV_OPT_THREADSAFE) ? 1 : 0;
+#ifdef PHP_EVENT_STATS
+	php_event_bevent_stats_attach(bev);
+#endif
+#ifdef PHP_EVENT_SSL_RECORD_SIZING
+	if (ectx && ectx->dynamic_records) {
+		php_event_bevent_record_sizing_attach(bev, PHP_EVENT_SSL_RECORD_SMALL,
+				PHP_EVENT_SSL_RECORD_BOOST_AFTER, PHP_EVENT_SSL_RECORD_IDLE);
+	}
+#endif
+
+	bev->self = zbev;
+	Z_ADDREF_P(zbev);
+	bev->owned = 1;
+
+	if (conns) {
+		conns->refcount++;
+		conns->live++;
+		bev->conns = conns;
+	}
+
+	bev->base = zbase;
+	Z_ADDREF_P(zbase);
+
+	if (t->data) {
+		bev->data = t->data;
+		Z_ADDREF_P(t->data);
+	}
+
+	if (t->fci_read) {
+		PHP_EVENT_COPY_FCALL_INFO(bev->fci_read, bev->fcc_read, t->fci_read, t->fcc_read);
+	}
+	if (t->fci_write) {
+		PHP_EVENT_COPY_FCALL_INFO(bev->fci_write, bev->fcc_write, t->fci_write, t->fcc_write);
+	}
+	if (t->fci_event) {
+		PHP_EVENT_COPY_FCALL_INFO(bev->fci_event, bev->fcc_event, t->fci_event, t->fcc_event);
+	}
+
+	TSRMLS_SET_CTX(bev->thread_ctx);
+
+	/* The event callback is always installed to release the object on close */
+	bufferevent_setcb(bevent,
+			bev->fci_read ? bevent_read_cb : NULL,
+			bev->fci_write ? bevent_write_cb : NULL,
+			bevent_event_cb, (void *) bev);
+
+	bufferevent_setwatermark(bevent, EV_READ, t->read_wm[0], t->read_wm[1]);
+	bufferevent_setwatermark(bevent, EV_WRITE, t->write_wm[0], t->write_wm[1]);
+
+	if (evutil_timerisset(&t->timeout_read) || evutil_timerisset(&t->timeout_write)) {
+		bufferevent_set_timeouts(bevent,
+				evutil_timerisset(&t->timeout_read) ? &t->timeout_read : NULL,
+				evutil_timerisset(&t->timeout_write) ? &t->timeout_write : NULL);
+	}
+
+	if (t->events) {
+		bufferevent_enable(bevent, t->events);
+	}
+
+	return SUCCESS;
+}
+/* }}} */
+
+/* {{{ php_event_bevent_template_free */
+void php_event_bevent_template_free(php_event_bevent_template_t *t)
+{
+	if (t->data) {
+		zval_ptr_dtor(&t->data);
+	}
+	PHP_EVENT_FREE_FCALL_INFO(t->fci_read, t->fcc_read);
+	PHP_EVENT_FREE_FCALL_INFO(t->fci_write, t->fcc_write);
+	PHP_EVENT_FREE_FCALL_INFO(t->fci_event, t->fcc_event);
+#ifdef HAVE_EVENT_OPENSSL_LIB
+	if (t->ctx) {
+		zval_ptr_dtor(&t->ctx);
+	}
+#endif
+	efree(t);
+}
+/* }}} */
+
+/* {{{ php_event_conn_counter_new
+ * Allocates a connection counter with a single reference held by the owner */
+php_event_conn_counter_t *php_event_conn_counter_new(void *owner, void (*on_close)(php_event_conn_counter_t *c))
+{
+	php_event_conn_counter_t *c = ecalloc(1, sizeof(php_event_conn_counter_t));
+
+	c->refcount = 1;
+	c->owner    = owner;
+	c->on_close = on_close;
+
+	return c;
+}
+/* }}} */
+
+/* {{{ php_event_conn_counter_release */
+void php_event_conn_counter_release(php_event_conn_counter_t *c)
+{
+	PHP_EVENT_ASSERT(c && c->refcount);
+
+	if (--c->refcount == 0) {
+		efree(c);
+	}
+}
+/* }}} */
+
+/* {{{ php_event_bevent_conn_closed
+ * Removes the connection from the counter of the listener which accepted it */
+void php_event_bevent_conn_closed(php_event_bevent_t *bev)
+{
+	php_event_conn_counter_t *c = bev->conns;
+
+	if (c) {
+		bev->conns = NULL;
+		c->live--;
+		if (c->owner && c->on_close) {
+			c->on_close(c);
+		}
+		php_event_conn_counter_release(c);
+	}
+}
+/* }}} */
+
+#ifdef PHP_EVENT_FD_PASSING
+/* Bytes read with one recvmsg() in the descriptor passing mode */
+#define PHP_EVENT_FDPASS_READ_SIZE 4096
+
+/* {{{ _bevent_fdpass_queue
+ * Appends received descriptors to the queue returned by fetchFds() */
+static void _bevent_fdpass_queue(php_event_bevent_fdpass_t *fp, const int *fds, size_t nfds)
+{
+	if (fp->nfds + nfds > fp->size) {
+		fp->size = MAX(fp->size * 2, fp->nfds + nfds);
+		fp->fds  = erealloc(fp->fds, fp->size * sizeof(int));
+	}
+	memcpy(fp->fds + fp->nfds, fds, nfds * sizeof(int));
+	fp->nfds += nfds;
+}
+/* }}} */
+
+/* {{{ _bevent_fdpass_highmark
+ * Returns the read high watermark of the buffer event, 0 if there is none */
+static zend_always_inline size_t _bevent_fdpass_highmark(php_event_bevent_t *bev)
+{
+#if LIBEVENT_VERSION_NUMBER >= 0x02010500
+	size_t high = 0;
+
+	bufferevent_getwatermark(bev->bevent, EV_READ, NULL, &high);
+
+	return high;
+#else
+	return 0;
+#endif
+}
+/* }}} */
+
+/* {{{ _bevent_fdpass_lowmark
+ * Returns the read low watermark of the buffer event, 0 if there is none */
+static zend_always_inline size_t _bevent_fdpass_lowmark(php_event_bevent_t *bev)
+{
+#if LIBEVENT_VERSION_NUMBER >= 0x02010500
+	size_t low = 0;
+
+	bufferevent_getwatermark(bev->bevent, EV_READ, &low, NULL);
+
+	return low;
+#else
+	return 0;
+#endif
+}
+/* }}} */
+
+/* {{{ _bevent_fdpass_set_reading
+ * Adds or removes the read event of the descriptor passing mode */
+static int _bevent_fdpass_set_reading(php_event_bevent_t *bev, zend_bool on)
+{
+	php_event_bevent_fdpass_t *fp = &bev->fdpass;
+
+	if (on == fp->reading) {
+		return SUCCESS;
+	}
+
+	/* The event is not pending while paused by the high watermark */
+	if (!fp->paused && (on ? event_add(fp->read_ev, NULL) : event_del(fp->read_ev))) {
+		return FAILURE;
+	}
+	fp->reading = on;
+
+	return SUCCESS;
+}
+/* }}} */
+
+/* {{{ _bevent_fdpass_input_cb
+ * Resumes reading, when the input drops below the read high watermark */
+static void _bevent_fdpass_input_cb(struct evbuffer *input, const struct evbuffer_cb_info *info, void *arg)
+{
+	php_event_bevent_t        *bev  = (php_event_bevent_t *) arg;
+	php_event_bevent_fdpass_t *fp   = &bev->fdpass;
+	size_t                     high;
+
+	if (!fp->paused || !info->n_deleted) {
+		return;
+	}
+
+	high = _bevent_fdpass_highmark(bev);
+	if (high && evbuffer_get_length(input) >= high) {
+		return;
+	}
+
+	fp->paused = 0;
+	if (fp->reading) {
+		event_add(fp->read_ev, NULL);
+	}
+}
+/* }}} */
+
+/* {{{ _bevent_fdpass_read_cb
+ * Reads the socket in place of the bufferevent. The data goes to the input
+ * buffer, the descriptors passed with it to the queue. Then the callbacks are
+ * invoked as if the bufferevent read the data itself. */
+static void _bevent_fdpass_read_cb(evutil_socket_t fd, short what, void *arg)
+{
+	php_event_bevent_t    *bev       = (php_event_bevent_t *) arg;
+	struct evbuffer       *input;
+	struct evbuffer_iovec  v;
+	int                    fds[PHP_EVENT_MAX_PASSED_FDS];
+	size_t                 nfds;
+	int                    truncated;
+	ssize_t                n;
+	size_t                 high;
+	PHP_EVENT_TSRM_DECL
+
+	PHP_EVENT_ASSERT(bev->bevent);
+	PHP_EVENT_TSRMLS_FETCH_FROM_CTX(bev->thread_ctx);
+
+	input = bufferevent_get_input(bev->bevent);
+	if (evbuffer_reserve_space(input, PHP_EVENT_FDPASS_READ_SIZE, &v, 1) < 1) {
+		return;
+	}
+
+	do {
+		nfds = PHP_EVENT_MAX_PASSED_FDS;
+		n    = php_event_recv_fds(fd, v.iov_base, v.iov_len, fds, &nfds, &truncated);
+	} while (n < 0 && errno == EINTR);
+
+	if (n <= 0) {
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			return;
+		}
+		_bevent_fdpass_set_reading(bev, 0);
+		bevent_event_cb(bev->bevent, BEV_EVENT_READING | (n ? BEV_EVENT_ERROR : BEV_EVENT_EOF), (void *) bev);
+		return;
+	}
+
+	v.iov_len = (size_t) n;
+	evbuffer_commit_space(input, &v, 1);
+
+	if (nfds) {
+		_bevent_fdpass_queue(&bev->fdpass, fds, nfds);
+	}
+
+	high = _bevent_fdpass_highmark(bev);
+	if (high && evbuffer_get_length(input) >= high) {
+		/* Like the bufferevent, stop reading until the input is drained */
+		bev->fdpass.paused = 1;
+		event_del(bev->fdpass.read_ev);
+	}
+
+	if (truncated) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "Some of the passed descriptors were dropped");
+	}
+
+	/* Like the bufferevent, wait for the low watermark */
+	if (bev->fci_read && evbuffer_get_length(input) >= _bevent_fdpass_lowmark(bev)) {
+		bevent_read_cb(bev->bevent, (void *) bev);
+	}
+}
+/* }}} */
+
+/* {{{ php_event_bevent_fdpass_free
+ * Turns the descriptor passing mode off. Closes the descriptors not fetched */
+void php_event_bevent_fdpass_free(php_event_bevent_t *bev)
+{
+	php_event_bevent_fdpass_t *fp = &bev->fdpass;
+	size_t                     i;
+
+	if (fp->read_ev) {
+		event_free(fp->read_ev);
+		fp->read_ev = NULL;
+	}
+	if (fp->input_cb && bev->bevent) {
+		evbuffer_remove_cb_entry(bufferevent_get_input(bev->bevent), fp->input_cb);
+	}
+	fp->input_cb = NULL;
+	fp->reading  = 0;
+	fp->paused   = 0;
+
+	for (i = 0; i < fp->nfds; i++) {
+		close(fp->fds[i]);
+	}
+	if (fp->fds) {
+		efree(fp->fds);
+		fp->fds = NULL;
+	}
+	fp->nfds = fp->size = 0;
+}
+/* }}} */
+#endif
+
 /* Private }}} */
 
 
@@ -380,9 +927,7 @@ PHP_METHOD(EventBufferEvent, __construct)
 
 	PHP_EVENT_FETCH_BEVENT(bev, zself);
 
-#ifdef HAVE_EVENT_PTHREADS_LIB
-	options |= BEV_OPT_THREADSAFE;
-#endif
+	options = _bevent_opt_threadsafe(base, options);
 	bevent = bufferevent_socket_new(base->base, fd, options);
 	if (bevent == NULL) {
 		php_error_docref(NULL TSRMLS_CC, E_ERROR,
@@ -391,6 +936,10 @@ PHP_METHOD(EventBufferEvent, __construct)
 	}
 	bev->_internal = 0;
 	bev->bevent = bevent;
+	bev->lock = (options & BEV_OPT_THREADSAFE) ? 1 : 0;
+#ifdef PHP_EVENT_STATS
+	php_event_bevent_stats_attach(bev);
+#endif
 
 	bev->self = zself;
 	Z_ADDREF_P(zself);
@@ -440,6 +989,10 @@ PHP_METHOD(EventBufferEvent, __construct)
 
 	TSRMLS_SET_CTX(bev->thread_ctx);
 
+#ifdef PHP_EVENT_STATS
+	event_cb = bevent_event_cb;
+#endif
+
 	if (read_cb || write_cb || event_cb || zarg) {
 		bufferevent_setcb(bev->bevent, read_cb, write_cb, event_cb, (void *) bev);
 	}
@@ -455,12 +1008,29 @@ PHP_METHOD(EventBufferEvent, free)
 	PHP_EVENT_FETCH_BEVENT(bev, zbevent);
 
 	if (bev->bevent) {
+		php_event_idle_reaper_unlink(bev);
+		php_event_bevent_coalesce_free(bev);
+		php_event_bevent_read_sizing_detach(bev);
+#ifdef PHP_EVENT_SSL_RECORD_SIZING
+		php_event_bevent_record_sizing_detach(bev);
+#endif
+		php_event_bevent_wprio_free(bev);
+		php_event_bevent_cork_free(bev);
+#ifdef PHP_EVENT_FD_PASSING
+		php_event_bevent_fdpass_free(bev);
+#endif
+
 		if (!bev->_internal) {
+#ifdef PHP_EVENT_STATS
+			php_event_bevent_stats_detach(bev);
+#endif
 			bufferevent_free(bev->bevent);
 		}
 		bev->bevent = 0;
 
 		/* Do it once */
+		bev->owned = 0;
+		php_event_bevent_conn_closed(bev);
 		if (bev->self) {
 			zval_ptr_dtor(&bev->self);
 			bev->self = NULL;
@@ -534,6 +1104,10 @@ PHP_METHOD(EventBufferEvent, createPair)
 		PHP_EVENT_FETCH_BEVENT(b[i], zbev[i]);
 
 		b[i]->bevent    = bevent_pair[i];
+		b[i]->lock      = (options & BEV_OPT_THREADSAFE) ? 1 : 0;
+#ifdef PHP_EVENT_STATS
+		php_event_bevent_stats_attach(b[i]);
+#endif
 
 		add_next_index_zval(return_value, zbev[i]);
 	}
@@ -598,6 +1172,11 @@ PHP_METHOD(EventBufferEvent, connect)
 			RETURN_FALSE;
 		}
 
+#ifdef PHP_EVENT_STATS
+	bev->stats.started   = php_event_bevent_stats_now(bev->bevent);
+	bev->stats.connected = 0;
+#endif
+
 	/* bufferevent_socket_connect() allocates a socket stream internally, if we
 	 * didn't provide the file descriptor to the bufferevent before, e.g. with
 	 * bufferevent_socket_new() */
@@ -670,6 +1249,22 @@ PHP_METHOD(EventBufferEvent, connectHost)
 	 * didn't provide the file descriptor to the bufferevent before, e.g. with
 	 * bufferevent_socket_new() */
 
+#ifdef PHP_EVENT_STATS
+	bev->stats.started   = php_event_bevent_stats_now(bev->bevent);
+	bev->stats.connected = 0;
+#endif
+
+#ifdef HAVE_EVENT_OPENSSL_LIB
+	{
+		/* Resume the cached session of the host, if any */
+		struct ssl_st *ssl = bufferevent_openssl_get_ssl(bev->bevent);
+
+		if (ssl) {
+			php_event_ssl_session_prepare(ssl, hostname, port);
+		}
+	}
+#endif
+
 #ifdef HAVE_EVENT_EXTRA_LIB
 	if (zdns_base) {
 		PHP_EVENT_FETCH_DNS_BASE(dnsb, zdns_base);
@@ -798,6 +1393,9 @@ PHP_METHOD(EventBufferEvent, setCallbacks)
 
 	TSRMLS_SET_CTX(bev->thread_ctx);
 
+#ifdef PHP_EVENT_STATS
+	event_cb = bevent_event_cb;
+#endif
 	bufferevent_setcb(bev->bevent, read_cb, write_cb, event_cb, (void *) bev);
 }
 /* }}} */
@@ -818,6 +1416,21 @@ PHP_METHOD(EventBufferEvent, enable)
 	PHP_EVENT_FETCH_BEVENT(bev, zbevent);
 	_ret_if_invalid_bevent_ptr(bev);
 
+#ifdef PHP_EVENT_FD_PASSING
+	if (bev->fdpass.read_ev && (events & EV_READ)) {
+		if (_bevent_fdpass_set_reading(bev, 1) == FAILURE) {
+			RETURN_FALSE;
+		}
+		events &= ~EV_READ;
+	}
+#endif
+
+	/* The write side is resumed by uncork() */
+	if (bev->cork.corked && (events & EV_WRITE)) {
+		bev->cork.write_enabled = 1;
+		events &= ~EV_WRITE;
+	}
+
 	if (bufferevent_enable(bev->bevent, events)) {
 		RETURN_FALSE;
 	}
@@ -842,6 +1455,20 @@ PHP_METHOD(EventBufferEvent,disable)
 	PHP_EVENT_FETCH_BEVENT(bev, zbevent);
 	_ret_if_invalid_bevent_ptr(bev);
 
+#ifdef PHP_EVENT_FD_PASSING
+	if (bev->fdpass.read_ev && (events & EV_READ)) {
+		if (_bevent_fdpass_set_reading(bev, 0) == FAILURE) {
+			RETURN_FALSE;
+		}
+		events &= ~EV_READ;
+	}
+#endif
+
+	/* Keeps uncork() from resuming the write side */
+	if (bev->cork.corked && (events & EV_WRITE)) {
+		bev->cork.write_enabled = 0;
+	}
+
 	if (bufferevent_disable(bev->bevent, events)) {
 		RETURN_FALSE;
 	}
@@ -856,6 +1483,7 @@ PHP_METHOD(EventBufferEvent, getEnabled)
 {
 	zval               *zbevent = getThis();
 	php_event_bevent_t *bev;
+	short               enabled;
 
 	if (zend_parse_parameters_none() == FAILURE) {
 		return;
@@ -864,8 +1492,17 @@ PHP_METHOD(EventBufferEvent, getEnabled)
 	PHP_EVENT_FETCH_BEVENT(bev, zbevent);
 	_ret_if_invalid_bevent_ptr(bev);
 
+	enabled = bufferevent_get_enabled(bev->bevent);
+#ifdef PHP_EVENT_FD_PASSING
+	if (bev->fdpass.reading) {
+		enabled |= EV_READ;
+	}
+#endif
+	if (bev->cork.corked && bev->cork.write_enabled) {
+		enabled |= EV_WRITE;
+	}
 
-	RETVAL_LONG(bufferevent_get_enabled(bev->bevent));
+	RETVAL_LONG(enabled);
 }
 /* }}} */
 
@@ -1118,112 +1755,105 @@ PHP_METHOD(EventBufferEvent, setTimeouts)
 }
 /* }}} */
 
-#ifdef HAVE_EVENT_OPENSSL_LIB /* {{{ */
-/* {{{ proto EventBufferEvent EventBufferEvent::sslFilter(mixed unused, EventBufferEvent underlying, EventSslContext ctx, int state[, int options = 0]);
- */
-PHP_METHOD(EventBufferEvent, sslFilter)
+/* {{{ proto bool EventBufferEvent::setSocketProfile(int profile);
+ * Applies one of the EventUtil::SOCKET_PROFILE_* sets of TCP options to the
+ * socket of the buffer event. */
+PHP_METHOD(EventBufferEvent, setSocketProfile)
 {
-	_create_ssl_filter(INTERNAL_FUNCTION_PARAM_PASSTHRU, 1);
-}
-/* }}} */
+	zval               *zbevent = getThis();
+	php_event_bevent_t *bev;
+	long                profile;
+	evutil_socket_t     fd;
 
-/* {{{ proto EventBufferEvent EventBufferEvent::createSslFilter(EventBufferEvent underlying, EventSslContext ctx, int state[, int options = 0]);
- */
-PHP_METHOD(EventBufferEvent, createSslFilter)
-{
-	_create_ssl_filter(INTERNAL_FUNCTION_PARAM_PASSTHRU, 0);
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "l", &profile) == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_BEVENT(bev, zbevent);
+	_ret_if_invalid_bevent_ptr(bev);
+
+	fd = bufferevent_getfd(bev->bevent);
+	if (fd == -1) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "Buffer event has no socket");
+		RETURN_FALSE;
+	}
+
+	if (php_event_set_socket_profile(fd, profile TSRMLS_CC) == FAILURE) {
+		RETURN_FALSE;
+	}
+
+	RETVAL_TRUE;
 }
 /* }}} */
 
-/* {{{ proto EventBufferEvent EventBufferEvent::sslSocket(EventBase base, mixed socket, EventSslContext ctx, int state[, int options = 0]);
- * */
-PHP_METHOD(EventBufferEvent, sslSocket)
+/* {{{ proto bool EventBufferEvent::writePriority(string data, int prio);
+ * Queues data with priority prio, 0 being the highest. Queued messages enter
+ * the output buffer whole, highest priority first, as the output drains below
+ * 16 KiB. Data added with write() bypasses the queues. */
+PHP_METHOD(EventBufferEvent, writePriority)
 {
-	zval                     *zbase;
-	php_event_base_t         *base;
-	zval                     *zctx;
-	php_event_ssl_context_t  *ectx;
-	zval                    **ppzfd;
-	evutil_socket_t           fd;
-	long                      state;
-	long                      options = 0;
-	php_event_bevent_t       *bev;
-	struct bufferevent       *bevent;
-	SSL                      *ssl;
+	zval               *zbevent = getThis();
+	php_event_bevent_t *bev;
+	char               *data;
+	int                 data_len;
+	long                prio;
 
-	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "OZOl|l",
-				&zbase, php_event_base_ce,
-				&ppzfd,
-				&zctx, php_event_ssl_context_ce,
-				&state, &options) == FAILURE) {
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "sl",
+				&data, &data_len, &prio) == FAILURE) {
 		return;
 	}
 
-	PHP_EVENT_REQUIRE_BASE_BY_REF(zbase);
+	PHP_EVENT_FETCH_BEVENT(bev, zbevent);
+	_ret_if_invalid_bevent_ptr(bev);
 
-	if (!is_valid_ssl_state(state)) {
+	if (prio < 0 || prio >= PHP_EVENT_WRITE_PRIORITIES) {
 		php_error_docref(NULL TSRMLS_CC, E_WARNING,
-				"Invalid state specified");
+				"prio must be in range 0..%d", PHP_EVENT_WRITE_PRIORITIES - 1);
 		RETURN_FALSE;
 	}
 
-	PHP_EVENT_FETCH_BASE(base, zbase);
-	PHP_EVENT_FETCH_SSL_CONTEXT(ectx, zctx);
-
-	PHP_EVENT_INIT_CLASS_OBJECT(return_value, php_event_bevent_ce);
-	PHP_EVENT_FETCH_BEVENT(bev, return_value);
-
-	if (Z_TYPE_PP(ppzfd) == IS_NULL) {
-		/* User decided to set fd later via connect or connectHost etc.*/
-		fd = -1;
-	} else {
-		fd = php_event_zval_to_fd(ppzfd TSRMLS_CC);
-		if (fd < 0) {
-			RETURN_FALSE;
-		}
-		/* Make sure that the socket is in non-blocking mode(libevent's tip) */
-		/*evutil_make_socket_nonblocking(fd);*/
+	if (data_len == 0) {
+		RETURN_TRUE;
 	}
 
-	PHP_EVENT_ASSERT(ectx->ctx);
-	ssl = SSL_new(ectx->ctx);
-	if (!ssl) {
-		php_error_docref(NULL TSRMLS_CC, E_WARNING,
-				"Event: Failed creating SSL handle");
+	if (php_event_bevent_wprio_queue(bev, data, data_len, (int) prio) == FAILURE) {
 		RETURN_FALSE;
 	}
-	/* Attach ectx to ssl for callbacks */
-	SSL_set_ex_data(ssl, php_event_ssl_data_index, ectx);
 
-#ifdef HAVE_EVENT_PTHREADS_LIB
-	options |= BEV_OPT_THREADSAFE;
-#endif
-	bevent = bufferevent_openssl_socket_new(base->base, fd, ssl, state, options);
-	if (bevent == NULL) {
-		php_error_docref(NULL TSRMLS_CC, E_ERROR,
-				"Failed to allocate bufferevent filter");
-		RETURN_FALSE;
+	RETVAL_TRUE;
+}
+/* }}} */
+
+/* {{{ proto array EventBufferEvent::getWritePriorityDepths(void);
+ * Returns the number of bytes waiting in each of the writePriority() queues,
+ * indexed by priority. */
+PHP_METHOD(EventBufferEvent, getWritePriorityDepths)
+{
+	zval               *zbevent = getThis();
+	php_event_bevent_t *bev;
+	int                 i;
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
 	}
-	bev->bevent = bevent;
 
-	bev->self = return_value;
-	Z_ADDREF_P(return_value);
+	PHP_EVENT_FETCH_BEVENT(bev, zbevent);
 
-	bev->base = zbase;
-	Z_ADDREF_P(zbase);
+	array_init(return_value);
+
+	for (i = 0; i < PHP_EVENT_WRITE_PRIORITIES; i++) {
+		add_index_long(return_value, i, (long) bev->wprio.bytes[i]);
+	}
 }
 /* }}} */
 
-/* {{{ proto string EventBufferEvent::sslError(void);
- *
- * Returns most recent OpenSSL error reported on the buffer event. The function
- * returns FALSE, if there is no more error to return. */
-PHP_METHOD(EventBufferEvent, sslError)
+/* {{{ proto bool EventBufferEvent::cork(void);
+ * Holds the writes until uncork() is called. TCP_CORK is turned on for the
+ * socket, if available, until the held data is written. */
+PHP_METHOD(EventBufferEvent, cork)
 {
-	zval               *zbevent  = getThis();
+	zval               *zbevent = getThis();
 	php_event_bevent_t *bev;
-	char                buf[512];
-	unsigned long       e;
 
 	if (zend_parse_parameters_none() == FAILURE) {
 		return;
@@ -1232,28 +1862,17 @@ PHP_METHOD(EventBufferEvent, sslError)
 	PHP_EVENT_FETCH_BEVENT(bev, zbevent);
 	_ret_if_invalid_bevent_ptr(bev);
 
-	e = bufferevent_get_openssl_error(bev->bevent);
-	if (e) {
-		RETURN_STRING(ERR_error_string(e, buf), 1);
-	}
+	php_event_bevent_cork(bev);
 
-	RETVAL_FALSE;
+	RETVAL_TRUE;
 }
 /* }}} */
 
-/* {{{ proto void EventBufferEvent::sslRenegotiate(void);
- *
- * Tells a bufferevent to begin SSL renegotiation.
- *
- * Warning. Calling this function tells the SSL to renegotiate, and the
- * bufferevent to invoke appropriate callbacks. This is an advanced topic; you
- * should generally avoid it unless you really know what you’re doing,
- * especially since many SSL versions have had known security issues related to
- * renegotiation.
- **/
-PHP_METHOD(EventBufferEvent, sslRenegotiate)
+/* {{{ proto bool EventBufferEvent::uncork(void);
+ * Releases the writes held by cork() or by the auto mode with a single flush */
+PHP_METHOD(EventBufferEvent, uncork)
 {
-	zval               *zbevent  = getThis();
+	zval               *zbevent = getThis();
 	php_event_bevent_t *bev;
 
 	if (zend_parse_parameters_none() == FAILURE) {
@@ -1263,103 +1882,156 @@ PHP_METHOD(EventBufferEvent, sslRenegotiate)
 	PHP_EVENT_FETCH_BEVENT(bev, zbevent);
 	_ret_if_invalid_bevent_ptr(bev);
 
-	bufferevent_ssl_renegotiate(bev->bevent);
+	php_event_bevent_uncork(bev);
+
+	RETVAL_TRUE;
 }
 /* }}} */
 
-/* {{{ proto string EventBufferEvent::sslGetCipherInfo(void);
- *
- * Returns the current Cipher of the connexion as
- * SSL_get_current_cipher/SSL_CIPHER_description do. Otherwise FALSE. */
-PHP_METHOD(EventBufferEvent, sslGetCipherInfo)
+/* {{{ proto bool EventBufferEvent::setAutoCork(int threshold, double deadline);
+ * Holds the writes until threshold bytes are buffered, or deadline seconds
+ * passed since the first held write. Zero deadline releases the writes at the
+ * end of the current loop iteration. Zero threshold turns the auto mode off. */
+PHP_METHOD(EventBufferEvent, setAutoCork)
 {
 	zval               *zbevent = getThis();
 	php_event_bevent_t *bev;
-	struct ssl_st      *ssl;
-	char               *desc;
-	const SSL_CIPHER   *cipher;
+	long                threshold;
+	double              deadline;
 
-	if (zend_parse_parameters_none() == FAILURE) {
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "ld",
+				&threshold, &deadline) == FAILURE) {
 		return;
 	}
 
 	PHP_EVENT_FETCH_BEVENT(bev, zbevent);
 	_ret_if_invalid_bevent_ptr(bev);
 
-	ssl = bufferevent_openssl_get_ssl(bev->bevent);
-	if (ssl) {
-		cipher = SSL_get_current_cipher(ssl);
-		if (cipher) {
-			desc = SSL_CIPHER_description(cipher, NULL, 128);
-			RETVAL_STRING(desc, 1);
-			OPENSSL_free(desc);
-			return;
-		}
+	if (threshold < 0 || deadline < 0) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "threshold and deadline must not be negative");
+		RETURN_FALSE;
 	}
 
-	RETVAL_FALSE;
+	if (php_event_bevent_set_auto_cork(bev, (size_t) threshold, deadline) == FAILURE) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "Failed to allocate flush timer");
+		RETURN_FALSE;
+	}
+
+	RETVAL_TRUE;
 }
 /* }}} */
 
-/* {{{ proto string EventBufferEvent::sslGetCipherName(void);
- *
- * Returns the current Cipher Name of the connection as SSL_get_cipher_name does.
- * returns FALSE, if there is no more error to return. */
-PHP_METHOD(EventBufferEvent, sslGetCipherName)
+/* {{{ proto bool EventBufferEvent::setReadCoalescing(int min_bytes, double max_delay);
+ * Defers the read callback until at least min_bytes are buffered in the input,
+ * or max_delay seconds passed since the first deferred read, whichever comes
+ * first. Zero min_bytes turns the coalescing off. */
+PHP_METHOD(EventBufferEvent, setReadCoalescing)
 {
 	zval               *zbevent = getThis();
 	php_event_bevent_t *bev;
-	struct ssl_st      *ssl;
+	long                min_bytes;
+	double              max_delay;
+	struct event_base  *base;
+	struct timeval      tv;
+#if LIBEVENT_VERSION_NUMBER >= 0x02000400
+	const struct timeval *ptv;
+#endif
 
-	if (zend_parse_parameters_none() == FAILURE) {
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "ld",
+				&min_bytes, &max_delay) == FAILURE) {
 		return;
 	}
 
 	PHP_EVENT_FETCH_BEVENT(bev, zbevent);
 	_ret_if_invalid_bevent_ptr(bev);
 
-	ssl = bufferevent_openssl_get_ssl(bev->bevent);
-	if (ssl) {
-		RETURN_STRING(SSL_get_cipher_name(ssl), 1);
+	if (min_bytes < 0) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "min_bytes must not be negative");
+		RETURN_FALSE;
 	}
-	RETVAL_FALSE;
+
+	if (min_bytes == 0) {
+		bev->coalesce.min_bytes = 0;
+		if (bev->coalesce.timer && evtimer_pending(bev->coalesce.timer, NULL)) {
+			/* Release the deferred read on the next loop iteration */
+			event_active(bev->coalesce.timer, EV_TIMEOUT, 0);
+		}
+		RETURN_TRUE;
+	}
+
+	if (max_delay <= 0) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "max_delay must be positive");
+		RETURN_FALSE;
+	}
+
+	base = bufferevent_get_base(bev->bevent);
+
+	if (!bev->coalesce.timer) {
+		bev->coalesce.timer = evtimer_new(base, bevent_coalesce_timer_cb, (void *) bev);
+		if (!bev->coalesce.timer) {
+			php_error_docref(NULL TSRMLS_CC, E_WARNING, "Failed to allocate read coalescing timer");
+			RETURN_FALSE;
+		}
+	}
+
+	PHP_EVENT_TIMEVAL_SET(tv, max_delay);
+#if LIBEVENT_VERSION_NUMBER >= 0x02000400
+	/* Buffer events of the base with the same delay share one timer queue */
+	ptv = event_base_init_common_timeout(base, &tv);
+	if (ptv) {
+		tv = *ptv;
+	}
+#endif
+	bev->coalesce.tv        = tv;
+	bev->coalesce.min_bytes = (size_t) min_bytes;
+
+	if (evtimer_pending(bev->coalesce.timer, NULL)) {
+		/* Reschedule the deferred read with the new delay */
+		evtimer_add(bev->coalesce.timer, &bev->coalesce.tv);
+	}
+
+	RETVAL_TRUE;
 }
 /* }}} */
 
-/* {{{ proto string EventBufferEvent::sslGetCipherVersion(void);
- *
- * Returns the current cipher version of the connection as SSL_get_cipher_version does.
- * returns FALSE, if there is no more error to return. */
-PHP_METHOD(EventBufferEvent, sslGetCipherVersion)
+#if LIBEVENT_VERSION_NUMBER >= 0x02010100
+/* {{{ proto bool EventBufferEvent::setMaxSingleRead(int size);
+ * Sets the maximum number of bytes to read in a single operation. Zero
+ * restores the libevent default. Turns the adaptive read sizing off. */
+PHP_METHOD(EventBufferEvent, setMaxSingleRead)
 {
-	zval               *zbevent  = getThis();
+	zval               *zbevent = getThis();
 	php_event_bevent_t *bev;
-	struct ssl_st      *ssl;
+	long                size;
 
-	if (zend_parse_parameters_none() == FAILURE) {
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "l", &size) == FAILURE) {
 		return;
 	}
 
 	PHP_EVENT_FETCH_BEVENT(bev, zbevent);
 	_ret_if_invalid_bevent_ptr(bev);
 
-	ssl = bufferevent_openssl_get_ssl(bev->bevent);
-	if (ssl) {
-		RETURN_STRING(SSL_get_cipher_version(ssl), 1);
+	if (size < 0) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "size must not be negative");
+		RETURN_FALSE;
 	}
-	RETVAL_FALSE;
+
+	php_event_bevent_read_sizing_detach(bev);
+
+	if (bufferevent_set_max_single_read(bev->bevent, (size_t) size)) {
+		RETURN_FALSE;
+	}
+
+	RETVAL_TRUE;
 }
 /* }}} */
 
-/* {{{ proto string EventBufferEvent::sslGetProtocol(void);
- *
- * Returns the current Protocol of the connection as SSL_get_version does,
- * otherwise FALSE. */
-PHP_METHOD(EventBufferEvent, sslGetProtocol)
+/* {{{ proto int EventBufferEvent::getMaxSingleRead(void);
+ * Returns the maximum number of bytes to read in a single operation */
+PHP_METHOD(EventBufferEvent, getMaxSingleRead)
 {
 	zval               *zbevent = getThis();
 	php_event_bevent_t *bev;
-	struct ssl_st      *ssl;
 
 	if (zend_parse_parameters_none() == FAILURE) {
 		return;
@@ -1368,7 +2040,575 @@ PHP_METHOD(EventBufferEvent, sslGetProtocol)
 	PHP_EVENT_FETCH_BEVENT(bev, zbevent);
 	_ret_if_invalid_bevent_ptr(bev);
 
-	ssl = bufferevent_openssl_get_ssl(bev->bevent);
+	RETVAL_LONG(bufferevent_get_max_single_read(bev->bevent));
+}
+/* }}} */
+
+/* {{{ proto bool EventBufferEvent::setMaxSingleWrite(int size);
+ * Sets the maximum number of bytes to write in a single operation. Zero
+ * restores the libevent default. */
+PHP_METHOD(EventBufferEvent, setMaxSingleWrite)
+{
+	zval               *zbevent = getThis();
+	php_event_bevent_t *bev;
+	long                size;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "l", &size) == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_BEVENT(bev, zbevent);
+	_ret_if_invalid_bevent_ptr(bev);
+
+	if (size < 0) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "size must not be negative");
+		RETURN_FALSE;
+	}
+
+	if (bufferevent_set_max_single_write(bev->bevent, (size_t) size)) {
+		RETURN_FALSE;
+	}
+
+	RETVAL_TRUE;
+}
+/* }}} */
+
+/* {{{ proto int EventBufferEvent::getMaxSingleWrite(void);
+ * Returns the maximum number of bytes to write in a single operation */
+PHP_METHOD(EventBufferEvent, getMaxSingleWrite)
+{
+	zval               *zbevent = getThis();
+	php_event_bevent_t *bev;
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_BEVENT(bev, zbevent);
+	_ret_if_invalid_bevent_ptr(bev);
+
+	RETVAL_LONG(bufferevent_get_max_single_write(bev->bevent));
+}
+/* }}} */
+
+/* {{{ proto bool EventBufferEvent::setAdaptiveRead(int min_size, int max_size);
+ * Lets the maximum single read grow and shrink between min_size and max_size
+ * following the sizes of the reads observed. Zero sizes turn it off. */
+PHP_METHOD(EventBufferEvent, setAdaptiveRead)
+{
+	zval               *zbevent = getThis();
+	php_event_bevent_t *bev;
+	long                min_size;
+	long                max_size;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "ll", &min_size, &max_size) == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_BEVENT(bev, zbevent);
+	_ret_if_invalid_bevent_ptr(bev);
+
+	if (min_size == 0 && max_size == 0) {
+		php_event_bevent_read_sizing_detach(bev);
+		bufferevent_set_max_single_read(bev->bevent, 0);
+		RETURN_TRUE;
+	}
+
+	if (min_size <= 0 || max_size < min_size) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "Expected 0 < min_size <= max_size");
+		RETURN_FALSE;
+	}
+
+	bev->read_sizing.min_size = (size_t) min_size;
+	bev->read_sizing.max_size = (size_t) max_size;
+	php_event_bevent_read_sizing_attach(bev);
+
+	RETVAL_TRUE;
+}
+/* }}} */
+
+/* {{{ proto array EventBufferEvent::getAdaptiveReadStats(void);
+ * Returns the state of the adaptive read sizing: current size, number of reads,
+ * grows, shrinks and the read syscalls saved compared to reading min_size bytes
+ * at a time. */
+PHP_METHOD(EventBufferEvent, getAdaptiveReadStats)
+{
+	zval                           *zbevent = getThis();
+	php_event_bevent_t             *bev;
+	php_event_bevent_read_sizing_t *rs;
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_BEVENT(bev, zbevent);
+	_ret_if_invalid_bevent_ptr(bev);
+
+	rs = &bev->read_sizing;
+
+	array_init(return_value);
+
+	add_assoc_bool(return_value, "enabled",        rs->input_cb != NULL);
+	add_assoc_long(return_value, "size",           (long) rs->size);
+	add_assoc_long(return_value, "reads",          (long) rs->reads);
+	add_assoc_long(return_value, "grows",          (long) rs->grows);
+	add_assoc_long(return_value, "shrinks",        (long) rs->shrinks);
+	add_assoc_long(return_value, "syscalls_saved", (long) rs->syscalls_saved);
+}
+/* }}} */
+#endif
+
+#ifdef PHP_EVENT_TCP_INFO
+/* {{{ proto array EventBufferEvent::getTcpInfo(void);
+ * Returns a snapshot of the TCP state of the underlying socket.
+ * See EventUtil::getTcpInfo(). */
+PHP_METHOD(EventBufferEvent, getTcpInfo)
+{
+	zval               *zbevent = getThis();
+	php_event_bevent_t *bev;
+	evutil_socket_t     fd;
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_BEVENT(bev, zbevent);
+	_ret_if_invalid_bevent_ptr(bev);
+
+	fd = bufferevent_getfd(bev->bevent);
+	if (fd == -1) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "Buffer event has no socket");
+		RETURN_FALSE;
+	}
+
+	if (php_event_get_tcp_info(fd, return_value TSRMLS_CC) == FAILURE) {
+		RETURN_FALSE;
+	}
+}
+/* }}} */
+#endif
+
+#ifdef PHP_EVENT_STATS
+/* {{{ proto array EventBufferEvent::getStats(void);
+ * Returns I/O statistics of the buffer event.
+ *
+ * The counters are kept by the extension internally. Timestamps are in
+ * seconds since the Epoch; connect_time is the time elapsed from creation(or
+ * connect call) till BEV_EVENT_CONNECTED, which includes the SSL handshake. */
+PHP_METHOD(EventBufferEvent, getStats)
+{
+	zval                     *zbevent = getThis();
+	php_event_bevent_t       *bev;
+	php_event_bevent_stats_t *st;
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_BEVENT(bev, zbevent);
+	st = &bev->stats;
+
+	array_init(return_value);
+
+	add_assoc_long(return_value, "bytes_read",      (long) st->bytes_read);
+	add_assoc_long(return_value, "bytes_written",   (long) st->bytes_written);
+	add_assoc_long(return_value, "read_callbacks",  (long) st->read_calls);
+	add_assoc_long(return_value, "write_callbacks", (long) st->write_calls);
+	add_assoc_long(return_value, "event_callbacks", (long) st->event_calls);
+
+	if (st->last_read) {
+		add_assoc_double(return_value, "last_read", st->last_read);
+	} else {
+		add_assoc_null(return_value, "last_read");
+	}
+
+	if (st->last_write) {
+		add_assoc_double(return_value, "last_write", st->last_write);
+	} else {
+		add_assoc_null(return_value, "last_write");
+	}
+
+	if (st->connected) {
+		add_assoc_double(return_value, "connect_time", st->connected - st->started);
+	} else {
+		add_assoc_null(return_value, "connect_time");
+	}
+}
+/* }}} */
+#endif
+
+#ifdef PHP_EVENT_FD_PASSING
+/* {{{ proto bool EventBufferEvent::setFdPassing(bool enable);
+ * Makes the buffer event read its Unix domain socket with recvmsg(), so the
+ * descriptors passed with the data(SCM_RIGHTS) are not lost. The read callback
+ * takes them with fetchFds(). The read timeout and the read low watermark
+ * don't apply in this mode. The read high watermark stops reading until the
+ * input buffer is drained below it(requires Libevent 2.1.5 or later, reading
+ * isn't limited otherwise). */
+PHP_METHOD(EventBufferEvent, setFdPassing)
+{
+	php_event_bevent_t        *bev;
+	php_event_bevent_fdpass_t *fp;
+	zend_bool                  enable;
+	zend_bool                  reading;
+	evutil_socket_t            fd;
+	php_sockaddr_storage       sa_storage;
+	struct sockaddr           *sa         = (struct sockaddr *) &sa_storage;
+	socklen_t                  sa_len     = sizeof(php_sockaddr_storage);
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "b", &enable) == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_BEVENT(bev, getThis());
+	_ret_if_invalid_bevent_ptr(bev);
+
+	fp = &bev->fdpass;
+
+	if (!enable) {
+		if (fp->read_ev) {
+			reading = fp->reading;
+			event_free(fp->read_ev);
+			evbuffer_remove_cb_entry(bufferevent_get_input(bev->bevent), fp->input_cb);
+			fp->read_ev  = NULL;
+			fp->input_cb = NULL;
+			fp->reading  = 0;
+			fp->paused   = 0;
+			if (reading) {
+				bufferevent_enable(bev->bevent, EV_READ);
+			}
+		}
+		RETURN_TRUE;
+	}
+
+	if (fp->read_ev) {
+		RETURN_TRUE;
+	}
+
+	fd = bufferevent_getfd(bev->bevent);
+	if (fd < 0 || bufferevent_get_underlying(bev->bevent) != NULL
+#ifdef HAVE_EVENT_OPENSSL_LIB
+			|| bufferevent_openssl_get_ssl(bev->bevent) != NULL
+#endif
+			|| getsockname(fd, sa, &sa_len) || sa->sa_family != AF_UNIX) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "Descriptor passing requires a plain Unix domain socket");
+		RETURN_FALSE;
+	}
+
+	fp->read_ev = event_new(bufferevent_get_base(bev->bevent), fd, EV_READ | EV_PERSIST,
+			_bevent_fdpass_read_cb, (void *) bev);
+	if (!fp->read_ev) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "Failed to allocate descriptor passing event");
+		RETURN_FALSE;
+	}
+
+	fp->input_cb = evbuffer_add_cb(bufferevent_get_input(bev->bevent), _bevent_fdpass_input_cb, (void *) bev);
+	if (!fp->input_cb) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "Failed to add descriptor passing input callback");
+		event_free(fp->read_ev);
+		fp->read_ev = NULL;
+		RETURN_FALSE;
+	}
+
+	if (bufferevent_get_enabled(bev->bevent) & EV_READ) {
+		bufferevent_disable(bev->bevent, EV_READ);
+		if (_bevent_fdpass_set_reading(bev, 1) == FAILURE) {
+			php_error_docref(NULL TSRMLS_CC, E_WARNING, "Failed to add descriptor passing event");
+			RETURN_FALSE;
+		}
+	}
+
+	RETVAL_TRUE;
+}
+/* }}} */
+
+/* {{{ proto array EventBufferEvent::fetchFds(void);
+ * Returns numeric file descriptors received in the descriptor passing mode
+ * since the previous call, in the order of arrival. The caller is responsible
+ * for closing them. */
+PHP_METHOD(EventBufferEvent, fetchFds)
+{
+	php_event_bevent_t        *bev;
+	php_event_bevent_fdpass_t *fp;
+	size_t                     i;
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_BEVENT(bev, getThis());
+	_ret_if_invalid_bevent_ptr(bev);
+
+	fp = &bev->fdpass;
+
+	array_init(return_value);
+	for (i = 0; i < fp->nfds; i++) {
+		add_next_index_long(return_value, fp->fds[i]);
+	}
+	fp->nfds = 0;
+}
+/* }}} */
+#endif
+
+#ifdef HAVE_EVENT_OPENSSL_LIB /* {{{ */
+/* {{{ proto EventBufferEvent EventBufferEvent::sslFilter(mixed unused, EventBufferEvent underlying, EventSslContext ctx, int state[, int options = 0]);
+ */
+PHP_METHOD(EventBufferEvent, sslFilter)
+{
+	_create_ssl_filter(INTERNAL_FUNCTION_PARAM_PASSTHRU, 1);
+}
+/* }}} */
+
+/* {{{ proto EventBufferEvent EventBufferEvent::createSslFilter(EventBufferEvent underlying, EventSslContext ctx, int state[, int options = 0]);
+ */
+PHP_METHOD(EventBufferEvent, createSslFilter)
+{
+	_create_ssl_filter(INTERNAL_FUNCTION_PARAM_PASSTHRU, 0);
+}
+/* }}} */
+
+/* {{{ proto EventBufferEvent EventBufferEvent::sslSocket(EventBase base, mixed socket, EventSslContext ctx, int state[, int options = 0]);
+ * */
+PHP_METHOD(EventBufferEvent, sslSocket)
+{
+	zval                     *zbase;
+	php_event_base_t         *base;
+	zval                     *zctx;
+	php_event_ssl_context_t  *ectx;
+	zval                    **ppzfd;
+	evutil_socket_t           fd;
+	long                      state;
+	long                      options = 0;
+	php_event_bevent_t       *bev;
+	struct bufferevent       *bevent;
+	SSL                      *ssl;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "OZOl|l",
+				&zbase, php_event_base_ce,
+				&ppzfd,
+				&zctx, php_event_ssl_context_ce,
+				&state, &options) == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_REQUIRE_BASE_BY_REF(zbase);
+
+	if (!is_valid_ssl_state(state)) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING,
+				"Invalid state specified");
+		RETURN_FALSE;
+	}
+
+	PHP_EVENT_FETCH_BASE(base, zbase);
+	PHP_EVENT_FETCH_SSL_CONTEXT(ectx, zctx);
+
+	PHP_EVENT_INIT_CLASS_OBJECT(return_value, php_event_bevent_ce);
+	PHP_EVENT_FETCH_BEVENT(bev, return_value);
+
+	if (Z_TYPE_PP(ppzfd) == IS_NULL) {
+		/* User decided to set fd later via connect or connectHost etc.*/
+		fd = -1;
+	} else {
+		fd = php_event_zval_to_fd(ppzfd TSRMLS_CC);
+		if (fd < 0) {
+			RETURN_FALSE;
+		}
+		/* Make sure that the socket is in non-blocking mode(libevent's tip) */
+		/*evutil_make_socket_nonblocking(fd);*/
+	}
+
+	PHP_EVENT_ASSERT(ectx->ctx);
+	ssl = SSL_new(ectx->ctx);
+	if (!ssl) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING,
+				"Event: Failed creating SSL handle");
+		RETURN_FALSE;
+	}
+	/* Attach ectx to ssl for callbacks */
+	SSL_set_ex_data(ssl, php_event_ssl_data_index, ectx);
+
+	options = _bevent_opt_threadsafe(base, options);
+	bevent = bufferevent_openssl_socket_new(base->base, fd, ssl, state, options);
+	if (bevent == NULL) {
+		php_error_docref(NULL TSRMLS_CC, E_ERROR,
+				"Failed to allocate bufferevent filter");
+		RETURN_FALSE;
+	}
+	bev->bevent = bevent;
+	bev->lock = (options & BEV_OPT_THREADSAFE) ? 1 : 0;
+#ifdef PHP_EVENT_STATS
+	php_event_bevent_stats_attach(bev);
+#endif
+#ifdef PHP_EVENT_SSL_RECORD_SIZING
+	if (ectx->dynamic_records) {
+		php_event_bevent_record_sizing_attach(bev, PHP_EVENT_SSL_RECORD_SMALL,
+				PHP_EVENT_SSL_RECORD_BOOST_AFTER, PHP_EVENT_SSL_RECORD_IDLE);
+	}
+#endif
+
+	bev->self = return_value;
+	Z_ADDREF_P(return_value);
+
+	bev->base = zbase;
+	Z_ADDREF_P(zbase);
+}
+/* }}} */
+
+/* {{{ proto string EventBufferEvent::sslError(void);
+ *
+ * Returns most recent OpenSSL error reported on the buffer event. The function
+ * returns FALSE, if there is no more error to return. */
+PHP_METHOD(EventBufferEvent, sslError)
+{
+	zval               *zbevent  = getThis();
+	php_event_bevent_t *bev;
+	char                buf[512];
+	unsigned long       e;
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_BEVENT(bev, zbevent);
+	_ret_if_invalid_bevent_ptr(bev);
+
+	e = bufferevent_get_openssl_error(bev->bevent);
+	if (e) {
+		RETURN_STRING(ERR_error_string(e, buf), 1);
+	}
+
+	RETVAL_FALSE;
+}
+/* }}} */
+
+/* {{{ proto void EventBufferEvent::sslRenegotiate(void);
+ *
+ * Tells a bufferevent to begin SSL renegotiation.
+ *
+ * Warning. Calling this function tells the SSL to renegotiate, and the
+ * bufferevent to invoke appropriate callbacks. This is an advanced topic; you
+ * should generally avoid it unless you really know what you’re doing,
+ * especially since many SSL versions have had known security issues related to
+ * renegotiation.
+ **/
+PHP_METHOD(EventBufferEvent, sslRenegotiate)
+{
+	zval               *zbevent  = getThis();
+	php_event_bevent_t *bev;
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_BEVENT(bev, zbevent);
+	_ret_if_invalid_bevent_ptr(bev);
+
+	bufferevent_ssl_renegotiate(bev->bevent);
+}
+/* }}} */
+
+/* {{{ proto string EventBufferEvent::sslGetCipherInfo(void);
+ *
+ * Returns the current Cipher of the connexion as
+ * SSL_get_current_cipher/SSL_CIPHER_description do. Otherwise FALSE. */
+PHP_METHOD(EventBufferEvent, sslGetCipherInfo)
+{
+	zval               *zbevent = getThis();
+	php_event_bevent_t *bev;
+	struct ssl_st      *ssl;
+	char               *desc;
+	const SSL_CIPHER   *cipher;
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_BEVENT(bev, zbevent);
+	_ret_if_invalid_bevent_ptr(bev);
+
+	ssl = bufferevent_openssl_get_ssl(bev->bevent);
+	if (ssl) {
+		cipher = SSL_get_current_cipher(ssl);
+		if (cipher) {
+			desc = SSL_CIPHER_description(cipher, NULL, 128);
+			RETVAL_STRING(desc, 1);
+			OPENSSL_free(desc);
+			return;
+		}
+	}
+
+	RETVAL_FALSE;
+}
+/* }}} */
+
+/* {{{ proto string EventBufferEvent::sslGetCipherName(void);
+ *
+ * Returns the current Cipher Name of the connection as SSL_get_cipher_name does.
+ * returns FALSE, if there is no more error to return. */
+PHP_METHOD(EventBufferEvent, sslGetCipherName)
+{
+	zval               *zbevent = getThis();
+	php_event_bevent_t *bev;
+	struct ssl_st      *ssl;
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_BEVENT(bev, zbevent);
+	_ret_if_invalid_bevent_ptr(bev);
+
+	ssl = bufferevent_openssl_get_ssl(bev->bevent);
+	if (ssl) {
+		RETURN_STRING(SSL_get_cipher_name(ssl), 1);
+	}
+	RETVAL_FALSE;
+}
+/* }}} */
+
+/* {{{ proto string EventBufferEvent::sslGetCipherVersion(void);
+ *
+ * Returns the current cipher version of the connection as SSL_get_cipher_version does.
+ * returns FALSE, if there is no more error to return. */
+PHP_METHOD(EventBufferEvent, sslGetCipherVersion)
+{
+	zval               *zbevent  = getThis();
+	php_event_bevent_t *bev;
+	struct ssl_st      *ssl;
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_BEVENT(bev, zbevent);
+	_ret_if_invalid_bevent_ptr(bev);
+
+	ssl = bufferevent_openssl_get_ssl(bev->bevent);
+	if (ssl) {
+		RETURN_STRING(SSL_get_cipher_version(ssl), 1);
+	}
+	RETVAL_FALSE;
+}
+/* }}} */
+
+/* {{{ proto string EventBufferEvent::sslGetProtocol(void);
+ *
+ * Returns the current Protocol of the connection as SSL_get_version does,
+ * otherwise FALSE. */
+PHP_METHOD(EventBufferEvent, sslGetProtocol)
+{
+	zval               *zbevent = getThis();
+	php_event_bevent_t *bev;
+	struct ssl_st      *ssl;
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_BEVENT(bev, zbevent);
+	_ret_if_invalid_bevent_ptr(bev);
+
+	ssl = bufferevent_openssl_get_ssl(bev->bevent);
 	if (ssl) {
 		RETURN_STRING(SSL_get_version(ssl), 1);
 	}
@@ -1376,6 +2616,307 @@ PHP_METHOD(EventBufferEvent, sslGetProtocol)
 }
 /* }}} */
 
+/* {{{ proto string EventBufferEvent::sslGetSession(void);
+ *
+ * Returns the SSL session of the connection serialized in DER format,
+ * otherwise FALSE. The string may be passed to sslSetSession() to resume the
+ * session in another connection. */
+PHP_METHOD(EventBufferEvent, sslGetSession)
+{
+	zval               *zbevent = getThis();
+	php_event_bevent_t *bev;
+	struct ssl_st      *ssl;
+	SSL_SESSION        *session;
+	char               *buf;
+	unsigned char      *p;
+	int                 len;
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_BEVENT(bev, zbevent);
+	_ret_if_invalid_bevent_ptr(bev);
+
+	ssl = bufferevent_openssl_get_ssl(bev->bevent);
+	if (!ssl || (session = SSL_get1_session(ssl)) == NULL) {
+		RETURN_FALSE;
+	}
+
+	len = i2d_SSL_SESSION(session, NULL);
+	if (len <= 0) {
+		SSL_SESSION_free(session);
+		RETURN_FALSE;
+	}
+
+	buf = emalloc(len + 1);
+	p   = (unsigned char *) buf;
+	i2d_SSL_SESSION(session, &p);
+	buf[len] = '\0';
+
+	SSL_SESSION_free(session);
+
+	RETVAL_STRINGL(buf, len, 0);
+}
+/* }}} */
+
+/* {{{ proto bool EventBufferEvent::sslSetSession(string session);
+ *
+ * Sets the session to resume, when the client connection performs the
+ * handshake. session is a string returned by sslGetSession(). */
+PHP_METHOD(EventBufferEvent, sslSetSession)
+{
+	zval                *zbevent = getThis();
+	php_event_bevent_t  *bev;
+	struct ssl_st       *ssl;
+	SSL_SESSION         *session;
+	char                *data;
+	int                  data_len;
+	const unsigned char *p;
+	int                  res;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "s",
+				&data, &data_len) == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_BEVENT(bev, zbevent);
+	_ret_if_invalid_bevent_ptr(bev);
+
+	ssl = bufferevent_openssl_get_ssl(bev->bevent);
+	if (!ssl) {
+		RETURN_FALSE;
+	}
+
+	p       = (const unsigned char *) data;
+	session = d2i_SSL_SESSION(NULL, &p, (long) data_len);
+	if (session == NULL) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "Failed to decode SSL session");
+		RETURN_FALSE;
+	}
+
+	res = SSL_set_session(ssl, session);
+	SSL_SESSION_free(session);
+
+	RETVAL_BOOL(res == 1);
+}
+/* }}} */
+
+/* {{{ proto bool EventBufferEvent::sslSessionReused(void);
+ *
+ * Returns TRUE, if the handshake of the connection resumed a session. */
+PHP_METHOD(EventBufferEvent, sslSessionReused)
+{
+	zval               *zbevent = getThis();
+	php_event_bevent_t *bev;
+	struct ssl_st      *ssl;
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_BEVENT(bev, zbevent);
+	_ret_if_invalid_bevent_ptr(bev);
+
+	ssl = bufferevent_openssl_get_ssl(bev->bevent);
+	RETVAL_BOOL(ssl && SSL_session_reused(ssl));
+}
+/* }}} */
+
+/* {{{ proto array EventBufferEvent::sslGetKtlsStatus(void);
+ *
+ * Returns whether kernel TLS is active on the connection for sending and
+ * receiving, as array('send' => bool, 'recv' => bool). Both are FALSE, if the
+ * kernel, or the OpenSSL library doesn't support kTLS, or the context has no
+ * EventSslContext::OPT_KTLS option. Returns FALSE, if the buffer event is not
+ * an SSL buffer event. */
+PHP_METHOD(EventBufferEvent, sslGetKtlsStatus)
+{
+	zval               *zbevent = getThis();
+	php_event_bevent_t *bev;
+	struct ssl_st      *ssl;
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_BEVENT(bev, zbevent);
+	_ret_if_invalid_bevent_ptr(bev);
+
+	ssl = bufferevent_openssl_get_ssl(bev->bevent);
+	if (!ssl) {
+		RETURN_FALSE;
+	}
+
+	array_init(return_value);
+#ifdef PHP_EVENT_KTLS
+	add_assoc_bool(return_value, "send", SSL_get_wbio(ssl) && BIO_get_ktls_send(SSL_get_wbio(ssl)));
+	add_assoc_bool(return_value, "recv", SSL_get_rbio(ssl) && BIO_get_ktls_recv(SSL_get_rbio(ssl)));
+#else
+	add_assoc_bool(return_value, "send", 0);
+	add_assoc_bool(return_value, "recv", 0);
+#endif
+}
+/* }}} */
+
+#ifdef PHP_EVENT_KTLS
+/* {{{ proto int EventBufferEvent::sslSendfile(mixed fd, int offset, int length);
+ *
+ * Sends length bytes of the file fd starting at offset with sendfile(2),
+ * while the kernel encrypts the records. Requires active kTLS sending (see
+ * sslGetKtlsStatus()), and empty output buffer. Returns the number of bytes
+ * sent, 0 if the socket is not writable, or FALSE on error. */
+PHP_METHOD(EventBufferEvent, sslSendfile)
+{
+	zval               *zbevent = getThis();
+	php_event_bevent_t *bev;
+	struct ssl_st      *ssl;
+	zval               *zfd;
+	long                offset;
+	long                length;
+	php_socket_t        fd;
+	ossl_ssize_t        res;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "zll",
+				&zfd, &offset, &length) == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_BEVENT(bev, zbevent);
+	_ret_if_invalid_bevent_ptr(bev);
+
+	if (offset < 0 || length <= 0) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "Invalid file range");
+		RETURN_FALSE;
+	}
+
+	ssl = bufferevent_openssl_get_ssl(bev->bevent);
+	if (!ssl || !SSL_get_wbio(ssl) || !BIO_get_ktls_send(SSL_get_wbio(ssl))) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "Kernel TLS sending is not active");
+		RETURN_FALSE;
+	}
+
+	/* The file data must not overtake the buffered records */
+	if (evbuffer_get_length(bufferevent_get_output(bev->bevent))) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "Output buffer is not empty");
+		RETURN_FALSE;
+	}
+
+	fd = php_event_zval_to_fd(&zfd TSRMLS_CC);
+	if (fd < 0) {
+		RETURN_FALSE;
+	}
+
+	res = SSL_sendfile(ssl, (int) fd, (off_t) offset, (size_t) length, 0);
+	if (res < 0) {
+		if (SSL_get_error(ssl, (int) res) == SSL_ERROR_WANT_WRITE) {
+			ERR_clear_error();
+			RETURN_LONG(0);
+		}
+		RETURN_FALSE;
+	}
+
+	RETVAL_LONG((long) res);
+}
+/* }}} */
+#endif
+
+#ifdef PHP_EVENT_SSL_ALPN
+/* {{{ proto string EventBufferEvent::sslGetAlpnProtocol(void);
+ *
+ * Returns the application protocol negotiated with ALPN(see
+ * EventSslContext::OPT_ALPN_PROTOCOLS), or NULL, if no protocol is negotiated
+ * (yet). Returns FALSE, if the buffer event is not an SSL buffer event. */
+PHP_METHOD(EventBufferEvent, sslGetAlpnProtocol)
+{
+	zval                *zbevent   = getThis();
+	php_event_bevent_t  *bev;
+	SSL                 *ssl;
+	const unsigned char *proto     = NULL;
+	unsigned int         proto_len = 0;
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_BEVENT(bev, zbevent);
+	_ret_if_invalid_bevent_ptr(bev);
+
+	ssl = bufferevent_openssl_get_ssl(bev->bevent);
+	if (!ssl) {
+		RETURN_FALSE;
+	}
+
+	SSL_get0_alpn_selected(ssl, &proto, &proto_len);
+	if (proto == NULL || proto_len == 0) {
+		RETURN_NULL();
+	}
+
+	RETVAL_STRINGL((const char *) proto, proto_len, 1);
+}
+/* }}} */
+#endif
+
+#ifdef PHP_EVENT_SSL_RECORD_SIZING
+/* {{{ proto bool EventBufferEvent::setDynamicRecordSizing([int small_size = 1400[, int boost_after = 1048576[, float idle = 1.0]]]);
+ *
+ * Sends TLS records carrying at most small_size bytes, until boost_after bytes
+ * are written. Then the records grow to the maximum(16384 bytes). When no data
+ * is written for idle seconds, the records are small again. Small records let
+ * the peer process the first bytes of a response early, large records cut the
+ * overhead of bulk transfers. Zero small_size turns it off.
+ *
+ * Returns FALSE, if the buffer event is not an SSL buffer event. */
+PHP_METHOD(EventBufferEvent, setDynamicRecordSizing)
+{
+	zval               *zbevent     = getThis();
+	php_event_bevent_t *bev;
+	long                small_size  = PHP_EVENT_SSL_RECORD_SMALL;
+	long                boost_after = PHP_EVENT_SSL_RECORD_BOOST_AFTER;
+	double              idle        = PHP_EVENT_SSL_RECORD_IDLE;
+	SSL                *ssl;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "|lld",
+				&small_size, &boost_after, &idle) == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_BEVENT(bev, zbevent);
+	_ret_if_invalid_bevent_ptr(bev);
+
+	ssl = bufferevent_openssl_get_ssl(bev->bevent);
+	if (!ssl) {
+		RETURN_FALSE;
+	}
+
+	if (small_size == 0) {
+		php_event_bevent_record_sizing_detach(bev);
+		SSL_set_max_send_fragment(ssl, SSL3_RT_MAX_PLAIN_LENGTH);
+		RETURN_TRUE;
+	}
+
+	if (small_size < 512 || small_size > SSL3_RT_MAX_PLAIN_LENGTH) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING,
+				"Expected 512 <= small_size <= %d", SSL3_RT_MAX_PLAIN_LENGTH);
+		RETURN_FALSE;
+	}
+
+	if (boost_after < 0 || idle < 0) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING,
+				"Expected non-negative boost_after and idle");
+		RETURN_FALSE;
+	}
+
+	if (php_event_bevent_record_sizing_attach(bev, (size_t) small_size,
+				(size_t) boost_after, idle) == FAILURE) {
+		RETURN_FALSE;
+	}
+
+	RETVAL_TRUE;
+}
+/* }}} */
+#endif
+
 #endif /* HAVE_EVENT_OPENSSL_LIB }}} */
 
 /*
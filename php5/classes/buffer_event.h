@@ -0,0 +1,40 @@
+/*
+   +----------------------------------------------------------------------+
+   | PHP Version 5                                                        |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 1997-2016 The PHP Group                                |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+   | Author: Ruslan Osmanov <osmanov@php.net>                             |
+   +----------------------------------------------------------------------+
+*/
+
+#ifndef PHP_EVENT_BUFFER_EVENT_H
+#define PHP_EVENT_BUFFER_EVENT_H
+
+int php_event_bevent_from_template(zval *zbev, zval *zbase, evutil_socket_t fd, php_event_bevent_template_t *t, php_event_conn_counter_t *conns TSRMLS_DC);
+void php_event_bevent_template_free(php_event_bevent_template_t *t);
+
+php_event_conn_counter_t *php_event_conn_counter_new(void *owner, void (*on_close)(php_event_conn_counter_t *c));
+void php_event_conn_counter_release(php_event_conn_counter_t *c);
+void php_event_bevent_conn_closed(php_event_bevent_t *bev);
+#ifdef PHP_EVENT_FD_PASSING
+void php_event_bevent_fdpass_free(php_event_bevent_t *bev);
+#endif
+
+#endif /* PHP_EVENT_BUFFER_EVENT_H */
+/*
+ * Local variables:
+ * tab-width: 4
+ * c-basic-offset: 4
+ * End:
+ * vim600: noet sw=4 ts=4 sts=4 fdm=marker
+ * vim<600: noet sw=4 ts=4 sts=4
+ */
@@ -151,6 +151,7 @@ PHP_METHOD(EventConfig, setFlags)
 	PHP_EVENT_FETCH_CONFIG(cfg, zcfg);
 
 	if (!event_config_set_flag(cfg->ptr, flags)) {
+		cfg->flags |= flags;
 		RETURN_TRUE;
 	}
 
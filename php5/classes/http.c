@@ -41,7 +41,8 @@ static zend_always_inline php_event_http_cb_t *_new_http_cb(zval *zbase, zval *z
 
 	TSRMLS_SET_CTX(cb->thread_ctx);
 
-	cb->next = NULL;
+	cb->methods = 0;
+	cb->next    = NULL;
 
 	return cb;
 }
@@ -197,11 +198,20 @@ static void _http_default_callback(struct evhttp_request *req, void *arg)
  */
 static struct bufferevent* _bev_ssl_callback(struct event_base *base, void *arg) {
 	struct bufferevent* bev;
-	SSL_CTX *ctx = (SSL_CTX *) arg;
+	php_event_ssl_context_t *ectx = (php_event_ssl_context_t *) arg;
+	SSL *ssl;
+
+	/* The current SSL_CTX, which EventSslContext::reload() may replace */
+	ssl = SSL_new(ectx->ctx);
+	if (ssl == NULL) {
+		return NULL;
+	}
+	/* Attach ectx to ssl for callbacks */
+	SSL_set_ex_data(ssl, php_event_ssl_data_index, ectx);
 
 	bev = bufferevent_openssl_socket_new(base,
 			-1,
-			SSL_new(ctx),
+			ssl,
 			BUFFEREVENT_SSL_ACCEPTING,
 			BEV_OPT_CLOSE_ON_FREE);
 	return bev;
@@ -209,6 +219,354 @@ static struct bufferevent* _bev_ssl_callback(struct event_base *base, void *arg)
 /*}}}*/
 #endif
 
+/* Maximum number of {param} segments in a route pattern */
+#define PHP_EVENT_HTTP_ROUTE_MAX_PARAMS 32
+
+/* State of matching a request path against the routing tree */
+typedef struct {
+	int       cmd;      /* Command(method) of the request                 */
+	zend_bool mismatch; /* A route matches the path, but not the method   */
+	int       nparams;
+	struct {
+		const char *name;
+		size_t      name_len;
+		char       *val;
+		size_t      len;
+	} params[PHP_EVENT_HTTP_ROUTE_MAX_PARAMS + 1]; /* + the remainder of a prefix route */
+} php_event_http_route_match_t;
+
+/* {{{ _http_route_new */
+static zend_always_inline php_event_http_route_t *_http_route_new(void)
+{
+	return ecalloc(1, sizeof(php_event_http_route_t));
+}
+/* }}} */
+
+/* {{{ _http_route_child_dtor */
+static void _http_route_child_dtor(void *data)
+{
+	_php_event_free_http_route(*(php_event_http_route_t **) data);
+}
+/* }}} */
+
+/* {{{ _http_route_add
+ * Adds a route to the tree of the HTTP server. Pattern segments are static
+ * strings, {name} parameters matching any non-empty segment, or a trailing *
+ * matching the rest of the path. */
+static int _http_route_add(php_event_http_t *http, const char *pattern, size_t pattern_len, long methods, const zend_fcall_info *fci, const zend_fcall_info_cache *fcc, zval *zarg TSRMLS_DC)
+{
+	php_event_http_route_t  *node;
+	php_event_http_route_t  *child;
+	php_event_http_route_t **pchild;
+	php_event_http_cb_t    **list;
+	php_event_http_cb_t     *cb;
+	char                    *segment;
+	const char              *p       = pattern;
+	const char              *end     = pattern + pattern_len;
+	const char              *seg_end;
+	size_t                   len;
+	int                      nparams = 0;
+
+	if (pattern_len == 0 || *pattern != '/') {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "Route pattern must start with '/'");
+		return FAILURE;
+	}
+
+	if (!http->routes) {
+		http->routes = _http_route_new();
+	}
+	node = http->routes;
+	list = &node->handlers;
+
+	while (p < end) {
+		if (*p == '/') {
+			p++;
+			continue;
+		}
+
+		seg_end = memchr(p, '/', end - p);
+		if (seg_end == NULL) {
+			seg_end = end;
+		}
+		len = seg_end - p;
+
+		if (len == 1 && *p == '*') {
+			if (seg_end != end) {
+				php_error_docref(NULL TSRMLS_CC, E_WARNING, "'*' is allowed only at the end of a route pattern");
+				return FAILURE;
+			}
+			list = &node->prefix;
+			break;
+		}
+
+		if (*p == '{') {
+			if (len < 3 || p[len - 1] != '}'
+					|| memchr(p + 1, '{', len - 2) || memchr(p + 1, '}', len - 2)) {
+				php_error_docref(NULL TSRMLS_CC, E_WARNING, "Invalid route parameter: %.*s", (int) len, p);
+				return FAILURE;
+			}
+			if (++nparams > PHP_EVENT_HTTP_ROUTE_MAX_PARAMS) {
+				php_error_docref(NULL TSRMLS_CC, E_WARNING, "At most %d route parameters are allowed",
+						PHP_EVENT_HTTP_ROUTE_MAX_PARAMS);
+				return FAILURE;
+			}
+
+			if (!node->param) {
+				node->param           = _http_route_new();
+				node->param->name     = estrndup(p + 1, len - 2);
+				node->param->name_len = len - 2;
+			} else if (node->param->name_len != len - 2 || memcmp(node->param->name, p + 1, len - 2)) {
+				php_error_docref(NULL TSRMLS_CC, E_WARNING, "Route parameter %.*s conflicts with {%s} of another route",
+						(int) len, p, node->param->name);
+				return FAILURE;
+			}
+			node = node->param;
+		} else {
+			if (memchr(p, '{', len) || memchr(p, '}', len) || memchr(p, '*', len)) {
+				php_error_docref(NULL TSRMLS_CC, E_WARNING, "Invalid route segment: %.*s", (int) len, p);
+				return FAILURE;
+			}
+
+			if (!node->children) {
+				ALLOC_HASHTABLE(node->children);
+				zend_hash_init(node->children, 8, NULL, _http_route_child_dtor, 0);
+			}
+
+			segment = estrndup(p, len);
+			if (zend_hash_find(node->children, segment, len + 1, (void **) &pchild) == SUCCESS) {
+				child = *pchild;
+			} else {
+				child = _http_route_new();
+				zend_hash_add(node->children, segment, len + 1, (void *) &child, sizeof(child), NULL);
+			}
+			efree(segment);
+			node = child;
+		}
+
+		list = &node->handlers;
+		p    = seg_end;
+	}
+
+	for (; *list; list = &(*list)->next) {
+		if ((*list)->methods == methods) {
+			php_error_docref(NULL TSRMLS_CC, E_WARNING, "The route already exists");
+			return FAILURE;
+		}
+	}
+
+	cb          = _new_http_cb(http->base, zarg, fci, fcc TSRMLS_CC);
+	cb->methods = (int) methods;
+	*list       = cb;
+
+	return SUCCESS;
+}
+/* }}} */
+
+/* {{{ _http_route_handler
+ * Returns the first route of the list accepting the request method */
+static zend_always_inline php_event_http_cb_t *_http_route_handler(php_event_http_cb_t *cb, php_event_http_route_match_t *m)
+{
+	for (; cb; cb = cb->next) {
+		if (!cb->methods || (cb->methods & m->cmd)) {
+			return cb;
+		}
+		m->mismatch = 1;
+	}
+
+	return NULL;
+}
+/* }}} */
+
+/* {{{ _http_route_match
+ * Matches the path(without the leading slash) against the subtree. Static
+ * segments take precedence over parameters, and parameters over prefixes.
+ * The cost depends on the number of path segments, not on the number of routes. */
+static php_event_http_cb_t *_http_route_match(php_event_http_route_t *node, char *path, php_event_http_route_match_t *m)
+{
+	php_event_http_route_t **pchild;
+	php_event_http_cb_t     *cb;
+	char                    *end;
+	char                    *next;
+	char                     saved;
+	size_t                   len;
+	int                      nparams = m->nparams;
+
+	if (*path == '\0') {
+		if ((cb = _http_route_handler(node->handlers, m)) != NULL) {
+			return cb;
+		}
+	} else {
+		end = strchr(path, '/');
+		if (end == NULL) {
+			end = path + strlen(path);
+		}
+		len  = end - path;
+		next = *end ? end + 1 : end;
+
+		if (node->children) {
+			/* The hash keys are NUL-terminated */
+			saved = *end;
+			*end  = '\0';
+			if (zend_hash_find(node->children, path, len + 1, (void **) &pchild) != SUCCESS) {
+				pchild = NULL;
+			}
+			*end = saved;
+
+			if (pchild && (cb = _http_route_match(*pchild, next, m)) != NULL) {
+				return cb;
+			}
+			m->nparams = nparams;
+		}
+
+		if (node->param && len) {
+			m->params[nparams].name     = node->param->name;
+			m->params[nparams].name_len = node->param->name_len;
+			m->params[nparams].val      = path;
+			m->params[nparams].len      = len;
+			m->nparams++;
+
+			if ((cb = _http_route_match(node->param, next, m)) != NULL) {
+				return cb;
+			}
+			m->nparams = nparams;
+		}
+	}
+
+	if (node->prefix && (cb = _http_route_handler(node->prefix, m)) != NULL) {
+		m->params[nparams].name     = "*";
+		m->params[nparams].name_len = 1;
+		m->params[nparams].val      = path;
+		m->params[nparams].len      = strlen(path);
+		m->nparams++;
+		return cb;
+	}
+
+	return NULL;
+}
+/* }}} */
+
+/* {{{ _http_route_callback
+ * Generic callback of an HTTP server with routes. Passes the request to the
+ * matching route, otherwise to the default callback. */
+static void _http_route_callback(struct evhttp_request *req, void *arg)
+{
+	php_event_http_t             *http       = (php_event_http_t *) arg;
+	php_event_http_route_match_t  m;
+	php_event_http_cb_t          *cb         = NULL;
+	const struct evhttp_uri      *uri;
+	const char                   *uri_path;
+	char                         *path;
+	char                         *decoded;
+	size_t                        decoded_len;
+	int                           i;
+	php_event_base_t             *b;
+	php_event_http_req_t         *http_req;
+	zend_fcall_info              *pfci;
+	zend_fcall_info_cache        *pfcc;
+	zval                         *arg_data;
+	zval                         *arg_req;
+	zval                         *arg_params;
+	zval                        **args[3];
+	zval                         *retval_ptr = NULL;
+	PHP_EVENT_TSRM_DECL
+
+	PHP_EVENT_ASSERT(http);
+
+	PHP_EVENT_TSRMLS_FETCH_FROM_CTX(http->thread_ctx);
+
+	uri      = evhttp_request_get_evhttp_uri(req);
+	uri_path = uri ? evhttp_uri_get_path(uri) : NULL;
+	if (uri_path == NULL) {
+		uri_path = "";
+	} else if (*uri_path == '/') {
+		uri_path++;
+	}
+	path = estrdup(uri_path);
+
+	m.cmd      = evhttp_request_get_command(req);
+	m.mismatch = 0;
+	m.nparams  = 0;
+
+	if (http->routes) {
+		cb = _http_route_match(http->routes, path, &m);
+	}
+
+	if (cb == NULL) {
+		efree(path);
+
+		if (m.mismatch) {
+			evhttp_send_error(req, HTTP_BADMETHOD, NULL);
+		} else if (http->fci) {
+			_http_default_callback(req, arg);
+		} else {
+			evhttp_send_error(req, HTTP_NOTFOUND, NULL);
+		}
+		return;
+	}
+
+	pfci = cb->fci;
+	pfcc = cb->fcc;
+	PHP_EVENT_ASSERT(pfci && pfcc);
+
+	/* Call userspace function according to
+	 * proto void callback(EventHttpRequest req, mixed data, array params);*/
+
+	arg_data = cb->data;
+
+	MAKE_STD_ZVAL(arg_req);
+	PHP_EVENT_INIT_CLASS_OBJECT(arg_req, php_event_http_req_ce);
+	PHP_EVENT_FETCH_HTTP_REQ(http_req, arg_req);
+	http_req->ptr = req;
+	args[0] = &arg_req;
+
+	if (arg_data) {
+		Z_ADDREF_P(arg_data);
+	} else {
+		ALLOC_INIT_ZVAL(arg_data);
+	}
+	args[1] = &arg_data;
+
+	MAKE_STD_ZVAL(arg_params);
+	array_init(arg_params);
+	for (i = 0; i < m.nparams; i++) {
+		/* Parameters are ordered, so the terminator only overwrites a separator */
+		m.params[i].val[m.params[i].len] = '\0';
+		decoded = evhttp_uridecode(m.params[i].val, 0, &decoded_len);
+		if (decoded) {
+			add_assoc_stringl_ex(arg_params, m.params[i].name, m.params[i].name_len + 1,
+					decoded, decoded_len, 1);
+			free(decoded);
+		}
+	}
+	efree(path);
+	args[2] = &arg_params;
+
+	pfci->params		 = args;
+	pfci->retval_ptr_ptr = &retval_ptr;
+	pfci->param_count	 = 3;
+	pfci->no_separation  = 1;
+
+	if (zend_call_function(pfci, pfcc TSRMLS_CC) == SUCCESS) {
+		if (retval_ptr) {
+			zval_ptr_dtor(&retval_ptr);
+		}
+	} else {
+		if (EG(exception)) {
+			PHP_EVENT_ASSERT(cb->base);
+			PHP_EVENT_FETCH_BASE(b, cb->base);
+			event_base_loopbreak(b->base);
+		} else {
+			php_error_docref(NULL TSRMLS_CC, E_WARNING,
+					"An error occurred while invoking the http route callback");
+		}
+	}
+
+	zval_ptr_dtor(&arg_req);
+	zval_ptr_dtor(&arg_data);
+	zval_ptr_dtor(&arg_params);
+}
+/* }}} */
+
 /* }}} */
 
 /* {{{  _php_event_free_http_cb */
@@ -229,6 +587,37 @@ void _php_event_free_http_cb(php_event_http_cb_t *cb)
 }
 /* }}} */
 
+/* {{{ _php_event_free_http_route
+ * Frees a node of the routing tree together with its subtree and routes */
+void _php_event_free_http_route(php_event_http_route_t *node)
+{
+	php_event_http_cb_t *cb;
+	php_event_http_cb_t *cb_next;
+
+	if (node->children) {
+		zend_hash_destroy(node->children);
+		FREE_HASHTABLE(node->children);
+	}
+	if (node->param) {
+		_php_event_free_http_route(node->param);
+	}
+	if (node->name) {
+		efree(node->name);
+	}
+
+	for (cb = node->handlers; cb; cb = cb_next) {
+		cb_next = cb->next;
+		_php_event_free_http_cb(cb);
+	}
+	for (cb = node->prefix; cb; cb = cb_next) {
+		cb_next = cb->next;
+		_php_event_free_http_cb(cb);
+	}
+
+	efree(node);
+}
+/* }}} */
+
 /* {{{ proto EventHttp EventHttp::__construct(EventBase base[, EventSslContext ctx = NULL]);
  * Creates new http server object.
  */
@@ -276,6 +665,7 @@ PHP_METHOD(EventHttp, __construct)
 	http->fcc     = NULL;
 	http->data    = NULL;
 	http->cb_head = NULL;
+	http->routes  = NULL;
 
 	TSRMLS_SET_CTX(http->thread_ctx);
 
@@ -283,7 +673,9 @@ PHP_METHOD(EventHttp, __construct)
 	if (zctx) {
 		PHP_EVENT_FETCH_SSL_CONTEXT(ectx, zctx);
 		PHP_EVENT_ASSERT(ectx->ctx);
-		evhttp_set_bevcb(http_ptr, _bev_ssl_callback, ectx->ctx);
+		Z_ADDREF_P(zctx);
+		http->ctx = zctx;
+		evhttp_set_bevcb(http_ptr, _bev_ssl_callback, ectx);
 	}
 #endif
 }
@@ -416,6 +808,48 @@ PHP_METHOD(EventHttp, setCallback)
 }
 /* }}} */
 
+/* {{{ proto bool EventHttp::route(string pattern, callable cb[, int methods = 0[, mixed arg = NULL]]);
+ * Adds a route to the routing tree of the server. Pattern segments match
+ * exactly, except for {name} segments, which match any non-empty segment, and
+ * a trailing *, which matches the rest of the path. The callback receives an
+ * array of the parameter values(the rest of the path under '*' key) after
+ * arg. methods is a mask of EventHttpRequest::CMD_* constants, or 0 for any
+ * method. Callbacks set with setCallback() take precedence over the routes,
+ * the default callback gets the requests no route matches.
+ */
+PHP_METHOD(EventHttp, route)
+{
+	zval                  *zhttp       = getThis();
+	php_event_http_t      *http;
+	char                  *pattern;
+	int                    pattern_len;
+	zend_fcall_info        fci         = empty_fcall_info;
+	zend_fcall_info_cache  fcc         = empty_fcall_info_cache;
+	long                   methods     = 0;
+	zval                  *zarg        = NULL;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "sf|lz!",
+				&pattern, &pattern_len, &fci, &fcc, &methods, &zarg) == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_HTTP(http, zhttp);
+
+	if (methods < 0) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "methods must not be negative");
+		RETURN_FALSE;
+	}
+
+	if (_http_route_add(http, pattern, (size_t) pattern_len, methods, &fci, &fcc, zarg TSRMLS_CC) == FAILURE) {
+		RETURN_FALSE;
+	}
+
+	evhttp_set_gencb(http->ptr, _http_route_callback, (void *) http);
+
+	RETVAL_TRUE;
+}
+/* }}} */
+
 /* {{{ proto void EventHttp::setDefaultCallback(callable cb[, mixed arg = NULL]);
  * Sets default callback to handle requests that are not caught by specific callbacks
  */
@@ -444,7 +878,7 @@ PHP_METHOD(EventHttp, setDefaultCallback)
 	}
 	http->data = zarg;
 
-	evhttp_set_gencb(http->ptr, _http_default_callback, (void *) http);
+	evhttp_set_gencb(http->ptr, http->routes ? _http_route_callback : _http_default_callback, (void *) http);
 }
 /* }}} */
 
@@ -21,6 +21,7 @@
 #ifdef HAVE_EVENT_EXTRA_LIB
 
 void _php_event_free_http_cb(php_event_http_cb_t *cb);
+void _php_event_free_http_route(php_event_http_route_t *node);
 
 #endif /* HAVE_EVENT_EXTRA_LIB */
 #endif /* PHP_EVENT_HTTP_H */
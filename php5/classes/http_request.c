@@ -420,6 +420,8 @@ PHP_METHOD(EventHttpRequest, getBufferEvent)
 	bev->input = NULL;
 	bev->output = NULL;
 	bev->_internal = 1;
+	/* We don't know how libevent created it */
+	bev->lock = 1;
 }
 /* }}} */
 #endif
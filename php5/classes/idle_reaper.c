@@ -0,0 +1,449 @@
+/*
+   +----------------------------------------------------------------------+
+   | PHP Version 5                                                        |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 1997-2016 The PHP Group                                |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+   | Author: Ruslan Osmanov <osmanov@php.net>                             |
+   +----------------------------------------------------------------------+
+*/
+#include "../src/common.h"
+#include "../src/util.h"
+#include "../src/priv.h"
+#include "zend_exceptions.h"
+#include "idle_reaper.h"
+
+/* {{{ Private */
+
+#define _ret_if_invalid_reaper_ptr(r)                   \
+{                                                       \
+	if (!(r)->timer) {                                  \
+		php_error_docref(NULL TSRMLS_CC, E_WARNING,     \
+				"Idle reaper is not initialized");      \
+		RETURN_FALSE;                                   \
+	}                                                   \
+}
+
+/* Returns the bufferevent object owning the wheel entry */
+#define _idle_entry_bevent(e) \
+	((php_event_bevent_t *)((char *)(e) - XtOffsetOf(php_event_bevent_t, idle)))
+
+/* Tick at which an entry expires, if there is no activity since the tick of
+ * the last activity. One extra tick makes the idle period a lower bound. */
+#define _idle_entry_deadline(e) ((e)->tick + PHP_EVENT_IDLE_REAPER_TICKS + 1)
+
+static zend_always_inline void _idle_list_init(php_event_idle_entry_t *head)/*{{{*/
+{
+	head->prev = head->next = head;
+}/*}}}*/
+
+static zend_always_inline void _idle_list_append(php_event_idle_entry_t *head, php_event_idle_entry_t *e)/*{{{*/
+{
+	e->prev          = head->prev;
+	e->next          = head;
+	head->prev->next = e;
+	head->prev       = e;
+}/*}}}*/
+
+static zend_always_inline void _idle_list_remove(php_event_idle_entry_t *e)/*{{{*/
+{
+	e->prev->next = e->next;
+	e->next->prev = e->prev;
+	e->prev       = e->next = NULL;
+}/*}}}*/
+
+static zend_always_inline void _idle_schedule(php_event_idle_reaper_t *r, php_event_idle_entry_t *e)/*{{{*/
+{
+	_idle_list_append(&r->slots[_idle_entry_deadline(e) % PHP_EVENT_IDLE_REAPER_SLOTS], e);
+}/*}}}*/
+
+/* {{{ _idle_input_cb
+ * Marks the entry active, when data arrives in the input buffer. Only stores
+ * the current tick; the entry is moved lazily when its slot expires. */
+static void _idle_input_cb(struct evbuffer *buf, const struct evbuffer_cb_info *info, void *arg)
+{
+	php_event_idle_entry_t *e = (php_event_idle_entry_t *) arg;
+
+	if (info->n_added && e->reaper) {
+		e->tick = e->reaper->tick;
+	}
+}
+/* }}} */
+
+/* {{{ _idle_output_cb
+ * Marks the entry active, when data leaves the output buffer */
+static void _idle_output_cb(struct evbuffer *buf, const struct evbuffer_cb_info *info, void *arg)
+{
+	php_event_idle_entry_t *e = (php_event_idle_entry_t *) arg;
+
+	if (info->n_deleted && e->reaper) {
+		e->tick = e->reaper->tick;
+	}
+}
+/* }}} */
+
+/* {{{ _idle_detach
+ * Removes the entry from the wheel. Disarms the timer, if there is nothing to watch. */
+static void _idle_detach(php_event_idle_entry_t *e)
+{
+	php_event_idle_reaper_t *r   = e->reaper;
+	php_event_bevent_t      *bev = _idle_entry_bevent(e);
+
+	PHP_EVENT_ASSERT(r);
+
+	_idle_list_remove(e);
+
+	if (bev->bevent) {
+		if (e->input_cb) {
+			evbuffer_remove_cb_entry(bufferevent_get_input(bev->bevent), e->input_cb);
+		}
+		if (e->output_cb) {
+			evbuffer_remove_cb_entry(bufferevent_get_output(bev->bevent), e->output_cb);
+		}
+	}
+	e->input_cb  = NULL;
+	e->output_cb = NULL;
+	e->reaper    = NULL;
+
+	if (--r->count == 0 && r->timer) {
+		event_del(r->timer);
+	}
+}
+/* }}} */
+
+/* {{{ _idle_invoke
+ * Invokes the idle callback for bev */
+static void _idle_invoke(php_event_idle_reaper_t *r, php_event_bevent_t *bev TSRMLS_DC)
+{
+	zend_fcall_info   *pfci       = r->fci;
+	zval              *arg_data   = r->data;
+	zval              *arg_bev    = bev->self;
+	zval             **args[2];
+	zval              *retval_ptr = NULL;
+	php_event_base_t  *b;
+
+	if (!pfci || !ZEND_FCI_INITIALIZED(*pfci)) {
+		return;
+	}
+
+	if (arg_bev) {
+		Z_ADDREF_P(arg_bev);
+	} else {
+		ALLOC_INIT_ZVAL(arg_bev);
+	}
+	args[0] = &arg_bev;
+
+	if (arg_data) {
+		Z_ADDREF_P(arg_data);
+	} else {
+		ALLOC_INIT_ZVAL(arg_data);
+	}
+	args[1] = &arg_data;
+
+	/* Prepare callback */
+	pfci->params         = args;
+	pfci->retval_ptr_ptr = &retval_ptr;
+	pfci->param_count    = 2;
+	pfci->no_separation  = 1;
+
+	if (zend_call_function(pfci, r->fcc TSRMLS_CC) == SUCCESS && retval_ptr) {
+		zval_ptr_dtor(&retval_ptr);
+	} else {
+		if (EG(exception)) {
+			PHP_EVENT_ASSERT(r->base);
+			PHP_EVENT_FETCH_BASE(b, r->base);
+			event_base_loopbreak(b->base);
+		} else {
+			php_error_docref(NULL TSRMLS_CC, E_WARNING,
+					"An error occurred while invoking the idle callback");
+		}
+	}
+
+	zval_ptr_dtor(&arg_bev);
+	zval_ptr_dtor(&arg_data);
+}
+/* }}} */
+
+/* {{{ _idle_tick_cb
+ * Advances the wheel by one tick. The entries of the current slot are either
+ * re-slotted according to the tick of their last activity, or reaped. */
+static void _idle_tick_cb(evutil_socket_t fd, short what, void *arg)
+{
+	php_event_idle_reaper_t *r    = (php_event_idle_reaper_t *) arg;
+	php_event_idle_entry_t  *slot;
+	php_event_idle_entry_t  *e;
+	PHP_EVENT_TSRM_DECL
+
+	r->tick++;
+	slot = &r->slots[r->tick % PHP_EVENT_IDLE_REAPER_SLOTS];
+
+	if (slot->next == slot) {
+		return;
+	}
+
+	PHP_EVENT_TSRMLS_FETCH_FROM_CTX(r->thread_ctx);
+
+	/* Move the slot to the expired list, since the callbacks may add
+	 * or remove entries */
+	r->expired.next       = slot->next;
+	r->expired.prev       = slot->prev;
+	r->expired.next->prev = &r->expired;
+	r->expired.prev->next = &r->expired;
+	_idle_list_init(slot);
+
+	/* The object may be released in the callback */
+	zend_objects_store_add_ref_by_handle(r->handle TSRMLS_CC);
+
+	while (r->timer && r->expired.next != &r->expired && !EG(exception)) {
+		e = r->expired.next;
+
+		if (_idle_entry_deadline(e) > r->tick) {
+			_idle_list_remove(e);
+			_idle_schedule(r, e);
+			continue;
+		}
+
+		_idle_detach(e);
+		_idle_invoke(r, _idle_entry_bevent(e) TSRMLS_CC);
+	}
+
+	/* The loop is interrupted by an exception. Reap the rest on the next tick */
+	while (r->expired.next != &r->expired) {
+		e = r->expired.next;
+		_idle_list_remove(e);
+		_idle_list_append(&r->slots[(r->tick + 1) % PHP_EVENT_IDLE_REAPER_SLOTS], e);
+	}
+
+	zend_objects_store_del_ref_by_handle(r->handle TSRMLS_CC);
+}
+/* }}} */
+
+/* Private }}} */
+
+/* {{{ php_event_idle_reaper_init */
+int php_event_idle_reaper_init(php_event_idle_reaper_t *r, zval *zbase, double idle, zend_fcall_info *pfci, zend_fcall_info_cache *pfcc, zval *arg TSRMLS_DC)
+{
+	php_event_base_t *b;
+	int               i;
+
+	if (idle <= 0) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "Idle period must be positive");
+		return FAILURE;
+	}
+
+	PHP_EVENT_FETCH_BASE(b, zbase);
+	PHP_EVENT_ASSERT(b && b->base);
+
+	r->timer = event_new(b->base, -1, EV_PERSIST, _idle_tick_cb, (void *) r);
+	if (!r->timer) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "event_new failed");
+		return FAILURE;
+	}
+
+	idle /= PHP_EVENT_IDLE_REAPER_TICKS;
+	PHP_EVENT_TIMEVAL_SET(r->tv, idle);
+
+	for (i = 0; i < PHP_EVENT_IDLE_REAPER_SLOTS; i++) {
+		_idle_list_init(&r->slots[i]);
+	}
+	_idle_list_init(&r->expired);
+
+	r->base = zbase;
+	Z_ADDREF_P(zbase);
+
+	if (arg) {
+		Z_ADDREF_P(arg);
+	}
+	r->data = arg;
+
+	PHP_EVENT_COPY_FCALL_INFO(r->fci, r->fcc, pfci, pfcc);
+
+	TSRMLS_SET_CTX(r->thread_ctx);
+
+	return SUCCESS;
+}
+/* }}} */
+
+/* {{{ php_event_idle_reaper_unlink
+ * Removes bev from its idle reaper, if any. Must be called before bufferevent_free() */
+void php_event_idle_reaper_unlink(php_event_bevent_t *bev)
+{
+	if (bev->idle.reaper) {
+		_idle_detach(&bev->idle);
+	}
+}
+/* }}} */
+
+/* {{{ php_event_idle_reaper_clear
+ * Releases the watched bufferevents, the timer and the userspace values */
+void php_event_idle_reaper_clear(php_event_idle_reaper_t *r)
+{
+	int i;
+
+	if (r->timer) {
+		for (i = 0; i < PHP_EVENT_IDLE_REAPER_SLOTS; i++) {
+			while (r->slots[i].next != &r->slots[i]) {
+				_idle_detach(r->slots[i].next);
+			}
+		}
+		while (r->expired.next != &r->expired) {
+			_idle_detach(r->expired.next);
+		}
+
+		event_free(r->timer);
+		r->timer = NULL;
+	}
+
+	PHP_EVENT_FREE_FCALL_INFO(r->fci, r->fcc);
+
+	if (r->data) {
+		zval_ptr_dtor(&r->data);
+		r->data = NULL;
+	}
+
+	if (r->base) {
+		zval_ptr_dtor(&r->base);
+		r->base = NULL;
+	}
+}
+/* }}} */
+
+PHP_METHOD(EventIdleReaper, __construct)
+{
+	zend_throw_exception(NULL, "An object of this type cannot be created "
+			"with the new operator", 0 TSRMLS_CC);
+}
+
+/* {{{ proto bool EventIdleReaper::add(EventBufferEvent bev);
+ * Starts watching bev for inactivity. Any data read from, or written to the
+ * underlying transport counts as activity. bev must use the event base of the
+ * reaper. */
+PHP_METHOD(EventIdleReaper, add)
+{
+	zval                    *zbev;
+	php_event_idle_reaper_t *r;
+	php_event_bevent_t      *bev;
+	php_event_idle_entry_t  *e;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "O",
+				&zbev, php_event_bevent_ce) == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_IDLE_REAPER(r, getThis());
+	_ret_if_invalid_reaper_ptr(r);
+
+	PHP_EVENT_FETCH_BEVENT(bev, zbev);
+	if (!bev->bevent) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "Buffer Event is not initialized");
+		RETURN_FALSE;
+	}
+	/* The timer and the evbuffer callbacks must run in the same loop */
+	if (bufferevent_get_base(bev->bevent) != event_get_base(r->timer)) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING,
+				"Buffer Event is attached to another event base");
+		RETURN_FALSE;
+	}
+
+	e = &bev->idle;
+
+	if (e->reaper == r) {
+		e->tick = r->tick;
+		RETURN_TRUE;
+	}
+	if (e->reaper) {
+		_idle_detach(e);
+	}
+
+	e->reaper    = r;
+	e->tick      = r->tick;
+	e->input_cb  = evbuffer_add_cb(bufferevent_get_input(bev->bevent), _idle_input_cb, (void *) e);
+	e->output_cb = evbuffer_add_cb(bufferevent_get_output(bev->bevent), _idle_output_cb, (void *) e);
+	_idle_schedule(r, e);
+
+	if (r->count++ == 0 && event_add(r->timer, &r->tv)) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "Failed to arm the idle timer");
+		_idle_detach(e);
+		RETURN_FALSE;
+	}
+
+	RETURN_TRUE;
+}
+/* }}} */
+
+/* {{{ proto bool EventIdleReaper::remove(EventBufferEvent bev);
+ * Stops watching bev */
+PHP_METHOD(EventIdleReaper, remove)
+{
+	zval                    *zbev;
+	php_event_idle_reaper_t *r;
+	php_event_bevent_t      *bev;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "O",
+				&zbev, php_event_bevent_ce) == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_IDLE_REAPER(r, getThis());
+	_ret_if_invalid_reaper_ptr(r);
+
+	PHP_EVENT_FETCH_BEVENT(bev, zbev);
+
+	if (bev->idle.reaper != r) {
+		RETURN_FALSE;
+	}
+
+	_idle_detach(&bev->idle);
+
+	RETURN_TRUE;
+}
+/* }}} */
+
+/* {{{ proto int EventIdleReaper::getCount(void);
+ * Returns the number of watched bufferevents */
+PHP_METHOD(EventIdleReaper, getCount)
+{
+	php_event_idle_reaper_t *r;
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_IDLE_REAPER(r, getThis());
+
+	RETURN_LONG(r->count);
+}
+/* }}} */
+
+/* {{{ proto void EventIdleReaper::free(void);
+ * Stops watching all bufferevents and frees the timer */
+PHP_METHOD(EventIdleReaper, free)
+{
+	php_event_idle_reaper_t *r;
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_IDLE_REAPER(r, getThis());
+
+	php_event_idle_reaper_clear(r);
+}
+/* }}} */
+
+/*
+ * Local variables:
+ * tab-width: 4
+ * c-basic-offset: 4
+ * End:
+ * vim600: noet sw=4 ts=4 sts=4 fdm=marker
+ * vim<600: noet sw=4 ts=4 sts=4
+ */
@@ -0,0 +1,34 @@
+/*
+   +----------------------------------------------------------------------+
+   | PHP Version 5                                                        |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 1997-2016 The PHP Group                                |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+   | Author: Ruslan Osmanov <osmanov@php.net>                             |
+   +----------------------------------------------------------------------+
+*/
+
+#ifndef PHP_EVENT_IDLE_REAPER_H
+#define PHP_EVENT_IDLE_REAPER_H
+
+int php_event_idle_reaper_init(php_event_idle_reaper_t *r, zval *zbase, double idle, zend_fcall_info *pfci, zend_fcall_info_cache *pfcc, zval *arg TSRMLS_DC);
+void php_event_idle_reaper_unlink(php_event_bevent_t *bev);
+void php_event_idle_reaper_clear(php_event_idle_reaper_t *r);
+
+#endif /* PHP_EVENT_IDLE_REAPER_H */
+/*
+ * Local variables:
+ * tab-width: 4
+ * c-basic-offset: 4
+ * End:
+ * vim600: noet sw=4 ts=4 sts=4 fdm=marker
+ * vim<600: noet sw=4 ts=4 sts=4
+ */
@@ -18,6 +18,8 @@
 #include "../src/common.h"
 #include "../src/util.h"
 #include "../src/priv.h"
+#include "buffer_event.h"
+#include "listener.h"
 #include "zend_exceptions.h"
 
 /* {{{ Private */
@@ -93,6 +95,446 @@ static int sockaddr_parse(const struct sockaddr *in_addr, zval *out_zarr)
 }
 /* }}} */
 
+/* {{{ _listener_accept_events
+ * Turns accepting on, or off. l->disabled and l->paused are not touched */
+static int _listener_accept_events(php_event_listener_t *l, int on)
+{
+	if (l->batch_ev) {
+		return on ? event_add(l->batch_ev, NULL) : event_del(l->batch_ev);
+	}
+	return on ? evconnlistener_enable(l->listener) : evconnlistener_disable(l->listener);
+}
+/* }}} */
+
+/* {{{ _listener_pause
+ * Stops accepting, when the connection limit is reached */
+static void _listener_pause(php_event_listener_t *l)
+{
+	if (l->paused || l->listener == NULL) {
+		return;
+	}
+	if (!l->disabled) {
+		_listener_accept_events(l, 0);
+	}
+	l->paused = 1;
+	l->pauses++;
+	evutil_gettimeofday(&l->paused_at, NULL);
+}
+/* }}} */
+
+/* {{{ _listener_resume */
+static void _listener_resume(php_event_listener_t *l)
+{
+	struct timeval now;
+	struct timeval delta;
+
+	if (!l->paused) {
+		return;
+	}
+	l->paused = 0;
+
+	evutil_gettimeofday(&now, NULL);
+	evutil_timersub(&now, &l->paused_at, &delta);
+	evutil_timeradd(&l->paused_time, &delta, &l->paused_time);
+
+	if (!l->disabled && l->listener) {
+		_listener_accept_events(l, 1);
+	}
+}
+/* }}} */
+
+/* {{{ _listener_conn_closed
+ * Called when a buffer event created from the template is closed */
+static void _listener_conn_closed(php_event_conn_counter_t *c)
+{
+	php_event_listener_t *l = (php_event_listener_t *) c->owner;
+
+	if (l->paused && c->live <= l->low_conns) {
+		_listener_resume(l);
+	}
+}
+/* }}} */
+
+/* {{{ PROXY protocol */
+
+static void _php_event_listener_cb(struct evconnlistener *listener, evutil_socket_t fd, struct sockaddr *address, int socklen, void *ctx);
+
+/* Errors of recv() meaning that the data is not available yet */
+#ifdef PHP_WIN32
+# define PHP_EVENT_RECV_RETRIABLE(e) ((e) == WSAEWOULDBLOCK || (e) == WSAEINTR)
+#else
+# define PHP_EVENT_RECV_RETRIABLE(e) ((e) == EAGAIN || (e) == EWOULDBLOCK || (e) == EINTR)
+#endif
+
+/* Max. length of a v1 header including CRLF */
+#define PHP_EVENT_PROXY_V1_MAX 107
+/* Length of the fixed part of a v2 header */
+#define PHP_EVENT_PROXY_V2_HDR 16
+
+static const unsigned char proxy_v2_sig[12] = {
+	0x0D, 0x0A, 0x0D, 0x0A, 0x00, 0x0D, 0x0A, 0x51, 0x55, 0x49, 0x54, 0x0A
+};
+
+/* {{{ _proxy_conn_free
+ * Frees a connection waiting for the header. The socket is closed, if
+ * close_fd is non-zero */
+static void _proxy_conn_free(php_event_proxy_conn_t *p, int close_fd)
+{
+	php_event_listener_t *l = p->l;
+
+	if (p->prev) {
+		p->prev->next = p->next;
+	} else {
+		l->proxy_head = p->next;
+	}
+	if (p->next) {
+		p->next->prev = p->prev;
+	}
+
+	event_free(p->ev);
+	if (close_fd) {
+		evutil_closesocket(p->fd);
+	}
+	efree(p);
+}
+/* }}} */
+
+/* {{{ php_event_listener_proxy_clear
+ * Drops connections waiting for the PROXY header */
+void php_event_listener_proxy_clear(php_event_listener_t *l)
+{
+	while (l->proxy_head) {
+		_proxy_conn_free(l->proxy_head, 1);
+	}
+}
+/* }}} */
+
+/* {{{ _proxy_parse_port */
+static int _proxy_parse_port(const char *s)
+{
+	size_t i;
+	int    port = 0;
+
+	for (i = 0; s[i]; i++) {
+		if (i == 5 || s[i] < '0' || s[i] > '9') {
+			return -1;
+		}
+		port = port * 10 + (s[i] - '0');
+	}
+
+	return (i && port <= 65535) ? port : -1;
+}
+/* }}} */
+
+/* {{{ _proxy_parse_v1
+ * Parses a header like "PROXY TCP4 <src> <dst> <sport> <dport>\r\n" replacing
+ * the peer address with the source address */
+static int _proxy_parse_v1(php_event_proxy_conn_t *p)
+{
+	char  line[PHP_EVENT_PROXY_V1_MAX + 1];
+	char *tok[6];
+	char *s;
+	int   ntok = 0;
+	int   port;
+
+	if (p->len < 8 || p->buf[p->len - 2] != '\r') {
+		return FAILURE;
+	}
+	memcpy(line, p->buf, p->len - 2);
+	line[p->len - 2] = '\0';
+
+	for (s = line; s && ntok < 6; ntok++) {
+		tok[ntok] = s;
+		if ((s = strchr(s, ' ')) != NULL) {
+			*s++ = '\0';
+		}
+	}
+	if (s || ntok < 2 || strcmp(tok[0], "PROXY")) {
+		return FAILURE;
+	}
+
+	if (!strcmp(tok[1], "UNKNOWN")) {
+		/* Keep the address of the proxy */
+		return SUCCESS;
+	}
+
+	if (ntok != 6 || (port = _proxy_parse_port(tok[4])) < 0 || _proxy_parse_port(tok[5]) < 0) {
+		return FAILURE;
+	}
+
+	memset(&p->addr, 0, sizeof(p->addr));
+
+	if (!strcmp(tok[1], "TCP4")) {
+		struct sockaddr_in *sin = (struct sockaddr_in *) &p->addr;
+
+		if (evutil_inet_pton(AF_INET, tok[2], &sin->sin_addr) != 1) {
+			return FAILURE;
+		}
+		sin->sin_family = AF_INET;
+		sin->sin_port   = htons((unsigned short) port);
+		p->addr_len     = sizeof(*sin);
+#if HAVE_IPV6
+	} else if (!strcmp(tok[1], "TCP6")) {
+		struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *) &p->addr;
+
+		if (evutil_inet_pton(AF_INET6, tok[2], &sin6->sin6_addr) != 1) {
+			return FAILURE;
+		}
+		sin6->sin6_family = AF_INET6;
+		sin6->sin6_port   = htons((unsigned short) port);
+		p->addr_len       = sizeof(*sin6);
+#endif
+	} else {
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+/* }}} */
+
+/* {{{ _proxy_parse_v2
+ * Parses a binary header replacing the peer address with the source address */
+static int _proxy_parse_v2(php_event_proxy_conn_t *p)
+{
+	const unsigned char *d   = p->buf + PHP_EVENT_PROXY_V2_HDR;
+	/* The TLVs beyond the buffer are discarded */
+	size_t               len = MIN(p->len, sizeof(p->buf)) - PHP_EVENT_PROXY_V2_HDR;
+
+	if (memcmp(p->buf, proxy_v2_sig, sizeof(proxy_v2_sig)) || (p->buf[12] & 0xF0) != 0x20) {
+		return FAILURE;
+	}
+
+	switch (p->buf[12] & 0x0F) {
+		case 0x0:
+			/* LOCAL, e.g. a health check of the proxy itself */
+			return SUCCESS;
+		case 0x1:
+			/* PROXY */
+			break;
+		default:
+			return FAILURE;
+	}
+
+	switch (p->buf[13] >> 4) {
+		case 0x1: {
+			struct sockaddr_in *sin = (struct sockaddr_in *) &p->addr;
+
+			if (len < 12) {
+				return FAILURE;
+			}
+			memset(&p->addr, 0, sizeof(p->addr));
+			sin->sin_family = AF_INET;
+			memcpy(&sin->sin_addr, d, 4);
+			memcpy(&sin->sin_port, d + 8, 2);
+			p->addr_len = sizeof(*sin);
+			break;
+		}
+#if HAVE_IPV6
+		case 0x2: {
+			struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *) &p->addr;
+
+			if (len < 36) {
+				return FAILURE;
+			}
+			memset(&p->addr, 0, sizeof(p->addr));
+			sin6->sin6_family = AF_INET6;
+			memcpy(&sin6->sin6_addr, d, 16);
+			memcpy(&sin6->sin6_port, d + 32, 2);
+			p->addr_len = sizeof(*sin6);
+			break;
+		}
+#endif
+		default:
+			/* AF_UNSPEC, AF_UNIX: keep the address of the proxy */
+			break;
+	}
+
+	return SUCCESS;
+}
+/* }}} */
+
+/* {{{ _proxy_recv
+ * Returns number of bytes received, 0 if no data is available yet, or -1 if
+ * the connection is closed, or failed */
+static zend_always_inline ssize_t _proxy_recv(evutil_socket_t fd, unsigned char *buf, size_t len, int flags)
+{
+	ssize_t n = recv(fd, (char *) buf, len, flags);
+
+	if (n > 0) {
+		return n;
+	}
+	if (n < 0 && PHP_EVENT_RECV_RETRIABLE(EVUTIL_SOCKET_ERROR())) {
+		return 0;
+	}
+	return -1;
+}
+/* }}} */
+
+/* {{{ _proxy_conn_wait
+ * Waits for more data until the deadline */
+static void _proxy_conn_wait(php_event_proxy_conn_t *p)
+{
+	struct timeval now;
+	struct timeval tv;
+
+	evutil_gettimeofday(&now, NULL);
+
+	if (!evutil_timercmp(&now, &p->deadline, <)) {
+		_proxy_conn_free(p, 1);
+		return;
+	}
+	evutil_timersub(&p->deadline, &now, &tv);
+
+	if (event_add(p->ev, &tv)) {
+		_proxy_conn_free(p, 1);
+	}
+}
+/* }}} */
+
+/* {{{ _proxy_read_cb
+ * Reads the header without consuming any byte of the payload following it.
+ * Then passes the connection to the accept callback */
+static void _proxy_read_cb(evutil_socket_t fd, short what, void *arg)
+{
+	php_event_proxy_conn_t  *p = (php_event_proxy_conn_t *) arg;
+	php_event_listener_t    *l = p->l;
+	unsigned char            peek[PHP_EVENT_PROXY_V1_MAX];
+	unsigned char            skip[PHP_EVENT_PROXY_HDR_MAX];
+	unsigned char           *nl;
+	unsigned char           *dst;
+	struct sockaddr_storage  addr;
+	ev_socklen_t             addr_len;
+	size_t                   want;
+	size_t                   total;
+	ssize_t                  n;
+	int                      res;
+
+	if (what & EV_TIMEOUT) {
+		_proxy_conn_free(p, 1);
+		return;
+	}
+
+	for (;;) {
+		dst = p->buf + p->len;
+
+		if (p->len == 0) {
+			/* The first byte tells the version */
+			want = 1;
+		} else if (p->buf[0] == proxy_v2_sig[0]) {
+			if (p->len < PHP_EVENT_PROXY_V2_HDR) {
+				want = PHP_EVENT_PROXY_V2_HDR - p->len;
+			} else {
+				total = PHP_EVENT_PROXY_V2_HDR + ((p->buf[14] << 8) | p->buf[15]);
+				if (total == p->len) {
+					res = _proxy_parse_v2(p);
+					break;
+				}
+				want = total - p->len;
+
+				if (p->len >= sizeof(p->buf)) {
+					/* The address block is in the buffer. Read and drop the rest of the TLVs */
+					dst  = skip;
+					want = MIN(want, sizeof(skip));
+				} else {
+					want = MIN(want, sizeof(p->buf) - p->len);
+				}
+			}
+		} else if (p->buf[0] == 'P') {
+			if (p->buf[p->len - 1] == '\n') {
+				res = _proxy_parse_v1(p);
+				break;
+			}
+			if (p->len >= PHP_EVENT_PROXY_V1_MAX) {
+				_proxy_conn_free(p, 1);
+				return;
+			}
+
+			/* Take the bytes up to LF */
+			n = _proxy_recv(fd, peek, PHP_EVENT_PROXY_V1_MAX - p->len, MSG_PEEK);
+			if (n <= 0) {
+				if (n < 0) {
+					_proxy_conn_free(p, 1);
+				} else {
+					_proxy_conn_wait(p);
+				}
+				return;
+			}
+			nl   = memchr(peek, '\n', n);
+			want = nl ? (size_t) (nl - peek) + 1 : (size_t) n;
+		} else {
+			_proxy_conn_free(p, 1);
+			return;
+		}
+
+		n = _proxy_recv(fd, dst, want, 0);
+		if (n <= 0) {
+			if (n < 0) {
+				_proxy_conn_free(p, 1);
+			} else {
+				_proxy_conn_wait(p);
+			}
+			return;
+		}
+		p->len += n;
+	}
+
+	if (res == FAILURE) {
+		_proxy_conn_free(p, 1);
+		return;
+	}
+
+	memcpy(&addr, &p->addr, p->addr_len);
+	addr_len = p->addr_len;
+	_proxy_conn_free(p, 0);
+
+	_php_event_listener_cb(NULL, fd, (struct sockaddr *) &addr, (int) addr_len, (void *) l);
+}
+/* }}} */
+
+/* {{{ _proxy_conn_start
+ * Starts waiting for the header of an accepted connection */
+static void _proxy_conn_start(php_event_listener_t *l, evutil_socket_t fd, struct sockaddr *address, int socklen)
+{
+	php_event_proxy_conn_t *p;
+	php_event_base_t       *b;
+	struct timeval          now;
+	PHP_EVENT_TSRM_DECL
+
+	PHP_EVENT_TSRMLS_FETCH_FROM_CTX(l->thread_ctx);
+	PHP_EVENT_FETCH_BASE(b, l->base);
+
+	p = ecalloc(1, sizeof(php_event_proxy_conn_t));
+	p->l  = l;
+	p->fd = fd;
+	if (socklen > 0 && (size_t) socklen <= sizeof(p->addr)) {
+		memcpy(&p->addr, address, socklen);
+		p->addr_len = socklen;
+	}
+
+	evutil_gettimeofday(&now, NULL);
+	evutil_timeradd(&now, &l->proxy_timeout, &p->deadline);
+
+	/* Not persistent: the timeout is a deadline for the whole header */
+	p->ev = event_new(b->base, fd, EV_READ, _proxy_read_cb, (void *) p);
+	if (p->ev == NULL || event_add(p->ev, &l->proxy_timeout)) {
+		if (p->ev) {
+			event_free(p->ev);
+		}
+		efree(p);
+		evutil_closesocket(fd);
+		return;
+	}
+
+	p->next = l->proxy_head;
+	if (p->next) {
+		p->next->prev = p;
+	}
+	l->proxy_head = p;
+}
+/* }}} */
+
+/* PROXY protocol }}} */
+
 /* {{{ _php_event_listener_cb */
 static void _php_event_listener_cb(struct evconnlistener *listener, evutil_socket_t fd, struct sockaddr *address, int socklen, void *ctx) {
 	php_event_listener_t *l = (php_event_listener_t *) ctx;
@@ -103,10 +545,17 @@ static void _php_event_listener_cb(struct evconnlistener *listener, evutil_socke
 	zval   *arg_address;
 	zval   *arg_data;
 	zval   *retval_ptr = NULL;
+	zval   *zbev       = NULL;
 	PHP_EVENT_TSRM_DECL
 
 	PHP_EVENT_ASSERT(l);
 
+	if (listener && l->proxy) {
+		/* Called again with NULL listener, when the header is read */
+		_proxy_conn_start(l, fd, address, socklen);
+		return;
+	}
+
 	pfci = l->fci;
 	pfcc = l->fcc;
 
@@ -116,9 +565,29 @@ static void _php_event_listener_cb(struct evconnlistener *listener, evutil_socke
 
 	PHP_EVENT_TSRMLS_FETCH_FROM_CTX(l->thread_ctx);
 
+	if (l->tpl) {
+		/* Wrap the socket without a trip to userspace. The object stays alive
+		 * until the connection is closed, even if the accept callback is not
+		 * set, or doesn't keep it */
+		MAKE_STD_ZVAL(zbev);
+		if (php_event_bevent_from_template(zbev, l->base, fd, l->tpl, l->conns TSRMLS_CC) == FAILURE) {
+			php_error_docref(NULL TSRMLS_CC, E_WARNING,
+					"Failed to allocate bufferevent for accepted socket");
+			FREE_ZVAL(zbev);
+			evutil_closesocket(fd);
+			return;
+		}
+
+		if (l->max_conns > 0 && l->conns->live >= l->max_conns) {
+			_listener_pause(l);
+		}
+	}
+
 	/* Call user function having proto:
 	 * void cb (EventListener $listener, resource $fd, array $address, mixed $data);
 	 * $address = array ("IP-address", port)
+	 *
+	 * $fd is an EventBufferEvent object, if there is a buffer event template.
 	 */
 
 	if (ZEND_FCI_INITIALIZED(*pfci)) {
@@ -140,7 +609,10 @@ static void _php_event_listener_cb(struct evconnlistener *listener, evutil_socke
 		 *
 		 * Thus, we're just passing numeric fd here.
 		 */
-		if (fd) {
+		if (zbev) {
+			arg_fd = zbev;
+			zbev   = NULL;
+		} else if (fd) {
 			MAKE_STD_ZVAL(arg_fd);
 			ZVAL_LONG(arg_fd, fd);
 		} else {
@@ -188,6 +660,10 @@ static void _php_event_listener_cb(struct evconnlistener *listener, evutil_socke
         zval_ptr_dtor(&arg_address);
         zval_ptr_dtor(&arg_data);
 	}
+
+	if (zbev) {
+		zval_ptr_dtor(&zbev);
+	}
 }
 /* }}} */
 
@@ -243,6 +719,241 @@ static void listener_error_cb(struct evconnlistener *listener, void *ctx) {
 }
 /* }}} */
 
+#if LIBEVENT_VERSION_NUMBER >= 0x02000300
+/* Errors of accept() meaning that the next connection may be accepted later */
+#ifdef PHP_WIN32
+# define PHP_EVENT_ACCEPT_RETRIABLE(e) \
+	((e) == WSAEWOULDBLOCK || (e) == WSAEINTR || (e) == WSAECONNRESET)
+#else
+# define PHP_EVENT_ACCEPT_RETRIABLE(e) \
+	((e) == EAGAIN || (e) == EWOULDBLOCK || (e) == EINTR || (e) == ECONNABORTED)
+#endif
+
+/* {{{ accept_nonblock
+ * Accepts a connection as a non-blocking, close-on-exec socket */
+static zend_always_inline evutil_socket_t accept_nonblock(evutil_socket_t lfd, struct sockaddr *addr, socklen_t *addr_len)
+{
+	evutil_socket_t fd;
+
+#if defined(HAVE_ACCEPT4) && defined(SOCK_NONBLOCK) && defined(SOCK_CLOEXEC)
+	fd = accept4(lfd, addr, addr_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+	fd = accept(lfd, addr, addr_len);
+	if (fd >= 0) {
+		evutil_make_socket_nonblocking(fd);
+		evutil_make_socket_closeonexec(fd);
+	}
+#endif
+
+	return fd;
+}
+/* }}} */
+
+/* {{{ _php_event_listener_batch_cb
+ * Accepts up to batch_max pending connections, and passes them to the batch
+ * callback at once. The rest is accepted on the next loop iteration. */
+static void _php_event_listener_batch_cb(evutil_socket_t lfd, short what, void *arg)
+{
+	php_event_listener_t    *l          = (php_event_listener_t *) arg;
+	zend_fcall_info         *pfci;
+	zend_fcall_info_cache   *pfcc;
+	struct sockaddr_storage  ss;
+	socklen_t                ss_len;
+	evutil_socket_t          fd         = -1;
+	long                     n          = 0;
+	int                      err        = 0;
+	zval                   **args[4];
+	zval                    *arg_fds;
+	zval                    *arg_addresses;
+	zval                    *arg_address;
+	zval                    *arg_data;
+	zval                    *retval_ptr = NULL;
+	zval                   **ppzfd;
+	HashPosition             pos;
+	zend_bool                called     = 0;
+	PHP_EVENT_TSRM_DECL
+
+	PHP_EVENT_ASSERT(l);
+
+	pfci = l->fci_batch;
+	pfcc = l->fcc_batch;
+
+	PHP_EVENT_ASSERT(pfci && pfcc);
+
+	PHP_EVENT_TSRMLS_FETCH_FROM_CTX(l->thread_ctx);
+
+	MAKE_STD_ZVAL(arg_fds);
+	array_init(arg_fds);
+
+	MAKE_STD_ZVAL(arg_addresses);
+	if (l->batch_addr) {
+		array_init(arg_addresses);
+	} else {
+		ZVAL_NULL(arg_addresses);
+	}
+
+	while (n < l->batch_max) {
+		ss_len = sizeof(ss);
+		fd = accept_nonblock(lfd, l->batch_addr ? (struct sockaddr *) &ss : NULL,
+				l->batch_addr ? &ss_len : NULL);
+		if (fd < 0) {
+			err = EVUTIL_SOCKET_ERROR();
+			break;
+		}
+		n++;
+
+		add_next_index_long(arg_fds, fd);
+
+		if (l->batch_addr) {
+			MAKE_STD_ZVAL(arg_address);
+			/* See _php_event_listener_cb() */
+#ifdef AF_UNIX
+			if (ss.ss_family == AF_UNIX) {
+				ZVAL_NULL(arg_address);
+			} else
+#endif
+			{
+				array_init(arg_address);
+				sockaddr_parse((struct sockaddr *) &ss, arg_address);
+			}
+			add_next_index_zval(arg_addresses, arg_address);
+		}
+	}
+
+	/* Call user function having proto:
+	 * void cb (EventListener $listener, array $fds, ?array $addresses, mixed $data); */
+	if (n && ZEND_FCI_INITIALIZED(*pfci)) {
+		args[0] = &l->self;
+		args[1] = &arg_fds;
+		args[2] = &arg_addresses;
+
+		arg_data = l->data;
+		if (arg_data) {
+			Z_ADDREF_P(arg_data);
+		} else {
+			ALLOC_INIT_ZVAL(arg_data);
+		}
+		args[3] = &arg_data;
+
+		/* Prepare callback */
+		pfci->params         = args;
+		pfci->retval_ptr_ptr = &retval_ptr;
+		pfci->param_count    = 4;
+		pfci->no_separation  = 1;
+
+		if (zend_call_function(pfci, pfcc TSRMLS_CC) == SUCCESS) {
+			called = 1;
+			if (retval_ptr) {
+				zval_ptr_dtor(&retval_ptr);
+			}
+		} else if (EG(exception)) {
+			if (l->listener) {
+				event_base_loopbreak(evconnlistener_get_base(l->listener));
+			}
+		} else {
+			php_error_docref(NULL TSRMLS_CC, E_WARNING,
+					"An error occurred while invoking the callback");
+		}
+
+		zval_ptr_dtor(&arg_data);
+	}
+
+	if (n && !called) {
+		/* Nobody else owns the sockets */
+		for (zend_hash_internal_pointer_reset_ex(Z_ARRVAL_P(arg_fds), &pos);
+				zend_hash_get_current_data_ex(Z_ARRVAL_P(arg_fds), (void **) &ppzfd, &pos) == SUCCESS;
+				zend_hash_move_forward_ex(Z_ARRVAL_P(arg_fds), &pos)) {
+			evutil_closesocket((evutil_socket_t) Z_LVAL_PP(ppzfd));
+		}
+	}
+
+	zval_ptr_dtor(&arg_fds);
+	zval_ptr_dtor(&arg_addresses);
+
+	if (err && !PHP_EVENT_ACCEPT_RETRIABLE(err) && l->batch_ev && l->fci_err) {
+		EVUTIL_SET_SOCKET_ERROR(err);
+		listener_error_cb(l->listener, (void *) l);
+	}
+}
+/* }}} */
+
+/* {{{ batch_free
+ * Switches the listener back from the batched accept */
+static void batch_free(php_event_listener_t *l TSRMLS_DC)
+{
+	if (l->batch_ev) {
+		event_free(l->batch_ev);
+		l->batch_ev = NULL;
+
+		if (!l->disabled && !l->paused) {
+			evconnlistener_enable(l->listener);
+		}
+	}
+	PHP_EVENT_FREE_FCALL_INFO(l->fci_batch, l->fcc_batch);
+}
+/* }}} */
+#endif
+
+/* {{{ bevent_template_settings
+ * Reads the optional settings of EventListener::setBufferEventTemplate() */
+static int bevent_template_settings(php_event_bevent_template_t *t, HashTable *ht TSRMLS_DC)
+{
+	static const char *wm_keys[] = {
+		"read_lowmark", "read_highmark", "write_lowmark", "write_highmark"
+	};
+	size_t  *wm[] = { &t->read_wm[0], &t->read_wm[1], &t->write_wm[0], &t->write_wm[1] };
+	zval   **ppzval;
+	double   timeout;
+	int      i;
+
+	if (zend_hash_find(ht, "events", sizeof("events"), (void **) &ppzval) == SUCCESS) {
+		convert_to_long_ex(ppzval);
+		t->events = Z_LVAL_PP(ppzval) & (EV_READ | EV_WRITE);
+	}
+
+	for (i = 0; i < 4; i++) {
+		if (zend_hash_find(ht, wm_keys[i], strlen(wm_keys[i]) + 1, (void **) &ppzval) == SUCCESS) {
+			convert_to_long_ex(ppzval);
+
+			if (Z_LVAL_PP(ppzval) < 0) {
+				php_error_docref(NULL TSRMLS_CC, E_WARNING, "%s must not be negative", wm_keys[i]);
+				return FAILURE;
+			}
+			*wm[i] = (size_t) Z_LVAL_PP(ppzval);
+		}
+	}
+
+	if (zend_hash_find(ht, "timeout_read", sizeof("timeout_read"), (void **) &ppzval) == SUCCESS) {
+		convert_to_double_ex(ppzval);
+		timeout = Z_DVAL_PP(ppzval);
+		PHP_EVENT_TIMEVAL_SET(t->timeout_read, timeout);
+	}
+	if (zend_hash_find(ht, "timeout_write", sizeof("timeout_write"), (void **) &ppzval) == SUCCESS) {
+		convert_to_double_ex(ppzval);
+		timeout = Z_DVAL_PP(ppzval);
+		PHP_EVENT_TIMEVAL_SET(t->timeout_write, timeout);
+	}
+
+	if (zend_hash_find(ht, "ssl_context", sizeof("ssl_context"), (void **) &ppzval) == SUCCESS
+			&& Z_TYPE_PP(ppzval) != IS_NULL) {
+#ifdef HAVE_EVENT_OPENSSL_LIB
+		if (Z_TYPE_PP(ppzval) != IS_OBJECT
+				|| !instanceof_function(Z_OBJCE_PP(ppzval), php_event_ssl_context_ce TSRMLS_CC)) {
+			php_error_docref(NULL TSRMLS_CC, E_WARNING, "ssl_context must be an EventSslContext object");
+			return FAILURE;
+		}
+		t->ctx = *ppzval;
+		Z_ADDREF_P(t->ctx);
+#else
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "Event is built without SSL support");
+		return FAILURE;
+#endif
+	}
+
+	return SUCCESS;
+}
+/* }}} */
+
 /* Private }}} */
 
 /* {{{ proto EventListener EventListener::__construct(EventBase base, callable cb, mixed data, int flags, int backlog, mixed target);
@@ -335,6 +1046,9 @@ PHP_METHOD(EventListener, __construct)
 	}
 
 	l->listener = listener;
+#ifdef LEV_OPT_DISABLED
+	l->disabled = (flags & LEV_OPT_DISABLED) ? 1 : 0;
+#endif
 
 	if (zdata) {
 		l->data = zdata;
@@ -346,6 +1060,9 @@ PHP_METHOD(EventListener, __construct)
 	l->self = zself;
 	Z_ADDREF_P(l->self);
 
+	l->base = zbase;
+	Z_ADDREF_P(zbase);
+
 	TSRMLS_SET_CTX(l->thread_ctx);
 }
 /* }}} */
@@ -379,6 +1096,11 @@ PHP_METHOD(EventListener, free)
 	PHP_EVENT_FETCH_LISTENER(l, self);
 
 	if (l != NULL && l->listener != NULL) {
+		if (l->batch_ev) {
+			event_free(l->batch_ev);
+			l->batch_ev = NULL;
+		}
+		php_event_listener_proxy_clear(l);
 		evconnlistener_free(l->listener);
 		l->listener = NULL;
 	}
@@ -398,9 +1120,11 @@ PHP_METHOD(EventListener, enable)
 	PHP_EVENT_FETCH_LISTENER(l, zlistener);
 	_ret_if_invalid_listener_ptr(l);
 
-	if (evconnlistener_enable(l->listener)) {
+	/* Accepting is resumed later, if paused by the connection limit */
+	if (!l->paused && _listener_accept_events(l, 1)) {
 		RETURN_FALSE;
 	}
+	l->disabled = 0;
 
 	RETVAL_TRUE;
 }
@@ -421,9 +1145,10 @@ PHP_METHOD(EventListener, disable)
 	PHP_EVENT_FETCH_LISTENER(l, zlistener);
 	_ret_if_invalid_listener_ptr(l);
 
-	if (evconnlistener_disable(l->listener)) {
+	if (!l->paused && _listener_accept_events(l, 0)) {
 		RETURN_FALSE;
 	}
+	l->disabled = 1;
 
 	RETVAL_TRUE;
 }
@@ -565,6 +1290,364 @@ PHP_METHOD(EventListener, getSocketName)
 }
 /* }}} */
 
+/* {{{ proto bool EventListener::setSocketProfile(int profile);
+ * Applies one of the EventUtil::SOCKET_PROFILE_* sets of TCP options to the
+ * listening socket. On most systems accepted sockets inherit the options. */
+PHP_METHOD(EventListener, setSocketProfile)
+{
+	php_event_listener_t *l;
+	zval                 *zlistener = getThis();
+	long                  profile;
+	evutil_socket_t       fd;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "l", &profile) == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_LISTENER(l, zlistener);
+	_ret_if_invalid_listener_ptr(l);
+
+	fd = evconnlistener_get_fd(l->listener);
+	if (fd <= 0) {
+		RETURN_FALSE;
+	}
+
+	if (php_event_set_socket_profile(fd, profile TSRMLS_CC) == FAILURE) {
+		RETURN_FALSE;
+	}
+	RETVAL_TRUE;
+}
+/* }}} */
+
+#ifdef PHP_EVENT_REUSEPORT_CBPF
+/* {{{ proto bool EventListener::attachReuseportCbpf(void);
+ * Attaches a classic BPF program to the SO_REUSEPORT group of the listening
+ * socket, which steers new connections to the socket at index equal to the
+ * number of the CPU handling the packet. Sockets in the group should be
+ * created in CPU order by workers pinned to the CPUs, e.g. EventWorkerPool
+ * workers. */
+PHP_METHOD(EventListener, attachReuseportCbpf)
+{
+	php_event_listener_t *l;
+	zval                 *zlistener = getThis();
+	evutil_socket_t       fd;
+	struct sock_filter    code[] = {
+		/* A = raw_smp_processor_id() */
+		{ BPF_LD | BPF_W | BPF_ABS, 0, 0, SKF_AD_OFF + SKF_AD_CPU },
+		/* return A */
+		{ BPF_RET | BPF_A, 0, 0, 0 },
+	};
+	struct sock_fprog     prog;
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_LISTENER(l, zlistener);
+	_ret_if_invalid_listener_ptr(l);
+
+	fd = evconnlistener_get_fd(l->listener);
+	if (fd <= 0) {
+		RETURN_FALSE;
+	}
+
+	prog.len    = sizeof(code) / sizeof(code[0]);
+	prog.filter = code;
+
+	if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog))) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "Failed to attach reuseport program: %s",
+				strerror(errno));
+		RETURN_FALSE;
+	}
+	RETVAL_TRUE;
+}
+/* }}} */
+#endif
+
+/* {{{ proto bool EventListener::setBufferEventTemplate(int options[, callable readcb = NULL[, callable writecb = NULL[, callable eventcb = NULL[, mixed arg = NULL[, array settings = NULL]]]]]);
+ *
+ * Makes the listener wrap accepted sockets into EventBufferEvent objects
+ * created with the options(EventBufferEvent::OPT_*), callbacks and the
+ * callback argument as if they were passed to EventBufferEvent::__construct.
+ * OPT_CLOSE_ON_FREE is always on.
+ *
+ * settings is an array with optional keys:
+ *  "events"         - events enabled on the buffer event, Event::READ by default;
+ *  "read_lowmark", "read_highmark", "write_lowmark", "write_highmark" - watermarks;
+ *  "timeout_read", "timeout_write" - timeouts in seconds;
+ *  "ssl_context"    - EventSslContext. Makes server side SSL buffer events.
+ *
+ * The accept callback, if set, receives the EventBufferEvent object instead of
+ * the file descriptor. Otherwise the connection is served without entering
+ * userspace until the buffer event callbacks. The object is kept alive until
+ * the connection is closed(EOF or error), or EventBufferEvent::free() is called.
+ * The template is not applied to the connections accepted in batches, see
+ * setBatchCallback().
+ *
+ * NULL options removes the template.
+ */
+PHP_METHOD(EventListener, setBufferEventTemplate)
+{
+	zval                        *zlistener   = getThis();
+	php_event_listener_t        *l;
+	zval                        *zoptions;
+	zval                         zopt;
+	zend_fcall_info              fci_read    = empty_fcall_info;
+	zend_fcall_info_cache        fcc_read    = empty_fcall_info_cache;
+	zend_fcall_info              fci_write   = empty_fcall_info;
+	zend_fcall_info_cache        fcc_write   = empty_fcall_info_cache;
+	zend_fcall_info              fci_event   = empty_fcall_info;
+	zend_fcall_info_cache        fcc_event   = empty_fcall_info_cache;
+	zval                        *zarg        = NULL;
+	HashTable                   *ht_settings = NULL;
+	php_event_bevent_template_t *tpl;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "z!|f!f!f!z!h!",
+				&zoptions,
+				&fci_read, &fcc_read,
+				&fci_write, &fcc_write,
+				&fci_event, &fcc_event,
+				&zarg, &ht_settings) == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_LISTENER(l, zlistener);
+	_ret_if_invalid_listener_ptr(l);
+
+	if (zoptions == NULL) {
+		if (l->tpl) {
+			php_event_bevent_template_free(l->tpl);
+			l->tpl = NULL;
+		}
+		RETURN_TRUE;
+	}
+
+	tpl = ecalloc(1, sizeof(php_event_bevent_template_t));
+
+	zopt = *zoptions;
+	zval_copy_ctor(&zopt);
+	convert_to_long(&zopt);
+	tpl->options = Z_LVAL(zopt);
+	tpl->events  = EV_READ;
+
+	if (zarg) {
+		tpl->data = zarg;
+		Z_ADDREF_P(zarg);
+	}
+
+	PHP_EVENT_COPY_FCALL_INFO(tpl->fci_read, tpl->fcc_read, &fci_read, &fcc_read);
+	PHP_EVENT_COPY_FCALL_INFO(tpl->fci_write, tpl->fcc_write, &fci_write, &fcc_write);
+	PHP_EVENT_COPY_FCALL_INFO(tpl->fci_event, tpl->fcc_event, &fci_event, &fcc_event);
+
+	if (ht_settings && bevent_template_settings(tpl, ht_settings TSRMLS_CC) == FAILURE) {
+		php_event_bevent_template_free(tpl);
+		RETURN_FALSE;
+	}
+
+	if (l->tpl) {
+		php_event_bevent_template_free(l->tpl);
+	}
+	l->tpl = tpl;
+
+	RETVAL_TRUE;
+}
+/* }}} */
+
+/* {{{ proto bool EventListener::setMaxConnections(int max_conns[, int low_conns = -1]);
+ *
+ * Limits the number of live connections wrapped into EventBufferEvent objects
+ * with the buffer event template (see setBufferEventTemplate()). Accepting
+ * is paused when max_conns connections are open, and resumed after the
+ * number drops to low_conns (90% of max_conns by default). Pending
+ * connections wait in the listen backlog meanwhile. Zero max_conns removes
+ * the limit. Sockets passed to the accept callback as descriptors, or to the
+ * batch callback, are not counted. */
+PHP_METHOD(EventListener, setMaxConnections)
+{
+	php_event_listener_t *l;
+	zval                 *zlistener = getThis();
+	long                  max_conns;
+	long                  low_conns = -1;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "l|l", &max_conns, &low_conns) == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_LISTENER(l, zlistener);
+	_ret_if_invalid_listener_ptr(l);
+
+	if (max_conns < 0) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "max_conns must not be negative");
+		RETURN_FALSE;
+	}
+
+	if (low_conns < 0) {
+		low_conns = max_conns * 9 / 10;
+	} else if (max_conns > 0 && low_conns >= max_conns) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "low_conns must be less than max_conns");
+		RETURN_FALSE;
+	}
+
+	if (l->conns == NULL) {
+		l->conns = php_event_conn_counter_new((void *) l, _listener_conn_closed);
+	}
+
+	l->max_conns = max_conns;
+	l->low_conns = low_conns;
+
+	if (max_conns > 0 && l->conns->live >= max_conns) {
+		_listener_pause(l);
+	} else if (max_conns == 0 || l->conns->live <= low_conns) {
+		_listener_resume(l);
+	}
+
+	RETVAL_TRUE;
+}
+/* }}} */
+
+/* {{{ proto array EventListener::getConnectionStats(void);
+ *
+ * Returns an array with the keys:
+ *  "connections"     - number of live connections counted against the limit;
+ *  "max_connections" - the limit, 0 if off;
+ *  "paused"          - whether accepting is paused by the limit;
+ *  "pauses"          - number of pauses;
+ *  "paused_time"     - total time spent in pauses, in seconds. */
+PHP_METHOD(EventListener, getConnectionStats)
+{
+	php_event_listener_t *l;
+	zval                 *zlistener = getThis();
+	struct timeval        total;
+	struct timeval        now;
+	struct timeval        delta;
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_LISTENER(l, zlistener);
+
+	total = l->paused_time;
+	if (l->paused) {
+		evutil_gettimeofday(&now, NULL);
+		evutil_timersub(&now, &l->paused_at, &delta);
+		evutil_timeradd(&total, &delta, &total);
+	}
+
+	array_init(return_value);
+	add_assoc_long(return_value,   "connections",     l->conns ? l->conns->live : 0);
+	add_assoc_long(return_value,   "max_connections", l->max_conns);
+	add_assoc_bool(return_value,   "paused",          l->paused);
+	add_assoc_long(return_value,   "pauses",          l->pauses);
+	add_assoc_double(return_value, "paused_time",     total.tv_sec + total.tv_usec / 1000000.0);
+}
+/* }}} */
+
+/* {{{ proto bool EventListener::setProxyProtocol(bool enable[, float timeout = 5.0]);
+ *
+ * Makes the listener expect a PROXY protocol(v1 or v2) header at the start
+ * of every accepted connection, e.g. behind a load balancer. The header is
+ * read and stripped before the accept callback is invoked, and the client
+ * address from the header is passed to the callback instead of the address
+ * of the proxy. Connections with a malformed header, or without a complete
+ * header within timeout seconds, are closed. Connections accepted with the
+ * batch callback are not affected. */
+PHP_METHOD(EventListener, setProxyProtocol)
+{
+	php_event_listener_t *l;
+	zval                 *zlistener = getThis();
+	zend_bool             enable;
+	double                timeout = 5.0;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "b|d", &enable, &timeout) == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_LISTENER(l, zlistener);
+	_ret_if_invalid_listener_ptr(l);
+
+	if (timeout <= 0) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "timeout must be positive");
+		RETURN_FALSE;
+	}
+
+	l->proxy = enable;
+	PHP_EVENT_TIMEVAL_SET(l->proxy_timeout, timeout);
+
+	RETVAL_TRUE;
+}
+/* }}} */
+
+#if LIBEVENT_VERSION_NUMBER >= 0x02000300
+/* {{{ proto bool EventListener::setBatchCallback(callable cb[, int max_batch = 64[, bool addresses = FALSE]]);
+ *
+ * Switches the listener to batched accept: on every readiness event up to
+ * max_batch pending connections are accepted as non-blocking, close-on-exec
+ * sockets, and passed to cb at once:
+ *
+ * void cb(EventListener $listener, array $fds, ?array $addresses, mixed $data);
+ *
+ * $addresses is an array of [address, port] pairs (NULL for UNIX domain
+ * peers) if addresses is TRUE; otherwise NULL. The accept callback is not
+ * invoked in this mode. NULL cb switches back to the accept callback.
+ */
+PHP_METHOD(EventListener, setBatchCallback)
+{
+	zval                  *zlistener = getThis();
+	php_event_listener_t  *l;
+	zend_fcall_info        fci       = empty_fcall_info;
+	zend_fcall_info_cache  fcc       = empty_fcall_info_cache;
+	long                   max_batch = 64;
+	zend_bool              addresses = 0;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "f!|lb",
+				&fci, &fcc, &max_batch, &addresses) == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_LISTENER(l, zlistener);
+	_ret_if_invalid_listener_ptr(l);
+
+	if (!ZEND_FCI_INITIALIZED(fci)) {
+		batch_free(l TSRMLS_CC);
+		RETURN_TRUE;
+	}
+
+	if (max_batch <= 0) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "max_batch must be positive");
+		RETURN_FALSE;
+	}
+
+	if (l->batch_ev == NULL) {
+		l->batch_ev = event_new(evconnlistener_get_base(l->listener),
+				evconnlistener_get_fd(l->listener), EV_READ | EV_PERSIST,
+				_php_event_listener_batch_cb, (void *) l);
+		if (l->batch_ev == NULL) {
+			php_error_docref(NULL TSRMLS_CC, E_WARNING, "Failed to allocate batch event");
+			RETURN_FALSE;
+		}
+
+		evconnlistener_disable(l->listener);
+
+		if (!l->disabled && !l->paused && event_add(l->batch_ev, NULL)) {
+			php_error_docref(NULL TSRMLS_CC, E_WARNING, "Failed to add batch event");
+			event_free(l->batch_ev);
+			l->batch_ev = NULL;
+			evconnlistener_enable(l->listener);
+			RETURN_FALSE;
+		}
+	}
+
+	PHP_EVENT_FREE_FCALL_INFO(l->fci_batch, l->fcc_batch);
+	PHP_EVENT_COPY_FCALL_INFO(l->fci_batch, l->fcc_batch, &fci, &fcc);
+	l->batch_max  = max_batch;
+	l->batch_addr = addresses;
+
+	RETVAL_TRUE;
+}
+/* }}} */
+#endif
+
 /*
  * Local variables:
  * tab-width: 4
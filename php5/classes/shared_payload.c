@@ -0,0 +1,129 @@
+/*
+   +----------------------------------------------------------------------+
+   | PHP Version 5                                                        |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 1997-2016 The PHP Group                                |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+   | Author: Ruslan Osmanov <osmanov@php.net>                             |
+   +----------------------------------------------------------------------+
+*/
+#include "../src/common.h"
+#include "../src/util.h"
+#include "../src/priv.h"
+#include "zend_exceptions.h"
+#include "shared_payload.h"
+
+/* {{{ Private */
+
+/* {{{ _shared_block_cleanup
+ * Called by libevent, when a buffer no longer references the block */
+static void _shared_block_cleanup(const void *data, size_t datlen, void *extra)
+{
+	php_event_shared_block_release((php_event_shared_block_t *) extra);
+}
+/* }}} */
+
+/* Private }}} */
+
+/* {{{ php_event_shared_block_new
+ * Copies data into a new block with a single reference. The block is
+ * allocated persistently, since libevent may release the last reference
+ * after the request. */
+php_event_shared_block_t *php_event_shared_block_new(const char *data, size_t len)
+{
+	php_event_shared_block_t *blk;
+
+	blk = pemalloc(XtOffsetOf(php_event_shared_block_t, data) + len + 1, 1);
+
+	blk->refcount = 1;
+	blk->len      = len;
+	memcpy(blk->data, data, len);
+	blk->data[len] = '\0';
+
+	return blk;
+}
+/* }}} */
+
+/* {{{ php_event_shared_block_release */
+void php_event_shared_block_release(php_event_shared_block_t *blk)
+{
+	PHP_EVENT_ASSERT(blk && blk->refcount);
+
+	if (--blk->refcount == 0) {
+		pefree(blk, 1);
+	}
+}
+/* }}} */
+
+/* {{{ php_event_shared_block_add
+ * Appends the block to buf by reference, without copying the data */
+int php_event_shared_block_add(struct evbuffer *buf, php_event_shared_block_t *blk)
+{
+	blk->refcount++;
+
+	if (evbuffer_add_reference(buf, blk->data, blk->len, _shared_block_cleanup, (void *) blk)) {
+		blk->refcount--;
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+/* }}} */
+
+/* {{{ proto EventSharedPayload::__construct(string data);
+ * Stores data once to be added to many output buffers by reference with
+ * EventBase::broadcast() */
+PHP_METHOD(EventSharedPayload, __construct)
+{
+	zval                       *zself = getThis();
+	php_event_shared_payload_t *p;
+	char                       *data;
+	int                         data_len;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "s",
+				&data, &data_len) == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_SHARED_PAYLOAD(p, zself);
+
+	if (p->block) {
+		php_event_shared_block_release(p->block);
+	}
+	p->block = php_event_shared_block_new(data, data_len);
+}
+/* }}} */
+
+/* {{{ proto int EventSharedPayload::getLength(void);
+ * Returns the payload length in bytes */
+PHP_METHOD(EventSharedPayload, getLength)
+{
+	zval                       *zself = getThis();
+	php_event_shared_payload_t *p;
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_SHARED_PAYLOAD(p, zself);
+
+	RETVAL_LONG(p->block ? (long) p->block->len : 0);
+}
+/* }}} */
+
+/*
+ * Local variables:
+ * tab-width: 4
+ * c-basic-offset: 4
+ * End:
+ * vim600: noet sw=4 ts=4 sts=4 fdm=marker
+ * vim<600: noet sw=4 ts=4 sts=4
+ */
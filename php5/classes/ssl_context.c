@@ -92,6 +92,326 @@ static zend_always_inline void set_ciphers(SSL_CTX *ctx, const char *cipher_list
 }
 /* }}} */
 
+/* Upper bounds of the handshake latency buckets in milliseconds. The last
+ * bucket counts the handshakes longer than 1 second */
+static const long metrics_latency_bounds[PHP_EVENT_SSL_LATENCY_BUCKETS - 1] = {
+	1, 5, 10, 25, 50, 100, 250, 500, 1000
+};
+
+/* {{{ metrics_count */
+static void metrics_count(HashTable *ht, const char *key)
+{
+	long *pn;
+	long  n   = 1;
+	uint  len = strlen(key) + 1;
+
+	if (zend_hash_find(ht, key, len, (void **) &pn) == SUCCESS) {
+		(*pn)++;
+	} else {
+		zend_hash_add(ht, key, len, (void *) &n, sizeof(long), NULL);
+	}
+}
+/* }}} */
+
+/* {{{ metrics_info
+ * Updates the detailed metrics(OPT_METRICS) from the info callback */
+static void metrics_info(SSL *ssl, php_event_ssl_metrics_t *m, int where, int ret)
+{
+	struct timeval *start;
+	struct timeval  now;
+	double          ms;
+	size_t          i;
+
+	if (where & SSL_CB_HANDSHAKE_START) {
+		start = (struct timeval *) SSL_get_ex_data(ssl, php_event_ssl_start_index);
+		if (start == NULL) {
+			start = pemalloc(sizeof(struct timeval), 1);
+			SSL_set_ex_data(ssl, php_event_ssl_start_index, start);
+		}
+		evutil_gettimeofday(start, NULL);
+	} else if (where & SSL_CB_HANDSHAKE_DONE) {
+		start = (struct timeval *) SSL_get_ex_data(ssl, php_event_ssl_start_index);
+		if (start && start->tv_sec) {
+			evutil_gettimeofday(&now, NULL);
+			ms = (now.tv_sec - start->tv_sec) * 1e3 + (now.tv_usec - start->tv_usec) / 1e3;
+
+			for (i = 0; i < PHP_EVENT_SSL_LATENCY_BUCKETS - 1 && ms > metrics_latency_bounds[i]; i++);
+			m->latency[i]++;
+
+			start->tv_sec = 0;
+		}
+
+		metrics_count(&m->ciphers, SSL_get_cipher_name(ssl));
+		metrics_count(&m->protocols, SSL_get_version(ssl));
+	} else if ((where & SSL_CB_ALERT) && (ret >> 8) == SSL3_AL_FATAL) {
+		metrics_count((where & SSL_CB_WRITE) ? &m->alerts_sent : &m->alerts_received,
+				SSL_alert_desc_string_long(ret));
+	}
+}
+/* }}} */
+
+#ifdef SSL3_RT_HEADER
+/* {{{ msg_callback
+ * Counts the record bytes sent and received(OPT_METRICS) */
+static void msg_callback(int write_p, int version, int content_type, const void *buf, size_t len, SSL *ssl, void *arg)
+{
+	php_event_ssl_context_t *ectx;
+	const unsigned char     *header = (const unsigned char *) buf;
+
+	if (content_type != SSL3_RT_HEADER || len < SSL3_RT_HEADER_LENGTH) {
+		return;
+	}
+
+	ectx = (php_event_ssl_context_t *) SSL_get_ex_data(ssl, php_event_ssl_data_index);
+	if (!ectx || !ectx->metrics) {
+		return;
+	}
+
+	/* The record length follows the content type and version */
+	if (write_p) {
+		ectx->metrics->bytes_encrypted += (header[3] << 8) | header[4];
+	} else {
+		ectx->metrics->bytes_decrypted += (header[3] << 8) | header[4];
+	}
+}
+/* }}} */
+#endif
+
+/* {{{ info_callback
+ * Counts the completed handshakes of the context, and updates the detailed
+ * metrics, if any */
+static void info_callback(const SSL *ssl, int where, int ret)
+{
+	php_event_ssl_context_t *ectx;
+
+	if (!(where & (SSL_CB_HANDSHAKE_START | SSL_CB_HANDSHAKE_DONE | SSL_CB_ALERT))) {
+		return;
+	}
+
+	ectx = (php_event_ssl_context_t *) SSL_get_ex_data((SSL *) ssl, php_event_ssl_data_index);
+	if (!ectx) {
+		return;
+	}
+
+	if (where & (SSL_CB_HANDSHAKE_START | SSL_CB_HANDSHAKE_DONE)) {
+		/* TLS 1.3 reports post-handshake messages, such as NewSessionTicket
+		 * and KeyUpdate, as handshakes too. Only the first one is counted, and
+		 * measured by the metrics */
+		if (SSL_get_ex_data((SSL *) ssl, php_event_ssl_done_index)) {
+			return;
+		}
+
+		if (where & SSL_CB_HANDSHAKE_DONE) {
+			SSL_set_ex_data((SSL *) ssl, php_event_ssl_done_index, (void *) 1);
+
+			ectx->handshakes++;
+			if (SSL_session_reused((SSL *) ssl)) {
+				ectx->resumed++;
+			}
+		}
+	}
+
+	if (ectx->metrics) {
+		metrics_info((SSL *) ssl, ectx->metrics, where, ret);
+	}
+}
+/* }}} */
+
+/* {{{ session_dtor */
+static void session_dtor(void *data)
+{
+	SSL_SESSION_free(*(SSL_SESSION **) data);
+}
+/* }}} */
+
+/* {{{ client_session_new_cb
+ * Stores a new client session in the cache of the context under the key bound
+ * with php_event_ssl_session_prepare() */
+static int client_session_new_cb(SSL *ssl, SSL_SESSION *session)
+{
+	php_event_ssl_context_t *ectx;
+	const char              *key;
+
+	ectx = (php_event_ssl_context_t *) SSL_get_ex_data(ssl, php_event_ssl_data_index);
+	key  = (const char *) SSL_get_ex_data(ssl, php_event_ssl_host_index);
+
+	if (!ectx || !ectx->sessions || !key) {
+		return 0;
+	}
+
+	/* The previous session of the host is freed by the hash dtor */
+	zend_hash_update(ectx->sessions, key, strlen(key) + 1, (void *) &session,
+			sizeof(SSL_SESSION *), NULL);
+
+	/* We hold the reference now */
+	return 1;
+}
+/* }}} */
+
+#ifdef PHP_EVENT_SSL_TICKET_KEYS
+static int rotate_ticket_keys(php_event_ssl_context_t *ectx);
+
+#ifdef PHP_EVENT_SSL_TICKET_EVP_MAC
+typedef EVP_MAC_CTX php_event_ticket_mac_ctx_t;
+#else
+typedef HMAC_CTX php_event_ticket_mac_ctx_t;
+#endif
+
+/* {{{ ticket_key_mac_init
+ * Initializes HMAC-SHA256 of the session ticket with the key */
+static zend_always_inline int ticket_key_mac_init(php_event_ticket_mac_ctx_t *hctx, php_event_ssl_ticket_key_t *key)
+{
+#ifdef PHP_EVENT_SSL_TICKET_EVP_MAC
+	OSSL_PARAM params[3];
+
+	params[0] = OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, key->hmac_key, sizeof(key->hmac_key));
+	params[1] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, (char *) "SHA256", 0);
+	params[2] = OSSL_PARAM_construct_end();
+
+	return EVP_MAC_CTX_set_params(hctx, params);
+#else
+	return HMAC_Init_ex(hctx, key->hmac_key, sizeof(key->hmac_key), EVP_sha256(), NULL);
+#endif
+}
+/* }}} */
+
+/* {{{ ticket_key_callback
+ * Encrypts new session tickets with the current key, and decrypts tickets
+ * issued with either the current, or the previous key */
+static int ticket_key_callback(SSL *ssl, unsigned char *name, unsigned char *iv,
+		EVP_CIPHER_CTX *cctx, php_event_ticket_mac_ctx_t *hctx, int enc)
+{
+	php_event_ssl_context_t    *ectx;
+	php_event_ssl_ticket_key_t *key;
+	int                         i;
+
+	ectx = (php_event_ssl_context_t *) SSL_get_ex_data(ssl, php_event_ssl_data_index);
+	if (!ectx || !ectx->ticket_keys[0].set) {
+		/* No keys yet: don't issue a ticket, or fall back to a full handshake */
+		return 0;
+	}
+
+	if (enc) {
+		if (ectx->ticket_key_lifetime > 0
+				&& time(NULL) - ectx->ticket_key_created >= ectx->ticket_key_lifetime) {
+			rotate_ticket_keys(ectx);
+		}
+
+		key = &ectx->ticket_keys[0];
+
+		if (RAND_bytes(iv, EVP_CIPHER_iv_length(EVP_aes_256_cbc())) != 1) {
+			return -1;
+		}
+		memcpy(name, key->name, sizeof(key->name));
+		if (EVP_EncryptInit_ex(cctx, EVP_aes_256_cbc(), NULL, key->aes_key, iv) != 1
+				|| ticket_key_mac_init(hctx, key) != 1) {
+			return -1;
+		}
+
+		return 1;
+	}
+
+	for (i = 0; i < 2; i++) {
+		key = &ectx->ticket_keys[i];
+
+		if (key->set && memcmp(name, key->name, sizeof(key->name)) == 0) {
+			if (ticket_key_mac_init(hctx, key) != 1
+					|| EVP_DecryptInit_ex(cctx, EVP_aes_256_cbc(), NULL, key->aes_key, iv) != 1) {
+				return -1;
+			}
+
+			/* 2 renews the tickets issued with the previous key */
+			return (i == 0 ? 1 : 2);
+		}
+	}
+
+	/* Unknown key: full handshake */
+	return 0;
+}
+/* }}} */
+
+/* {{{ set_ticket_key_callback */
+static zend_always_inline void set_ticket_key_callback(SSL_CTX *ctx)
+{
+#ifdef PHP_EVENT_SSL_TICKET_EVP_MAC
+	SSL_CTX_set_tlsext_ticket_key_evp_cb(ctx, ticket_key_callback);
+#else
+	SSL_CTX_set_tlsext_ticket_key_cb(ctx, ticket_key_callback);
+#endif
+}
+/* }}} */
+
+/* {{{ rotate_ticket_keys
+ * Generates a new current session ticket key. The previous key is kept to
+ * accept the tickets issued before the rotation. */
+static int rotate_ticket_keys(php_event_ssl_context_t *ectx)
+{
+	php_event_ssl_ticket_key_t key;
+
+	if (RAND_bytes(key.name, sizeof(key.name)) != 1
+			|| RAND_bytes(key.aes_key, sizeof(key.aes_key)) != 1
+			|| RAND_bytes(key.hmac_key, sizeof(key.hmac_key)) != 1) {
+		OPENSSL_cleanse(&key, sizeof(key));
+		return FAILURE;
+	}
+	key.set = 1;
+
+	ectx->ticket_keys[1]     = ectx->ticket_keys[0];
+	ectx->ticket_keys[0]     = key;
+	ectx->ticket_key_created = time(NULL);
+	OPENSSL_cleanse(&key, sizeof(key));
+
+	set_ticket_key_callback(ectx->ctx);
+
+	return SUCCESS;
+}
+/* }}} */
+#endif
+
+/* {{{ php_event_ssl_host_free
+ * Frees the client session cache key of an SSL handle */
+void php_event_ssl_host_free(void *parent, void *ptr, CRYPTO_EX_DATA *ad, int idx, long argl, void *argp)
+{
+	if (ptr) {
+		pefree(ptr, 1);
+	}
+}
+/* }}} */
+
+/* {{{ php_event_ssl_session_prepare
+ * Binds the client SSL handle to the session cache entry of host:port, and
+ * sets the cached session, if any. Does nothing, if the context has no client
+ * session cache. */
+void php_event_ssl_session_prepare(SSL *ssl, const char *host, long port)
+{
+	php_event_ssl_context_t *ectx;
+	SSL_SESSION            **ppsession;
+	char                    *key;
+	int                      key_len;
+	void                    *old_key;
+
+	ectx = (php_event_ssl_context_t *) SSL_get_ex_data(ssl, php_event_ssl_data_index);
+	if (!ectx || !ectx->sessions) {
+		return;
+	}
+
+	key_len = spprintf(&key, 0, "%s:%ld", host, port);
+
+	/* The key may be needed after the request, when OpenSSL frees the handle */
+	old_key = SSL_get_ex_data(ssl, php_event_ssl_host_index);
+	if (old_key) {
+		pefree(old_key, 1);
+	}
+	SSL_set_ex_data(ssl, php_event_ssl_host_index, pestrndup(key, key_len, 1));
+
+	if (zend_hash_find(ectx->sessions, key, key_len + 1, (void **) &ppsession) == SUCCESS) {
+		SSL_set_session(ssl, *ppsession);
+	}
+
+	efree(key);
+}
+/* }}} */
+
 /* {{{ _php_event_ssl_ctx_set_private_key */
 int _php_event_ssl_ctx_set_private_key(SSL_CTX *ctx, const char *private_key TSRMLS_DC)
 {
@@ -144,6 +464,112 @@ int _php_event_ssl_ctx_set_local_cert(SSL_CTX *ctx, const char *certfile, const
 }
 /* }}} */
 
+#ifdef PHP_EVENT_SSL_ALPN
+/* {{{ alpn_append */
+static zend_always_inline int alpn_append(unsigned char *wire, size_t *pos, const char *proto, size_t len)
+{
+	if (len == 0 || len > 255) {
+		return FAILURE;
+	}
+
+	wire[(*pos)++] = (unsigned char) len;
+	memcpy(wire + *pos, proto, len);
+	*pos += len;
+
+	return SUCCESS;
+}
+/* }}} */
+
+/* {{{ alpn_wire
+ * Converts protocol list(array, or comma-separated string) to the wire format
+ * of the ALPN extension, i.e. length-prefixed protocol names in the order of
+ * preference. Returns emalloc'd buffer, or NULL, if the list is invalid. */
+static unsigned char *alpn_wire(zval *zv, unsigned int *wire_len)
+{
+	unsigned char  *wire;
+	size_t          size = 0;
+	size_t          pos  = 0;
+	zval          **ppzproto;
+	HashPosition    hpos;
+
+	if (Z_TYPE_P(zv) == IS_ARRAY) {
+		for (zend_hash_internal_pointer_reset_ex(Z_ARRVAL_P(zv), &hpos);
+				zend_hash_get_current_data_ex(Z_ARRVAL_P(zv), (void **) &ppzproto, &hpos) == SUCCESS;
+				zend_hash_move_forward_ex(Z_ARRVAL_P(zv), &hpos)) {
+			if (Z_TYPE_PP(ppzproto) != IS_STRING) {
+				return NULL;
+			}
+			size += Z_STRLEN_PP(ppzproto) + 1;
+		}
+	} else if (Z_TYPE_P(zv) == IS_STRING) {
+		size = Z_STRLEN_P(zv) + 1;
+	}
+
+	if (size < 2 || size > 0xffff) {
+		return NULL;
+	}
+
+	wire = emalloc(size);
+
+	if (Z_TYPE_P(zv) == IS_ARRAY) {
+		for (zend_hash_internal_pointer_reset_ex(Z_ARRVAL_P(zv), &hpos);
+				zend_hash_get_current_data_ex(Z_ARRVAL_P(zv), (void **) &ppzproto, &hpos) == SUCCESS;
+				zend_hash_move_forward_ex(Z_ARRVAL_P(zv), &hpos)) {
+			if (alpn_append(wire, &pos, Z_STRVAL_PP(ppzproto), Z_STRLEN_PP(ppzproto)) == FAILURE) {
+				efree(wire);
+				return NULL;
+			}
+		}
+	} else {
+		const char *proto = Z_STRVAL_P(zv);
+		const char *end   = proto + Z_STRLEN_P(zv);
+		const char *comma;
+
+		while (proto <= end) {
+			comma = memchr(proto, ',', end - proto);
+			if (comma == NULL) {
+				comma = end;
+			}
+			if (alpn_append(wire, &pos, proto, comma - proto) == FAILURE) {
+				efree(wire);
+				return NULL;
+			}
+			proto = comma + 1;
+		}
+	}
+
+	*wire_len = (unsigned int) pos;
+
+	return wire;
+}
+/* }}} */
+
+/* {{{ alpn_select_cb
+ * Selects the first protocol of the server list offered by the client */
+static int alpn_select_cb(SSL *ssl, const unsigned char **out, unsigned char *outlen,
+		const unsigned char *in, unsigned int inlen, void *arg)
+{
+	php_event_ssl_context_t *ectx;
+	unsigned char           *selected;
+
+	ectx = (php_event_ssl_context_t *) SSL_get_ex_data(ssl, php_event_ssl_data_index);
+	if (!ectx || !ectx->alpn) {
+		return SSL_TLSEXT_ERR_NOACK;
+	}
+
+	/* SSL_select_next_proto walks the server list in the order of preference */
+	if (SSL_select_next_proto(&selected, outlen, ectx->alpn, ectx->alpn_len, in, inlen)
+			!= OPENSSL_NPN_NEGOTIATED) {
+		/* Proceed without application protocol */
+		return SSL_TLSEXT_ERR_NOACK;
+	}
+	*out = selected;
+
+	return SSL_TLSEXT_ERR_OK;
+}
+/* }}} */
+#endif
+
 /* {{{ set_ssl_ctx_options */
 static inline void set_ssl_ctx_options(php_event_ssl_context_t *ectx TSRMLS_DC)
 {
@@ -151,6 +577,7 @@ static inline void set_ssl_ctx_options(php_event_ssl_context_t *ectx TSRMLS_DC)
 	HashTable    *ht          = ectx->ht;
 	HashPosition  pos         = 0;
 	zend_bool     got_ciphers = 0;
+	zend_bool     sess_cache  = 0;
 	int           verify_mode = SSL_VERIFY_NONE;
 	char         *cafile      = NULL;
 	char         *capath      = NULL;
@@ -307,7 +734,10 @@ static inline void set_ssl_ctx_options(php_event_ssl_context_t *ectx TSRMLS_DC)
 				}
 				break;
 			case PHP_EVENT_OPT_ALLOW_SELF_SIGNED:
-				ectx->allow_self_signed = (zend_bool) zval_is_true(*ppzval);
+			case PHP_EVENT_OPT_TICKET_KEY_LIFETIME:
+			case PHP_EVENT_OPT_SHARED_CTX:
+			case PHP_EVENT_OPT_DYNAMIC_RECORDS:
+				/* Skip. Applied in set_ssl_ectx_options() */
 				break;
 			case PHP_EVENT_OPT_VERIFY_PEER:
 				if (zval_is_true(*ppzval)) {
@@ -335,6 +765,64 @@ static inline void set_ssl_ctx_options(php_event_ssl_context_t *ectx TSRMLS_DC)
 					verify_mode |= SSL_VERIFY_CLIENT_ONCE;
 				}
 				break;
+			case PHP_EVENT_OPT_SESSION_CACHE_SIZE:
+				convert_to_long_ex(ppzval);
+				SSL_CTX_sess_set_cache_size(ctx, Z_LVAL_PP(ppzval));
+				break;
+			case PHP_EVENT_OPT_SESSION_TIMEOUT:
+				convert_to_long_ex(ppzval);
+				SSL_CTX_set_timeout(ctx, Z_LVAL_PP(ppzval));
+				break;
+			case PHP_EVENT_OPT_SESSION_TICKETS:
+				if (zend_is_true(*ppzval)) {
+					SSL_CTX_clear_options(ctx, SSL_OP_NO_TICKET);
+				} else {
+					SSL_CTX_set_options(ctx, SSL_OP_NO_TICKET);
+				}
+				break;
+			case PHP_EVENT_OPT_CLIENT_SESSION_CACHE:
+				sess_cache = (zend_bool) zend_is_true(*ppzval);
+				break;
+			case PHP_EVENT_OPT_KTLS:
+				/* Without kTLS support in the OpenSSL library, or in the kernel,
+				 * the records are encrypted in userspace as usual */
+#ifdef PHP_EVENT_KTLS
+				if (zend_is_true(*ppzval)) {
+					SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+				} else {
+					SSL_CTX_clear_options(ctx, SSL_OP_ENABLE_KTLS);
+				}
+#endif
+				break;
+			case PHP_EVENT_OPT_METRICS:
+#ifdef SSL3_RT_HEADER
+				if (zend_is_true(*ppzval)) {
+					SSL_CTX_set_msg_callback(ctx, msg_callback);
+				}
+#endif
+				break;
+			case PHP_EVENT_OPT_ALPN_PROTOCOLS:
+#ifdef PHP_EVENT_SSL_ALPN
+				{
+					unsigned char *wire;
+					unsigned int   wire_len;
+
+					wire = alpn_wire(*ppzval, &wire_len);
+					if (wire == NULL) {
+						php_error_docref(NULL TSRMLS_CC, E_WARNING, "Invalid ALPN protocol list");
+						break;
+					}
+					/* The list offered by the clients */
+					SSL_CTX_set_alpn_protos(ctx, wire, wire_len);
+					/* The servers select from the list of the EventSslContext */
+					SSL_CTX_set_alpn_select_cb(ctx, alpn_select_cb, NULL);
+					efree(wire);
+				}
+#else
+				php_error_docref(NULL TSRMLS_CC, E_WARNING,
+						"ALPN is not supported by the OpenSSL library");
+#endif
+				break;
 			default:
 				php_error_docref(NULL TSRMLS_CC, E_WARNING,
 						"Unknown option %ld", idx);
@@ -348,15 +836,116 @@ static inline void set_ssl_ctx_options(php_event_ssl_context_t *ectx TSRMLS_DC)
 	}
 
 	if (cafile || capath) {
+		set_ca(ctx, cafile, capath TSRMLS_CC);
+	}
+
+	if (sess_cache) {
+		/* The sessions are stored in the per-host cache only */
+		SSL_CTX_set_session_cache_mode(ctx, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+		SSL_CTX_sess_set_new_cb(ctx, client_session_new_cb);
+	}
+}
+/* }}} */
+
+/* {{{ set_ssl_ectx_options
+ * Applies the options kept by the EventSslContext object rather than by the
+ * SSL_CTX, which may be shared with other objects(see OPT_SHARED_CTX) */
+static inline void set_ssl_ectx_options(php_event_ssl_context_t *ectx TSRMLS_DC)
+{
+	HashTable  *ht = ectx->ht;
+	zval      **ppzval;
+
+	if (zend_hash_index_find(ht, PHP_EVENT_OPT_ALLOW_SELF_SIGNED, (void **) &ppzval) == SUCCESS) {
+		ectx->allow_self_signed = (zend_bool) zval_is_true(*ppzval);
+	}
+
+	if (zend_hash_index_exists(ht, PHP_EVENT_OPT_CA_FILE)
+			|| zend_hash_index_exists(ht, PHP_EVENT_OPT_CA_PATH)) {
 		/* We have to disable this flag, because CA file/path provides
 		 * a "whitelist" of specific certificates which will pass even if self-signed.
 		 * We can't have allow_self_signed enabled, because in this case verify_callback
 		 * accepts *any* self-signed certificate.
 		 */
 		ectx->allow_self_signed = 0;
+	}
 
-		set_ca(ctx, cafile, capath TSRMLS_CC);
+	if (zend_hash_index_find(ht, PHP_EVENT_OPT_TICKET_KEY_LIFETIME, (void **) &ppzval) == SUCCESS) {
+#ifdef PHP_EVENT_SSL_TICKET_KEYS
+		convert_to_long_ex(ppzval);
+		if (Z_LVAL_PP(ppzval) < 0) {
+			php_error_docref(NULL TSRMLS_CC, E_WARNING, "Ticket key lifetime must be non-negative");
+		} else {
+			ectx->ticket_key_lifetime = Z_LVAL_PP(ppzval);
+			if (!ectx->ticket_keys[0].set && rotate_ticket_keys(ectx) == FAILURE) {
+				php_error_docref(NULL TSRMLS_CC, E_WARNING, "Failed to generate session ticket key");
+			}
+		}
+#else
+		php_error_docref(NULL TSRMLS_CC, E_WARNING,
+				"Session ticket key callback is not supported by the OpenSSL library");
+#endif
+	}
+
+	/* The state is rebuilt, when the options are changed by reload() */
+	if (ectx->sessions) {
+		/* Sessions of the previous SSL_CTX */
+		zend_hash_destroy(ectx->sessions);
+		FREE_HASHTABLE(ectx->sessions);
+		ectx->sessions = NULL;
+	}
+	if (zend_hash_index_find(ht, PHP_EVENT_OPT_CLIENT_SESSION_CACHE, (void **) &ppzval) == SUCCESS
+			&& zend_is_true(*ppzval)) {
+		ALLOC_HASHTABLE(ectx->sessions);
+		zend_hash_init(ectx->sessions, 8, NULL, session_dtor, 0);
+	}
+
+#ifdef PHP_EVENT_SSL_ALPN
+	if (ectx->alpn) {
+		efree(ectx->alpn);
+		ectx->alpn     = NULL;
+		ectx->alpn_len = 0;
 	}
+	if (zend_hash_index_find(ht, PHP_EVENT_OPT_ALPN_PROTOCOLS, (void **) &ppzval) == SUCCESS) {
+		ectx->alpn = alpn_wire(*ppzval, &ectx->alpn_len);
+	}
+#endif
+
+	if (zend_hash_index_find(ht, PHP_EVENT_OPT_METRICS, (void **) &ppzval) == SUCCESS
+			&& zend_is_true(*ppzval)) {
+		/* The counters survive reload() */
+		if (!ectx->metrics) {
+			ectx->metrics = ecalloc(1, sizeof(php_event_ssl_metrics_t));
+			zend_hash_init(&ectx->metrics->alerts_sent,     8, NULL, NULL, 0);
+			zend_hash_init(&ectx->metrics->alerts_received, 8, NULL, NULL, 0);
+			zend_hash_init(&ectx->metrics->ciphers,         8, NULL, NULL, 0);
+			zend_hash_init(&ectx->metrics->protocols,       8, NULL, NULL, 0);
+		}
+	} else if (ectx->metrics) {
+		zend_hash_destroy(&ectx->metrics->alerts_sent);
+		zend_hash_destroy(&ectx->metrics->alerts_received);
+		zend_hash_destroy(&ectx->metrics->ciphers);
+		zend_hash_destroy(&ectx->metrics->protocols);
+		efree(ectx->metrics);
+		ectx->metrics = NULL;
+	}
+
+	/* Without SSL_set_max_send_fragment() the records are sized by OpenSSL as usual */
+	if (zend_hash_index_find(ht, PHP_EVENT_OPT_DYNAMIC_RECORDS, (void **) &ppzval) == SUCCESS) {
+		ectx->dynamic_records = (zend_bool)zend_is_true(*ppzval);
+	}
+}
+/* }}} */
+
+/* {{{ configure_ssl_ctx
+ * Applies the options to the new SSL_CTX of ectx */
+static void configure_ssl_ctx(php_event_ssl_context_t *ectx TSRMLS_DC)
+{
+	SSL_CTX_set_options(ectx->ctx, SSL_OP_ALL);
+	SSL_CTX_set_info_callback(ectx->ctx, info_callback);
+	set_ssl_ctx_options(ectx TSRMLS_CC);
+
+	/* Issue #20 */
+	SSL_CTX_set_session_id_context(ectx->ctx, (unsigned char *)(void *)ectx->ctx, sizeof(ectx->ctx));
 }
 /* }}} */
 
@@ -527,26 +1116,583 @@ static zend_always_inline SSL_METHOD *get_ssl_method(long in_method TSRMLS_DC)
 }
 /* }}} */
 
-/* Private }}} */
+#ifdef PHP_EVENT_SSL_SNI
+/* {{{ sni_add
+ * Stores a reference to the EventSslContext zctx in *pht under the key */
+static void sni_add(HashTable **pht, const char *key, int key_len, zval *zctx)
+{
+	if (*pht == NULL) {
+		ALLOC_HASHTABLE(*pht);
+		zend_hash_init(*pht, 8, NULL, ZVAL_PTR_DTOR, 0);
+	}
 
+	Z_ADDREF_P(zctx);
+	zend_hash_update(*pht, key, key_len + 1, (void *) &zctx, sizeof(zval *), NULL);
+}
+/* }}} */
 
-/* {{{ proto EventSslContext EventSslContext::__construct(int method, array options);
- *
- * Creates SSL context holding pointer to SSL_CTX.
- * method parameter is one of EventSslContext::*_METHOD constants.
- * options parameter is an associative array of SSL context options */
-PHP_METHOD(EventSslContext, __construct)
+/* {{{ sni_load
+ * Invokes the SNI callback for the hostname which has no context. The context
+ * returned by the callback is cached for the next connections. */
+static php_event_ssl_context_t *sni_load(php_event_ssl_context_t *ectx, const char *host, int host_len TSRMLS_DC)
 {
-	php_event_ssl_context_t *ectx;
-	HashTable               *ht_options;
-	long                     in_method;
-	SSL_METHOD              *method;
-	SSL_CTX                 *ctx;
-	long                     options    = SSL_OP_ALL;
+	zend_fcall_info          *pfci       = ectx->sni_fci;
+	zval                     *arg_host;
+	zval                    **args[1];
+	zval                     *retval_ptr = NULL;
+	php_event_ssl_context_t  *target     = NULL;
+
+	if (!pfci || !ZEND_FCI_INITIALIZED(*pfci)) {
+		return NULL;
+	}
 
-	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "lh",
-				&in_method, &ht_options) == FAILURE) {
-		return;
+	MAKE_STD_ZVAL(arg_host);
+	ZVAL_STRINGL(arg_host, host, host_len, 1);
+	args[0] = &arg_host;
+
+	/* Prepare callback */
+	pfci->params         = args;
+	pfci->retval_ptr_ptr = &retval_ptr;
+	pfci->param_count    = 1;
+	pfci->no_separation  = 1;
+
+	if (zend_call_function(pfci, ectx->sni_fcc TSRMLS_CC) == SUCCESS && retval_ptr) {
+		if (Z_TYPE_P(retval_ptr) == IS_OBJECT
+				&& instanceof_function(Z_OBJCE_P(retval_ptr), php_event_ssl_context_ce TSRMLS_CC)) {
+			PHP_EVENT_FETCH_SSL_CONTEXT(target, retval_ptr);
+
+			if (target == ectx || target->ctx == NULL) {
+				/* Use the default certificate */
+				target = NULL;
+			} else {
+				sni_add(&ectx->sni, host, host_len, retval_ptr);
+			}
+		}
+		zval_ptr_dtor(&retval_ptr);
+	} else if (!EG(exception)) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "Failed to invoke SNI callback");
+	}
+
+	zval_ptr_dtor(&arg_host);
+
+	return target;
+}
+/* }}} */
+
+/* {{{ sni_find
+ * Finds the context for the lowercase hostname: exact names first, then
+ * "*.suffix" wildcards matching a single leftmost label, then the callback */
+static php_event_ssl_context_t *sni_find(php_event_ssl_context_t *ectx, const char *host, int host_len TSRMLS_DC)
+{
+	php_event_ssl_context_t  *target;
+	zval                    **ppzctx;
+	const char               *dot;
+
+	if (ectx->sni && zend_hash_find(ectx->sni, host, host_len + 1, (void **) &ppzctx) == SUCCESS) {
+		PHP_EVENT_FETCH_SSL_CONTEXT(target, *ppzctx);
+		return target;
+	}
+
+	dot = memchr(host, '.', host_len);
+	if (ectx->sni_wildcard && dot && dot > host && dot + 1 < host + host_len) {
+		if (zend_hash_find(ectx->sni_wildcard, dot + 1,
+					host_len - (int) (dot + 1 - host) + 1, (void **) &ppzctx) == SUCCESS) {
+			PHP_EVENT_FETCH_SSL_CONTEXT(target, *ppzctx);
+			return target;
+		}
+	}
+
+	return sni_load(ectx, host, host_len TSRMLS_CC);
+}
+/* }}} */
+
+/* {{{ sni_callback
+ * Switches the connection to the SSL_CTX of the requested server name. The
+ * certificates are loaded once per EventSslContext, and shared by the
+ * connections. */
+static int sni_callback(SSL *ssl, int *ad, void *arg)
+{
+	php_event_ssl_context_t *ectx;
+	php_event_ssl_context_t *target;
+	const char              *servername;
+	char                     host[256];
+	size_t                   host_len;
+	PHP_EVENT_TSRM_DECL
+
+	/* The SSL_CTX may be shared by several contexts(OPT_SHARED_CTX), so
+	 * the servername argument of the SSL_CTX is not used */
+	ectx = (php_event_ssl_context_t *) SSL_get_ex_data(ssl, php_event_ssl_data_index);
+
+	servername = SSL_get_servername(ssl, TLSEXT_NAMETYPE_host_name);
+	if (!servername || !ectx) {
+		return SSL_TLSEXT_ERR_NOACK;
+	}
+
+	host_len = strlen(servername);
+	if (host_len == 0 || host_len >= sizeof(host)) {
+		return SSL_TLSEXT_ERR_NOACK;
+	}
+	zend_str_tolower_copy(host, servername, host_len);
+
+	PHP_EVENT_TSRMLS_FETCH_FROM_CTX(ectx->thread_ctx);
+
+	target = sni_find(ectx, host, (int) host_len TSRMLS_CC);
+	if (!target || !target->ctx) {
+		/* Proceed with the default certificate */
+		return SSL_TLSEXT_ERR_NOACK;
+	}
+
+	if (SSL_get_SSL_CTX(ssl) != target->ctx) {
+		SSL_set_SSL_CTX(ssl, target->ctx);
+	}
+
+	return SSL_TLSEXT_ERR_OK;
+}
+/* }}} */
+
+/* {{{ sni_enable */
+static zend_always_inline void sni_enable(php_event_ssl_context_t *ectx TSRMLS_DC)
+{
+	TSRMLS_SET_CTX(ectx->thread_ctx);
+
+	SSL_CTX_set_tlsext_servername_callback(ectx->ctx, sni_callback);
+}
+/* }}} */
+
+/* {{{ sni_parse_hostname
+ * Lowercases hostname into buf. Returns the length of the key, or 0, if the
+ * hostname is invalid. *wildcard is set for "*.suffix", and the key is the
+ * suffix. */
+static int sni_parse_hostname(char *buf, int buf_size, const char *hostname, int hostname_len, zend_bool *wildcard)
+{
+	*wildcard = 0;
+
+	if (hostname_len > 2 && hostname[0] == '*' && hostname[1] == '.') {
+		*wildcard     = 1;
+		hostname     += 2;
+		hostname_len -= 2;
+	}
+
+	if (hostname_len <= 0 || hostname_len >= buf_size
+			|| memchr(hostname, '*', hostname_len) || memchr(hostname, '\0', hostname_len)) {
+		return 0;
+	}
+
+	zend_str_tolower_copy(buf, hostname, hostname_len);
+
+	return hostname_len;
+}
+/* }}} */
+#endif
+
+/* {{{ Shared SSL_CTX cache
+ * SSL_CTX objects created with OPT_SHARED_CTX are cached per process by the
+ * digest of the method and the options. The contexts constructed with the same
+ * method and options share a single SSL_CTX, so the certificates and keys are
+ * parsed once. */
+static HashTable ctx_cache;
+#ifdef ZTS
+static MUTEX_T   ctx_cache_mutex;
+# define CTX_CACHE_LOCK()   tsrm_mutex_lock(ctx_cache_mutex)
+# define CTX_CACHE_UNLOCK() tsrm_mutex_unlock(ctx_cache_mutex)
+#else
+# define CTX_CACHE_LOCK()
+# define CTX_CACHE_UNLOCK()
+#endif
+
+/* Options naming the files checked for modifications */
+static const ulong ctx_cache_files[] = {
+	PHP_EVENT_OPT_LOCAL_CERT,
+	PHP_EVENT_OPT_LOCAL_PK,
+	PHP_EVENT_OPT_CA_FILE
+};
+
+/* {{{ ctx_cache_entry_dtor */
+static void ctx_cache_entry_dtor(void *data)
+{
+	php_event_ssl_ctx_cache_entry_t *e = *(php_event_ssl_ctx_cache_entry_t **) data;
+
+	/* The connections and the objects using the SSL_CTX hold own references */
+	SSL_CTX_free(e->ctx);
+	pefree(e, 1);
+}
+/* }}} */
+
+/* {{{ ctx_cache_key_compare */
+static int ctx_cache_key_compare(const void *a, const void *b TSRMLS_DC)
+{
+	const Bucket *f = *((const Bucket **) a);
+	const Bucket *s = *((const Bucket **) b);
+
+	return f->h < s->h ? -1 : (f->h > s->h ? 1 : 0);
+}
+/* }}} */
+
+/* {{{ ctx_cache_key
+ * Computes the digest of the method and the options ordered by index into key.
+ * Returns the length of the digest, or 0 on failure. */
+static unsigned int ctx_cache_key(unsigned char *key, long method, HashTable *ht TSRMLS_DC)
+{
+	EVP_MD_CTX   *md;
+	HashTable    *sorted;
+	HashPosition  pos;
+	zval        **ppzval;
+	zval          tmp;
+	char         *str_key;
+	uint          str_key_len;
+	ulong         idx;
+	size_t        len;
+	unsigned int  key_len = 0;
+
+	md = EVP_MD_CTX_create();
+	if (md == NULL) {
+		return 0;
+	}
+	if (!EVP_DigestInit_ex(md, EVP_sha256(), NULL)) {
+		EVP_MD_CTX_destroy(md);
+		return 0;
+	}
+	EVP_DigestUpdate(md, &method, sizeof(method));
+
+	ALLOC_HASHTABLE(sorted);
+	zend_hash_init(sorted, zend_hash_num_elements(ht), NULL, NULL, 0);
+	zend_hash_copy(sorted, ht, NULL, NULL, sizeof(zval *));
+	zend_hash_sort(sorted, zend_qsort, ctx_cache_key_compare, 0 TSRMLS_CC);
+
+	for (zend_hash_internal_pointer_reset_ex(sorted, &pos);
+			zend_hash_get_current_data_ex(sorted, (void **) &ppzval, &pos) == SUCCESS;
+			zend_hash_move_forward_ex(sorted, &pos)) {
+		if (zend_hash_get_current_key_ex(sorted, &str_key, &str_key_len, &idx, 0, &pos) != HASH_KEY_IS_LONG
+				|| idx == PHP_EVENT_OPT_SHARED_CTX
+				|| idx == PHP_EVENT_OPT_DYNAMIC_RECORDS) {
+			continue;
+		}
+
+		EVP_DigestUpdate(md, &idx, sizeof(idx));
+
+		if (Z_TYPE_PP(ppzval) == IS_ARRAY) {
+			HashPosition   ipos;
+			zval         **ppzitem;
+
+			for (zend_hash_internal_pointer_reset_ex(Z_ARRVAL_PP(ppzval), &ipos);
+					zend_hash_get_current_data_ex(Z_ARRVAL_PP(ppzval), (void **) &ppzitem, &ipos) == SUCCESS;
+					zend_hash_move_forward_ex(Z_ARRVAL_PP(ppzval), &ipos)) {
+				tmp = **ppzitem;
+				zval_copy_ctor(&tmp);
+				convert_to_string(&tmp);
+
+				len = (size_t) Z_STRLEN(tmp);
+				EVP_DigestUpdate(md, &len, sizeof(len));
+				EVP_DigestUpdate(md, Z_STRVAL(tmp), len);
+				zval_dtor(&tmp);
+			}
+			continue;
+		}
+
+		tmp = **ppzval;
+		zval_copy_ctor(&tmp);
+		convert_to_string(&tmp);
+
+		len = (size_t) Z_STRLEN(tmp);
+		EVP_DigestUpdate(md, &len, sizeof(len));
+		EVP_DigestUpdate(md, Z_STRVAL(tmp), len);
+		zval_dtor(&tmp);
+	}
+
+	zend_hash_destroy(sorted);
+	FREE_HASHTABLE(sorted);
+
+	if (!EVP_DigestFinal_ex(md, key, &key_len)) {
+		key_len = 0;
+	}
+	EVP_MD_CTX_destroy(md);
+
+	return key_len;
+}
+/* }}} */
+
+/* {{{ ctx_cache_mtimes
+ * Fetches modification times of the files passed in options */
+static void ctx_cache_mtimes(time_t *mtime, HashTable *ht)
+{
+	struct stat   st;
+	zval        **ppzval;
+	size_t        i;
+
+	for (i = 0; i < sizeof(ctx_cache_files) / sizeof(ctx_cache_files[0]); i++) {
+		mtime[i] = 0;
+
+		if (zend_hash_index_find(ht, ctx_cache_files[i], (void **) &ppzval) == SUCCESS
+				&& Z_TYPE_PP(ppzval) == IS_STRING
+				&& VCWD_STAT(Z_STRVAL_PP(ppzval), &st) == 0) {
+			mtime[i] = st.st_mtime;
+		}
+	}
+}
+/* }}} */
+
+/* {{{ ctx_cache_find
+ * Returns a new reference to the cached SSL_CTX, or NULL. If any of the files
+ * has been modified since the SSL_CTX creation, the entry is dropped, and the
+ * caller creates a new SSL_CTX. Live connections keep the old one. */
+static SSL_CTX *ctx_cache_find(const unsigned char *key, unsigned int key_len, const time_t *mtime)
+{
+	php_event_ssl_ctx_cache_entry_t **pe;
+	SSL_CTX                          *ctx = NULL;
+
+	CTX_CACHE_LOCK();
+
+	if (zend_hash_find(&ctx_cache, (const char *) key, key_len, (void **) &pe) == SUCCESS) {
+		if (memcmp((*pe)->mtime, mtime, sizeof((*pe)->mtime)) == 0) {
+			ctx = (*pe)->ctx;
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L || (defined(LIBRESSL_VERSION_NUMBER) && LIBRESSL_VERSION_NUMBER >= 0x2070000fL)
+			SSL_CTX_up_ref(ctx);
+#else
+			CRYPTO_add(&ctx->references, 1, CRYPTO_LOCK_SSL_CTX);
+#endif
+		} else {
+			zend_hash_del(&ctx_cache, (const char *) key, key_len);
+		}
+	}
+
+	CTX_CACHE_UNLOCK();
+
+	return ctx;
+}
+/* }}} */
+
+/* {{{ ctx_cache_add */
+static void ctx_cache_add(const unsigned char *key, unsigned int key_len, const time_t *mtime, SSL_CTX *ctx)
+{
+	php_event_ssl_ctx_cache_entry_t *e;
+
+	e = pemalloc(sizeof(php_event_ssl_ctx_cache_entry_t), 1);
+	memcpy(e->mtime, mtime, sizeof(e->mtime));
+	e->ctx = ctx;
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L || (defined(LIBRESSL_VERSION_NUMBER) && LIBRESSL_VERSION_NUMBER >= 0x2070000fL)
+	SSL_CTX_up_ref(ctx);
+#else
+	CRYPTO_add(&ctx->references, 1, CRYPTO_LOCK_SSL_CTX);
+#endif
+
+	CTX_CACHE_LOCK();
+	zend_hash_update(&ctx_cache, (const char *) key, key_len, (void *) &e, sizeof(e), NULL);
+	CTX_CACHE_UNLOCK();
+}
+/* }}} */
+/* Shared SSL_CTX cache }}} */
+
+/* {{{ reload_ssl_ctx
+ * Replaces the SSL_CTX of ectx with a new one configured from the options
+ * merged with ht_options, if not NULL. On failure the SSL_CTX and the options
+ * are left intact. The live connections hold own references to the old SSL_CTX. */
+static int reload_ssl_ctx(php_event_ssl_context_t *ectx, HashTable *ht_options TSRMLS_DC)
+{
+	SSL_METHOD *method;
+	SSL_CTX    *old_ctx = ectx->ctx;
+	HashTable  *old_ht  = ectx->ht;
+
+	method = get_ssl_method(ectx->method TSRMLS_CC);
+	if (method == NULL) {
+		return FAILURE;
+	}
+
+	ectx->ctx = SSL_CTX_new(method);
+	if (ectx->ctx == NULL) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "Creation of a new SSL_CTX object failed");
+		ectx->ctx = old_ctx;
+		return FAILURE;
+	}
+
+	if (ht_options) {
+		ALLOC_HASHTABLE(ectx->ht);
+		zend_hash_init(ectx->ht, zend_hash_num_elements(old_ht), NULL, ZVAL_PTR_DTOR, 0);
+		zend_hash_copy(ectx->ht, old_ht, (copy_ctor_func_t) zval_add_ref,
+				(void *) NULL, sizeof(zval *));
+		zend_hash_merge(ectx->ht, ht_options, (copy_ctor_func_t) zval_add_ref,
+				(void *) NULL, sizeof(zval *), 1);
+	}
+
+	configure_ssl_ctx(ectx TSRMLS_CC);
+
+	/* Fails also if the files are missing, or don't match */
+	if (zend_hash_index_exists(ectx->ht, PHP_EVENT_OPT_LOCAL_CERT)
+			&& SSL_CTX_check_private_key(ectx->ctx) != 1) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "Failed to load the certificate and the private key");
+		ERR_clear_error();
+
+		SSL_CTX_free(ectx->ctx);
+		ectx->ctx = old_ctx;
+		if (ectx->ht != old_ht) {
+			zend_hash_destroy(ectx->ht);
+			FREE_HASHTABLE(ectx->ht);
+			ectx->ht = old_ht;
+		}
+		return FAILURE;
+	}
+
+	if (ectx->ht != old_ht) {
+		set_ssl_ectx_options(ectx TSRMLS_CC);
+	}
+
+	/* The state applied to the SSL_CTX by the methods */
+#ifdef PHP_EVENT_SSL_TICKET_KEYS
+	if (ectx->ticket_keys[0].set) {
+		set_ticket_key_callback(ectx->ctx);
+	}
+#endif
+#ifdef PHP_EVENT_SSL_SNI
+	if (ectx->sni || ectx->sni_wildcard || ectx->sni_fci) {
+		sni_enable(ectx TSRMLS_CC);
+	}
+#endif
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L && !defined(LIBRESSL_VERSION_NUMBER)
+	/* The OPT_NO_* options passed to reload() take precedence */
+	if (ht_options && (zend_hash_index_exists(ht_options, PHP_EVENT_OPT_NO_SSLv2)
+				|| zend_hash_index_exists(ht_options, PHP_EVENT_OPT_NO_SSLv3)
+				|| zend_hash_index_exists(ht_options, PHP_EVENT_OPT_NO_TLSv1)
+				|| zend_hash_index_exists(ht_options, PHP_EVENT_OPT_NO_TLSv1_1)
+				|| zend_hash_index_exists(ht_options, PHP_EVENT_OPT_NO_TLSv1_2))) {
+		ectx->min_proto = 0;
+	}
+	if (ectx->min_proto) {
+		SSL_CTX_set_min_proto_version(ectx->ctx, ectx->min_proto);
+	}
+	if (ectx->max_proto) {
+		SSL_CTX_set_max_proto_version(ectx->ctx, ectx->max_proto);
+	}
+#endif
+
+	if (ectx->ht != old_ht) {
+		/* The passphrase callback of the old SSL_CTX refers to the old options */
+		SSL_CTX_set_default_passwd_cb(old_ctx, NULL);
+		SSL_CTX_set_default_passwd_cb_userdata(old_ctx, NULL);
+		zend_hash_destroy(old_ht);
+		FREE_HASHTABLE(old_ht);
+	}
+	SSL_CTX_free(old_ctx);
+
+	ctx_cache_mtimes(ectx->mtime, ectx->ht);
+
+	return SUCCESS;
+}
+/* }}} */
+
+/* {{{ watch_callback
+ * Reloads the SSL_CTX, if any of the files is modified */
+static void watch_callback(evutil_socket_t fd, short what, void *arg)
+{
+	php_event_ssl_context_t *ectx = (php_event_ssl_context_t *) arg;
+	time_t                   mtime[sizeof(ectx->mtime) / sizeof(ectx->mtime[0])];
+	PHP_EVENT_TSRM_DECL
+
+	ctx_cache_mtimes(mtime, ectx->ht);
+	if (memcmp(mtime, ectx->mtime, sizeof(mtime)) == 0) {
+		return;
+	}
+
+	PHP_EVENT_TSRMLS_FETCH_FROM_CTX(ectx->thread_ctx);
+
+	if (reload_ssl_ctx(ectx, NULL TSRMLS_CC) == FAILURE) {
+		/* Probably caught in the middle of an update. Retried after the next
+		 * modification */
+		memcpy(ectx->mtime, mtime, sizeof(mtime));
+	}
+}
+/* }}} */
+
+/* {{{ metrics_export
+ * Adds copy of the counters in ht to arr under name */
+static void metrics_export(zval *arr, const char *name, HashTable *ht)
+{
+	zval         *zcounters;
+	HashPosition  pos;
+	long         *pn;
+	char         *key;
+	uint          key_len;
+	ulong         idx;
+
+	MAKE_STD_ZVAL(zcounters);
+	array_init(zcounters);
+
+	if (ht) {
+		for (zend_hash_internal_pointer_reset_ex(ht, &pos);
+				zend_hash_get_current_data_ex(ht, (void **) &pn, &pos) == SUCCESS;
+				zend_hash_move_forward_ex(ht, &pos)) {
+			if (zend_hash_get_current_key_ex(ht, &key, &key_len, &idx, 0, &pos) == HASH_KEY_IS_STRING) {
+				add_assoc_long_ex(zcounters, key, key_len, *pn);
+			}
+		}
+	}
+
+	add_assoc_zval(arr, name, zcounters);
+}
+/* }}} */
+
+/* Private }}} */
+
+/* {{{ php_event_ssl_ctx_cache_init */
+void php_event_ssl_ctx_cache_init(void)
+{
+	zend_hash_init(&ctx_cache, 8, NULL, ctx_cache_entry_dtor, 1);
+#ifdef ZTS
+	ctx_cache_mutex = tsrm_mutex_alloc();
+#endif
+}
+/* }}} */
+
+/* {{{ php_event_ssl_ctx_cache_destroy */
+void php_event_ssl_ctx_cache_destroy(void)
+{
+	zend_hash_destroy(&ctx_cache);
+#ifdef ZTS
+	tsrm_mutex_free(ctx_cache_mutex);
+#endif
+}
+/* }}} */
+
+/* {{{ php_event_ssl_context_unwatch
+ * Stops the timer of EventSslContext::watch() */
+void php_event_ssl_context_unwatch(php_event_ssl_context_t *ectx)
+{
+	if (ectx->watch_ev) {
+		event_free(ectx->watch_ev);
+		ectx->watch_ev = NULL;
+	}
+
+	if (ectx->watch_base) {
+		zval_ptr_dtor(&ectx->watch_base);
+		ectx->watch_base = NULL;
+	}
+}
+/* }}} */
+
+
+/* {{{ proto EventSslContext EventSslContext::__construct(int method, array options);
+ *
+ * Creates SSL context holding pointer to SSL_CTX.
+ * method parameter is one of EventSslContext::*_METHOD constants.
+ * options parameter is an associative array of SSL context options.
+ *
+ * With OPT_SHARED_CTX option the SSL_CTX is shared with the other contexts
+ * created with the same method and options. The shared SSL_CTX is re-created,
+ * when the local_cert, local_pk, or cafile files are modified. */
+PHP_METHOD(EventSslContext, __construct)
+{
+	php_event_ssl_context_t  *ectx;
+	HashTable                *ht_options;
+	long                      in_method;
+	SSL_METHOD               *method;
+	SSL_CTX                  *ctx;
+	zval                    **ppzshared;
+	zend_bool                 cached;
+	unsigned char             key[EVP_MAX_MD_SIZE];
+	unsigned int              key_len    = 0;
+	time_t                    mtime[sizeof(ctx_cache_files) / sizeof(ctx_cache_files[0])];
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "lh",
+				&in_method, &ht_options) == FAILURE) {
+		return;
 	}
 
 	method = get_ssl_method(in_method TSRMLS_CC);
@@ -556,15 +1702,28 @@ PHP_METHOD(EventSslContext, __construct)
 		return;
 	}
 
-	ctx = SSL_CTX_new(method);
-	if (ctx == NULL) {
-		php_error_docref(NULL TSRMLS_CC, E_WARNING,
-				"Creation of a new SSL_CTX object failed");
-		return;
+	if (zend_hash_index_find(ht_options, PHP_EVENT_OPT_SHARED_CTX, (void **) &ppzshared) == SUCCESS
+			&& zend_is_true(*ppzshared)) {
+		key_len = ctx_cache_key(key, in_method, ht_options TSRMLS_CC);
+	}
+	ctx_cache_mtimes(mtime, ht_options);
+
+	ctx    = key_len ? ctx_cache_find(key, key_len, mtime) : NULL;
+	cached = (ctx != NULL);
+
+	if (!cached) {
+		ctx = SSL_CTX_new(method);
+		if (ctx == NULL) {
+			php_error_docref(NULL TSRMLS_CC, E_WARNING,
+					"Creation of a new SSL_CTX object failed");
+			return;
+		}
 	}
 
 	PHP_EVENT_FETCH_SSL_CONTEXT(ectx, getThis());
-	ectx->ctx = ctx;
+	ectx->ctx    = ctx;
+	ectx->method = in_method;
+	memcpy(ectx->mtime, mtime, sizeof(ectx->mtime));
 
 	ALLOC_HASHTABLE(ectx->ht);
 	if (zend_hash_init_ex(ectx->ht, zend_hash_num_elements(ht_options), NULL, ZVAL_PTR_DTOR, 0, 0) == FAILURE) {
@@ -576,11 +1735,22 @@ PHP_METHOD(EventSslContext, __construct)
 	zend_hash_copy(ectx->ht, ht_options, (copy_ctor_func_t) zval_add_ref,
 			(void *) NULL, sizeof(zval *));
 
-	SSL_CTX_set_options(ectx->ctx, options);
-	set_ssl_ctx_options(ectx TSRMLS_CC);
+	if (cached) {
+		/* The SSL_CTX is configured already */
+		set_ssl_ectx_options(ectx TSRMLS_CC);
+		return;
+	}
 
-	/* Issue #20 */
-	SSL_CTX_set_session_id_context(ectx->ctx, (unsigned char *)(void *)ectx->ctx, sizeof(ectx->ctx));
+	configure_ssl_ctx(ectx TSRMLS_CC);
+	set_ssl_ectx_options(ectx TSRMLS_CC);
+
+	if (key_len) {
+		/* The keys are loaded. The passphrase belongs to this object */
+		SSL_CTX_set_default_passwd_cb(ectx->ctx, NULL);
+		SSL_CTX_set_default_passwd_cb_userdata(ectx->ctx, NULL);
+
+		ctx_cache_add(key, key_len, mtime, ectx->ctx);
+	}
 }
 /* }}} */
 
@@ -602,8 +1772,11 @@ PHP_METHOD(EventSslContext, setMinProtoVersion)
 	PHP_EVENT_FETCH_SSL_CONTEXT(ectx, getThis());
 
 	if (!SSL_CTX_set_min_proto_version(ectx->ctx, proto)) {
-		RETVAL_FALSE;
+		RETURN_FALSE;
 	}
+	/* Applied again by reload() */
+	ectx->min_proto = proto;
+
 	RETVAL_TRUE;
 } /*}}}*/
 
@@ -623,12 +1796,379 @@ PHP_METHOD(EventSslContext, setMaxProtoVersion)
 	PHP_EVENT_FETCH_SSL_CONTEXT(ectx, getThis());
 
 	if (!SSL_CTX_set_max_proto_version(ectx->ctx, proto)) {
-		RETVAL_FALSE;
+		RETURN_FALSE;
 	}
+	/* Applied again by reload() */
+	ectx->max_proto = proto;
+
 	RETVAL_TRUE;
 } /*}}}*/
 #endif /* OpenSSL version >= 1.1.0 */
 
+/* {{{ proto array EventSslContext::getSessionStats(void);
+ *
+ * Returns session resumption counters of the context: handshakes completed,
+ * handshakes resumed, the OpenSSL server session cache counters, and the
+ * number of entries in the client session cache. */
+PHP_METHOD(EventSslContext, getSessionStats)
+{
+	php_event_ssl_context_t *ectx;
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_SSL_CONTEXT(ectx, getThis());
+	if (ectx->ctx == NULL) {
+		RETURN_FALSE;
+	}
+
+	array_init(return_value);
+
+	add_assoc_long(return_value, "handshakes",     ectx->handshakes);
+	add_assoc_long(return_value, "resumed",        ectx->resumed);
+	add_assoc_long(return_value, "cache_hits",     SSL_CTX_sess_hits(ectx->ctx));
+	add_assoc_long(return_value, "cache_misses",   SSL_CTX_sess_misses(ectx->ctx));
+	add_assoc_long(return_value, "cache_timeouts", SSL_CTX_sess_timeouts(ectx->ctx));
+	add_assoc_long(return_value, "cache_full",     SSL_CTX_sess_cache_full(ectx->ctx));
+	add_assoc_long(return_value, "cached",         SSL_CTX_sess_number(ectx->ctx));
+	add_assoc_long(return_value, "client_cached",
+			ectx->sessions ? zend_hash_num_elements(ectx->sessions) : 0);
+}
+/* }}} */
+
+/* {{{ proto array EventSslContext::getMetrics([bool reset = FALSE]);
+ *
+ * Returns snapshot of the TLS metrics of the context: the numbers of full and
+ * resumed handshakes; and, with OPT_METRICS option, the handshake latency
+ * histogram(bucket upper bound in milliseconds => count), fatal alerts sent
+ * and received by description, record bytes encrypted and decrypted, and the
+ * numbers of handshakes by negotiated cipher and protocol. If reset is TRUE,
+ * the counters are zeroed after the snapshot. */
+PHP_METHOD(EventSslContext, getMetrics)
+{
+	php_event_ssl_context_t *ectx;
+	php_event_ssl_metrics_t *m;
+	zend_bool                reset    = 0;
+	zval                    *zlatency;
+	zval                    *zfailures;
+	size_t                   i;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "|b", &reset) == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_SSL_CONTEXT(ectx, getThis());
+	if (ectx->ctx == NULL) {
+		RETURN_FALSE;
+	}
+	m = ectx->metrics;
+
+	array_init(return_value);
+
+	add_assoc_long(return_value, "handshakes", ectx->handshakes);
+	add_assoc_long(return_value, "full",       ectx->handshakes - ectx->resumed);
+	add_assoc_long(return_value, "resumed",    ectx->resumed);
+
+	MAKE_STD_ZVAL(zlatency);
+	array_init(zlatency);
+	for (i = 0; i < PHP_EVENT_SSL_LATENCY_BUCKETS - 1; i++) {
+		add_index_long(zlatency, metrics_latency_bounds[i], m ? m->latency[i] : 0);
+	}
+	add_assoc_long(zlatency, "+Inf", m ? m->latency[i] : 0);
+	add_assoc_zval(return_value, "handshake_latency", zlatency);
+
+	MAKE_STD_ZVAL(zfailures);
+	array_init(zfailures);
+	metrics_export(zfailures, "sent",     m ? &m->alerts_sent : NULL);
+	metrics_export(zfailures, "received", m ? &m->alerts_received : NULL);
+	add_assoc_zval(return_value, "failures", zfailures);
+
+	add_assoc_long(return_value, "bytes_encrypted", m ? m->bytes_encrypted : 0);
+	add_assoc_long(return_value, "bytes_decrypted", m ? m->bytes_decrypted : 0);
+	metrics_export(return_value, "ciphers",   m ? &m->ciphers : NULL);
+	metrics_export(return_value, "protocols", m ? &m->protocols : NULL);
+
+	if (reset) {
+		ectx->handshakes = 0;
+		ectx->resumed    = 0;
+
+		if (m) {
+			memset(m->latency, 0, sizeof(m->latency));
+			m->bytes_encrypted = 0;
+			m->bytes_decrypted = 0;
+			zend_hash_clean(&m->alerts_sent);
+			zend_hash_clean(&m->alerts_received);
+			zend_hash_clean(&m->ciphers);
+			zend_hash_clean(&m->protocols);
+		}
+	}
+}
+/* }}} */
+
+#ifdef PHP_EVENT_SSL_TICKET_KEYS
+/* {{{ proto bool EventSslContext::rotateTicketKeys(void);
+ *
+ * Generates a new session ticket key. New tickets are issued with the new key.
+ * The tickets issued with the previous key are still accepted, and renewed. */
+PHP_METHOD(EventSslContext, rotateTicketKeys)
+{
+	php_event_ssl_context_t *ectx;
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_SSL_CONTEXT(ectx, getThis());
+	if (ectx->ctx == NULL) {
+		RETURN_FALSE;
+	}
+
+	if (rotate_ticket_keys(ectx) == FAILURE) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "Failed to generate session ticket key");
+		RETURN_FALSE;
+	}
+
+	RETVAL_TRUE;
+}
+/* }}} */
+#endif
+
+#ifdef PHP_EVENT_SSL_SNI
+/* {{{ proto bool EventSslContext::addSniContext(string hostname, EventSslContext ctx);
+ *
+ * Makes the server connections requesting hostname(Server Name Indication)
+ * use the certificate and private key of ctx. hostname is either an exact
+ * name, or a "*.suffix" wildcard matching a single label. Exact names take
+ * precedence over wildcards. Other connections use the certificate of this
+ * context. */
+PHP_METHOD(EventSslContext, addSniContext)
+{
+	php_event_ssl_context_t *ectx;
+	php_event_ssl_context_t *target;
+	zval                    *zctx;
+	char                    *hostname;
+	int                      hostname_len;
+	char                     key[256];
+	int                      key_len;
+	zend_bool                wildcard;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "sO",
+				&hostname, &hostname_len, &zctx, php_event_ssl_context_ce) == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_SSL_CONTEXT(ectx, getThis());
+	PHP_EVENT_FETCH_SSL_CONTEXT(target, zctx);
+
+	if (ectx->ctx == NULL || target->ctx == NULL) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "SSL context is not initialized");
+		RETURN_FALSE;
+	}
+	if (target == ectx) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "Can't add the context to itself");
+		RETURN_FALSE;
+	}
+
+	key_len = sni_parse_hostname(key, sizeof(key), hostname, hostname_len, &wildcard);
+	if (key_len == 0) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "Invalid hostname: `%s'", hostname);
+		RETURN_FALSE;
+	}
+
+	sni_add(wildcard ? &ectx->sni_wildcard : &ectx->sni, key, key_len, zctx);
+	sni_enable(ectx TSRMLS_CC);
+
+	RETVAL_TRUE;
+}
+/* }}} */
+
+/* {{{ proto bool EventSslContext::removeSniContext(string hostname);
+ *
+ * Removes the context added for hostname with addSniContext(). */
+PHP_METHOD(EventSslContext, removeSniContext)
+{
+	php_event_ssl_context_t *ectx;
+	HashTable               *ht;
+	char                    *hostname;
+	int                      hostname_len;
+	char                     key[256];
+	int                      key_len;
+	zend_bool                wildcard;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "s",
+				&hostname, &hostname_len) == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_SSL_CONTEXT(ectx, getThis());
+
+	key_len = sni_parse_hostname(key, sizeof(key), hostname, hostname_len, &wildcard);
+	ht      = wildcard ? ectx->sni_wildcard : ectx->sni;
+
+	if (key_len == 0 || ht == NULL) {
+		RETURN_FALSE;
+	}
+
+	RETVAL_BOOL(zend_hash_del(ht, key, key_len + 1) == SUCCESS);
+}
+/* }}} */
+
+/* {{{ proto void EventSslContext::setSniCallback(callable cb);
+ *
+ * Sets callback loading the context of a hostname unknown to addSniContext():
+ *
+ * ?EventSslContext cb(string hostname);
+ *
+ * The hostname is lowercase. The returned context is added for the hostname,
+ * so the callback is invoked once per hostname. If the callback returns NULL,
+ * the connection uses the certificate of this context. Pass NULL to remove
+ * the callback. */
+PHP_METHOD(EventSslContext, setSniCallback)
+{
+	php_event_ssl_context_t *ectx;
+	zend_fcall_info          fci   = empty_fcall_info;
+	zend_fcall_info_cache    fcc   = empty_fcall_info_cache;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "f!",
+				&fci, &fcc) == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_SSL_CONTEXT(ectx, getThis());
+	if (ectx->ctx == NULL) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "SSL context is not initialized");
+		return;
+	}
+
+	PHP_EVENT_FREE_FCALL_INFO(ectx->sni_fci, ectx->sni_fcc);
+
+	if (ZEND_FCI_INITIALIZED(fci)) {
+		PHP_EVENT_COPY_FCALL_INFO(ectx->sni_fci, ectx->sni_fcc, &fci, &fcc);
+		sni_enable(ectx TSRMLS_CC);
+	}
+}
+/* }}} */
+#endif
+
+/* {{{ proto int EventSslContext::clearSharedCache(void);
+ *
+ * Drops the SSL_CTX objects cached for OPT_SHARED_CTX. The contexts created
+ * afterwards re-read the certificates. The existing contexts and connections
+ * keep using the old SSL_CTX objects. Returns the number of dropped objects. */
+PHP_METHOD(EventSslContext, clearSharedCache)
+{
+	long n;
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	CTX_CACHE_LOCK();
+	n = (long) zend_hash_num_elements(&ctx_cache);
+	zend_hash_clean(&ctx_cache);
+	CTX_CACHE_UNLOCK();
+
+	RETURN_LONG(n);
+}
+/* }}} */
+
+/* {{{ proto bool EventSslContext::reload([array options = NULL]);
+ *
+ * Re-reads the certificate, the chain and the private key into a new SSL_CTX,
+ * which replaces the current one. options, if passed, are merged into the
+ * options of the context, e.g. to switch to new local_cert and local_pk
+ * files. The new handshakes use the new SSL_CTX, the established connections
+ * keep the old one. This applies also to the buffer events created for
+ * EventListener connections and to EventHttp servers.
+ *
+ * With OPT_SHARED_CTX option the context gets own SSL_CTX. Session tickets
+ * issued with the ticket keys of the context remain valid. The protocol
+ * versions set with setMinProtoVersion() and setMaxProtoVersion() are applied
+ * to the new SSL_CTX, unless OPT_NO_* options are passed.
+ *
+ * Returns FALSE and keeps the current SSL_CTX, if the files can't be loaded. */
+PHP_METHOD(EventSslContext, reload)
+{
+	php_event_ssl_context_t *ectx;
+	HashTable               *ht_options = NULL;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "|h!", &ht_options) == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_SSL_CONTEXT(ectx, getThis());
+	if (ectx->ctx == NULL) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "SSL context is not initialized");
+		RETURN_FALSE;
+	}
+
+	RETVAL_BOOL(reload_ssl_ctx(ectx, ht_options TSRMLS_CC) == SUCCESS);
+}
+/* }}} */
+
+/* {{{ proto bool EventSslContext::watch(EventBase base[, float interval = 5.0]);
+ *
+ * Checks modification times of the local_cert, local_pk and cafile files every
+ * interval seconds, and reloads the context(see reload()), when any of the
+ * files is modified. The files should be replaced by renaming, so a partially
+ * written file is never loaded. A failed reload is retried after the next
+ * modification. Zero interval stops watching. */
+PHP_METHOD(EventSslContext, watch)
+{
+	php_event_ssl_context_t *ectx;
+	php_event_base_t        *b;
+	zval                    *zbase;
+	double                   interval = 5.0;
+	struct timeval           tv;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS() TSRMLS_CC, "O|d",
+				&zbase, php_event_base_ce, &interval) == FAILURE) {
+		return;
+	}
+
+	PHP_EVENT_FETCH_SSL_CONTEXT(ectx, getThis());
+	if (ectx->ctx == NULL) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "SSL context is not initialized");
+		RETURN_FALSE;
+	}
+
+	if (interval < 0) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "Interval must be non-negative");
+		RETURN_FALSE;
+	}
+
+	php_event_ssl_context_unwatch(ectx);
+
+	if (interval == 0) {
+		RETURN_TRUE;
+	}
+
+	PHP_EVENT_FETCH_BASE(b, zbase);
+	PHP_EVENT_ASSERT(b && b->base);
+
+	ectx->watch_ev = event_new(b->base, -1, EV_PERSIST, watch_callback, (void *) ectx);
+	if (!ectx->watch_ev) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "event_new failed");
+		RETURN_FALSE;
+	}
+
+	PHP_EVENT_TIMEVAL_SET(tv, interval);
+	if (event_add(ectx->watch_ev, &tv)) {
+		php_error_docref(NULL TSRMLS_CC, E_WARNING, "Failed adding the timer");
+		php_event_ssl_context_unwatch(ectx);
+		RETURN_FALSE;
+	}
+
+	Z_ADDREF_P(zbase);
+	ectx->watch_base = zbase;
+
+	TSRMLS_SET_CTX(ectx->thread_ctx);
+
+	RETVAL_TRUE;
+}
+/* }}} */
+
 /*
  * Local variables:
  * tab-width: 4
@@ -20,6 +20,15 @@
 #include "src/util.h"
 #include "src/priv.h"
 #include "classes/http.h"
+#include "classes/idle_reaper.h"
+#include "classes/buffer_event.h"
+#ifdef HAVE_EVENT_EXTRA_LIB
+# include "classes/listener.h"
+#endif
+#include "classes/shared_payload.h"
+#ifdef HAVE_EVENT_OPENSSL_LIB
+# include "classes/ssl_context.h"
+#endif
 #include "zend_exceptions.h"
 
 #if 0
@@ -36,6 +45,11 @@ zend_class_entry *php_event_config_ce;
 zend_class_entry *php_event_bevent_ce;
 zend_class_entry *php_event_buffer_ce;
 zend_class_entry *php_event_util_ce;
+zend_class_entry *php_event_idle_reaper_ce;
+zend_class_entry *php_event_shared_payload_ce;
+#ifdef PHP_EVENT_WORKER_POOL
+zend_class_entry *php_event_worker_pool_ce;
+#endif
 #ifdef HAVE_EVENT_OPENSSL_LIB
 zend_class_entry *php_event_ssl_context_ce;
 #endif
@@ -60,6 +74,9 @@ static HashTable event_listener_properties;
 #ifdef HAVE_EVENT_OPENSSL_LIB
 static HashTable event_ssl_context_properties;
 int php_event_ssl_data_index;
+int php_event_ssl_host_index;
+int php_event_ssl_start_index;
+int php_event_ssl_done_index;
 #endif
 
 
@@ -206,6 +223,17 @@ static void event_bevent_object_dtor(void *object, zend_object_handle handle TSR
 	zend_objects_destroy_object(object, handle TSRMLS_CC);
 }/*}}}*/
 
+static void event_idle_reaper_object_dtor(void *object, zend_object_handle handle TSRMLS_DC)/*{{{*/
+{
+	php_event_idle_reaper_t *r = (php_event_idle_reaper_t *) object;
+
+	PHP_EVENT_ASSERT(r);
+
+	php_event_idle_reaper_clear(r);
+
+	zend_objects_destroy_object(object, handle TSRMLS_CC);
+}/*}}}*/
+
 /* {{{ event_generic_object_free_storage */
 static zend_always_inline void event_generic_object_free_storage(void *ptr TSRMLS_DC)
 {
@@ -290,6 +318,19 @@ static void event_bevent_object_free_storage(void *ptr TSRMLS_DC)
 	php_event_bevent_t *b = (php_event_bevent_t *) ptr;
 
 	if (b) {
+		php_event_idle_reaper_unlink(b);
+		php_event_bevent_coalesce_free(b);
+		php_event_bevent_read_sizing_detach(b);
+#ifdef PHP_EVENT_SSL_RECORD_SIZING
+		php_event_bevent_record_sizing_detach(b);
+#endif
+		php_event_bevent_wprio_free(b);
+		php_event_bevent_cork_free(b);
+#ifdef PHP_EVENT_FD_PASSING
+		php_event_bevent_fdpass_free(b);
+#endif
+		php_event_bevent_conn_closed(b);
+
 #if 0
 		if (b->data) {
 			zval_ptr_dtor(&b->data);
@@ -320,6 +361,9 @@ static void event_bevent_object_free_storage(void *ptr TSRMLS_DC)
 #endif
 
 		if (b->bevent) {
+#ifdef PHP_EVENT_STATS
+			php_event_bevent_stats_detach(b);
+#endif
 			bufferevent_free(b->bevent);
 			b->bevent = NULL;
 		}
@@ -330,6 +374,55 @@ static void event_bevent_object_free_storage(void *ptr TSRMLS_DC)
 }
 /* }}} */
 
+/* {{{ event_idle_reaper_object_free_storage */
+static void event_idle_reaper_object_free_storage(void *ptr TSRMLS_DC)
+{
+	php_event_idle_reaper_t *r = (php_event_idle_reaper_t *) ptr;
+
+	PHP_EVENT_ASSERT(r);
+
+	php_event_idle_reaper_clear(r);
+
+	event_generic_object_free_storage(ptr TSRMLS_CC);
+}
+/* }}} */
+
+/* {{{ event_shared_payload_object_free_storage */
+static void event_shared_payload_object_free_storage(void *ptr TSRMLS_DC)
+{
+	php_event_shared_payload_t *p = (php_event_shared_payload_t *) ptr;
+
+	PHP_EVENT_ASSERT(p);
+
+	if (p->block) {
+		/* Buffers still holding the data keep their own references */
+		php_event_shared_block_release(p->block);
+		p->block = NULL;
+	}
+
+	event_generic_object_free_storage(ptr TSRMLS_CC);
+}
+/* }}} */
+
+#ifdef PHP_EVENT_WORKER_POOL
+/* {{{ event_worker_pool_object_free_storage */
+static void event_worker_pool_object_free_storage(void *ptr TSRMLS_DC)
+{
+	php_event_worker_pool_t *pool = (php_event_worker_pool_t *) ptr;
+
+	PHP_EVENT_ASSERT(pool);
+
+	/* Workers outlive the object; they are not killed here */
+	if (pool->workers) {
+		efree(pool->workers);
+		pool->workers = NULL;
+	}
+
+	event_generic_object_free_storage(ptr TSRMLS_CC);
+}
+/* }}} */
+#endif
+
 /* {{{ event_buffer_object_free_storage */
 static void event_buffer_object_free_storage(void *ptr TSRMLS_DC)
 {
@@ -390,12 +483,37 @@ static void event_listener_object_free_storage(void *ptr TSRMLS_DC)
 
 	PHP_EVENT_FREE_FCALL_INFO(l->fci, l->fcc);
 	PHP_EVENT_FREE_FCALL_INFO(l->fci_err, l->fcc_err);
+	PHP_EVENT_FREE_FCALL_INFO(l->fci_batch, l->fcc_batch);
+
+	if (l->tpl) {
+		php_event_bevent_template_free(l->tpl);
+		l->tpl = NULL;
+	}
+
+	php_event_listener_proxy_clear(l);
+
+	if (l->conns) {
+		/* Buffer events still alive keep their own references */
+		l->conns->owner = NULL;
+		php_event_conn_counter_release(l->conns);
+		l->conns = NULL;
+	}
+
+	if (l->batch_ev) {
+		event_free(l->batch_ev);
+		l->batch_ev = NULL;
+	}
 
 	if (l->listener) {
 		evconnlistener_free(l->listener);
 		l->listener = NULL;
 	}
 
+	if (l->base) {
+		zval_ptr_dtor(&l->base);
+		l->base = NULL;
+	}
+
 	event_generic_object_free_storage(ptr TSRMLS_CC);
 }
 /* }}} */
@@ -459,6 +577,11 @@ static void event_http_object_free_storage(void *ptr TSRMLS_DC)
 		cb = cb_next;
 	}
 
+	if (http->routes) {
+		_php_event_free_http_route(http->routes);
+		http->routes = NULL;
+	}
+
 	if (http->data) {
 		zval_ptr_dtor(&http->data);
 		http->data = NULL;
@@ -473,6 +596,13 @@ static void event_http_object_free_storage(void *ptr TSRMLS_DC)
 		evhttp_free(http->ptr);
 		http->ptr = NULL;
 	}
+#ifdef HAVE_EVENT_OPENSSL_LIB
+	/* Released after evhttp_free(), since the connections are created with it */
+	if (http->ctx) {
+		zval_ptr_dtor(&http->ctx);
+		http->ctx = NULL;
+	}
+#endif
 
 	event_generic_object_free_storage(ptr TSRMLS_CC);
 }
@@ -522,6 +652,8 @@ static void event_ssl_context_object_free_storage(void *ptr TSRMLS_DC)
 {
 	php_event_ssl_context_t *ectx = (php_event_ssl_context_t *) ptr;
 
+	php_event_ssl_context_unwatch(ectx);
+
 	if (ectx->ctx) {
 		SSL_CTX_free(ectx->ctx);
 		ectx->ctx = NULL;
@@ -533,6 +665,42 @@ static void event_ssl_context_object_free_storage(void *ptr TSRMLS_DC)
 		ectx->ht = NULL;
 	}
 
+	if (ectx->sessions) {
+		zend_hash_destroy(ectx->sessions);
+		FREE_HASHTABLE(ectx->sessions);
+		ectx->sessions = NULL;
+	}
+#ifdef PHP_EVENT_SSL_TICKET_KEYS
+	OPENSSL_cleanse(ectx->ticket_keys, sizeof(ectx->ticket_keys));
+#endif
+#ifdef PHP_EVENT_SSL_SNI
+	if (ectx->sni) {
+		zend_hash_destroy(ectx->sni);
+		FREE_HASHTABLE(ectx->sni);
+		ectx->sni = NULL;
+	}
+	if (ectx->sni_wildcard) {
+		zend_hash_destroy(ectx->sni_wildcard);
+		FREE_HASHTABLE(ectx->sni_wildcard);
+		ectx->sni_wildcard = NULL;
+	}
+	PHP_EVENT_FREE_FCALL_INFO(ectx->sni_fci, ectx->sni_fcc);
+#endif
+#ifdef PHP_EVENT_SSL_ALPN
+	if (ectx->alpn) {
+		efree(ectx->alpn);
+		ectx->alpn = NULL;
+	}
+#endif
+	if (ectx->metrics) {
+		zend_hash_destroy(&ectx->metrics->alerts_sent);
+		zend_hash_destroy(&ectx->metrics->alerts_received);
+		zend_hash_destroy(&ectx->metrics->ciphers);
+		zend_hash_destroy(&ectx->metrics->protocols);
+		efree(ectx->metrics);
+		ectx->metrics = NULL;
+	}
+
 	event_generic_object_free_storage(ptr TSRMLS_CC);
 }
 /* }}} */
@@ -619,6 +787,47 @@ static zend_object_value event_bevent_object_create(zend_class_entry *ce TSRMLS_
 }
 /* }}} */
 
+/* {{{ event_idle_reaper_object_create
+ * EventIdleReaper object ctor */
+static zend_object_value event_idle_reaper_object_create(zend_class_entry *ce TSRMLS_DC)
+{
+	zend_object_value        retval;
+	php_event_idle_reaper_t *r = (php_event_idle_reaper_t *) object_new(ce, sizeof(php_event_idle_reaper_t) TSRMLS_CC);
+
+	retval = register_object(ce, (void *) r, (zend_objects_store_dtor_t) event_idle_reaper_object_dtor,
+			event_idle_reaper_object_free_storage TSRMLS_CC);
+	r->handle = retval.handle;
+
+	return retval;
+}
+/* }}} */
+
+/* {{{ event_shared_payload_object_create
+ * EventSharedPayload object ctor */
+static zend_object_value event_shared_payload_object_create(zend_class_entry *ce TSRMLS_DC)
+{
+	php_event_abstract_object_t *obj = (php_event_abstract_object_t *) object_new(ce, sizeof(php_event_shared_payload_t) TSRMLS_CC);
+
+	return register_object(ce, (void *) obj, (zend_objects_store_dtor_t) zend_objects_destroy_object,
+			event_shared_payload_object_free_storage TSRMLS_CC);
+}
+/* }}} */
+
+#ifdef PHP_EVENT_WORKER_POOL
+/* {{{ event_worker_pool_object_create
+ * EventWorkerPool object ctor */
+static zend_object_value event_worker_pool_object_create(zend_class_entry *ce TSRMLS_DC)
+{
+	php_event_abstract_object_t *obj = (php_event_abstract_object_t *) object_new(ce, sizeof(php_event_worker_pool_t) TSRMLS_CC);
+
+	((php_event_worker_pool_t *) obj)->index = -1;
+
+	return register_object(ce, (void *) obj, (zend_objects_store_dtor_t) zend_objects_destroy_object,
+			event_worker_pool_object_free_storage TSRMLS_CC);
+}
+/* }}} */
+#endif
+
 /* {{{ event_buffer_object_create
  * EventBuffer object ctor */
 static zend_object_value event_buffer_object_create(zend_class_entry *ce TSRMLS_DC)
@@ -1134,6 +1343,23 @@ static zend_always_inline void register_classes(TSRMLS_D)
 	zend_hash_add(&classes, ce->name, ce->name_length + 1, &event_bevent_properties,
 			sizeof(event_bevent_properties), NULL);
 
+	PHP_EVENT_REGISTER_CLASS("EventIdleReaper", event_idle_reaper_object_create, php_event_idle_reaper_ce,
+			php_event_idle_reaper_ce_functions);
+	ce = php_event_idle_reaper_ce;
+	ce->ce_flags |= ZEND_ACC_FINAL_CLASS;
+
+	PHP_EVENT_REGISTER_CLASS("EventSharedPayload", event_shared_payload_object_create, php_event_shared_payload_ce,
+			php_event_shared_payload_ce_functions);
+	ce = php_event_shared_payload_ce;
+	ce->ce_flags |= ZEND_ACC_FINAL_CLASS;
+
+#ifdef PHP_EVENT_WORKER_POOL
+	PHP_EVENT_REGISTER_CLASS("EventWorkerPool", event_worker_pool_object_create, php_event_worker_pool_ce,
+			php_event_worker_pool_ce_functions);
+	ce = php_event_worker_pool_ce;
+	ce->ce_flags |= ZEND_ACC_FINAL_CLASS;
+#endif
+
 	PHP_EVENT_REGISTER_CLASS("EventBuffer", event_buffer_object_create, php_event_buffer_ce,
 			php_event_buffer_ce_functions);
 	ce = php_event_buffer_ce;
@@ -1293,6 +1519,7 @@ PHP_MINIT_FUNCTION(event)
 	REGISTER_EVENT_CLASS_CONST_LONG(php_event_bevent_ce, OPT_CLOSE_ON_FREE,    BEV_OPT_CLOSE_ON_FREE);
 	REGISTER_EVENT_CLASS_CONST_LONG(php_event_bevent_ce, OPT_THREADSAFE,       BEV_OPT_THREADSAFE);
 	REGISTER_EVENT_CLASS_CONST_LONG(php_event_bevent_ce, OPT_DEFER_CALLBACKS,  BEV_OPT_DEFER_CALLBACKS);
+	REGISTER_EVENT_CLASS_CONST_LONG(php_event_bevent_ce, WRITE_PRIORITIES,     PHP_EVENT_WRITE_PRIORITIES);
 #if LIBEVENT_VERSION_NUMBER >= 0x02000500
 	REGISTER_EVENT_CLASS_CONST_LONG(php_event_bevent_ce, OPT_UNLOCK_CALLBACKS, BEV_OPT_UNLOCK_CALLBACKS);
 #endif
@@ -1311,6 +1538,9 @@ PHP_MINIT_FUNCTION(event)
 	/* Socket options */
 	REGISTER_EVENT_CLASS_CONST_LONG(php_event_util_ce, SO_DEBUG,     SO_DEBUG);
 	REGISTER_EVENT_CLASS_CONST_LONG(php_event_util_ce, SO_REUSEADDR, SO_REUSEADDR);
+#ifdef SO_REUSEPORT
+	REGISTER_EVENT_CLASS_CONST_LONG(php_event_util_ce, SO_REUSEPORT, SO_REUSEPORT);
+#endif
 	REGISTER_EVENT_CLASS_CONST_LONG(php_event_util_ce, SO_KEEPALIVE, SO_KEEPALIVE);
 	REGISTER_EVENT_CLASS_CONST_LONG(php_event_util_ce, SO_DONTROUTE, SO_DONTROUTE);
 	REGISTER_EVENT_CLASS_CONST_LONG(php_event_util_ce, SO_LINGER,    SO_LINGER);
@@ -1327,6 +1557,40 @@ PHP_MINIT_FUNCTION(event)
 #ifdef TCP_NODELAY
 	REGISTER_EVENT_CLASS_CONST_LONG(php_event_util_ce, TCP_NODELAY, TCP_NODELAY);
 #endif
+#ifdef SO_RCVBUFFORCE
+	REGISTER_EVENT_CLASS_CONST_LONG(php_event_util_ce, SO_RCVBUFFORCE, SO_RCVBUFFORCE);
+#endif
+#ifdef SO_SNDBUFFORCE
+	REGISTER_EVENT_CLASS_CONST_LONG(php_event_util_ce, SO_SNDBUFFORCE, SO_SNDBUFFORCE);
+#endif
+#ifdef SO_BUSY_POLL
+	REGISTER_EVENT_CLASS_CONST_LONG(php_event_util_ce, SO_BUSY_POLL, SO_BUSY_POLL);
+#endif
+#ifdef SO_INCOMING_CPU
+	REGISTER_EVENT_CLASS_CONST_LONG(php_event_util_ce, SO_INCOMING_CPU, SO_INCOMING_CPU);
+#endif
+#ifdef TCP_CORK
+	REGISTER_EVENT_CLASS_CONST_LONG(php_event_util_ce, TCP_CORK, TCP_CORK);
+#endif
+#ifdef TCP_QUICKACK
+	REGISTER_EVENT_CLASS_CONST_LONG(php_event_util_ce, TCP_QUICKACK, TCP_QUICKACK);
+#endif
+#ifdef TCP_DEFER_ACCEPT
+	REGISTER_EVENT_CLASS_CONST_LONG(php_event_util_ce, TCP_DEFER_ACCEPT, TCP_DEFER_ACCEPT);
+#endif
+#ifdef TCP_FASTOPEN
+	REGISTER_EVENT_CLASS_CONST_LONG(php_event_util_ce, TCP_FASTOPEN, TCP_FASTOPEN);
+#endif
+#ifdef TCP_NOTSENT_LOWAT
+	REGISTER_EVENT_CLASS_CONST_LONG(php_event_util_ce, TCP_NOTSENT_LOWAT, TCP_NOTSENT_LOWAT);
+#endif
+#ifdef IP_BIND_ADDRESS_NO_PORT
+	REGISTER_EVENT_CLASS_CONST_LONG(php_event_util_ce, IP_BIND_ADDRESS_NO_PORT, IP_BIND_ADDRESS_NO_PORT);
+#endif
+
+	/* Socket tuning profiles */
+	REGISTER_EVENT_CLASS_CONST_LONG(php_event_util_ce, SOCKET_PROFILE_LOW_LATENCY, PHP_EVENT_SOCKET_PROFILE_LOW_LATENCY);
+	REGISTER_EVENT_CLASS_CONST_LONG(php_event_util_ce, SOCKET_PROFILE_BULK,        PHP_EVENT_SOCKET_PROFILE_BULK);
 
 	/* Socket protocol levels */
 	REGISTER_EVENT_CLASS_CONST_LONG(php_event_util_ce, SOL_SOCKET, SOL_SOCKET);
@@ -1353,6 +1617,9 @@ PHP_MINIT_FUNCTION(event)
 	REGISTER_EVENT_CLASS_CONST_LONG(php_event_listener_ce, OPT_CLOSE_ON_FREE,          LEV_OPT_CLOSE_ON_FREE);
 	REGISTER_EVENT_CLASS_CONST_LONG(php_event_listener_ce, OPT_CLOSE_ON_EXEC,          LEV_OPT_CLOSE_ON_EXEC);
 	REGISTER_EVENT_CLASS_CONST_LONG(php_event_listener_ce, OPT_REUSEABLE,              LEV_OPT_REUSEABLE);
+# ifdef LEV_OPT_REUSEABLE_PORT
+	REGISTER_EVENT_CLASS_CONST_LONG(php_event_listener_ce, OPT_REUSEABLE_PORT,         LEV_OPT_REUSEABLE_PORT);
+# endif
 # if LIBEVENT_VERSION_NUMBER >= 0x02010100
 	REGISTER_EVENT_CLASS_CONST_LONG(php_event_listener_ce, OPT_DISABLED,               LEV_OPT_DISABLED);
 # endif
@@ -1428,6 +1695,16 @@ PHP_MINIT_FUNCTION(event)
 	REGISTER_EVENT_CLASS_CONST_LONG(php_event_ssl_context_ce, OPT_CIPHER_SERVER_PREFERENCE, PHP_EVENT_OPT_CIPHER_SERVER_PREFERENCE);
 	REGISTER_EVENT_CLASS_CONST_LONG(php_event_ssl_context_ce, OPT_REQUIRE_CLIENT_CERT,      PHP_EVENT_OPT_REQUIRE_CLIENT_CERT);
 	REGISTER_EVENT_CLASS_CONST_LONG(php_event_ssl_context_ce, OPT_VERIFY_CLIENT_ONCE,       PHP_EVENT_OPT_VERIFY_CLIENT_ONCE);
+	REGISTER_EVENT_CLASS_CONST_LONG(php_event_ssl_context_ce, OPT_SESSION_CACHE_SIZE,       PHP_EVENT_OPT_SESSION_CACHE_SIZE);
+	REGISTER_EVENT_CLASS_CONST_LONG(php_event_ssl_context_ce, OPT_SESSION_TIMEOUT,          PHP_EVENT_OPT_SESSION_TIMEOUT);
+	REGISTER_EVENT_CLASS_CONST_LONG(php_event_ssl_context_ce, OPT_SESSION_TICKETS,          PHP_EVENT_OPT_SESSION_TICKETS);
+	REGISTER_EVENT_CLASS_CONST_LONG(php_event_ssl_context_ce, OPT_TICKET_KEY_LIFETIME,      PHP_EVENT_OPT_TICKET_KEY_LIFETIME);
+	REGISTER_EVENT_CLASS_CONST_LONG(php_event_ssl_context_ce, OPT_CLIENT_SESSION_CACHE,     PHP_EVENT_OPT_CLIENT_SESSION_CACHE);
+	REGISTER_EVENT_CLASS_CONST_LONG(php_event_ssl_context_ce, OPT_KTLS,                     PHP_EVENT_OPT_KTLS);
+	REGISTER_EVENT_CLASS_CONST_LONG(php_event_ssl_context_ce, OPT_SHARED_CTX,               PHP_EVENT_OPT_SHARED_CTX);
+	REGISTER_EVENT_CLASS_CONST_LONG(php_event_ssl_context_ce, OPT_ALPN_PROTOCOLS,           PHP_EVENT_OPT_ALPN_PROTOCOLS);
+	REGISTER_EVENT_CLASS_CONST_LONG(php_event_ssl_context_ce, OPT_METRICS,                  PHP_EVENT_OPT_METRICS);
+	REGISTER_EVENT_CLASS_CONST_LONG(php_event_ssl_context_ce, OPT_DYNAMIC_RECORDS,          PHP_EVENT_OPT_DYNAMIC_RECORDS);
 
 	REGISTER_EVENT_CLASS_CONST_STRING(php_event_ssl_context_ce, OPENSSL_VERSION_TEXT,   OPENSSL_VERSION_TEXT);
 	REGISTER_EVENT_CLASS_CONST_LONG(php_event_ssl_context_ce,   OPENSSL_VERSION_NUMBER, OPENSSL_VERSION_NUMBER);
@@ -1459,6 +1736,16 @@ PHP_MINIT_FUNCTION(event)
 
 	/* Create new index which will be used to retreive custom data of the OpenSSL callbacks */
 	php_event_ssl_data_index = SSL_get_ex_new_index(0, "PHP EventSslContext index", NULL, NULL, NULL);
+	/* Index of the client session cache key, see php_event_ssl_session_prepare() */
+	php_event_ssl_host_index = SSL_get_ex_new_index(0, "PHP EventSslContext session key", NULL, NULL,
+			php_event_ssl_host_free);
+	/* Index of the handshake start time(OPT_METRICS). Freed the same way as the session key */
+	php_event_ssl_start_index = SSL_get_ex_new_index(0, "PHP EventSslContext handshake start", NULL, NULL,
+			php_event_ssl_host_free);
+	/* Index of the flag of the completed initial handshake, see info_callback() */
+	php_event_ssl_done_index = SSL_get_ex_new_index(0, "PHP EventSslContext handshake done", NULL, NULL, NULL);
+	/* Process-wide cache of the SSL_CTX objects created with OPT_SHARED_CTX */
+	php_event_ssl_ctx_cache_init();
 #endif /* HAVE_EVENT_OPENSSL_LIB */
 
 
@@ -1490,6 +1777,8 @@ PHP_MINIT_FUNCTION(event)
 PHP_MSHUTDOWN_FUNCTION(event)
 {
 #ifdef HAVE_EVENT_OPENSSL_LIB
+	php_event_ssl_ctx_cache_destroy();
+
 	/* Removes memory allocated when loading digest and cipher names
 	 * in the OpenSSL_add_all_ family of functions */
 	EVP_cleanup();
@@ -1547,6 +1836,11 @@ PHP_MINFO_FUNCTION(event)
 #else
 	php_info_print_table_row(2, "Thread safety support", "disabled");
 #endif
+#ifdef PHP_EVENT_STATS
+	php_info_print_table_row(2, "Connection statistics", "enabled");
+#else
+	php_info_print_table_row(2, "Connection statistics", "disabled");
+#endif
 
 	php_info_print_table_row(2, "Extension version", PHP_EVENT_VERSION);
 	php_info_print_table_row(2, "libevent2 headers version", LIBEVENT_VERSION);
@@ -170,6 +170,38 @@ ZEND_BEGIN_ARG_INFO_EX(arginfo_bufferevent_priority_set, 0, 0, 1)
 	ZEND_ARG_INFO(0, priority)
 ZEND_END_ARG_INFO();
 
+ZEND_BEGIN_ARG_INFO_EX(arginfo_event_set_socket_profile, 0, 0, 1)
+	ZEND_ARG_INFO(0, profile)
+ZEND_END_ARG_INFO();
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_bufferevent_write_priority, 0, 0, 2)
+	ZEND_ARG_INFO(0, data)
+	ZEND_ARG_INFO(0, prio)
+ZEND_END_ARG_INFO();
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_bufferevent_set_auto_cork, 0, 0, 2)
+	ZEND_ARG_INFO(0, threshold)
+	ZEND_ARG_INFO(0, deadline)
+ZEND_END_ARG_INFO();
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_bufferevent_set_read_coalescing, 0, 0, 2)
+	ZEND_ARG_INFO(0, min_bytes)
+	ZEND_ARG_INFO(0, max_delay)
+ZEND_END_ARG_INFO();
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_bufferevent_set_fd_passing, 0, 0, 1)
+	ZEND_ARG_INFO(0, enable)
+ZEND_END_ARG_INFO();
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_bufferevent_set_max_single, 0, 0, 1)
+	ZEND_ARG_INFO(0, size)
+ZEND_END_ARG_INFO();
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_bufferevent_set_adaptive_read, 0, 0, 2)
+	ZEND_ARG_INFO(0, min_size)
+	ZEND_ARG_INFO(0, max_size)
+ZEND_END_ARG_INFO();
+
 ZEND_BEGIN_ARG_INFO_EX(arginfo_bufferevent_set_timeouts, 0, 0, 2)
 	ZEND_ARG_INFO(0, timeout_read)
 	ZEND_ARG_INFO(0, timeout_write)
@@ -198,6 +230,22 @@ ZEND_BEGIN_ARG_INFO_EX(arginfo_bufferevent_ssl_socket, 0, 0, 4)
 	ZEND_ARG_INFO(0, state)
 	ZEND_ARG_INFO(0, options)
 ZEND_END_ARG_INFO();
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_bufferevent_ssl_set_session, 0, 0, 1)
+	ZEND_ARG_INFO(0, session)
+ZEND_END_ARG_INFO();
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_bufferevent_ssl_sendfile, 0, 0, 3)
+	ZEND_ARG_INFO(0, fd)
+	ZEND_ARG_INFO(0, offset)
+	ZEND_ARG_INFO(0, length)
+ZEND_END_ARG_INFO();
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_bufferevent_ssl_set_dynamic_record_sizing, 0, 0, 0)
+	ZEND_ARG_INFO(0, small_size)
+	ZEND_ARG_INFO(0, boost_after)
+	ZEND_ARG_INFO(0, idle)
+ZEND_END_ARG_INFO();
 #endif
 
 
@@ -320,6 +368,13 @@ ZEND_BEGIN_ARG_INFO_EX(arginfo_event_http_set_callback, 0, 0, 2)
 	ZEND_ARG_INFO(0, arg)
 ZEND_END_ARG_INFO();
 
+ZEND_BEGIN_ARG_INFO_EX(arginfo_event_http_route, 0, 0, 2)
+	ZEND_ARG_INFO(0, pattern)
+	ZEND_ARG_INFO(0, cb)
+	ZEND_ARG_INFO(0, methods)
+	ZEND_ARG_INFO(0, arg)
+ZEND_END_ARG_INFO();
+
 ZEND_BEGIN_ARG_INFO_EX(arginfo_event_http_set_gen_callback, 0, 0, 1)
 	ZEND_ARG_INFO(0, cb)
 	ZEND_ARG_INFO(0, arg)
@@ -390,6 +445,34 @@ ZEND_BEGIN_ARG_INFO_EX(arginfo_event_ssl_context__construct, 0, 0, 2)
 	ZEND_ARG_INFO(0, options)
 ZEND_END_ARG_INFO();
 
+ZEND_BEGIN_ARG_INFO_EX(arginfo_event_ssl_context_get_metrics, 0, 0, 0)
+	ZEND_ARG_INFO(0, reset)
+ZEND_END_ARG_INFO();
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_event_ssl_context_reload, 0, 0, 0)
+	ZEND_ARG_ARRAY_INFO(0, options, 1)
+ZEND_END_ARG_INFO();
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_event_ssl_context_watch, 0, 0, 1)
+	PHP_EVENT_ARG_OBJ_INFO(0, base, EventBase, 0)
+	ZEND_ARG_INFO(0, interval)
+ZEND_END_ARG_INFO();
+
+#ifdef PHP_EVENT_SSL_SNI
+ZEND_BEGIN_ARG_INFO_EX(arginfo_event_ssl_context_add_sni_context, 0, 0, 2)
+	ZEND_ARG_INFO(0, hostname)
+	ZEND_ARG_INFO(0, ctx)
+ZEND_END_ARG_INFO();
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_event_ssl_context_remove_sni_context, 0, 0, 1)
+	ZEND_ARG_INFO(0, hostname)
+ZEND_END_ARG_INFO();
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_event_ssl_context_set_sni_callback, 0, 0, 1)
+	ZEND_ARG_INFO(0, cb)
+ZEND_END_ARG_INFO();
+#endif
+
 #if OPENSSL_VERSION_NUMBER >= 0x10100000L
 ZEND_BEGIN_ARG_INFO_EX(arginfo_event_ssl_context_set_min_proto_version, 0, 0, 1)
 	ZEND_ARG_INFO(0, proto)
@@ -413,10 +496,59 @@ ZEND_BEGIN_ARG_INFO_EX(arginfo_event_util_set_socket_option, 0, 0, 4)
 	ZEND_ARG_INFO(0, optval)
 ZEND_END_ARG_INFO();
 
+ZEND_BEGIN_ARG_INFO_EX(arginfo_event_util_set_socket_profile, 0, 0, 2)
+	ZEND_ARG_INFO(0, socket)
+	ZEND_ARG_INFO(0, profile)
+ZEND_END_ARG_INFO();
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_event_util_send_fds, 0, 0, 3)
+	ZEND_ARG_INFO(0, socket)
+	ZEND_ARG_ARRAY_INFO(0, fds, 0)
+	ZEND_ARG_INFO(0, payload)
+ZEND_END_ARG_INFO();
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_event_util_recv_fds, 0, 0, 2)
+	ZEND_ARG_INFO(0, socket)
+	ZEND_ARG_INFO(1, fds)
+	ZEND_ARG_INFO(0, max_length)
+ZEND_END_ARG_INFO();
+
 ZEND_BEGIN_ARG_INFO_EX(arginfo_event_util_create_socket, 0, 0, 1)
 	ZEND_ARG_INFO(0, fd)
 ZEND_END_ARG_INFO();
 
+ZEND_BEGIN_ARG_INFO_EX(arginfo_event_base_create_idle_reaper, 0, 0, 2)
+	ZEND_ARG_INFO(0, idle)
+	ZEND_ARG_INFO(0, on_idle)
+	ZEND_ARG_INFO(0, arg)
+ZEND_END_ARG_INFO();
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_event_idle_reaper_bevent, 0, 0, 1)
+	ZEND_ARG_INFO(0, bev)
+ZEND_END_ARG_INFO();
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_event_base_broadcast, 0, 0, 2)
+	ZEND_ARG_ARRAY_INFO(0, bevents, 0)
+	ZEND_ARG_INFO(0, payload)
+	ZEND_ARG_INFO(0, max_output)
+	ZEND_ARG_INFO(1, skipped)
+ZEND_END_ARG_INFO();
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_event_shared_payload__construct, 0, 0, 1)
+	ZEND_ARG_INFO(0, data)
+ZEND_END_ARG_INFO();
+
+#ifdef PHP_EVENT_WORKER_POOL
+ZEND_BEGIN_ARG_INFO_EX(arginfo_event_worker_pool__construct, 0, 0, 1)
+	ZEND_ARG_INFO(0, workers)
+	ZEND_ARG_INFO(0, cpu_affinity)
+ZEND_END_ARG_INFO();
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_event_worker_pool_run, 0, 0, 0)
+	PHP_EVENT_ARG_OBJ_INFO(0, base, EventBase, 1)
+ZEND_END_ARG_INFO();
+#endif
+
 
 /* ARGINFO END }}} */
 
@@ -474,6 +606,31 @@ ZEND_BEGIN_ARG_INFO_EX(arginfo_evconnlistener_set_error_cb, 0, 0, 1)
 	ZEND_ARG_INFO(0, cb)
 ZEND_END_ARG_INFO();
 
+ZEND_BEGIN_ARG_INFO_EX(arginfo_evconnlistener_set_bevent_template, 0, 0, 1)
+	ZEND_ARG_INFO(0, options)
+	ZEND_ARG_INFO(0, readcb)
+	ZEND_ARG_INFO(0, writecb)
+	ZEND_ARG_INFO(0, eventcb)
+	ZEND_ARG_INFO(0, arg)
+	ZEND_ARG_ARRAY_INFO(0, settings, 1)
+ZEND_END_ARG_INFO();
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_evconnlistener_set_max_conns, 0, 0, 1)
+	ZEND_ARG_INFO(0, max_conns)
+	ZEND_ARG_INFO(0, low_conns)
+ZEND_END_ARG_INFO();
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_evconnlistener_set_proxy_protocol, 0, 0, 1)
+	ZEND_ARG_INFO(0, enable)
+	ZEND_ARG_INFO(0, timeout)
+ZEND_END_ARG_INFO();
+
+ZEND_BEGIN_ARG_INFO_EX(arginfo_evconnlistener_set_batch_cb, 0, 0, 1)
+	ZEND_ARG_INFO(0, cb)
+	ZEND_ARG_INFO(0, max_batch)
+	ZEND_ARG_INFO(0, addresses)
+ZEND_END_ARG_INFO();
+
 ZEND_BEGIN_ARG_INFO_EX(arginfo_evconnlistener_get_fd, 0, 0, 1)
 	ZEND_ARG_INFO(1, address)
 	ZEND_ARG_INFO(1, port)
@@ -532,6 +689,8 @@ const zend_function_entry php_event_base_ce_functions[] = {/* {{{ */
 #if LIBEVENT_VERSION_NUMBER >= 0x02010200
 	PHP_ME(EventBase, resume,             arginfo_event__void,              ZEND_ACC_PUBLIC)
 #endif
+	PHP_ME(EventBase, createIdleReaper, arginfo_event_base_create_idle_reaper, ZEND_ACC_PUBLIC)
+	PHP_ME(EventBase, broadcast,        arginfo_event_base_broadcast,          ZEND_ACC_PUBLIC)
 
 	PHP_FE_END
 };
@@ -575,6 +734,31 @@ const zend_function_entry php_event_bevent_ce_functions[] = {/* {{{ */
 	PHP_ME(EventBufferEvent, createPair,        arginfo_bufferevent_pair_new,      ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
 	PHP_ME(EventBufferEvent, setPriority,       arginfo_bufferevent_priority_set,  ZEND_ACC_PUBLIC)
 	PHP_ME(EventBufferEvent, setTimeouts,       arginfo_bufferevent_set_timeouts,  ZEND_ACC_PUBLIC)
+	PHP_ME(EventBufferEvent, setSocketProfile,  arginfo_event_set_socket_profile,  ZEND_ACC_PUBLIC)
+	PHP_ME(EventBufferEvent, writePriority,     arginfo_bufferevent_write_priority, ZEND_ACC_PUBLIC)
+	PHP_ME(EventBufferEvent, getWritePriorityDepths, arginfo_event__void,           ZEND_ACC_PUBLIC)
+	PHP_ME(EventBufferEvent, cork,              arginfo_event__void,               ZEND_ACC_PUBLIC)
+	PHP_ME(EventBufferEvent, uncork,            arginfo_event__void,               ZEND_ACC_PUBLIC)
+	PHP_ME(EventBufferEvent, setAutoCork,       arginfo_bufferevent_set_auto_cork, ZEND_ACC_PUBLIC)
+	PHP_ME(EventBufferEvent, setReadCoalescing, arginfo_bufferevent_set_read_coalescing, ZEND_ACC_PUBLIC)
+#if LIBEVENT_VERSION_NUMBER >= 0x02010100
+	PHP_ME(EventBufferEvent, setMaxSingleRead,     arginfo_bufferevent_set_max_single,    ZEND_ACC_PUBLIC)
+	PHP_ME(EventBufferEvent, getMaxSingleRead,     arginfo_event__void,                   ZEND_ACC_PUBLIC)
+	PHP_ME(EventBufferEvent, setMaxSingleWrite,    arginfo_bufferevent_set_max_single,    ZEND_ACC_PUBLIC)
+	PHP_ME(EventBufferEvent, getMaxSingleWrite,    arginfo_event__void,                   ZEND_ACC_PUBLIC)
+	PHP_ME(EventBufferEvent, setAdaptiveRead,      arginfo_bufferevent_set_adaptive_read, ZEND_ACC_PUBLIC)
+	PHP_ME(EventBufferEvent, getAdaptiveReadStats, arginfo_event__void,                   ZEND_ACC_PUBLIC)
+#endif
+#ifdef PHP_EVENT_TCP_INFO
+	PHP_ME(EventBufferEvent, getTcpInfo,        arginfo_event__void,               ZEND_ACC_PUBLIC)
+#endif
+#ifdef PHP_EVENT_STATS
+	PHP_ME(EventBufferEvent, getStats,          arginfo_event__void,               ZEND_ACC_PUBLIC)
+#endif
+#ifdef PHP_EVENT_FD_PASSING
+	PHP_ME(EventBufferEvent, setFdPassing,      arginfo_bufferevent_set_fd_passing, ZEND_ACC_PUBLIC)
+	PHP_ME(EventBufferEvent, fetchFds,          arginfo_event__void,               ZEND_ACC_PUBLIC)
+#endif
 #ifdef HAVE_EVENT_OPENSSL_LIB
 	PHP_ME(EventBufferEvent, sslFilter,           arginfo_bufferevent_ssl_filter,        ZEND_ACC_PUBLIC  | ZEND_ACC_STATIC  | ZEND_ACC_DEPRECATED)
 	PHP_ME(EventBufferEvent, createSslFilter,     arginfo_bufferevent_create_ssl_filter, ZEND_ACC_PUBLIC  | ZEND_ACC_STATIC)
@@ -585,6 +769,19 @@ const zend_function_entry php_event_bevent_ce_functions[] = {/* {{{ */
 	PHP_ME(EventBufferEvent, sslGetCipherName,    arginfo_event__void,                   ZEND_ACC_PUBLIC)
 	PHP_ME(EventBufferEvent, sslGetCipherVersion, arginfo_event__void,                   ZEND_ACC_PUBLIC)
 	PHP_ME(EventBufferEvent, sslGetProtocol,      arginfo_event__void,                   ZEND_ACC_PUBLIC)
+	PHP_ME(EventBufferEvent, sslGetSession,       arginfo_event__void,                   ZEND_ACC_PUBLIC)
+	PHP_ME(EventBufferEvent, sslSetSession,       arginfo_bufferevent_ssl_set_session,   ZEND_ACC_PUBLIC)
+	PHP_ME(EventBufferEvent, sslSessionReused,    arginfo_event__void,                   ZEND_ACC_PUBLIC)
+	PHP_ME(EventBufferEvent, sslGetKtlsStatus,    arginfo_event__void,                   ZEND_ACC_PUBLIC)
+# ifdef PHP_EVENT_SSL_ALPN
+	PHP_ME(EventBufferEvent, sslGetAlpnProtocol,  arginfo_event__void,                   ZEND_ACC_PUBLIC)
+# endif
+# ifdef PHP_EVENT_KTLS
+	PHP_ME(EventBufferEvent, sslSendfile,         arginfo_bufferevent_ssl_sendfile,      ZEND_ACC_PUBLIC)
+# endif
+# ifdef PHP_EVENT_SSL_RECORD_SIZING
+	PHP_ME(EventBufferEvent, setDynamicRecordSizing, arginfo_bufferevent_ssl_set_dynamic_record_sizing, ZEND_ACC_PUBLIC)
+# endif
 #endif
 
 	PHP_FE_END
@@ -631,12 +828,50 @@ const zend_function_entry php_event_util_ce_functions[] = {/* {{{ */
 	PHP_ME(EventUtil, getSocketName,   arginfo_event_util_get_socket_name,   ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
 	PHP_ME(EventUtil, getSocketFd,     arginfo_event_util_get_socket_fd,     ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
 	PHP_ME(EventUtil, setSocketOption, arginfo_event_util_set_socket_option, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+	PHP_ME(EventUtil, setSocketProfile, arginfo_event_util_set_socket_profile, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+#ifdef PHP_EVENT_TCP_INFO
+	PHP_ME(EventUtil, getTcpInfo,      arginfo_event_util_get_socket_fd,     ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+#endif
+#ifdef PHP_EVENT_FD_PASSING
+	PHP_ME(EventUtil, sendFds,         arginfo_event_util_send_fds,          ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+	PHP_ME(EventUtil, recvFds,         arginfo_event_util_recv_fds,          ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+#endif
 	PHP_ME(EventUtil, createSocket,    arginfo_event_util_create_socket,     ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
 
 	PHP_FE_END
 };
 /* }}} */
 
+const zend_function_entry php_event_idle_reaper_ce_functions[] = {/* {{{ */
+	PHP_ME(EventIdleReaper, __construct, arginfo_event__void,              ZEND_ACC_PRIVATE)
+	PHP_ME(EventIdleReaper, add,         arginfo_event_idle_reaper_bevent, ZEND_ACC_PUBLIC)
+	PHP_ME(EventIdleReaper, remove,      arginfo_event_idle_reaper_bevent, ZEND_ACC_PUBLIC)
+	PHP_ME(EventIdleReaper, getCount,    arginfo_event__void,              ZEND_ACC_PUBLIC)
+	PHP_ME(EventIdleReaper, free,        arginfo_event__void,              ZEND_ACC_PUBLIC)
+
+	PHP_FE_END
+};
+/* }}} */
+
+const zend_function_entry php_event_shared_payload_ce_functions[] = {/* {{{ */
+	PHP_ME(EventSharedPayload, __construct, arginfo_event_shared_payload__construct, ZEND_ACC_PUBLIC | ZEND_ACC_CTOR)
+	PHP_ME(EventSharedPayload, getLength,   arginfo_event__void,                     ZEND_ACC_PUBLIC)
+
+	PHP_FE_END
+};
+/* }}} */
+
+#ifdef PHP_EVENT_WORKER_POOL
+const zend_function_entry php_event_worker_pool_ce_functions[] = {/* {{{ */
+	PHP_ME(EventWorkerPool, __construct, arginfo_event_worker_pool__construct, ZEND_ACC_PUBLIC | ZEND_ACC_CTOR)
+	PHP_ME(EventWorkerPool, run,         arginfo_event_worker_pool_run,        ZEND_ACC_PUBLIC)
+	PHP_ME(EventWorkerPool, getRestarts, arginfo_event__void,                  ZEND_ACC_PUBLIC)
+
+	PHP_FE_END
+};
+/* }}} */
+#endif
+
 /* }}} */
 
 #if HAVE_EVENT_EXTRA_LIB
@@ -681,6 +916,7 @@ const zend_function_entry php_event_http_ce_functions[] = {
 	PHP_ME(EventHttp, accept,             arginfo_event_http_accept,              ZEND_ACC_PUBLIC)
 	PHP_ME(EventHttp, bind,               arginfo_event_http_bind,                ZEND_ACC_PUBLIC)
 	PHP_ME(EventHttp, setCallback,        arginfo_event_http_set_callback,        ZEND_ACC_PUBLIC)
+	PHP_ME(EventHttp, route,              arginfo_event_http_route,               ZEND_ACC_PUBLIC)
 	PHP_ME(EventHttp, setDefaultCallback, arginfo_event_http_set_gen_callback,    ZEND_ACC_PUBLIC)
 	PHP_ME(EventHttp, setAllowedMethods,  arginfo_event_http_set_allowed_methods, ZEND_ACC_PUBLIC)
 	PHP_ME(EventHttp, setMaxBodySize,     arginfo_event_http_set_value,           ZEND_ACC_PUBLIC)
@@ -735,8 +971,17 @@ const zend_function_entry php_event_listener_ce_functions[] = {
 	PHP_ME(EventListener, setCallback,      arginfo_evconnlistener_set_cb,       ZEND_ACC_PUBLIC)
 	PHP_ME(EventListener, setErrorCallback, arginfo_evconnlistener_set_error_cb, ZEND_ACC_PUBLIC)
 	PHP_ME(EventListener, getSocketName,    arginfo_evconnlistener_get_fd,       ZEND_ACC_PUBLIC)
+	PHP_ME(EventListener, setSocketProfile, arginfo_event_set_socket_profile,    ZEND_ACC_PUBLIC)
+	PHP_ME(EventListener, setBufferEventTemplate, arginfo_evconnlistener_set_bevent_template, ZEND_ACC_PUBLIC)
+	PHP_ME(EventListener, setMaxConnections, arginfo_evconnlistener_set_max_conns, ZEND_ACC_PUBLIC)
+	PHP_ME(EventListener, getConnectionStats, arginfo_event__void, ZEND_ACC_PUBLIC)
+	PHP_ME(EventListener, setProxyProtocol, arginfo_evconnlistener_set_proxy_protocol, ZEND_ACC_PUBLIC)
+#ifdef PHP_EVENT_REUSEPORT_CBPF
+	PHP_ME(EventListener, attachReuseportCbpf, arginfo_event__void, ZEND_ACC_PUBLIC)
+#endif
 #if LIBEVENT_VERSION_NUMBER >= 0x02000300
 	PHP_ME(EventListener, getBase, arginfo_event__void, ZEND_ACC_PUBLIC)
+	PHP_ME(EventListener, setBatchCallback, arginfo_evconnlistener_set_batch_cb, ZEND_ACC_PUBLIC)
 #endif
 
 	PHP_FE_END
@@ -748,6 +993,19 @@ const zend_function_entry php_event_listener_ce_functions[] = {
 #ifdef HAVE_EVENT_OPENSSL_LIB
 const zend_function_entry php_event_ssl_context_ce_functions[] = {/* {{{ */
 	PHP_ME(EventSslContext, __construct, arginfo_event_ssl_context__construct, ZEND_ACC_PUBLIC | ZEND_ACC_CTOR)
+	PHP_ME(EventSslContext, getSessionStats, arginfo_event__void, ZEND_ACC_PUBLIC)
+	PHP_ME(EventSslContext, getMetrics, arginfo_event_ssl_context_get_metrics, ZEND_ACC_PUBLIC)
+	PHP_ME(EventSslContext, clearSharedCache, arginfo_event__void, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+	PHP_ME(EventSslContext, reload, arginfo_event_ssl_context_reload, ZEND_ACC_PUBLIC)
+	PHP_ME(EventSslContext, watch, arginfo_event_ssl_context_watch, ZEND_ACC_PUBLIC)
+#ifdef PHP_EVENT_SSL_TICKET_KEYS
+	PHP_ME(EventSslContext, rotateTicketKeys, arginfo_event__void, ZEND_ACC_PUBLIC)
+#endif
+#ifdef PHP_EVENT_SSL_SNI
+	PHP_ME(EventSslContext, addSniContext,    arginfo_event_ssl_context_add_sni_context,    ZEND_ACC_PUBLIC)
+	PHP_ME(EventSslContext, removeSniContext, arginfo_event_ssl_context_remove_sni_context, ZEND_ACC_PUBLIC)
+	PHP_ME(EventSslContext, setSniCallback,   arginfo_event_ssl_context_set_sni_callback,   ZEND_ACC_PUBLIC)
+#endif
 #if OPENSSL_VERSION_NUMBER >= 0x10100000L && !defined(LIBRESSL_VERSION_NUMBER)
 	PHP_ME(EventSslContext, setMinProtoVersion, arginfo_event_ssl_context_set_min_proto_version, ZEND_ACC_PUBLIC)
 	PHP_ME(EventSslContext, setMaxProtoVersion, arginfo_event_ssl_context_set_min_proto_version, ZEND_ACC_PUBLIC)
@@ -335,6 +335,29 @@ static zval **event_bevent_output_prop_ptr_ptr(php_event_abstract_object_t *obj
 }
 /* }}} */
 
+#ifdef PHP_EVENT_STATS
+/* {{{ event_bevent_bytes_read_prop_read */
+static int event_bevent_bytes_read_prop_read(php_event_abstract_object_t *obj, zval **retval TSRMLS_DC)
+{
+	php_event_bevent_t *bev = (php_event_bevent_t *) obj;
+
+	MAKE_STD_ZVAL(*retval);
+	ZVAL_LONG(*retval, (long) bev->stats.bytes_read);
+	return SUCCESS;
+}
+/* }}} */
+
+/* {{{ event_bevent_bytes_written_prop_read */
+static int event_bevent_bytes_written_prop_read(php_event_abstract_object_t *obj, zval **retval TSRMLS_DC)
+{
+	php_event_bevent_t *bev = (php_event_bevent_t *) obj;
+
+	MAKE_STD_ZVAL(*retval);
+	ZVAL_LONG(*retval, (long) bev->stats.bytes_written);
+	return SUCCESS;
+}
+/* }}} */
+#endif
 
 #if LIBEVENT_VERSION_NUMBER >= 0x02010100
 /* {{{ event_bevent_allow_ssl_dirty_shutdown_prop_write*/
@@ -437,6 +460,10 @@ const php_event_property_entry_t event_bevent_property_entries[] = {
 	{"fd",       sizeof("fd")       - 1, event_bevent_fd_prop_read,       NULL,                             NULL                               },
 	{"input",    sizeof("input")    - 1, event_bevent_input_prop_read,    NULL,                             event_bevent_input_prop_ptr_ptr},
 	{"output",   sizeof("output")   - 1, event_bevent_output_prop_read,   NULL,                             event_bevent_output_prop_ptr_ptr},
+#ifdef PHP_EVENT_STATS
+	{"bytes_read",    sizeof("bytes_read")    - 1, event_bevent_bytes_read_prop_read,    NULL, NULL},
+	{"bytes_written", sizeof("bytes_written") - 1, event_bevent_bytes_written_prop_read, NULL, NULL},
+#endif
 
 #if LIBEVENT_VERSION_NUMBER >= 0x02010100
 	{"allow_ssl_dirty_shutdown", sizeof("allow_ssl_dirty_shutdown") - 1,
@@ -476,6 +503,10 @@ const zend_property_info event_bevent_property_entry_info[] = {
 	{ZEND_ACC_PUBLIC, "output",   sizeof("output")   - 1, -1, 0, NULL, 0, NULL},
 #if LIBEVENT_VERSION_NUMBER >= 0x02010100
 	{ZEND_ACC_PUBLIC, "allow_ssl_dirty_shutdown", sizeof("allow_ssl_dirty_shutdown") - 1, -1, 0, NULL, 0, NULL},
+#endif
+#ifdef PHP_EVENT_STATS
+	{ZEND_ACC_PUBLIC, "bytes_read",    sizeof("bytes_read")    - 1, -1, 0, NULL, 0, NULL},
+	{ZEND_ACC_PUBLIC, "bytes_written", sizeof("bytes_written") - 1, -1, 0, NULL, 0, NULL},
 #endif
 	{0, NULL, 0, -1, 0, NULL, 0, NULL}
 };
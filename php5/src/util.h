@@ -29,6 +29,39 @@
 
 php_socket_t php_event_zval_to_fd(zval **ppfd TSRMLS_DC);
 int _php_event_getsockname(evutil_socket_t fd, zval **ppzaddress, zval **ppzport TSRMLS_DC);
+int php_event_set_socket_profile(evutil_socket_t fd, long profile TSRMLS_DC);
+
+#ifdef PHP_EVENT_FD_PASSING
+ssize_t php_event_send_fds(evutil_socket_t sock, const int *fds, size_t nfds, const char *data, size_t len);
+ssize_t php_event_recv_fds(evutil_socket_t sock, char *buf, size_t len, int *fds, size_t *nfds, int *truncated);
+#endif
+
+void php_event_bevent_coalesce_free(php_event_bevent_t *bev);
+int php_event_bevent_wprio_queue(php_event_bevent_t *bev, const char *data, size_t len, int prio);
+void php_event_bevent_wprio_flush(php_event_bevent_t *bev);
+void php_event_bevent_wprio_free(php_event_bevent_t *bev);
+void php_event_bevent_cork(php_event_bevent_t *bev);
+void php_event_bevent_uncork(php_event_bevent_t *bev);
+int php_event_bevent_set_auto_cork(php_event_bevent_t *bev, size_t threshold, double deadline);
+void php_event_bevent_cork_free(php_event_bevent_t *bev);
+#if LIBEVENT_VERSION_NUMBER >= 0x02010100
+void php_event_bevent_read_sizing_attach(php_event_bevent_t *bev);
+#endif
+void php_event_bevent_read_sizing_detach(php_event_bevent_t *bev);
+#ifdef PHP_EVENT_SSL_RECORD_SIZING
+int php_event_bevent_record_sizing_attach(php_event_bevent_t *bev, size_t small_size, size_t boost_after, double idle);
+void php_event_bevent_record_sizing_detach(php_event_bevent_t *bev);
+#endif
+
+#ifdef PHP_EVENT_TCP_INFO
+int php_event_get_tcp_info(evutil_socket_t fd, zval *retval TSRMLS_DC);
+#endif
+
+#ifdef PHP_EVENT_STATS
+php_event_timestamp_t php_event_bevent_stats_now(struct bufferevent *bevent);
+void php_event_bevent_stats_attach(php_event_bevent_t *bev);
+void php_event_bevent_stats_detach(php_event_bevent_t *bev);
+#endif
 
 #define php_event_is_pending(e) \
 	event_pending((e), EV_READ | EV_WRITE | EV_SIGNAL | EV_TIMEOUT, NULL)
@@ -69,6 +102,15 @@ int _php_event_getsockname(evutil_socket_t fd, zval **ppzaddress, zval **ppzport
 #define PHP_EVENT_FETCH_BEVENT(b, zb) \
 	b = (php_event_bevent_t *) zend_object_store_get_object(zb TSRMLS_CC)
 
+#define PHP_EVENT_FETCH_IDLE_REAPER(r, zr) \
+	r = (php_event_idle_reaper_t *) zend_object_store_get_object(zr TSRMLS_CC)
+
+#define PHP_EVENT_FETCH_SHARED_PAYLOAD(p, zp) \
+	p = (php_event_shared_payload_t *) zend_object_store_get_object(zp TSRMLS_CC)
+
+#define PHP_EVENT_FETCH_WORKER_POOL(p, zp) \
+	p = (php_event_worker_pool_t *) zend_object_store_get_object(zp TSRMLS_CC)
+
 #define PHP_EVENT_FETCH_BUFFER(b, zb) \
 	b = (php_event_buffer_t *) zend_object_store_get_object(zb TSRMLS_CC)
 
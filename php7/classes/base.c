@@ -19,6 +19,8 @@
 #include "../src/util.h"
 #include "../src/priv.h"
 #include "zend_exceptions.h"
+#include "idle_reaper.h"
+#include "shared_payload.h"
 
 /* {{{ proto EventBase EventBase::__construct([EventConfig cfg = null]); */
 PHP_METHOD(EventBase, __construct)
@@ -39,7 +41,8 @@ PHP_METHOD(EventBase, __construct)
 	} else {
 		cfg = Z_EVENT_CONFIG_OBJ_P(zcfg);
 
-		b->base = event_base_new_with_config(cfg->ptr);
+		b->base   = event_base_new_with_config(cfg->ptr);
+		b->nolock = (cfg->flags & EVENT_BASE_FLAG_NOLOCK) ? 1 : 0;
 		if (!b->base) {
 			zend_throw_exception_ex(php_event_get_exception(), 0,
 					"EventBase cannot be constructed with the provided configuration. "
@@ -417,6 +420,135 @@ PHP_METHOD(EventBase, resume)
 /* }}} */
 #endif
 
+/* {{{ proto EventIdleReaper EventBase::createIdleReaper(double idle, callable on_idle[, mixed arg = NULL]);
+ * Creates an idle reaper. on_idle(EventBufferEvent bev, mixed arg) is invoked
+ * for each added bufferevent having no I/O activity for at least idle seconds.
+ * The bufferevent is removed from the reaper before the callback is invoked. */
+PHP_METHOD(EventBase, createIdleReaper)
+{
+	zval                    *zbase = getThis();
+	php_event_base_t        *b;
+	php_event_idle_reaper_t *r;
+	double                   idle;
+	zval                    *zcb;
+	zval                    *zarg  = NULL;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "dz|z!",
+				&idle, &zcb, &zarg) == FAILURE) {
+		return;
+	}
+
+	b = Z_EVENT_BASE_OBJ_P(zbase);
+	if (!b->base) {
+		php_error_docref(NULL, E_WARNING, "Event base is not initialized");
+		RETURN_FALSE;
+	}
+
+	PHP_EVENT_INIT_CLASS_OBJECT(return_value, php_event_idle_reaper_ce);
+	r = Z_EVENT_IDLE_REAPER_OBJ_P(return_value);
+
+	if (php_event_idle_reaper_init(r, zbase, idle, zcb, zarg) == FAILURE) {
+		zval_ptr_dtor(return_value);
+		RETURN_FALSE;
+	}
+}
+/* }}} */
+
+/* {{{ proto int EventBase::broadcast(array bevents, mixed payload[, int max_output = 0[, array &skipped = NULL]]);
+ * Appends payload to the output buffers of the bufferevents. payload is either
+ * a string, or an EventSharedPayload object. The data is stored once, and added
+ * to every buffer by reference.
+ *
+ * If max_output is positive, the bufferevents having at least max_output bytes
+ * pending in the output buffer are skipped. The keys of the skipped
+ * bufferevents are stored in skipped, so slow subscribers may be dropped by the
+ * caller.
+ *
+ * Returns the number of bufferevents the payload is added to. */
+PHP_METHOD(EventBase, broadcast)
+{
+	php_event_base_t         *b;
+	zval                     *zbevents;
+	zval                     *zpayload;
+	zend_long                 max_output = 0;
+	zval                     *zskipped   = NULL;
+	zval                     *zbev;
+	zend_ulong                idx;
+	zend_string              *key;
+	php_event_bevent_t       *bev;
+	php_event_shared_block_t *blk;
+	struct evbuffer          *output;
+	zend_long                 count      = 0;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "az|lz",
+				&zbevents, &zpayload, &max_output, &zskipped) == FAILURE) {
+		return;
+	}
+
+	b = Z_EVENT_BASE_OBJ_P(getThis());
+	if (!b->base) {
+		php_error_docref(NULL, E_WARNING, "Event base is not initialized");
+		RETURN_FALSE;
+	}
+
+	if (Z_TYPE_P(zpayload) == IS_OBJECT
+			&& instanceof_function(Z_OBJCE_P(zpayload), php_event_shared_payload_ce)) {
+		php_event_shared_payload_t *p = Z_EVENT_SHARED_PAYLOAD_OBJ_P(zpayload);
+
+		if (!p->block) {
+			php_error_docref(NULL, E_WARNING, "Shared payload is not initialized");
+			RETURN_FALSE;
+		}
+		blk = p->block;
+		blk->refcount++;
+	} else if (Z_TYPE_P(zpayload) == IS_STRING) {
+		blk = php_event_shared_block_new(Z_STRVAL_P(zpayload), Z_STRLEN_P(zpayload));
+	} else {
+		php_error_docref(NULL, E_WARNING, "Expected string or EventSharedPayload payload");
+		RETURN_FALSE;
+	}
+
+	if (zskipped) {
+		zval_dtor(zskipped);
+		array_init(zskipped);
+	}
+
+	ZEND_HASH_FOREACH_KEY_VAL(Z_ARRVAL_P(zbevents), idx, key, zbev) {
+		ZVAL_DEREF(zbev);
+		if (Z_TYPE_P(zbev) != IS_OBJECT
+				|| !instanceof_function(Z_OBJCE_P(zbev), php_event_bevent_ce)) {
+			php_error_docref(NULL, E_WARNING, "Expected EventBufferEvent objects only");
+			continue;
+		}
+
+		bev = Z_EVENT_BEVENT_OBJ_P(zbev);
+		if (!bev->bevent) {
+			continue;
+		}
+
+		output = bufferevent_get_output(bev->bevent);
+
+		if ((max_output > 0 && evbuffer_get_length(output) >= (size_t)max_output)
+				|| php_event_shared_block_add(output, blk) == FAILURE) {
+			if (zskipped) {
+				if (key) {
+					add_next_index_str(zskipped, zend_string_copy(key));
+				} else {
+					add_next_index_long(zskipped, (zend_long)idx);
+				}
+			}
+			continue;
+		}
+
+		++count;
+	} ZEND_HASH_FOREACH_END();
+
+	php_event_shared_block_release(blk);
+
+	RETVAL_LONG(count);
+}
+/* }}} */
+
 /*
  * Local variables:
  * tab-width: 4
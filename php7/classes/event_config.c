@@ -148,6 +148,7 @@ PHP_METHOD(EventConfig, setFlags)
 	cfg = Z_EVENT_CONFIG_OBJ_P(getThis());
 
 	if (!event_config_set_flag(cfg->ptr, flags)) {
+		cfg->flags |= flags;
 		RETURN_TRUE;
 	}
 
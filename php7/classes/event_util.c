@@ -233,6 +233,58 @@ PHP_METHOD(EventUtil, setSocketOption)
 }
 /* }}} */
 
+/* {{{ proto bool EventUtil::setSocketProfile(mixed socket, int profile)
+   Applies one of the EventUtil::SOCKET_PROFILE_* sets of TCP options to the socket */
+PHP_METHOD(EventUtil, setSocketProfile)
+{
+	zval            *zfd;
+	zend_long        profile;
+	evutil_socket_t  fd;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "zl",
+				&zfd, &profile) == FAILURE) {
+		return;
+	}
+
+	fd = php_event_zval_to_fd(zfd);
+	if (fd == -1) {
+		RETURN_FALSE;
+	}
+
+	if (php_event_set_socket_profile(fd, profile) == FAILURE) {
+		RETURN_FALSE;
+	}
+
+	RETVAL_TRUE;
+}
+/* }}} */
+
+#ifdef PHP_EVENT_TCP_INFO
+/* {{{ proto array EventUtil::getTcpInfo(mixed socket)
+   Returns a snapshot of the TCP state of the socket: rtt, rttvar, cwnd,
+   snd_mss, retransmits, unacked and delivery_rate. */
+PHP_METHOD(EventUtil, getTcpInfo)
+{
+	zval            *zfd;
+	evutil_socket_t  fd;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "z",
+				&zfd) == FAILURE) {
+		return;
+	}
+
+	fd = php_event_zval_to_fd(zfd);
+	if (fd == -1) {
+		RETURN_FALSE;
+	}
+
+	if (php_event_get_tcp_info(fd, return_value) == FAILURE) {
+		RETURN_FALSE;
+	}
+}
+/* }}} */
+#endif
+
 /* {{{ proto bool EventUtil::getSocketFd(mixed socket)
  *    Gets numeric file descriptor of a socket. */
 PHP_METHOD(EventUtil, getSocketFd) {
@@ -246,6 +298,131 @@ PHP_METHOD(EventUtil, getSocketFd) {
 }
 /* }}} */
 
+#ifdef PHP_EVENT_FD_PASSING
+/* {{{ proto int EventUtil::sendFds(mixed socket, array fds, string payload)
+ *    Sends the payload over the Unix domain socket with the descriptors of
+ *    fds attached (SCM_RIGHTS). fds may contain streams, socket resources and
+ *    numeric file descriptors. The payload must not be empty. Returns the
+ *    number of bytes sent, or &false; on error. */
+PHP_METHOD(EventUtil, sendFds)
+{
+	zval            *zfd;
+	zval            *zfds;
+	zval            *zv;
+	char            *data;
+	size_t           data_len;
+	evutil_socket_t  fd;
+	int              fds[PHP_EVENT_MAX_PASSED_FDS];
+	size_t           nfds     = 0;
+	ssize_t          n;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "zas",
+				&zfd, &zfds, &data, &data_len) == FAILURE) {
+		return;
+	}
+
+	fd = php_event_zval_to_fd(zfd);
+	if (fd < 0) {
+		RETURN_FALSE;
+	}
+
+	if (data_len == 0) {
+		php_error_docref(NULL, E_WARNING, "payload must not be empty");
+		RETURN_FALSE;
+	}
+
+	if (zend_hash_num_elements(Z_ARRVAL_P(zfds)) > PHP_EVENT_MAX_PASSED_FDS) {
+		php_error_docref(NULL, E_WARNING,
+				"At most %d descriptors can be sent at once", PHP_EVENT_MAX_PASSED_FDS);
+		RETURN_FALSE;
+	}
+
+	ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(zfds), zv) {
+		ZVAL_DEREF(zv);
+		fds[nfds] = (int)php_event_zval_to_fd(zv);
+		if (fds[nfds] < 0) {
+			RETURN_FALSE;
+		}
+		nfds++;
+	} ZEND_HASH_FOREACH_END();
+
+	n = php_event_send_fds(fd, fds, nfds, data, data_len);
+	if (n < 0) {
+		if (errno != EAGAIN && errno != EWOULDBLOCK) {
+			php_error_docref(NULL, E_WARNING, "Failed to send descriptors: %s", strerror(errno));
+		}
+		RETURN_FALSE;
+	}
+
+	RETVAL_LONG(n);
+}
+/* }}} */
+
+/* {{{ proto string EventUtil::recvFds(mixed socket, array &fds[, int max_length = 4096])
+ *    Receives up to max_length bytes from the Unix domain socket. fds is set
+ *    to the array of numeric file descriptors passed with them. Returns the
+ *    data received, an empty string on EOF, or &false; on error. */
+PHP_METHOD(EventUtil, recvFds)
+{
+	zval            *zfd;
+	zval            *zfds;
+	zend_long        max_len   = 4096;
+	evutil_socket_t  fd;
+	int              fds[PHP_EVENT_MAX_PASSED_FDS];
+	size_t           nfds      = PHP_EVENT_MAX_PASSED_FDS;
+	size_t           i;
+	int              truncated;
+	zend_string     *data;
+	ssize_t          n;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "zz|l",
+				&zfd, &zfds, &max_len) == FAILURE) {
+		return;
+	}
+
+	fd = php_event_zval_to_fd(zfd);
+	if (fd < 0) {
+		RETURN_FALSE;
+	}
+
+	if (max_len <= 0) {
+		php_error_docref(NULL, E_WARNING, "max_length must be positive");
+		RETURN_FALSE;
+	}
+
+	ZVAL_DEREF(zfds);
+	zval_dtor(zfds);
+	array_init(zfds);
+
+	data = zend_string_alloc(max_len, 0);
+
+	n = php_event_recv_fds(fd, ZSTR_VAL(data), (size_t)max_len, fds, &nfds, &truncated);
+	if (n < 0) {
+		zend_string_free(data);
+		if (errno != EAGAIN && errno != EWOULDBLOCK) {
+			php_error_docref(NULL, E_WARNING, "Failed to receive descriptors: %s", strerror(errno));
+		}
+		RETURN_FALSE;
+	}
+
+	for (i = 0; i < nfds; i++) {
+		add_next_index_long(zfds, fds[i]);
+	}
+
+	if (truncated) {
+		php_error_docref(NULL, E_WARNING, "Some of the passed descriptors were dropped");
+	}
+
+	if (n < max_len) {
+		data = zend_string_truncate(data, n, 0);
+	}
+	ZSTR_VAL(data)[n] = '\0';
+
+	RETURN_NEW_STR(data);
+}
+/* }}} */
+#endif /* PHP_EVENT_FD_PASSING */
+
 #ifdef PHP_EVENT_SOCKETS_SUPPORT
 /* {{{ proto resource EventUtil::createSocket(int fd)
  *    Creates socket resource from a numeric file descriptor. */
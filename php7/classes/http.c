@@ -231,11 +231,20 @@ static void _http_default_callback(struct evhttp_request *req, void *arg)
  */
 static struct bufferevent* _bev_ssl_callback(struct event_base *base, void *arg) {
 	struct bufferevent* bev;
-	SSL_CTX *ctx = (SSL_CTX *) arg;
+	php_event_ssl_context_t *ectx = (php_event_ssl_context_t *) arg;
+	SSL *ssl;
+
+	/* The current SSL_CTX, which EventSslContext::reload() may replace */
+	ssl = SSL_new(ectx->ctx);
+	if (ssl == NULL) {
+		return NULL;
+	}
+	/* Attach ectx to ssl for callbacks */
+	SSL_set_ex_data(ssl, php_event_ssl_data_index, ectx);
 
 	bev = bufferevent_openssl_socket_new(base,
 			-1,
-			SSL_new(ctx),
+			ssl,
 			BUFFEREVENT_SSL_ACCEPTING,
 			BEV_OPT_CLOSE_ON_FREE);
 	return bev;
@@ -243,6 +252,348 @@ static struct bufferevent* _bev_ssl_callback(struct event_base *base, void *arg)
 /*}}}*/
 #endif
 
+/* Maximum number of {param} segments in a route pattern */
+#define PHP_EVENT_HTTP_ROUTE_MAX_PARAMS 32
+
+/* State of matching a request path against the routing tree */
+typedef struct {
+	int       cmd;      /* Command(method) of the request                 */
+	zend_bool mismatch; /* A route matches the path, but not the method   */
+	int       nparams;
+	struct {
+		const char *name;
+		size_t      name_len;
+		char       *val;
+		size_t      len;
+	} params[PHP_EVENT_HTTP_ROUTE_MAX_PARAMS + 1]; /* + the remainder of a prefix route */
+} php_event_http_route_match_t;
+
+/* {{{ _http_route_new */
+static zend_always_inline php_event_http_route_t *_http_route_new(void)
+{
+	return ecalloc(1, sizeof(php_event_http_route_t));
+}
+/* }}} */
+
+/* {{{ _http_route_child_dtor */
+static void _http_route_child_dtor(zval *zv)
+{
+	_php_event_free_http_route((php_event_http_route_t *)Z_PTR_P(zv));
+}
+/* }}} */
+
+/* {{{ _http_route_add
+ * Adds a route to the tree of the HTTP server. Pattern segments are static
+ * strings, {name} parameters matching any non-empty segment, or a trailing *
+ * matching the rest of the path. */
+static int _http_route_add(php_event_http_t *http, const char *pattern, size_t pattern_len, zend_long methods, zval *zcb, zval *zarg)
+{
+	php_event_http_route_t  *node;
+	php_event_http_route_t  *child;
+	php_event_http_cb_t    **list;
+	php_event_http_cb_t     *cb;
+	const char              *p       = pattern;
+	const char              *end     = pattern + pattern_len;
+	const char              *seg_end;
+	size_t                   len;
+	int                      nparams = 0;
+
+	if (pattern_len == 0 || *pattern != '/') {
+		php_error_docref(NULL, E_WARNING, "Route pattern must start with '/'");
+		return FAILURE;
+	}
+
+	if (!http->routes) {
+		http->routes = _http_route_new();
+	}
+	node = http->routes;
+	list = &node->handlers;
+
+	while (p < end) {
+		if (*p == '/') {
+			p++;
+			continue;
+		}
+
+		seg_end = memchr(p, '/', end - p);
+		if (seg_end == NULL) {
+			seg_end = end;
+		}
+		len = seg_end - p;
+
+		if (len == 1 && *p == '*') {
+			if (seg_end != end) {
+				php_error_docref(NULL, E_WARNING, "'*' is allowed only at the end of a route pattern");
+				return FAILURE;
+			}
+			list = &node->prefix;
+			break;
+		}
+
+		if (*p == '{') {
+			if (len < 3 || p[len - 1] != '}'
+					|| memchr(p + 1, '{', len - 2) || memchr(p + 1, '}', len - 2)) {
+				php_error_docref(NULL, E_WARNING, "Invalid route parameter: %.*s", (int)len, p);
+				return FAILURE;
+			}
+			if (++nparams > PHP_EVENT_HTTP_ROUTE_MAX_PARAMS) {
+				php_error_docref(NULL, E_WARNING, "At most %d route parameters are allowed",
+						PHP_EVENT_HTTP_ROUTE_MAX_PARAMS);
+				return FAILURE;
+			}
+
+			if (!node->param) {
+				node->param           = _http_route_new();
+				node->param->name     = estrndup(p + 1, len - 2);
+				node->param->name_len = len - 2;
+			} else if (node->param->name_len != len - 2 || memcmp(node->param->name, p + 1, len - 2)) {
+				php_error_docref(NULL, E_WARNING, "Route parameter %.*s conflicts with {%s} of another route",
+						(int)len, p, node->param->name);
+				return FAILURE;
+			}
+			node = node->param;
+		} else {
+			if (memchr(p, '{', len) || memchr(p, '}', len) || memchr(p, '*', len)) {
+				php_error_docref(NULL, E_WARNING, "Invalid route segment: %.*s", (int)len, p);
+				return FAILURE;
+			}
+
+			if (!node->children) {
+				ALLOC_HASHTABLE(node->children);
+				zend_hash_init(node->children, 8, NULL, _http_route_child_dtor, 0);
+			}
+
+			child = zend_hash_str_find_ptr(node->children, p, len);
+			if (child == NULL) {
+				child = _http_route_new();
+				zend_hash_str_add_ptr(node->children, p, len, child);
+			}
+			node = child;
+		}
+
+		list = &node->handlers;
+		p    = seg_end;
+	}
+
+	for (; *list; list = &(*list)->next) {
+		if ((*list)->methods == methods) {
+			php_error_docref(NULL, E_WARNING, "The route already exists");
+			return FAILURE;
+		}
+	}
+
+	cb          = _new_http_cb(&http->base, zarg, zcb);
+	cb->methods = (int)methods;
+	*list       = cb;
+
+	return SUCCESS;
+}
+/* }}} */
+
+/* {{{ _http_route_handler
+ * Returns the first route of the list accepting the request method */
+static zend_always_inline php_event_http_cb_t *_http_route_handler(php_event_http_cb_t *cb, php_event_http_route_match_t *m)
+{
+	for (; cb; cb = cb->next) {
+		if (!cb->methods || (cb->methods & m->cmd)) {
+			return cb;
+		}
+		m->mismatch = 1;
+	}
+
+	return NULL;
+}
+/* }}} */
+
+/* {{{ _http_route_match
+ * Matches the path(without the leading slash) against the subtree. Static
+ * segments take precedence over parameters, and parameters over prefixes.
+ * The cost depends on the number of path segments, not on the number of routes. */
+static php_event_http_cb_t *_http_route_match(php_event_http_route_t *node, char *path, php_event_http_route_match_t *m)
+{
+	php_event_http_route_t *child;
+	php_event_http_cb_t    *cb;
+	char                   *end;
+	char                   *next;
+	size_t                  len;
+	int                     nparams = m->nparams;
+
+	if (*path == '\0') {
+		if ((cb = _http_route_handler(node->handlers, m)) != NULL) {
+			return cb;
+		}
+	} else {
+		end = strchr(path, '/');
+		if (end == NULL) {
+			end = path + strlen(path);
+		}
+		len  = end - path;
+		next = *end ? end + 1 : end;
+
+		if (node->children
+				&& (child = zend_hash_str_find_ptr(node->children, path, len)) != NULL
+				&& (cb = _http_route_match(child, next, m)) != NULL) {
+			return cb;
+		}
+		m->nparams = nparams;
+
+		if (node->param && len) {
+			m->params[nparams].name     = node->param->name;
+			m->params[nparams].name_len = node->param->name_len;
+			m->params[nparams].val      = path;
+			m->params[nparams].len      = len;
+			m->nparams++;
+
+			if ((cb = _http_route_match(node->param, next, m)) != NULL) {
+				return cb;
+			}
+			m->nparams = nparams;
+		}
+	}
+
+	if (node->prefix && (cb = _http_route_handler(node->prefix, m)) != NULL) {
+		m->params[nparams].name     = "*";
+		m->params[nparams].name_len = 1;
+		m->params[nparams].val      = path;
+		m->params[nparams].len      = strlen(path);
+		m->nparams++;
+		return cb;
+	}
+
+	return NULL;
+}
+/* }}} */
+
+/* {{{ _http_route_callback
+ * Generic callback of an HTTP server with routes. Passes the request to the
+ * matching route, otherwise to the default callback. */
+static void _http_route_callback(struct evhttp_request *req, void *arg)
+{
+	php_event_http_t             *http     = (php_event_http_t *) arg;
+	php_event_http_route_match_t  m;
+	php_event_http_cb_t          *cb       = NULL;
+	const struct evhttp_uri      *uri;
+	const char                   *uri_path;
+	char                         *path;
+	char                         *decoded;
+	size_t                        decoded_len;
+	int                           i;
+	zend_fcall_info               fci;
+	zval                          argv[3];
+	zval                          retval;
+	zval                          zcallable;
+	zend_string                  *func_name;
+	Z_EVENT_X_OBJ_T(base)        *b;
+	Z_EVENT_X_OBJ_T(http_req)    *http_req;
+
+	PHP_EVENT_ASSERT(http);
+
+	uri      = evhttp_request_get_evhttp_uri(req);
+	uri_path = uri ? evhttp_uri_get_path(uri) : NULL;
+	if (uri_path == NULL) {
+		uri_path = "";
+	} else if (*uri_path == '/') {
+		uri_path++;
+	}
+	path = estrdup(uri_path);
+
+	m.cmd      = evhttp_request_get_command(req);
+	m.mismatch = 0;
+	m.nparams  = 0;
+
+	if (http->routes) {
+		cb = _http_route_match(http->routes, path, &m);
+	}
+
+	if (cb == NULL) {
+		efree(path);
+
+		if (m.mismatch) {
+			evhttp_send_error(req, HTTP_BADMETHOD, NULL);
+		} else if (!Z_ISUNDEF(http->cb.func_name)) {
+			_http_default_callback(req, arg);
+		} else {
+			evhttp_send_error(req, HTTP_NOTFOUND, NULL);
+		}
+		return;
+	}
+
+	/* Protect against accidental destruction of the func name before zend_call_function() finished */
+	ZVAL_COPY(&zcallable, &cb->cb.func_name);
+
+	if (!zend_is_callable(&zcallable, IS_CALLABLE_STRICT, &func_name)) {
+		zend_string_release(func_name);
+		zval_ptr_dtor(&zcallable);
+		efree(path);
+		return;
+	}
+	zend_string_release(func_name);
+
+	/* Call userspace function according to
+	 * proto void callback(EventHttpRequest req, mixed data, array params);*/
+
+	PHP_EVENT_INIT_CLASS_OBJECT(&argv[0], php_event_http_req_ce);
+	http_req = Z_EVENT_HTTP_REQ_OBJ_P(&argv[0]);
+	http_req->ptr = req;
+	ZVAL_UNDEF(&http_req->self);
+	ZVAL_UNDEF(&http_req->data);
+	php_event_init_callback(&http_req->cb);
+	http_req->internal = 1; /* Don't evhttp_request_free(req) */
+
+	if (Z_ISUNDEF(cb->data)) {
+		ZVAL_NULL(&argv[1]);
+	} else {
+		ZVAL_COPY(&argv[1], &cb->data);
+	}
+
+	array_init(&argv[2]);
+	for (i = 0; i < m.nparams; i++) {
+		/* Parameters are ordered, so the terminator only overwrites a separator */
+		m.params[i].val[m.params[i].len] = '\0';
+		decoded = evhttp_uridecode(m.params[i].val, 0, &decoded_len);
+		if (decoded) {
+			add_assoc_stringl_ex(&argv[2], m.params[i].name, m.params[i].name_len, decoded, decoded_len);
+			free(decoded);
+		}
+	}
+	efree(path);
+
+	fci.size = sizeof(fci);
+#ifdef HAVE_PHP_ZEND_FCALL_INFO_FUNCTION_TABLE
+	fci.function_table = EG(function_table);
+#endif
+	ZVAL_COPY_VALUE(&fci.function_name, &zcallable);
+	fci.object = NULL;
+	fci.retval = &retval;
+	fci.params = argv;
+	fci.param_count = 3;
+	fci.no_separation = 1;
+#ifdef HAVE_PHP_ZEND_FCALL_INFO_SYMBOL_TABLE
+	fci.symbol_table = NULL;
+#endif
+
+	if (zend_call_function(&fci, &cb->cb.fci_cache) == SUCCESS) {
+		if (!Z_ISUNDEF(retval)) {
+			zval_ptr_dtor(&retval);
+		}
+	} else {
+		if (EG(exception)) {
+			b = Z_EVENT_BASE_OBJ_P(&cb->base);
+			PHP_EVENT_ASSERT(b && b->base);
+			event_base_loopbreak(b->base);
+		} else {
+			php_error_docref(NULL, E_WARNING, "Failed to invoke the http route callback");
+		}
+	}
+
+	zval_ptr_dtor(&zcallable);
+
+	zval_ptr_dtor(&argv[0]);
+	zval_ptr_dtor(&argv[1]);
+	zval_ptr_dtor(&argv[2]);
+}
+/* }}} */
+
 /* }}} */
 
 /*{{{ proto int EventHttp::__sleep */
@@ -273,6 +624,37 @@ void _php_event_free_http_cb(php_event_http_cb_t *http_cb)/*{{{*/
 	efree(http_cb);
 } /*}}}*/
 
+/* {{{ _php_event_free_http_route
+ * Frees a node of the routing tree together with its subtree and routes */
+void _php_event_free_http_route(php_event_http_route_t *node)
+{
+	php_event_http_cb_t *cb;
+	php_event_http_cb_t *cb_next;
+
+	if (node->children) {
+		zend_hash_destroy(node->children);
+		FREE_HASHTABLE(node->children);
+	}
+	if (node->param) {
+		_php_event_free_http_route(node->param);
+	}
+	if (node->name) {
+		efree(node->name);
+	}
+
+	for (cb = node->handlers; cb; cb = cb_next) {
+		cb_next = cb->next;
+		_php_event_free_http_cb(cb);
+	}
+	for (cb = node->prefix; cb; cb = cb_next) {
+		cb_next = cb->next;
+		_php_event_free_http_cb(cb);
+	}
+
+	efree(node);
+}
+/* }}} */
+
 /* {{{ proto EventHttp EventHttp::__construct(EventBase base[, EventSslContext ctx = NULL]);
  * Creates new http server object.
  */
@@ -318,12 +700,14 @@ PHP_METHOD(EventHttp, __construct)
 	ZVAL_UNDEF(&http->cb.func_name);
 	ZVAL_UNDEF(&http->data);
 	http->cb_head = NULL;
+	http->routes  = NULL;
 
 #if LIBEVENT_VERSION_NUMBER >= 0x02010000 && defined(HAVE_EVENT_OPENSSL_LIB)
 	if (zctx) {
 		ectx = Z_EVENT_SSL_CONTEXT_OBJ_P(zctx);
 		PHP_EVENT_ASSERT(ectx->ctx);
-		evhttp_set_bevcb(http_ptr, _bev_ssl_callback, ectx->ctx);
+		ZVAL_COPY(&http->ctx, zctx);
+		evhttp_set_bevcb(http_ptr, _bev_ssl_callback, ectx);
 	}
 #endif
 }
@@ -432,6 +816,46 @@ PHP_METHOD(EventHttp, setCallback)
 }
 /* }}} */
 
+/* {{{ proto bool EventHttp::route(string pattern, callable cb[, int methods = 0[, mixed arg = NULL]]);
+ * Adds a route to the routing tree of the server. Pattern segments match
+ * exactly, except for {name} segments, which match any non-empty segment, and
+ * a trailing *, which matches the rest of the path. The callback receives an
+ * array of the parameter values(the rest of the path under '*' key) after
+ * arg. methods is a mask of EventHttpRequest::CMD_* constants, or 0 for any
+ * method. Callbacks set with setCallback() take precedence over the routes,
+ * the default callback gets the requests no route matches.
+ */
+PHP_METHOD(EventHttp, route)
+{
+	php_event_http_t *http;
+	char             *pattern;
+	size_t            pattern_len;
+	zval             *zcb;
+	zend_long         methods     = 0;
+	zval             *zarg        = NULL;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "sz|lz!",
+				&pattern, &pattern_len, &zcb, &methods, &zarg) == FAILURE) {
+		return;
+	}
+
+	http = Z_EVENT_HTTP_OBJ_P(getThis());
+
+	if (methods < 0) {
+		php_error_docref(NULL, E_WARNING, "methods must not be negative");
+		RETURN_FALSE;
+	}
+
+	if (_http_route_add(http, pattern, pattern_len, methods, zcb, zarg) == FAILURE) {
+		RETURN_FALSE;
+	}
+
+	evhttp_set_gencb(http->ptr, _http_route_callback, (void *)http);
+
+	RETVAL_TRUE;
+}
+/* }}} */
+
 /* {{{ proto void EventHttp::setDefaultCallback(callable cb[, mixed arg = NULL]);
  * Sets default callback to handle requests that are not caught by specific callbacks
  */
@@ -455,7 +879,7 @@ PHP_METHOD(EventHttp, setDefaultCallback)
 		ZVAL_UNDEF(&http->data);
 	}
 
-	evhttp_set_gencb(http->ptr, _http_default_callback, (void *)http);
+	evhttp_set_gencb(http->ptr, http->routes ? _http_route_callback : _http_default_callback, (void *)http);
 }
 /* }}} */
 
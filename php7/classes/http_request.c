@@ -416,6 +416,8 @@ PHP_METHOD(EventHttpRequest, getBufferEvent)
 	ZVAL_UNDEF(&bev->input);
 	ZVAL_UNDEF(&bev->output);
 	bev->_internal = 1;
+	/* We don't know how libevent created it */
+	bev->lock      = 1;
 }
 /* }}} */
 #endif
@@ -18,6 +18,8 @@
 #include "../src/common.h"
 #include "../src/util.h"
 #include "../src/priv.h"
+#include "buffer_event.h"
+#include "listener.h"
 #include "zend_exceptions.h"
 
 /* {{{ Private */
@@ -90,6 +92,441 @@ static int sockaddr_parse(const struct sockaddr *in_addr, zval *out_zarr)
 }
 /* }}} */
 
+/* {{{ _listener_accept_events
+ * Turns accepting on, or off. l->disabled and l->paused are not touched */
+static int _listener_accept_events(php_event_listener_t *l, int on)
+{
+	if (l->batch_ev) {
+		return on ? event_add(l->batch_ev, NULL) : event_del(l->batch_ev);
+	}
+	return on ? evconnlistener_enable(l->listener) : evconnlistener_disable(l->listener);
+}
+/* }}} */
+
+/* {{{ _listener_pause
+ * Stops accepting, when the connection limit is reached */
+static void _listener_pause(php_event_listener_t *l)
+{
+	if (l->paused || l->listener == NULL) {
+		return;
+	}
+	if (!l->disabled) {
+		_listener_accept_events(l, 0);
+	}
+	l->paused = 1;
+	l->pauses++;
+	evutil_gettimeofday(&l->paused_at, NULL);
+}
+/* }}} */
+
+/* {{{ _listener_resume */
+static void _listener_resume(php_event_listener_t *l)
+{
+	struct timeval now;
+	struct timeval delta;
+
+	if (!l->paused) {
+		return;
+	}
+	l->paused = 0;
+
+	evutil_gettimeofday(&now, NULL);
+	evutil_timersub(&now, &l->paused_at, &delta);
+	evutil_timeradd(&l->paused_time, &delta, &l->paused_time);
+
+	if (!l->disabled && l->listener) {
+		_listener_accept_events(l, 1);
+	}
+}
+/* }}} */
+
+/* {{{ _listener_conn_closed
+ * Called when a buffer event created from the template is closed */
+static void _listener_conn_closed(php_event_conn_counter_t *c)
+{
+	php_event_listener_t *l = (php_event_listener_t *) c->owner;
+
+	if (l->paused && c->live <= l->low_conns) {
+		_listener_resume(l);
+	}
+}
+/* }}} */
+
+/* {{{ PROXY protocol */
+
+static void _php_event_listener_cb(struct evconnlistener *listener, evutil_socket_t fd, struct sockaddr *address, int socklen, void *ctx);
+
+/* Errors of recv() meaning that the data is not available yet */
+#ifdef PHP_WIN32
+# define PHP_EVENT_RECV_RETRIABLE(e) ((e) == WSAEWOULDBLOCK || (e) == WSAEINTR)
+#else
+# define PHP_EVENT_RECV_RETRIABLE(e) ((e) == EAGAIN || (e) == EWOULDBLOCK || (e) == EINTR)
+#endif
+
+/* Max. length of a v1 header including CRLF */
+#define PHP_EVENT_PROXY_V1_MAX 107
+/* Length of the fixed part of a v2 header */
+#define PHP_EVENT_PROXY_V2_HDR 16
+
+static const unsigned char proxy_v2_sig[12] = {
+	0x0D, 0x0A, 0x0D, 0x0A, 0x00, 0x0D, 0x0A, 0x51, 0x55, 0x49, 0x54, 0x0A
+};
+
+/* {{{ _proxy_conn_free
+ * Frees a connection waiting for the header. The socket is closed, if
+ * close_fd is non-zero */
+static void _proxy_conn_free(php_event_proxy_conn_t *p, int close_fd)
+{
+	php_event_listener_t *l = p->l;
+
+	if (p->prev) {
+		p->prev->next = p->next;
+	} else {
+		l->proxy_head = p->next;
+	}
+	if (p->next) {
+		p->next->prev = p->prev;
+	}
+
+	event_free(p->ev);
+	if (close_fd) {
+		evutil_closesocket(p->fd);
+	}
+	efree(p);
+}
+/* }}} */
+
+/* {{{ php_event_listener_proxy_clear
+ * Drops connections waiting for the PROXY header */
+void php_event_listener_proxy_clear(php_event_listener_t *l)
+{
+	while (l->proxy_head) {
+		_proxy_conn_free(l->proxy_head, 1);
+	}
+}
+/* }}} */
+
+/* {{{ _proxy_parse_port */
+static int _proxy_parse_port(const char *s)
+{
+	size_t i;
+	int    port = 0;
+
+	for (i = 0; s[i]; i++) {
+		if (i == 5 || s[i] < '0' || s[i] > '9') {
+			return -1;
+		}
+		port = port * 10 + (s[i] - '0');
+	}
+
+	return (i && port <= 65535) ? port : -1;
+}
+/* }}} */
+
+/* {{{ _proxy_parse_v1
+ * Parses a header like "PROXY TCP4 <src> <dst> <sport> <dport>\r\n" replacing
+ * the peer address with the source address */
+static int _proxy_parse_v1(php_event_proxy_conn_t *p)
+{
+	char  line[PHP_EVENT_PROXY_V1_MAX + 1];
+	char *tok[6];
+	char *s;
+	int   ntok = 0;
+	int   port;
+
+	if (p->len < 8 || p->buf[p->len - 2] != '\r') {
+		return FAILURE;
+	}
+	memcpy(line, p->buf, p->len - 2);
+	line[p->len - 2] = '\0';
+
+	for (s = line; s && ntok < 6; ntok++) {
+		tok[ntok] = s;
+		if ((s = strchr(s, ' ')) != NULL) {
+			*s++ = '\0';
+		}
+	}
+	if (s || ntok < 2 || strcmp(tok[0], "PROXY")) {
+		return FAILURE;
+	}
+
+	if (!strcmp(tok[1], "UNKNOWN")) {
+		/* Keep the address of the proxy */
+		return SUCCESS;
+	}
+
+	if (ntok != 6 || (port = _proxy_parse_port(tok[4])) < 0 || _proxy_parse_port(tok[5]) < 0) {
+		return FAILURE;
+	}
+
+	memset(&p->addr, 0, sizeof(p->addr));
+
+	if (!strcmp(tok[1], "TCP4")) {
+		struct sockaddr_in *sin = (struct sockaddr_in *) &p->addr;
+
+		if (evutil_inet_pton(AF_INET, tok[2], &sin->sin_addr) != 1) {
+			return FAILURE;
+		}
+		sin->sin_family = AF_INET;
+		sin->sin_port   = htons((unsigned short) port);
+		p->addr_len     = sizeof(*sin);
+#if HAVE_IPV6
+	} else if (!strcmp(tok[1], "TCP6")) {
+		struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *) &p->addr;
+
+		if (evutil_inet_pton(AF_INET6, tok[2], &sin6->sin6_addr) != 1) {
+			return FAILURE;
+		}
+		sin6->sin6_family = AF_INET6;
+		sin6->sin6_port   = htons((unsigned short) port);
+		p->addr_len       = sizeof(*sin6);
+#endif
+	} else {
+		return FAILURE;
+	}
+
+	return SUCCESS;
+}
+/* }}} */
+
+/* {{{ _proxy_parse_v2
+ * Parses a binary header replacing the peer address with the source address */
+static int _proxy_parse_v2(php_event_proxy_conn_t *p)
+{
+	const unsigned char *d   = p->buf + PHP_EVENT_PROXY_V2_HDR;
+	/* The TLVs beyond the buffer are discarded */
+	size_t               len = MIN(p->len, sizeof(p->buf)) - PHP_EVENT_PROXY_V2_HDR;
+
+	if (memcmp(p->buf, proxy_v2_sig, sizeof(proxy_v2_sig)) || (p->buf[12] & 0xF0) != 0x20) {
+		return FAILURE;
+	}
+
+	switch (p->buf[12] & 0x0F) {
+		case 0x0:
+			/* LOCAL, e.g. a health check of the proxy itself */
+			return SUCCESS;
+		case 0x1:
+			/* PROXY */
+			break;
+		default:
+			return FAILURE;
+	}
+
+	switch (p->buf[13] >> 4) {
+		case 0x1: {
+			struct sockaddr_in *sin = (struct sockaddr_in *) &p->addr;
+
+			if (len < 12) {
+				return FAILURE;
+			}
+			memset(&p->addr, 0, sizeof(p->addr));
+			sin->sin_family = AF_INET;
+			memcpy(&sin->sin_addr, d, 4);
+			memcpy(&sin->sin_port, d + 8, 2);
+			p->addr_len = sizeof(*sin);
+			break;
+		}
+#if HAVE_IPV6
+		case 0x2: {
+			struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *) &p->addr;
+
+			if (len < 36) {
+				return FAILURE;
+			}
+			memset(&p->addr, 0, sizeof(p->addr));
+			sin6->sin6_family = AF_INET6;
+			memcpy(&sin6->sin6_addr, d, 16);
+			memcpy(&sin6->sin6_port, d + 32, 2);
+			p->addr_len = sizeof(*sin6);
+			break;
+		}
+#endif
+		default:
+			/* AF_UNSPEC, AF_UNIX: keep the address of the proxy */
+			break;
+	}
+
+	return SUCCESS;
+}
+/* }}} */
+
+/* {{{ _proxy_recv
+ * Returns number of bytes received, 0 if no data is available yet, or -1 if
+ * the connection is closed, or failed */
+static zend_always_inline ssize_t _proxy_recv(evutil_socket_t fd, unsigned char *buf, size_t len, int flags)
+{
+	ssize_t n = recv(fd, (char *) buf, len, flags);
+
+	if (n > 0) {
+		return n;
+	}
+	if (n < 0 && PHP_EVENT_RECV_RETRIABLE(EVUTIL_SOCKET_ERROR())) {
+		return 0;
+	}
+	return -1;
+}
+/* }}} */
+
+/* {{{ _proxy_conn_wait
+ * Waits for more data until the deadline */
+static void _proxy_conn_wait(php_event_proxy_conn_t *p)
+{
+	struct timeval now;
+	struct timeval tv;
+
+	evutil_gettimeofday(&now, NULL);
+
+	if (!evutil_timercmp(&now, &p->deadline, <)) {
+		_proxy_conn_free(p, 1);
+		return;
+	}
+	evutil_timersub(&p->deadline, &now, &tv);
+
+	if (event_add(p->ev, &tv)) {
+		_proxy_conn_free(p, 1);
+	}
+}
+/* }}} */
+
+/* {{{ _proxy_read_cb
+ * Reads the header without consuming any byte of the payload following it.
+ * Then passes the connection to the accept callback */
+static void _proxy_read_cb(evutil_socket_t fd, short what, void *arg)
+{
+	php_event_proxy_conn_t  *p = (php_event_proxy_conn_t *) arg;
+	php_event_listener_t    *l = p->l;
+	unsigned char            peek[PHP_EVENT_PROXY_V1_MAX];
+	unsigned char            skip[PHP_EVENT_PROXY_HDR_MAX];
+	unsigned char           *nl;
+	unsigned char           *dst;
+	struct sockaddr_storage  addr;
+	ev_socklen_t             addr_len;
+	size_t                   want;
+	size_t                   total;
+	ssize_t                  n;
+	int                      res;
+
+	if (what & EV_TIMEOUT) {
+		_proxy_conn_free(p, 1);
+		return;
+	}
+
+	for (;;) {
+		dst = p->buf + p->len;
+
+		if (p->len == 0) {
+			/* The first byte tells the version */
+			want = 1;
+		} else if (p->buf[0] == proxy_v2_sig[0]) {
+			if (p->len < PHP_EVENT_PROXY_V2_HDR) {
+				want = PHP_EVENT_PROXY_V2_HDR - p->len;
+			} else {
+				total = PHP_EVENT_PROXY_V2_HDR + ((p->buf[14] << 8) | p->buf[15]);
+				if (total == p->len) {
+					res = _proxy_parse_v2(p);
+					break;
+				}
+				want = total - p->len;
+
+				if (p->len >= sizeof(p->buf)) {
+					/* The address block is in the buffer. Read and drop the rest of the TLVs */
+					dst  = skip;
+					want = MIN(want, sizeof(skip));
+				} else {
+					want = MIN(want, sizeof(p->buf) - p->len);
+				}
+			}
+		} else if (p->buf[0] == 'P') {
+			if (p->buf[p->len - 1] == '\n') {
+				res = _proxy_parse_v1(p);
+				break;
+			}
+			if (p->len >= PHP_EVENT_PROXY_V1_MAX) {
+				_proxy_conn_free(p, 1);
+				return;
+			}
+
+			/* Take the bytes up to LF */
+			n = _proxy_recv(fd, peek, PHP_EVENT_PROXY_V1_MAX - p->len, MSG_PEEK);
+			if (n <= 0) {
+				if (n < 0) {
+					_proxy_conn_free(p, 1);
+				} else {
+					_proxy_conn_wait(p);
+				}
+				return;
+			}
+			nl   = memchr(peek, '\n', n);
+			want = nl ? (size_t) (nl - peek) + 1 : (size_t) n;
+		} else {
+			_proxy_conn_free(p, 1);
+			return;
+		}
+
+		n = _proxy_recv(fd, dst, want, 0);
+		if (n <= 0) {
+			if (n < 0) {
+				_proxy_conn_free(p, 1);
+			} else {
+				_proxy_conn_wait(p);
+			}
+			return;
+		}
+		p->len += n;
+	}
+
+	if (res == FAILURE) {
+		_proxy_conn_free(p, 1);
+		return;
+	}
+
+	memcpy(&addr, &p->addr, p->addr_len);
+	addr_len = p->addr_len;
+	_proxy_conn_free(p, 0);
+
+	_php_event_listener_cb(NULL, fd, (struct sockaddr *) &addr, (int) addr_len, (void *) l);
+}
+/* }}} */
+
+/* {{{ _proxy_conn_start
+ * Starts waiting for the header of an accepted connection */
+static void _proxy_conn_start(php_event_listener_t *l, evutil_socket_t fd, struct sockaddr *address, int socklen)
+{
+	php_event_proxy_conn_t *p;
+	struct timeval          now;
+
+	p = ecalloc(1, sizeof(php_event_proxy_conn_t));
+	p->l  = l;
+	p->fd = fd;
+	if (socklen > 0 && (size_t) socklen <= sizeof(p->addr)) {
+		memcpy(&p->addr, address, socklen);
+		p->addr_len = socklen;
+	}
+
+	evutil_gettimeofday(&now, NULL);
+	evutil_timeradd(&now, &l->proxy_timeout, &p->deadline);
+
+	/* Not persistent: the timeout is a deadline for the whole header */
+	p->ev = event_new(Z_EVENT_BASE_OBJ_P(&l->base)->base, fd, EV_READ, _proxy_read_cb, (void *) p);
+	if (p->ev == NULL || event_add(p->ev, &l->proxy_timeout)) {
+		if (p->ev) {
+			event_free(p->ev);
+		}
+		efree(p);
+		evutil_closesocket(fd);
+		return;
+	}
+
+	p->next = l->proxy_head;
+	if (p->next) {
+		p->next->prev = p;
+	}
+	l->proxy_head = p;
+}
+/* }}} */
+
+/* PROXY protocol }}} */
+
 /* {{{ _php_event_listener_cb */
 static void _php_event_listener_cb(struct evconnlistener *listener, evutil_socket_t fd, struct sockaddr *address, int socklen, void *ctx) {
 	php_event_listener_t *l       = (php_event_listener_t *)ctx;
@@ -98,14 +535,40 @@ static void _php_event_listener_cb(struct evconnlistener *listener, evutil_socke
 	zval                  retval;
 	zend_string     *func_name;
 	zval                  zcallable;
+	zval                  zbev;
 
 	PHP_EVENT_ASSERT(l);
 
+	if (listener && l->proxy) {
+		/* Called again with NULL listener, when the header is read */
+		_proxy_conn_start(l, fd, address, socklen);
+		return;
+	}
+
+	if (l->tpl) {
+		/* Wrap the socket without a trip to userspace. The object stays alive
+		 * until the connection is closed, even if the accept callback is not
+		 * set, or doesn't keep it */
+		if (php_event_bevent_from_template(&zbev, &l->base, fd, l->tpl, l->conns) == FAILURE) {
+			php_error_docref(NULL, E_WARNING, "Failed to allocate bufferevent for accepted socket");
+			evutil_closesocket(fd);
+			return;
+		}
+
+		if (l->max_conns > 0 && l->conns->live >= l->max_conns) {
+			_listener_pause(l);
+		}
+	} else {
+		ZVAL_UNDEF(&zbev);
+	}
+
 	/* Protect against accidental destruction of the func name before zend_call_function() finished */
 	ZVAL_COPY(&zcallable, &l->cb.func_name);
 
 	if (!zend_is_callable(&zcallable,  IS_CALLABLE_STRICT, &func_name)) {
 		zend_string_release(func_name);
+		zval_ptr_dtor(&zcallable);
+		zval_ptr_dtor(&zbev);
 		return;
 	}
 	zend_string_release(func_name);
@@ -113,6 +576,8 @@ static void _php_event_listener_cb(struct evconnlistener *listener, evutil_socke
 	/* Call user function having proto:
 	 * void cb (EventListener $listener, resource $fd, array $address, mixed $data);
 	 * $address = array ("IP-address", port)
+	 *
+	 * $fd is an EventBufferEvent object, if there is a buffer event template.
 	 */
 
 	ZVAL_COPY(&argv[0], &l->self);
@@ -130,7 +595,9 @@ static void _php_event_listener_cb(struct evconnlistener *listener, evutil_socke
 	 *
 	 * Thus, we're just passing numeric fd here.
 	 */
-	if (fd) {
+	if (!Z_ISUNDEF(zbev)) {
+		ZVAL_COPY_VALUE(&argv[1], &zbev);
+	} else if (fd) {
 		ZVAL_LONG(&argv[1], fd);
 	} else {
 		ZVAL_NULL(&argv[1]);
@@ -247,6 +714,237 @@ static void listener_error_cb(struct evconnlistener *listener, void *ctx) {
 }
 /* }}} */
 
+#if LIBEVENT_VERSION_NUMBER >= 0x02000300
+/* Errors of accept() meaning that the next connection may be accepted later */
+#ifdef PHP_WIN32
+# define PHP_EVENT_ACCEPT_RETRIABLE(e) \
+	((e) == WSAEWOULDBLOCK || (e) == WSAEINTR || (e) == WSAECONNRESET)
+#else
+# define PHP_EVENT_ACCEPT_RETRIABLE(e) \
+	((e) == EAGAIN || (e) == EWOULDBLOCK || (e) == EINTR || (e) == ECONNABORTED)
+#endif
+
+/* {{{ accept_nonblock
+ * Accepts a connection as a non-blocking, close-on-exec socket */
+static zend_always_inline evutil_socket_t accept_nonblock(evutil_socket_t lfd, struct sockaddr *addr, socklen_t *addr_len)
+{
+	evutil_socket_t fd;
+
+#if defined(HAVE_ACCEPT4) && defined(SOCK_NONBLOCK) && defined(SOCK_CLOEXEC)
+	fd = accept4(lfd, addr, addr_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+	fd = accept(lfd, addr, addr_len);
+	if (fd >= 0) {
+		evutil_make_socket_nonblocking(fd);
+		evutil_make_socket_closeonexec(fd);
+	}
+#endif
+
+	return fd;
+}
+/* }}} */
+
+/* {{{ _php_event_listener_batch_cb
+ * Accepts up to batch_max pending connections, and passes them to the batch
+ * callback at once. The rest is accepted on the next loop iteration. */
+static void _php_event_listener_batch_cb(evutil_socket_t lfd, short what, void *arg)
+{
+	php_event_listener_t    *l     = (php_event_listener_t *) arg;
+	struct sockaddr_storage  ss;
+	socklen_t                ss_len;
+	evutil_socket_t          fd    = -1;
+	zend_long                n     = 0;
+	int                      err   = 0;
+	zend_fcall_info          fci;
+	zval                     argv[4];
+	zval                     retval;
+	zval                     zself;
+	zval                     zaddr;
+	zend_string             *func_name;
+	zval                     zcallable;
+	zval                    *zfd;
+	zend_bool                called = 0;
+
+	PHP_EVENT_ASSERT(l);
+
+	array_init(&argv[1]);
+	if (l->batch_addr) {
+		array_init(&argv[2]);
+	} else {
+		ZVAL_NULL(&argv[2]);
+	}
+
+	while (n < l->batch_max) {
+		ss_len = sizeof(ss);
+		fd = accept_nonblock(lfd, l->batch_addr ? (struct sockaddr *) &ss : NULL,
+				l->batch_addr ? &ss_len : NULL);
+		if (fd < 0) {
+			err = EVUTIL_SOCKET_ERROR();
+			break;
+		}
+		n++;
+
+		add_next_index_long(&argv[1], fd);
+
+		if (l->batch_addr) {
+			/* See _php_event_listener_cb() */
+#ifdef AF_UNIX
+			if (ss.ss_family == AF_UNIX) {
+				ZVAL_NULL(&zaddr);
+			} else
+#endif
+			{
+				array_init(&zaddr);
+				sockaddr_parse((struct sockaddr *) &ss, &zaddr);
+			}
+			add_next_index_zval(&argv[2], &zaddr);
+		}
+	}
+
+	/* The callbacks may free the listener */
+	ZVAL_COPY(&zself, &l->self);
+
+	if (n) {
+		/* Protect against accidental destruction of the func name before zend_call_function() finished */
+		ZVAL_COPY(&zcallable, &l->cb_batch.func_name);
+
+		if (zend_is_callable(&zcallable, IS_CALLABLE_STRICT, &func_name)) {
+			/* Call user function having proto:
+			 * void cb (EventListener $listener, array $fds, ?array $addresses, mixed $data); */
+			ZVAL_COPY(&argv[0], &l->self);
+
+			if (Z_ISUNDEF(l->data)) {
+				ZVAL_NULL(&argv[3]);
+			} else {
+				ZVAL_COPY(&argv[3], &l->data);
+			}
+
+			fci.size = sizeof(fci);
+#ifdef HAVE_PHP_ZEND_FCALL_INFO_FUNCTION_TABLE
+			fci.function_table = EG(function_table);
+#endif
+			ZVAL_COPY_VALUE(&fci.function_name, &zcallable);
+			fci.object = NULL;
+			fci.retval = &retval;
+			fci.params = argv;
+			fci.param_count = 4;
+			fci.no_separation  = 1;
+#ifdef HAVE_PHP_ZEND_FCALL_INFO_SYMBOL_TABLE
+			fci.symbol_table = NULL;
+#endif
+
+			if (zend_call_function(&fci, &l->cb_batch.fci_cache) == SUCCESS) {
+				called = 1;
+				if (!Z_ISUNDEF(retval)) {
+					zval_ptr_dtor(&retval);
+				}
+			} else if (EG(exception)) {
+				if (l->listener) {
+					event_base_loopbreak(evconnlistener_get_base(l->listener));
+				}
+			} else {
+				php_error_docref(NULL, E_WARNING, "Failed to invoke listener batch callback");
+			}
+
+			zval_ptr_dtor(&argv[0]);
+			zval_ptr_dtor(&argv[3]);
+		}
+		zend_string_release(func_name);
+
+		zval_ptr_dtor(&zcallable);
+
+		if (!called) {
+			/* Nobody else owns the sockets */
+			ZEND_HASH_FOREACH_VAL(Z_ARRVAL(argv[1]), zfd) {
+				evutil_closesocket((evutil_socket_t) Z_LVAL_P(zfd));
+			} ZEND_HASH_FOREACH_END();
+		}
+	}
+
+	zval_ptr_dtor(&argv[1]);
+	zval_ptr_dtor(&argv[2]);
+
+	if (err && !PHP_EVENT_ACCEPT_RETRIABLE(err) && l->batch_ev) {
+		EVUTIL_SET_SOCKET_ERROR(err);
+		listener_error_cb(l->listener, (void *) l);
+	}
+
+	zval_ptr_dtor(&zself);
+}
+/* }}} */
+
+/* {{{ batch_free
+ * Switches the listener back from the batched accept */
+static void batch_free(php_event_listener_t *l)
+{
+	if (l->batch_ev) {
+		event_free(l->batch_ev);
+		l->batch_ev = NULL;
+
+		if (!l->disabled && !l->paused) {
+			evconnlistener_enable(l->listener);
+		}
+	}
+	php_event_free_callback(&l->cb_batch);
+}
+/* }}} */
+#endif
+
+/* {{{ bevent_template_settings
+ * Reads the optional settings of EventListener::setBufferEventTemplate() */
+static int bevent_template_settings(php_event_bevent_template_t *t, HashTable *ht)
+{
+	static const char *wm_keys[] = {
+		"read_lowmark", "read_highmark", "write_lowmark", "write_highmark"
+	};
+	size_t *wm[] = { &t->read_wm[0], &t->read_wm[1], &t->write_wm[0], &t->write_wm[1] };
+	zval   *zv;
+	double  timeout;
+	int     i;
+
+	if ((zv = zend_hash_str_find(ht, "events", sizeof("events") - 1)) != NULL) {
+		t->events = zval_get_long(zv) & (EV_READ | EV_WRITE);
+	}
+
+	for (i = 0; i < 4; i++) {
+		if ((zv = zend_hash_str_find(ht, wm_keys[i], strlen(wm_keys[i]))) != NULL) {
+			zend_long n = zval_get_long(zv);
+
+			if (n < 0) {
+				php_error_docref(NULL, E_WARNING, "%s must not be negative", wm_keys[i]);
+				return FAILURE;
+			}
+			*wm[i] = (size_t) n;
+		}
+	}
+
+	if ((zv = zend_hash_str_find(ht, "timeout_read", sizeof("timeout_read") - 1)) != NULL) {
+		timeout = zval_get_double(zv);
+		PHP_EVENT_TIMEVAL_SET(t->timeout_read, timeout);
+	}
+	if ((zv = zend_hash_str_find(ht, "timeout_write", sizeof("timeout_write") - 1)) != NULL) {
+		timeout = zval_get_double(zv);
+		PHP_EVENT_TIMEVAL_SET(t->timeout_write, timeout);
+	}
+
+	if ((zv = zend_hash_str_find(ht, "ssl_context", sizeof("ssl_context") - 1)) != NULL
+			&& Z_TYPE_P(zv) != IS_NULL) {
+#ifdef HAVE_EVENT_OPENSSL_LIB
+		if (Z_TYPE_P(zv) != IS_OBJECT || !instanceof_function(Z_OBJCE_P(zv), php_event_ssl_context_ce)) {
+			php_error_docref(NULL, E_WARNING, "ssl_context must be an EventSslContext object");
+			return FAILURE;
+		}
+		ZVAL_COPY(&t->ctx, zv);
+#else
+		php_error_docref(NULL, E_WARNING, "Event is built without SSL support");
+		return FAILURE;
+#endif
+	}
+
+	return SUCCESS;
+}
+/* }}} */
+
 /* Private }}} */
 
 /* {{{ proto EventListener EventListener::__construct(EventBase base, callable cb, mixed data, int flags, int backlog, mixed target);
@@ -338,9 +1036,13 @@ PHP_METHOD(EventListener, __construct)
 	}
 
 	l->listener = listener;
+#ifdef LEV_OPT_DISABLED
+	l->disabled = (flags & LEV_OPT_DISABLED) ? 1 : 0;
+#endif
 	php_event_copy_zval(&l->data, zdata);
 	php_event_copy_callback(&l->cb, zcb);
 	ZVAL_COPY_VALUE(&l->self, zself);
+	ZVAL_COPY(&l->base, zbase);
 }
 /* }}} */
 
@@ -371,6 +1073,11 @@ PHP_METHOD(EventListener, free)
 	l = Z_EVENT_LISTENER_OBJ_P(self);
 
 	if (l != NULL && l->listener != NULL) {
+		if (l->batch_ev) {
+			event_free(l->batch_ev);
+			l->batch_ev = NULL;
+		}
+		php_event_listener_proxy_clear(l);
 		evconnlistener_free(l->listener);
 		l->listener = NULL;
 	}
@@ -390,9 +1097,11 @@ PHP_METHOD(EventListener, enable)
 	l = Z_EVENT_LISTENER_OBJ_P(zlistener);
 	_ret_if_invalid_listener_ptr(l);
 
-	if (evconnlistener_enable(l->listener)) {
+	/* Accepting is resumed later, if paused by the connection limit */
+	if (!l->paused && _listener_accept_events(l, 1)) {
 		RETURN_FALSE;
 	}
+	l->disabled = 0;
 
 	RETVAL_TRUE;
 }
@@ -413,9 +1122,10 @@ PHP_METHOD(EventListener, disable)
 	l = Z_EVENT_LISTENER_OBJ_P(zlistener);
 	_ret_if_invalid_listener_ptr(l);
 
-	if (evconnlistener_disable(l->listener)) {
+	if (!l->paused && _listener_accept_events(l, 0)) {
 		RETURN_FALSE;
 	}
+	l->disabled = 1;
 
 	RETVAL_TRUE;
 }
@@ -537,6 +1247,356 @@ PHP_METHOD(EventListener, getSocketName)
 }
 /* }}} */
 
+/* {{{ proto bool EventListener::setSocketProfile(int profile);
+ * Applies one of the EventUtil::SOCKET_PROFILE_* sets of TCP options to the
+ * listening socket. On most systems accepted sockets inherit the options. */
+PHP_METHOD(EventListener, setSocketProfile)
+{
+	php_event_listener_t *l;
+	zend_long             profile;
+	evutil_socket_t       fd;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "l", &profile) == FAILURE) {
+		return;
+	}
+
+	l = Z_EVENT_LISTENER_OBJ_P(getThis());
+	_ret_if_invalid_listener_ptr(l);
+
+	fd = evconnlistener_get_fd(l->listener);
+	if (fd <= 0) {
+		RETURN_FALSE;
+	}
+
+	if (php_event_set_socket_profile(fd, profile) == FAILURE) {
+		RETURN_FALSE;
+	}
+	RETVAL_TRUE;
+}
+/* }}} */
+
+#ifdef PHP_EVENT_REUSEPORT_CBPF
+/* {{{ proto bool EventListener::attachReuseportCbpf(void);
+ * Attaches a classic BPF program to the SO_REUSEPORT group of the listening
+ * socket, which steers new connections to the socket at index equal to the
+ * number of the CPU handling the packet. Sockets in the group should be
+ * created in CPU order by workers pinned to the CPUs, e.g. EventWorkerPool
+ * workers. */
+PHP_METHOD(EventListener, attachReuseportCbpf)
+{
+	php_event_listener_t *l;
+	evutil_socket_t       fd;
+	struct sock_filter    code[] = {
+		/* A = raw_smp_processor_id() */
+		{ BPF_LD | BPF_W | BPF_ABS, 0, 0, SKF_AD_OFF + SKF_AD_CPU },
+		/* return A */
+		{ BPF_RET | BPF_A, 0, 0, 0 },
+	};
+	struct sock_fprog     prog;
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	l = Z_EVENT_LISTENER_OBJ_P(getThis());
+	_ret_if_invalid_listener_ptr(l);
+
+	fd = evconnlistener_get_fd(l->listener);
+	if (fd <= 0) {
+		RETURN_FALSE;
+	}
+
+	prog.len    = sizeof(code) / sizeof(code[0]);
+	prog.filter = code;
+
+	if (setsockopt(fd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &prog, sizeof(prog))) {
+		php_error_docref(NULL, E_WARNING, "Failed to attach reuseport program: %s",
+				strerror(errno));
+		RETURN_FALSE;
+	}
+	RETVAL_TRUE;
+}
+/* }}} */
+#endif
+
+#if LIBEVENT_VERSION_NUMBER >= 0x02000300
+/* {{{ proto bool EventListener::setBatchCallback(callable cb[, int max_batch = 64[, bool addresses = FALSE]]);
+ *
+ * Switches the listener to batched accept: on every readiness event up to
+ * max_batch pending connections are accepted as non-blocking, close-on-exec
+ * sockets, and passed to cb at once:
+ *
+ * void cb(EventListener $listener, array $fds, ?array $addresses, mixed $data);
+ *
+ * $addresses is an array of [address, port] pairs (NULL for UNIX domain
+ * peers) if addresses is TRUE; otherwise NULL. The accept callback is not
+ * invoked in this mode. NULL cb switches back to the accept callback.
+ */
+PHP_METHOD(EventListener, setBatchCallback)
+{
+	php_event_listener_t *l;
+	zval                 *zcb;
+	zend_long             max_batch = 64;
+	zend_bool             addresses = 0;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "z!|lb", &zcb, &max_batch, &addresses) == FAILURE) {
+		return;
+	}
+
+	l = Z_EVENT_LISTENER_OBJ_P(getThis());
+	_ret_if_invalid_listener_ptr(l);
+
+	if (zcb == NULL) {
+		batch_free(l);
+		RETURN_TRUE;
+	}
+
+	if (!zend_is_callable(zcb, 0, NULL)) {
+		php_error_docref(NULL, E_WARNING, "Batch callback is not callable");
+		RETURN_FALSE;
+	}
+
+	if (max_batch <= 0) {
+		php_error_docref(NULL, E_WARNING, "max_batch must be positive");
+		RETURN_FALSE;
+	}
+
+	if (l->batch_ev == NULL) {
+		l->batch_ev = event_new(evconnlistener_get_base(l->listener),
+				evconnlistener_get_fd(l->listener), EV_READ | EV_PERSIST,
+				_php_event_listener_batch_cb, (void *) l);
+		if (l->batch_ev == NULL) {
+			php_error_docref(NULL, E_WARNING, "Failed to allocate batch event");
+			RETURN_FALSE;
+		}
+
+		evconnlistener_disable(l->listener);
+
+		if (!l->disabled && !l->paused && event_add(l->batch_ev, NULL)) {
+			php_error_docref(NULL, E_WARNING, "Failed to add batch event");
+			event_free(l->batch_ev);
+			l->batch_ev = NULL;
+			evconnlistener_enable(l->listener);
+			RETURN_FALSE;
+		}
+	}
+
+	php_event_replace_callback(&l->cb_batch, zcb);
+	l->batch_max  = max_batch;
+	l->batch_addr = addresses;
+
+	RETVAL_TRUE;
+}
+/* }}} */
+#endif
+
+/* {{{ proto bool EventListener::setBufferEventTemplate(int options[, callable readcb = NULL[, callable writecb = NULL[, callable eventcb = NULL[, mixed arg = NULL[, array settings = NULL]]]]]);
+ *
+ * Makes the listener wrap accepted sockets into EventBufferEvent objects
+ * created with the options(EventBufferEvent::OPT_*), callbacks and the
+ * callback argument as if they were passed to EventBufferEvent::__construct.
+ * OPT_CLOSE_ON_FREE is always on.
+ *
+ * settings is an array with optional keys:
+ *  "events"         - events enabled on the buffer event, Event::READ by default;
+ *  "read_lowmark", "read_highmark", "write_lowmark", "write_highmark" - watermarks;
+ *  "timeout_read", "timeout_write" - timeouts in seconds;
+ *  "ssl_context"    - EventSslContext. Makes server side SSL buffer events.
+ *
+ * The accept callback, if set, receives the EventBufferEvent object instead of
+ * the file descriptor. Otherwise the connection is served without entering
+ * userspace until the buffer event callbacks. The object is kept alive until
+ * the connection is closed(EOF or error), or EventBufferEvent::free() is called.
+ * The template is not applied to the connections accepted in batches, see
+ * setBatchCallback().
+ *
+ * NULL options removes the template.
+ */
+PHP_METHOD(EventListener, setBufferEventTemplate)
+{
+	php_event_listener_t        *l;
+	zend_long                    options;
+	zend_bool                    options_is_null = 0;
+	zval                        *zcb_read        = NULL;
+	zval                        *zcb_write       = NULL;
+	zval                        *zcb_event       = NULL;
+	zval                        *zarg            = NULL;
+	HashTable                   *ht_settings     = NULL;
+	php_event_bevent_template_t *tpl;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "l!|z!z!z!z!h!",
+				&options, &options_is_null,
+				&zcb_read, &zcb_write, &zcb_event, &zarg, &ht_settings) == FAILURE) {
+		return;
+	}
+
+	l = Z_EVENT_LISTENER_OBJ_P(getThis());
+	_ret_if_invalid_listener_ptr(l);
+
+	if (options_is_null) {
+		if (l->tpl) {
+			php_event_bevent_template_free(l->tpl);
+			l->tpl = NULL;
+		}
+		RETURN_TRUE;
+	}
+
+	tpl = ecalloc(1, sizeof(php_event_bevent_template_t));
+	tpl->options = options;
+	tpl->events  = EV_READ;
+	php_event_copy_zval(&tpl->data, zarg);
+	php_event_init_callback(&tpl->cb_read);
+	php_event_init_callback(&tpl->cb_write);
+	php_event_init_callback(&tpl->cb_event);
+	if (zcb_read) {
+		php_event_copy_callback(&tpl->cb_read, zcb_read);
+	}
+	if (zcb_write) {
+		php_event_copy_callback(&tpl->cb_write, zcb_write);
+	}
+	if (zcb_event) {
+		php_event_copy_callback(&tpl->cb_event, zcb_event);
+	}
+#ifdef HAVE_EVENT_OPENSSL_LIB
+	ZVAL_UNDEF(&tpl->ctx);
+#endif
+
+	if (ht_settings && bevent_template_settings(tpl, ht_settings) == FAILURE) {
+		php_event_bevent_template_free(tpl);
+		RETURN_FALSE;
+	}
+
+	if (l->tpl) {
+		php_event_bevent_template_free(l->tpl);
+	}
+	l->tpl = tpl;
+
+	RETVAL_TRUE;
+}
+/* }}} */
+
+/* {{{ proto bool EventListener::setMaxConnections(int max_conns[, int low_conns = -1]);
+ *
+ * Limits the number of live connections wrapped into EventBufferEvent objects
+ * with the buffer event template (see setBufferEventTemplate()). Accepting
+ * is paused when max_conns connections are open, and resumed after the
+ * number drops to low_conns (90% of max_conns by default). Pending
+ * connections wait in the listen backlog meanwhile. Zero max_conns removes
+ * the limit. Sockets passed to the accept callback as descriptors, or to the
+ * batch callback, are not counted. */
+PHP_METHOD(EventListener, setMaxConnections)
+{
+	php_event_listener_t *l;
+	zend_long             max_conns;
+	zend_long             low_conns = -1;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "l|l", &max_conns, &low_conns) == FAILURE) {
+		return;
+	}
+
+	l = Z_EVENT_LISTENER_OBJ_P(getThis());
+	_ret_if_invalid_listener_ptr(l);
+
+	if (max_conns < 0) {
+		php_error_docref(NULL, E_WARNING, "max_conns must not be negative");
+		RETURN_FALSE;
+	}
+
+	if (low_conns < 0) {
+		low_conns = max_conns * 9 / 10;
+	} else if (max_conns > 0 && low_conns >= max_conns) {
+		php_error_docref(NULL, E_WARNING, "low_conns must be less than max_conns");
+		RETURN_FALSE;
+	}
+
+	if (l->conns == NULL) {
+		l->conns = php_event_conn_counter_new((void *) l, _listener_conn_closed);
+	}
+
+	l->max_conns = max_conns;
+	l->low_conns = low_conns;
+
+	if (max_conns > 0 && l->conns->live >= max_conns) {
+		_listener_pause(l);
+	} else if (max_conns == 0 || l->conns->live <= low_conns) {
+		_listener_resume(l);
+	}
+
+	RETVAL_TRUE;
+}
+/* }}} */
+
+/* {{{ proto array EventListener::getConnectionStats(void);
+ *
+ * Returns an array with the keys:
+ *  "connections"     - number of live connections counted against the limit;
+ *  "max_connections" - the limit, 0 if off;
+ *  "paused"          - whether accepting is paused by the limit;
+ *  "pauses"          - number of pauses;
+ *  "paused_time"     - total time spent in pauses, in seconds. */
+PHP_METHOD(EventListener, getConnectionStats)
+{
+	php_event_listener_t *l;
+	struct timeval        total;
+	struct timeval        now;
+	struct timeval        delta;
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	l = Z_EVENT_LISTENER_OBJ_P(getThis());
+
+	total = l->paused_time;
+	if (l->paused) {
+		evutil_gettimeofday(&now, NULL);
+		evutil_timersub(&now, &l->paused_at, &delta);
+		evutil_timeradd(&total, &delta, &total);
+	}
+
+	array_init(return_value);
+	add_assoc_long(return_value,   "connections",     l->conns ? l->conns->live : 0);
+	add_assoc_long(return_value,   "max_connections", l->max_conns);
+	add_assoc_bool(return_value,   "paused",          l->paused);
+	add_assoc_long(return_value,   "pauses",          l->pauses);
+	add_assoc_double(return_value, "paused_time",     total.tv_sec + total.tv_usec / 1000000.0);
+}
+/* }}} */
+
+/* {{{ proto bool EventListener::setProxyProtocol(bool enable[, float timeout = 5.0]);
+ *
+ * Makes the listener expect a PROXY protocol(v1 or v2) header at the start
+ * of every accepted connection, e.g. behind a load balancer. The header is
+ * read and stripped before the accept callback is invoked, and the client
+ * address from the header is passed to the callback instead of the address
+ * of the proxy. Connections with a malformed header, or without a complete
+ * header within timeout seconds, are closed. Connections accepted with the
+ * batch callback are not affected. */
+PHP_METHOD(EventListener, setProxyProtocol)
+{
+	php_event_listener_t *l;
+	zend_bool             enable;
+	double                timeout = 5.0;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "b|d", &enable, &timeout) == FAILURE) {
+		return;
+	}
+
+	l = Z_EVENT_LISTENER_OBJ_P(getThis());
+	_ret_if_invalid_listener_ptr(l);
+
+	if (timeout <= 0) {
+		php_error_docref(NULL, E_WARNING, "timeout must be positive");
+		RETURN_FALSE;
+	}
+
+	l->proxy = enable;
+	PHP_EVENT_TIMEVAL_SET(l->proxy_timeout, timeout);
+
+	RETVAL_TRUE;
+}
+/* }}} */
+
 /*
  * Local variables:
  * tab-width: 4
@@ -21,6 +21,11 @@
 
 int _php_event_ssl_ctx_set_private_key(SSL_CTX *ctx, const char *private_key);
 int _php_event_ssl_ctx_set_local_cert(SSL_CTX *ctx, const char *certfile, const char *private_key);
+void php_event_ssl_host_free(void *parent, void *ptr, CRYPTO_EX_DATA *ad, int idx, long argl, void *argp);
+void php_event_ssl_session_prepare(SSL *ssl, const char *host, zend_long port);
+void php_event_ssl_ctx_cache_init(void);
+void php_event_ssl_ctx_cache_destroy(void);
+void php_event_ssl_context_unwatch(php_event_ssl_context_t *ectx);
 
 #endif /* PHP_EVENT_SSL_CONTEXT_H */
 /*
@@ -0,0 +1,345 @@
+/*
+   +----------------------------------------------------------------------+
+   | PHP Version 7                                                        |
+   +----------------------------------------------------------------------+
+   | Copyright (c) 1997-2016 The PHP Group                                |
+   +----------------------------------------------------------------------+
+   | This source file is subject to version 3.01 of the PHP license,      |
+   | that is bundled with this package in the file LICENSE, and is        |
+   | available through the world-wide-web at the following url:           |
+   | http://www.php.net/license/3_01.txt                                  |
+   | If you did not receive a copy of the PHP license and are unable to   |
+   | obtain it through the world-wide-web, please send a note to          |
+   | license@php.net so we can mail you a copy immediately.               |
+   +----------------------------------------------------------------------+
+   | Author: Ruslan Osmanov <osmanov@php.net>                             |
+   +----------------------------------------------------------------------+
+*/
+#include "../src/common.h"
+#include "../src/util.h"
+#include "../src/priv.h"
+#include "zend_exceptions.h"
+
+#ifdef PHP_EVENT_WORKER_POOL
+
+/* {{{ Private */
+
+static void _worker_restart_cb(evutil_socket_t fd, short what, void *arg);
+
+/* {{{ _worker_spawn
+ * Forks worker i. Returns 1 in the child process, 0 in the supervisor, and
+ * -1 on error */
+static int _worker_spawn(Z_EVENT_X_OBJ_T(worker_pool) *pool, zend_long i)
+{
+	php_event_worker_t *w = &pool->workers[i];
+	pid_t               pid;
+
+	pid = fork();
+
+	if (pid == -1) {
+		php_error_docref(NULL, E_WARNING, "Failed to fork worker %d: %s",
+				(int) i, strerror(errno));
+		return -1;
+	}
+
+	if (pid == 0) {
+		/* Leave the supervisor's loop */
+		pool->index = i;
+		event_base_loopbreak(pool->sup);
+		return 1;
+	}
+
+	w->pid = pid;
+	evutil_gettimeofday(&w->started, NULL);
+	pool->running++;
+
+	return 0;
+}
+/* }}} */
+
+/* {{{ _worker_pool_check_done */
+static zend_always_inline void _worker_pool_check_done(Z_EVENT_X_OBJ_T(worker_pool) *pool)
+{
+	if (pool->running == 0 && (pool->stopping || pool->pending == 0)) {
+		event_base_loopbreak(pool->sup);
+	}
+}
+/* }}} */
+
+/* {{{ _worker_restart_cb
+ * Restarts a worker which crashed too soon after the previous start */
+static void _worker_restart_cb(evutil_socket_t fd, short what, void *arg)
+{
+	php_event_worker_t           *w    = (php_event_worker_t *) arg;
+	Z_EVENT_X_OBJ_T(worker_pool) *pool = w->pool;
+
+	pool->pending--;
+
+	if (!pool->stopping && _worker_spawn(pool, w->index) == 1) {
+		return;
+	}
+
+	_worker_pool_check_done(pool);
+}
+/* }}} */
+
+/* {{{ _worker_sigchld_cb
+ * Reaps exited workers and restarts the ones that crashed or exited with
+ * non-zero status. Only the pool's own children are waited for. */
+static void _worker_sigchld_cb(evutil_socket_t signum, short what, void *arg)
+{
+	Z_EVENT_X_OBJ_T(worker_pool) *pool = (Z_EVENT_X_OBJ_T(worker_pool) *) arg;
+	php_event_worker_t           *w;
+	struct timeval                now;
+	struct timeval                delay;
+	zend_long                     i;
+	int                           status;
+
+	for (i = 0; i < pool->count; i++) {
+		w = &pool->workers[i];
+
+		if (w->pid <= 0 || waitpid(w->pid, &status, WNOHANG) != w->pid) {
+			continue;
+		}
+
+		w->pid = 0;
+		pool->running--;
+
+		if (pool->stopping || (WIFEXITED(status) && WEXITSTATUS(status) == 0)) {
+			continue;
+		}
+
+		pool->restarts++;
+		evutil_gettimeofday(&now, NULL);
+
+		if (now.tv_sec - w->started.tv_sec >= PHP_EVENT_WORKER_RESTART_DELAY) {
+			if (_worker_spawn(pool, i) == 1) {
+				return;
+			}
+		} else {
+			/* Avoid a fork loop, if the worker fails on startup */
+			delay.tv_sec  = PHP_EVENT_WORKER_RESTART_DELAY;
+			delay.tv_usec = 0;
+
+			if (event_base_once(pool->sup, -1, EV_TIMEOUT, _worker_restart_cb, (void *) w, &delay) == 0) {
+				pool->pending++;
+			}
+		}
+	}
+
+	_worker_pool_check_done(pool);
+}
+/* }}} */
+
+/* {{{ _worker_stop_cb
+ * Forwards SIGTERM/SIGINT to the workers and stops the supervisor after
+ * all of them exited */
+static void _worker_stop_cb(evutil_socket_t signum, short what, void *arg)
+{
+	Z_EVENT_X_OBJ_T(worker_pool) *pool = (Z_EVENT_X_OBJ_T(worker_pool) *) arg;
+	zend_long                     i;
+
+	pool->stopping = 1;
+
+	for (i = 0; i < pool->count; i++) {
+		if (pool->workers[i].pid > 0) {
+			kill(pool->workers[i].pid, signum);
+		}
+	}
+
+	_worker_pool_check_done(pool);
+}
+/* }}} */
+
+/* {{{ _worker_pin_cpu */
+static void _worker_pin_cpu(Z_EVENT_X_OBJ_T(worker_pool) *pool)
+{
+#if defined(HAVE_SCHED_SETAFFINITY) && defined(CPU_SET)
+	cpu_set_t set;
+	long      ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+
+	if (ncpu <= 0) {
+		return;
+	}
+
+	CPU_ZERO(&set);
+	CPU_SET(pool->index % ncpu, &set);
+
+	if (sched_setaffinity(0, sizeof(set), &set)) {
+		php_error_docref(NULL, E_WARNING, "Failed to set CPU affinity of worker %d: %s",
+				(int) pool->index, strerror(errno));
+	}
+#endif
+}
+/* }}} */
+
+/* Private }}} */
+
+/* {{{ proto EventWorkerPool::__construct(int workers[, bool cpu_affinity = TRUE]);
+ * Creates a pool of worker processes. Usually the workers share a listener
+ * created with EventListener::OPT_REUSEABLE_PORT, or create their own
+ * listeners bound to the same port with this option after run() returned. */
+PHP_METHOD(EventWorkerPool, __construct)
+{
+	Z_EVENT_X_OBJ_T(worker_pool) *pool;
+	zend_long                     count;
+	zend_bool                     cpu_affinity = 1;
+	zend_long                     i;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "l|b",
+				&count, &cpu_affinity) == FAILURE) {
+		return;
+	}
+
+	if (count <= 0) {
+		zend_throw_exception_ex(php_event_get_exception(), 0,
+				"Number of workers must be greater than zero");
+		return;
+	}
+
+	pool = Z_EVENT_WORKER_POOL_OBJ_P(getThis());
+
+	if (pool->workers) {
+		efree(pool->workers);
+	}
+
+	pool->workers      = ecalloc(count, sizeof(php_event_worker_t));
+	pool->count        = count;
+	pool->index        = -1;
+	pool->cpu_affinity = cpu_affinity;
+
+	for (i = 0; i < count; i++) {
+		pool->workers[i].pool  = pool;
+		pool->workers[i].index = i;
+	}
+}
+/* }}} */
+
+/* {{{ proto int EventWorkerPool::run([EventBase base = NULL]);
+ * Forks the workers and supervises them. Workers which crash, or exit with
+ * non-zero status, are restarted. SIGTERM and SIGINT are forwarded to the
+ * workers.
+ *
+ * In a worker process returns the worker index (0..workers-1) after the
+ * optional base is reinitialized and the process is pinned to a CPU. In the
+ * supervisor returns -1 after all workers exited, or FALSE on error. */
+PHP_METHOD(EventWorkerPool, run)
+{
+	static const int              signals[] = { SIGCHLD, SIGTERM, SIGINT };
+	zval                         *zbase     = NULL;
+	Z_EVENT_X_OBJ_T(worker_pool) *pool;
+	php_event_base_t             *b;
+	zend_long                     i;
+	int                           n;
+	zend_bool                     supervised = 0;
+
+	if (zend_parse_parameters(ZEND_NUM_ARGS(), "|O!",
+				&zbase, php_event_base_ce) == FAILURE) {
+		return;
+	}
+
+	pool = Z_EVENT_WORKER_POOL_OBJ_P(getThis());
+
+	if (!pool->workers || pool->index >= 0 || pool->sup) {
+		php_error_docref(NULL, E_WARNING, "Worker pool is not in the supervisor state");
+		RETURN_FALSE;
+	}
+
+	pool->sup = event_base_new();
+	if (!pool->sup) {
+		php_error_docref(NULL, E_WARNING, "Failed to allocate supervisor event base");
+		RETURN_FALSE;
+	}
+
+	pool->stopping = 0;
+	pool->pending  = 0;
+
+	for (n = 0; n < 3; n++) {
+		pool->sig_ev[n] = evsignal_new(pool->sup, signals[n],
+				(n == 0 ? _worker_sigchld_cb : _worker_stop_cb), (void *) pool);
+		if (!pool->sig_ev[n] || evsignal_add(pool->sig_ev[n], NULL)) {
+			php_error_docref(NULL, E_WARNING, "Failed to add supervisor signal event");
+			break;
+		}
+	}
+
+	if (n == 3) {
+		for (i = 0; i < pool->count && pool->index < 0; i++) {
+			_worker_spawn(pool, i);
+		}
+
+		if (pool->index < 0 && pool->running > 0) {
+			supervised = (event_base_dispatch(pool->sup) == 0);
+		}
+	}
+
+	if (pool->index >= 0) {
+		/* The kernel event queue is shared with the supervisor after fork. Free
+		 * the inherited base without touching the supervisor's registrations. */
+		event_reinit(pool->sup);
+	}
+
+	for (n = 0; n < 3; n++) {
+		if (pool->sig_ev[n]) {
+			event_free(pool->sig_ev[n]);
+			pool->sig_ev[n] = NULL;
+		}
+	}
+	event_base_free(pool->sup);
+	pool->sup = NULL;
+
+	if (pool->index < 0) {
+		if (!supervised || pool->running) {
+			RETURN_FALSE;
+		}
+		RETURN_LONG(-1);
+	}
+
+	/* Worker process */
+	for (i = 0; i < pool->count; i++) {
+		pool->workers[i].pid = 0;
+	}
+	pool->running = 0;
+
+	if (zbase) {
+		b = Z_EVENT_BASE_OBJ_P(zbase);
+
+		if (event_reinit(b->base)) {
+			php_error_docref(NULL, E_WARNING, "Failed to reinitialize event base in worker %d",
+					(int) pool->index);
+		}
+	}
+
+	if (pool->cpu_affinity) {
+		_worker_pin_cpu(pool);
+	}
+
+	RETURN_LONG(pool->index);
+}
+/* }}} */
+
+/* {{{ proto int EventWorkerPool::getRestarts(void);
+ * Returns number of workers restarted after a crash, or a non-zero exit */
+PHP_METHOD(EventWorkerPool, getRestarts)
+{
+	Z_EVENT_X_OBJ_T(worker_pool) *pool;
+
+	if (zend_parse_parameters_none() == FAILURE) {
+		return;
+	}
+
+	pool = Z_EVENT_WORKER_POOL_OBJ_P(getThis());
+
+	RETVAL_LONG(pool->restarts);
+}
+/* }}} */
+
+#endif /* PHP_EVENT_WORKER_POOL */
+/*
+ * Local variables:
+ * tab-width: 4
+ * c-basic-offset: 4
+ * End:
+ * vim600: noet sw=4 ts=4 sts=4 fdm=marker
+ * vim<600: noet sw=4 ts=4 sts=4
+ */
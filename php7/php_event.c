@@ -20,6 +20,15 @@
 #include "src/util.h"
 #include "src/priv.h"
 #include "classes/http.h"
+#include "classes/idle_reaper.h"
+#include "classes/buffer_event.h"
+#ifdef HAVE_EVENT_EXTRA_LIB
+# include "classes/listener.h"
+#endif
+#include "classes/shared_payload.h"
+#ifdef HAVE_EVENT_OPENSSL_LIB
+# include "classes/ssl_context.h"
+#endif
 #include "zend_exceptions.h"
 #include "ext/spl/spl_exceptions.h"
 
@@ -29,6 +38,11 @@ zend_class_entry *php_event_config_ce;
 zend_class_entry *php_event_bevent_ce;
 zend_class_entry *php_event_buffer_ce;
 zend_class_entry *php_event_util_ce;
+zend_class_entry *php_event_idle_reaper_ce;
+zend_class_entry *php_event_shared_payload_ce;
+#ifdef PHP_EVENT_WORKER_POOL
+zend_class_entry *php_event_worker_pool_ce;
+#endif
 #ifdef HAVE_EVENT_EXTRA_LIB
 zend_class_entry *php_event_dns_base_ce;
 zend_class_entry *php_event_listener_ce;
@@ -51,6 +65,9 @@ static HashTable event_listener_properties;
 #ifdef HAVE_EVENT_OPENSSL_LIB
 static HashTable event_ssl_context_properties;
 int php_event_ssl_data_index;
+int php_event_ssl_host_index;
+int php_event_ssl_start_index;
+int php_event_ssl_done_index;
 #endif
 
 static zend_object_handlers event_event_object_handlers;
@@ -59,6 +76,11 @@ static zend_object_handlers event_config_object_handlers;
 static zend_object_handlers event_bevent_object_handlers;
 static zend_object_handlers event_buffer_object_handlers;
 static zend_object_handlers event_util_object_handlers;
+static zend_object_handlers event_idle_reaper_object_handlers;
+static zend_object_handlers event_shared_payload_object_handlers;
+#ifdef PHP_EVENT_WORKER_POOL
+static zend_object_handlers event_worker_pool_object_handlers;
+#endif
 #if HAVE_EVENT_EXTRA_LIB
 static zend_object_handlers event_dns_base_object_handlers;
 static zend_object_handlers event_listener_object_handlers;
@@ -207,6 +229,28 @@ static void php_event_bevent_dtor_obj(zend_object *object)/*{{{*/
 	zend_objects_destroy_object(object);
 }/*}}}*/
 
+static void php_event_idle_reaper_dtor_obj(zend_object *object)/*{{{*/
+{
+	Z_EVENT_X_OBJ_T(idle_reaper) *intern = Z_EVENT_X_FETCH_OBJ(idle_reaper, object);
+	PHP_EVENT_ASSERT(intern);
+
+	php_event_idle_reaper_clear(intern);
+
+	zend_objects_destroy_object(object);
+}/*}}}*/
+
+static void php_event_shared_payload_dtor_obj(zend_object *object)/*{{{*/
+{
+	zend_objects_destroy_object(object);
+}/*}}}*/
+
+#ifdef PHP_EVENT_WORKER_POOL
+static void php_event_worker_pool_dtor_obj(zend_object *object)/*{{{*/
+{
+	zend_objects_destroy_object(object);
+}/*}}}*/
+#endif
+
 static void php_event_buffer_dtor_obj(zend_object *object)/*{{{*/
 {
 #if 0
@@ -273,6 +317,19 @@ static void php_event_bevent_free_obj(zend_object *object)/*{{{*/
 #endif
 	Z_EVENT_X_OBJ_T(bevent) *b = Z_EVENT_X_FETCH_OBJ(bevent, object);
 
+	php_event_idle_reaper_unlink(b);
+	php_event_bevent_coalesce_free(b);
+	php_event_bevent_read_sizing_detach(b);
+#ifdef PHP_EVENT_SSL_RECORD_SIZING
+	php_event_bevent_record_sizing_detach(b);
+#endif
+	php_event_bevent_wprio_free(b);
+	php_event_bevent_cork_free(b);
+#ifdef PHP_EVENT_FD_PASSING
+	php_event_bevent_fdpass_free(b);
+#endif
+	php_event_bevent_conn_closed(b);
+
 	if (!b->_internal && b->bevent) {
 #if defined(HAVE_EVENT_OPENSSL_LIB)
 		/* See www.wangafu.net/~nickm/libevent-book/Ref6a_advanced_bufferevents.html#_bufferevents_and_ssl */
@@ -284,6 +341,9 @@ static void php_event_bevent_free_obj(zend_object *object)/*{{{*/
 		}
 #endif
 
+#ifdef PHP_EVENT_STATS
+		php_event_bevent_stats_detach(b);
+#endif
 		bufferevent_free(b->bevent);
 		b->bevent = NULL;
 	}
@@ -291,6 +351,46 @@ static void php_event_bevent_free_obj(zend_object *object)/*{{{*/
 	zend_object_std_dtor(object);
 }/*}}}*/
 
+static void php_event_idle_reaper_free_obj(zend_object *object)/*{{{*/
+{
+	Z_EVENT_X_OBJ_T(idle_reaper) *r = Z_EVENT_X_FETCH_OBJ(idle_reaper, object);
+	PHP_EVENT_ASSERT(r);
+
+	php_event_idle_reaper_clear(r);
+
+	zend_object_std_dtor(object);
+}/*}}}*/
+
+static void php_event_shared_payload_free_obj(zend_object *object)/*{{{*/
+{
+	Z_EVENT_X_OBJ_T(shared_payload) *p = Z_EVENT_X_FETCH_OBJ(shared_payload, object);
+	PHP_EVENT_ASSERT(p);
+
+	if (p->block) {
+		/* Buffers still holding the data keep their own references */
+		php_event_shared_block_release(p->block);
+		p->block = NULL;
+	}
+
+	zend_object_std_dtor(object);
+}/*}}}*/
+
+#ifdef PHP_EVENT_WORKER_POOL
+static void php_event_worker_pool_free_obj(zend_object *object)/*{{{*/
+{
+	Z_EVENT_X_OBJ_T(worker_pool) *pool = Z_EVENT_X_FETCH_OBJ(worker_pool, object);
+	PHP_EVENT_ASSERT(pool);
+
+	/* Workers outlive the object; they are not killed here */
+	if (pool->workers) {
+		efree(pool->workers);
+		pool->workers = NULL;
+	}
+
+	zend_object_std_dtor(object);
+}/*}}}*/
+#endif
+
 static void php_event_buffer_free_obj(zend_object *object)/*{{{*/
 {
 	php_event_buffer_t *b = Z_EVENT_X_FETCH_OBJ(buffer, object);
@@ -335,6 +435,11 @@ static void php_event_listener_free_obj(zend_object *object)/*{{{*/
 
 	PHP_EVENT_ASSERT(l);
 
+	if (l->batch_ev) {
+		event_free(l->batch_ev);
+		l->batch_ev = NULL;
+	}
+
 	if (l->listener) {
 		evconnlistener_free(l->listener);
 		l->listener = NULL;
@@ -366,6 +471,13 @@ static void php_event_http_free_obj(zend_object *object)/*{{{*/
 		evhttp_free(http->ptr);
 		http->ptr = NULL;
 	}
+#ifdef HAVE_EVENT_OPENSSL_LIB
+	/* Released after evhttp_free(), since the connections are created with it */
+	if (!Z_ISUNDEF(http->ctx)) {
+		zval_ptr_dtor(&http->ctx);
+		ZVAL_UNDEF(&http->ctx);
+	}
+#endif
 
 	zend_object_std_dtor(object);
 }/*}}}*/
@@ -423,6 +535,26 @@ static void php_event_listener_dtor_obj(zend_object *object)/*{{{*/
 
 	php_event_free_callback(&intern->cb);
 	php_event_free_callback(&intern->cb_err);
+	php_event_free_callback(&intern->cb_batch);
+
+	if (intern->tpl) {
+		php_event_bevent_template_free(intern->tpl);
+		intern->tpl = NULL;
+	}
+
+	php_event_listener_proxy_clear(intern);
+
+	if (intern->conns) {
+		/* Buffer events still alive keep their own references */
+		intern->conns->owner = NULL;
+		php_event_conn_counter_release(intern->conns);
+		intern->conns = NULL;
+	}
+
+	if (!Z_ISUNDEF(intern->base)) {
+		Z_TRY_DELREF(intern->base);
+		ZVAL_UNDEF(&intern->base);
+	}
 
 	zend_objects_destroy_object(object);
 }/*}}}*/
@@ -469,6 +601,11 @@ static void php_event_http_dtor_obj(zend_object *object)/*{{{*/
 		cb = cb_next;
 	}
 
+	if (intern->routes) {
+		_php_event_free_http_route(intern->routes);
+		intern->routes = NULL;
+	}
+
 	if (!Z_ISUNDEF(intern->data)) {
 		zval_ptr_dtor(&intern->data);
 	}
@@ -508,6 +645,8 @@ static void php_event_ssl_context_free_obj(zend_object *object)/*{{{*/
 {
 	php_event_ssl_context_t *ectx = Z_EVENT_X_FETCH_OBJ(ssl_context, object);
 
+	php_event_ssl_context_unwatch(ectx);
+
 	if (ectx->ctx) {
 		SSL_CTX_free(ectx->ctx);
 		ectx->ctx = NULL;
@@ -519,15 +658,51 @@ static void php_event_ssl_context_free_obj(zend_object *object)/*{{{*/
 		ectx->ht = NULL;
 	}
 
+	if (ectx->sessions) {
+		zend_hash_destroy(ectx->sessions);
+		FREE_HASHTABLE(ectx->sessions);
+		ectx->sessions = NULL;
+	}
+#ifdef PHP_EVENT_SSL_TICKET_KEYS
+	OPENSSL_cleanse(ectx->ticket_keys, sizeof(ectx->ticket_keys));
+#endif
+#ifdef PHP_EVENT_SSL_SNI
+	if (ectx->sni) {
+		zend_hash_destroy(ectx->sni);
+		FREE_HASHTABLE(ectx->sni);
+		ectx->sni = NULL;
+	}
+	if (ectx->sni_wildcard) {
+		zend_hash_destroy(ectx->sni_wildcard);
+		FREE_HASHTABLE(ectx->sni_wildcard);
+		ectx->sni_wildcard = NULL;
+	}
+	php_event_free_callback(&ectx->sni_cb);
+#endif
+#ifdef PHP_EVENT_SSL_ALPN
+	if (ectx->alpn) {
+		efree(ectx->alpn);
+		ectx->alpn = NULL;
+	}
+#endif
+	if (ectx->metrics) {
+		zend_hash_destroy(&ectx->metrics->alerts_sent);
+		zend_hash_destroy(&ectx->metrics->alerts_received);
+		zend_hash_destroy(&ectx->metrics->ciphers);
+		zend_hash_destroy(&ectx->metrics->protocols);
+		efree(ectx->metrics);
+		ectx->metrics = NULL;
+	}
+
 	zend_object_std_dtor(object);
 }/*}}}*/
 
 static void php_event_ssl_context_dtor_obj(zend_object *object)/*{{{*/
 {
-#if 0
 	Z_EVENT_X_OBJ_T(ssl_context) *intern = Z_EVENT_X_FETCH_OBJ(ssl_context, object);
 	PHP_EVENT_ASSERT(intern);
-#endif
+
+	php_event_ssl_context_unwatch(intern);
 
 	zend_objects_destroy_object(object);
 }/*}}}*/
@@ -575,6 +750,39 @@ static zend_object * event_bevent_object_create(zend_class_entry *ce)/*{{{*/
 	return &intern->zo;
 }/*}}}*/
 
+static zend_object * event_idle_reaper_object_create(zend_class_entry *ce)/*{{{*/
+{
+	Z_EVENT_X_OBJ_T(idle_reaper) *intern;
+
+	PHP_EVENT_OBJ_ALLOC(intern, ce, Z_EVENT_X_OBJ_T(idle_reaper));
+	intern->zo.handlers = &event_idle_reaper_object_handlers;
+
+	return &intern->zo;
+}/*}}}*/
+
+static zend_object * event_shared_payload_object_create(zend_class_entry *ce)/*{{{*/
+{
+	Z_EVENT_X_OBJ_T(shared_payload) *intern;
+
+	PHP_EVENT_OBJ_ALLOC(intern, ce, Z_EVENT_X_OBJ_T(shared_payload));
+	intern->zo.handlers = &event_shared_payload_object_handlers;
+
+	return &intern->zo;
+}/*}}}*/
+
+#ifdef PHP_EVENT_WORKER_POOL
+static zend_object * event_worker_pool_object_create(zend_class_entry *ce)/*{{{*/
+{
+	Z_EVENT_X_OBJ_T(worker_pool) *intern;
+
+	PHP_EVENT_OBJ_ALLOC(intern, ce, Z_EVENT_X_OBJ_T(worker_pool));
+	intern->zo.handlers = &event_worker_pool_object_handlers;
+	intern->index       = -1;
+
+	return &intern->zo;
+}/*}}}*/
+#endif
+
 static zend_object * event_buffer_object_create(zend_class_entry *ce)/*{{{*/
 {
 	Z_EVENT_X_OBJ_T(buffer) *intern;
@@ -957,6 +1165,11 @@ PHP_EVENT_X_PROP_HND_DECL(event)
 PHP_EVENT_X_PROP_HND_DECL(config)
 PHP_EVENT_X_PROP_HND_DECL(buffer)
 PHP_EVENT_X_PROP_HND_DECL(bevent)
+PHP_EVENT_X_PROP_HND_DECL(idle_reaper)
+PHP_EVENT_X_PROP_HND_DECL(shared_payload)
+#ifdef PHP_EVENT_WORKER_POOL
+PHP_EVENT_X_PROP_HND_DECL(worker_pool)
+#endif
 
 #ifdef HAVE_EVENT_EXTRA_LIB
 PHP_EVENT_X_PROP_HND_DECL(dns_base)
@@ -1030,9 +1243,30 @@ static zend_always_inline void register_classes()/*{{{*/
 	PHP_EVENT_DECL_PROP_NULL(ce, output,   ZEND_ACC_PUBLIC);
 #if LIBEVENT_VERSION_NUMBER >= 0x02010100
 	PHP_EVENT_DECL_PROP_NULL(ce, allow_ssl_dirty_shutdown, ZEND_ACC_PUBLIC);
+#endif
+#ifdef PHP_EVENT_STATS
+	PHP_EVENT_DECL_PROP_NULL(ce, bytes_read,    ZEND_ACC_PUBLIC);
+	PHP_EVENT_DECL_PROP_NULL(ce, bytes_written, ZEND_ACC_PUBLIC);
 #endif
 	zend_hash_add_ptr(&classes, ce->name, &event_bevent_properties);
 
+	PHP_EVENT_REGISTER_CLASS("EventIdleReaper", event_idle_reaper_object_create, php_event_idle_reaper_ce,
+			php_event_idle_reaper_ce_functions);
+	ce = php_event_idle_reaper_ce;
+	ce->ce_flags |= ZEND_ACC_FINAL;
+
+	PHP_EVENT_REGISTER_CLASS("EventSharedPayload", event_shared_payload_object_create, php_event_shared_payload_ce,
+			php_event_shared_payload_ce_functions);
+	ce = php_event_shared_payload_ce;
+	ce->ce_flags |= ZEND_ACC_FINAL;
+
+#ifdef PHP_EVENT_WORKER_POOL
+	PHP_EVENT_REGISTER_CLASS("EventWorkerPool", event_worker_pool_object_create, php_event_worker_pool_ce,
+			php_event_worker_pool_ce_functions);
+	ce = php_event_worker_pool_ce;
+	ce->ce_flags |= ZEND_ACC_FINAL;
+#endif
+
 	PHP_EVENT_REGISTER_CLASS("EventBuffer", event_buffer_object_create, php_event_buffer_ce,
 			php_event_buffer_ce_functions);
 	ce = php_event_buffer_ce;
@@ -1118,6 +1352,11 @@ PHP_MINIT_FUNCTION(event)
 	PHP_EVENT_INIT_X_OBJ_HANDLERS(base);
 	PHP_EVENT_INIT_X_OBJ_HANDLERS(config);
 	PHP_EVENT_INIT_X_OBJ_HANDLERS(bevent);
+	PHP_EVENT_INIT_X_OBJ_HANDLERS(idle_reaper);
+	PHP_EVENT_INIT_X_OBJ_HANDLERS(shared_payload);
+#ifdef PHP_EVENT_WORKER_POOL
+	PHP_EVENT_INIT_X_OBJ_HANDLERS(worker_pool);
+#endif
 	PHP_EVENT_INIT_X_OBJ_HANDLERS(buffer);
 #if HAVE_EVENT_EXTRA_LIB
 	PHP_EVENT_INIT_X_OBJ_HANDLERS(dns_base);
@@ -1193,6 +1432,7 @@ PHP_MINIT_FUNCTION(event)
 	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_bevent_ce, OPT_CLOSE_ON_FREE,    BEV_OPT_CLOSE_ON_FREE);
 	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_bevent_ce, OPT_THREADSAFE,       BEV_OPT_THREADSAFE);
 	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_bevent_ce, OPT_DEFER_CALLBACKS,  BEV_OPT_DEFER_CALLBACKS);
+	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_bevent_ce, WRITE_PRIORITIES,     PHP_EVENT_WRITE_PRIORITIES);
 #if LIBEVENT_VERSION_NUMBER >= 0x02000500
 	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_bevent_ce, OPT_UNLOCK_CALLBACKS, BEV_OPT_UNLOCK_CALLBACKS);
 #endif
@@ -1211,6 +1451,9 @@ PHP_MINIT_FUNCTION(event)
 	/* Socket options */
 	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_util_ce, SO_DEBUG,     SO_DEBUG);
 	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_util_ce, SO_REUSEADDR, SO_REUSEADDR);
+#ifdef SO_REUSEPORT
+	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_util_ce, SO_REUSEPORT, SO_REUSEPORT);
+#endif
 	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_util_ce, SO_KEEPALIVE, SO_KEEPALIVE);
 	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_util_ce, SO_DONTROUTE, SO_DONTROUTE);
 	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_util_ce, SO_LINGER,    SO_LINGER);
@@ -1227,6 +1470,40 @@ PHP_MINIT_FUNCTION(event)
 #ifdef TCP_NODELAY
 	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_util_ce, TCP_NODELAY, TCP_NODELAY);
 #endif
+#ifdef SO_RCVBUFFORCE
+	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_util_ce, SO_RCVBUFFORCE, SO_RCVBUFFORCE);
+#endif
+#ifdef SO_SNDBUFFORCE
+	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_util_ce, SO_SNDBUFFORCE, SO_SNDBUFFORCE);
+#endif
+#ifdef SO_BUSY_POLL
+	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_util_ce, SO_BUSY_POLL, SO_BUSY_POLL);
+#endif
+#ifdef SO_INCOMING_CPU
+	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_util_ce, SO_INCOMING_CPU, SO_INCOMING_CPU);
+#endif
+#ifdef TCP_CORK
+	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_util_ce, TCP_CORK, TCP_CORK);
+#endif
+#ifdef TCP_QUICKACK
+	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_util_ce, TCP_QUICKACK, TCP_QUICKACK);
+#endif
+#ifdef TCP_DEFER_ACCEPT
+	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_util_ce, TCP_DEFER_ACCEPT, TCP_DEFER_ACCEPT);
+#endif
+#ifdef TCP_FASTOPEN
+	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_util_ce, TCP_FASTOPEN, TCP_FASTOPEN);
+#endif
+#ifdef TCP_NOTSENT_LOWAT
+	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_util_ce, TCP_NOTSENT_LOWAT, TCP_NOTSENT_LOWAT);
+#endif
+#ifdef IP_BIND_ADDRESS_NO_PORT
+	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_util_ce, IP_BIND_ADDRESS_NO_PORT, IP_BIND_ADDRESS_NO_PORT);
+#endif
+
+	/* Socket tuning profiles */
+	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_util_ce, SOCKET_PROFILE_LOW_LATENCY, PHP_EVENT_SOCKET_PROFILE_LOW_LATENCY);
+	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_util_ce, SOCKET_PROFILE_BULK,        PHP_EVENT_SOCKET_PROFILE_BULK);
 
 	/* Socket protocol levels */
 	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_util_ce, SOL_SOCKET, SOL_SOCKET);
@@ -1251,6 +1528,9 @@ PHP_MINIT_FUNCTION(event)
 	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_listener_ce, OPT_CLOSE_ON_FREE,          LEV_OPT_CLOSE_ON_FREE);
 	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_listener_ce, OPT_CLOSE_ON_EXEC,          LEV_OPT_CLOSE_ON_EXEC);
 	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_listener_ce, OPT_REUSEABLE,              LEV_OPT_REUSEABLE);
+# ifdef LEV_OPT_REUSEABLE_PORT
+	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_listener_ce, OPT_REUSEABLE_PORT,         LEV_OPT_REUSEABLE_PORT);
+# endif
 # if LIBEVENT_VERSION_NUMBER >= 0x02010100
 	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_listener_ce, OPT_DISABLED,               LEV_OPT_DISABLED);
 # endif
@@ -1325,6 +1605,16 @@ PHP_MINIT_FUNCTION(event)
 	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_ssl_context_ce, OPT_CIPHER_SERVER_PREFERENCE, PHP_EVENT_OPT_CIPHER_SERVER_PREFERENCE);
 	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_ssl_context_ce, OPT_REQUIRE_CLIENT_CERT,      PHP_EVENT_OPT_REQUIRE_CLIENT_CERT);
 	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_ssl_context_ce, OPT_VERIFY_CLIENT_ONCE,       PHP_EVENT_OPT_VERIFY_CLIENT_ONCE);
+	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_ssl_context_ce, OPT_SESSION_CACHE_SIZE,       PHP_EVENT_OPT_SESSION_CACHE_SIZE);
+	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_ssl_context_ce, OPT_SESSION_TIMEOUT,          PHP_EVENT_OPT_SESSION_TIMEOUT);
+	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_ssl_context_ce, OPT_SESSION_TICKETS,          PHP_EVENT_OPT_SESSION_TICKETS);
+	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_ssl_context_ce, OPT_TICKET_KEY_LIFETIME,      PHP_EVENT_OPT_TICKET_KEY_LIFETIME);
+	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_ssl_context_ce, OPT_CLIENT_SESSION_CACHE,     PHP_EVENT_OPT_CLIENT_SESSION_CACHE);
+	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_ssl_context_ce, OPT_KTLS,                     PHP_EVENT_OPT_KTLS);
+	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_ssl_context_ce, OPT_SHARED_CTX,               PHP_EVENT_OPT_SHARED_CTX);
+	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_ssl_context_ce, OPT_ALPN_PROTOCOLS,           PHP_EVENT_OPT_ALPN_PROTOCOLS);
+	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_ssl_context_ce, OPT_METRICS,                  PHP_EVENT_OPT_METRICS);
+	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_ssl_context_ce, OPT_DYNAMIC_RECORDS,          PHP_EVENT_OPT_DYNAMIC_RECORDS);
 
 	PHP_EVENT_REG_CLASS_CONST_STRING(php_event_ssl_context_ce, OPENSSL_VERSION_TEXT,       OPENSSL_VERSION_TEXT);
 	PHP_EVENT_REG_CLASS_CONST_LONG(php_event_ssl_context_ce,   OPENSSL_VERSION_NUMBER,     OPENSSL_VERSION_NUMBER);
@@ -1357,6 +1647,16 @@ PHP_MINIT_FUNCTION(event)
 
 	/* Create new index which will be used to retreive custom data of the OpenSSL callbacks */
 	php_event_ssl_data_index = SSL_get_ex_new_index(0, "PHP EventSslContext index", NULL, NULL, NULL);
+	/* Index of the client session cache key, see php_event_ssl_session_prepare() */
+	php_event_ssl_host_index = SSL_get_ex_new_index(0, "PHP EventSslContext session key", NULL, NULL,
+			php_event_ssl_host_free);
+	/* Index of the handshake start time(OPT_METRICS). Freed the same way as the session key */
+	php_event_ssl_start_index = SSL_get_ex_new_index(0, "PHP EventSslContext handshake start", NULL, NULL,
+			php_event_ssl_host_free);
+	/* Index of the flag of the completed initial handshake, see info_callback() */
+	php_event_ssl_done_index = SSL_get_ex_new_index(0, "PHP EventSslContext handshake done", NULL, NULL, NULL);
+	/* Process-wide cache of the SSL_CTX objects created with OPT_SHARED_CTX */
+	php_event_ssl_ctx_cache_init();
 #endif /* HAVE_EVENT_OPENSSL_LIB */
 
 #ifdef PHP_EVENT_DEBUG
@@ -1388,6 +1688,8 @@ PHP_MINIT_FUNCTION(event)
 PHP_MSHUTDOWN_FUNCTION(event)
 {
 #ifdef HAVE_EVENT_OPENSSL_LIB
+	php_event_ssl_ctx_cache_destroy();
+
 # ifndef LIBRESSL_VERSION_NUMBER
 	FIPS_mode_set(0);
 # endif
@@ -1476,6 +1778,11 @@ PHP_MINFO_FUNCTION(event)
 #else
 	php_info_print_table_row(2, "Thread safety support", "disabled");
 #endif
+#ifdef PHP_EVENT_STATS
+	php_info_print_table_row(2, "Connection statistics", "enabled");
+#else
+	php_info_print_table_row(2, "Connection statistics", "disabled");
+#endif
 
 
 	php_info_print_table_row(2, "Extension version", PHP_EVENT_VERSION);
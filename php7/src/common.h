@@ -32,6 +32,34 @@
 # include <sys/un.h>
 #endif
 
+#ifndef PHP_WIN32
+# include <netinet/tcp.h>
+#endif
+
+#if !defined(PHP_WIN32) && defined(SCM_RIGHTS)
+# define PHP_EVENT_FD_PASSING 1
+/* Maximum number of descriptors passed in one message (SCM_MAX_FD on Linux) */
+# define PHP_EVENT_MAX_PASSED_FDS 253
+#endif
+
+#if defined(TCP_INFO) && defined(__linux__)
+# define PHP_EVENT_TCP_INFO 1
+#endif
+
+#if !defined(PHP_WIN32) && defined(HAVE_FORK)
+# include <sys/wait.h>
+# define PHP_EVENT_WORKER_POOL 1
+#endif
+
+#ifdef HAVE_SCHED_SETAFFINITY
+# include <sched.h>
+#endif
+
+#if defined(HAVE_LINUX_FILTER_H) && defined(SO_ATTACH_REUSEPORT_CBPF)
+# include <linux/filter.h>
+# define PHP_EVENT_REUSEPORT_CBPF 1
+#endif
+
 #include <signal.h>
 
 #ifdef PHP_EVENT_SOCKETS
@@ -96,6 +124,27 @@
 # ifndef OPENSSL_NO_SSL3
 #  define HAVE_SSL3 1
 # endif
+# if OPENSSL_VERSION_NUMBER >= 0x30000000L && !defined(LIBRESSL_VERSION_NUMBER)
+/* HMAC_CTX and SSL_CTX_set_tlsext_ticket_key_cb() are deprecated in 3.0 */
+#  include <openssl/core_names.h>
+#  include <openssl/params.h>
+#  define PHP_EVENT_SSL_TICKET_KEYS 1
+#  define PHP_EVENT_SSL_TICKET_EVP_MAC 1
+# elif defined(SSL_CTX_set_tlsext_ticket_key_cb)
+#  define PHP_EVENT_SSL_TICKET_KEYS 1
+# endif
+# ifdef TLSEXT_TYPE_application_layer_protocol_negotiation
+#  define PHP_EVENT_SSL_ALPN 1
+# endif
+# ifdef SSL_CTX_set_tlsext_servername_callback
+#  define PHP_EVENT_SSL_SNI 1
+# endif
+# if defined(SSL_OP_ENABLE_KTLS) && defined(BIO_get_ktls_send)
+#  define PHP_EVENT_KTLS 1
+# endif
+# ifdef SSL_CTRL_SET_MAX_SEND_FRAGMENT
+#  define PHP_EVENT_SSL_RECORD_SIZING 1
+# endif
 #endif /* HAVE_EVENT_OPENSSL_LIB */
 
 #include "../php_event.h"
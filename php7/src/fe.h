@@ -56,6 +56,8 @@ PHP_METHOD(EventBase, free);
 #if LIBEVENT_VERSION_NUMBER >= 0x02010200
 PHP_METHOD(EventBase, resume);
 #endif
+PHP_METHOD(EventBase, createIdleReaper);
+PHP_METHOD(EventBase, broadcast);
 
 PHP_METHOD(EventConfig, __construct);
 PHP_METHOD(EventConfig, __sleep);
@@ -89,6 +91,31 @@ PHP_METHOD(EventBufferEvent, read);
 PHP_METHOD(EventBufferEvent, readBuffer);
 PHP_METHOD(EventBufferEvent, setPriority);
 PHP_METHOD(EventBufferEvent, setTimeouts);
+PHP_METHOD(EventBufferEvent, setSocketProfile);
+PHP_METHOD(EventBufferEvent, writePriority);
+PHP_METHOD(EventBufferEvent, getWritePriorityDepths);
+PHP_METHOD(EventBufferEvent, cork);
+PHP_METHOD(EventBufferEvent, uncork);
+PHP_METHOD(EventBufferEvent, setAutoCork);
+PHP_METHOD(EventBufferEvent, setReadCoalescing);
+#if LIBEVENT_VERSION_NUMBER >= 0x02010100
+PHP_METHOD(EventBufferEvent, setMaxSingleRead);
+PHP_METHOD(EventBufferEvent, getMaxSingleRead);
+PHP_METHOD(EventBufferEvent, setMaxSingleWrite);
+PHP_METHOD(EventBufferEvent, getMaxSingleWrite);
+PHP_METHOD(EventBufferEvent, setAdaptiveRead);
+PHP_METHOD(EventBufferEvent, getAdaptiveReadStats);
+#endif
+#ifdef PHP_EVENT_TCP_INFO
+PHP_METHOD(EventBufferEvent, getTcpInfo);
+#endif
+#ifdef PHP_EVENT_STATS
+PHP_METHOD(EventBufferEvent, getStats);
+#endif
+#ifdef PHP_EVENT_FD_PASSING
+PHP_METHOD(EventBufferEvent, setFdPassing);
+PHP_METHOD(EventBufferEvent, fetchFds);
+#endif
 #ifdef HAVE_EVENT_OPENSSL_LIB
 PHP_METHOD(EventBufferEvent, sslFilter);
 PHP_METHOD(EventBufferEvent, createSslFilter);
@@ -99,6 +126,19 @@ PHP_METHOD(EventBufferEvent, sslGetCipherInfo);
 PHP_METHOD(EventBufferEvent, sslGetCipherName);
 PHP_METHOD(EventBufferEvent, sslGetCipherVersion);
 PHP_METHOD(EventBufferEvent, sslGetProtocol);
+PHP_METHOD(EventBufferEvent, sslGetSession);
+PHP_METHOD(EventBufferEvent, sslSetSession);
+PHP_METHOD(EventBufferEvent, sslSessionReused);
+PHP_METHOD(EventBufferEvent, sslGetKtlsStatus);
+# ifdef PHP_EVENT_SSL_ALPN
+PHP_METHOD(EventBufferEvent, sslGetAlpnProtocol);
+# endif
+# ifdef PHP_EVENT_KTLS
+PHP_METHOD(EventBufferEvent, sslSendfile);
+# endif
+# ifdef PHP_EVENT_SSL_RECORD_SIZING
+PHP_METHOD(EventBufferEvent, setDynamicRecordSizing);
+# endif
 #endif
 
 PHP_METHOD(EventBuffer, __construct);
@@ -133,14 +173,50 @@ PHP_METHOD(EventUtil, sslRandPoll);
 PHP_METHOD(EventUtil, getSocketName);
 PHP_METHOD(EventUtil, getSocketFd);
 PHP_METHOD(EventUtil, setSocketOption);
+PHP_METHOD(EventUtil, setSocketProfile);
+#ifdef PHP_EVENT_TCP_INFO
+PHP_METHOD(EventUtil, getTcpInfo);
+#endif
+#ifdef PHP_EVENT_FD_PASSING
+PHP_METHOD(EventUtil, sendFds);
+PHP_METHOD(EventUtil, recvFds);
+#endif
 #ifdef PHP_EVENT_SOCKETS_SUPPORT
 PHP_METHOD(EventUtil, createSocket);
 #endif
 
+PHP_METHOD(EventIdleReaper, __construct);
+PHP_METHOD(EventIdleReaper, add);
+PHP_METHOD(EventIdleReaper, remove);
+PHP_METHOD(EventIdleReaper, getCount);
+PHP_METHOD(EventIdleReaper, free);
+
+PHP_METHOD(EventSharedPayload, __construct);
+PHP_METHOD(EventSharedPayload, getLength);
+
+#ifdef PHP_EVENT_WORKER_POOL
+PHP_METHOD(EventWorkerPool, __construct);
+PHP_METHOD(EventWorkerPool, run);
+PHP_METHOD(EventWorkerPool, getRestarts);
+#endif
+
 PHP_METHOD(EventBufferPosition, __construct);
 
 #ifdef HAVE_EVENT_OPENSSL_LIB
 PHP_METHOD(EventSslContext, __construct);
+PHP_METHOD(EventSslContext, getSessionStats);
+PHP_METHOD(EventSslContext, getMetrics);
+PHP_METHOD(EventSslContext, clearSharedCache);
+PHP_METHOD(EventSslContext, reload);
+PHP_METHOD(EventSslContext, watch);
+#ifdef PHP_EVENT_SSL_TICKET_KEYS
+PHP_METHOD(EventSslContext, rotateTicketKeys);
+#endif
+#ifdef PHP_EVENT_SSL_SNI
+PHP_METHOD(EventSslContext, addSniContext);
+PHP_METHOD(EventSslContext, removeSniContext);
+PHP_METHOD(EventSslContext, setSniCallback);
+#endif
 #if OPENSSL_VERSION_NUMBER >= 0x10100000L && !defined(LIBRESSL_VERSION_NUMBER)
 PHP_METHOD(EventSslContext, setMinProtoVersion);
 PHP_METHOD(EventSslContext, setMaxProtoVersion);
@@ -169,8 +245,17 @@ PHP_METHOD(EventListener, disable);
 PHP_METHOD(EventListener, setCallback);
 PHP_METHOD(EventListener, setErrorCallback);
 PHP_METHOD(EventListener, getSocketName);
+PHP_METHOD(EventListener, setSocketProfile);
+PHP_METHOD(EventListener, setBufferEventTemplate);
+PHP_METHOD(EventListener, setMaxConnections);
+PHP_METHOD(EventListener, getConnectionStats);
+PHP_METHOD(EventListener, setProxyProtocol);
+#ifdef PHP_EVENT_REUSEPORT_CBPF
+PHP_METHOD(EventListener, attachReuseportCbpf);
+#endif
 #if LIBEVENT_VERSION_NUMBER >= 0x02000300
 PHP_METHOD(EventListener, getBase);
+PHP_METHOD(EventListener, setBatchCallback);
 #endif
 
 PHP_METHOD(EventHttpConnection, __construct);
@@ -193,6 +278,7 @@ PHP_METHOD(EventHttp, __wakeup);
 PHP_METHOD(EventHttp, accept);
 PHP_METHOD(EventHttp, bind);
 PHP_METHOD(EventHttp, setCallback);
+PHP_METHOD(EventHttp, route);
 PHP_METHOD(EventHttp, setDefaultCallback);
 PHP_METHOD(EventHttp, setAllowedMethods);
 PHP_METHOD(EventHttp, setMaxBodySize);
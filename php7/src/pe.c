@@ -217,6 +217,24 @@ static zval * event_bevent_output_prop_ptr_ptr(void *obj)/*{{{*/
 	return NULL;
 }/*}}}*/
 
+#ifdef PHP_EVENT_STATS
+static zval * event_bevent_bytes_read_prop_read(void *obj, zval *retval)/*{{{*/
+{
+	php_event_bevent_t *bev = (php_event_bevent_t *)obj;
+
+	ZVAL_LONG(retval, (zend_long)bev->stats.bytes_read);
+	return retval;
+}/*}}}*/
+
+static zval * event_bevent_bytes_written_prop_read(void *obj, zval *retval)/*{{{*/
+{
+	php_event_bevent_t *bev = (php_event_bevent_t *)obj;
+
+	ZVAL_LONG(retval, (zend_long)bev->stats.bytes_written);
+	return retval;
+}/*}}}*/
+#endif
+
 
 #if LIBEVENT_VERSION_NUMBER >= 0x02010100 && defined(HAVE_EVENT_OPENSSL_LIB)
 static int event_bevent_allow_ssl_dirty_shutdown_prop_write(void *obj, zval *value)/*{{{*/
@@ -298,6 +316,10 @@ const php_event_property_entry_t event_bevent_property_entries[] = {
 	{"fd",       sizeof("fd")       - 1, event_bevent_fd_prop_read,       NULL,                             NULL                               },
 	{"input",    sizeof("input")    - 1, event_bevent_input_prop_read,    NULL,                             event_bevent_input_prop_ptr_ptr},
 	{"output",   sizeof("output")   - 1, event_bevent_output_prop_read,   NULL,                             event_bevent_output_prop_ptr_ptr},
+#ifdef PHP_EVENT_STATS
+	{"bytes_read",    sizeof("bytes_read")    - 1, event_bevent_bytes_read_prop_read,    NULL, NULL},
+	{"bytes_written", sizeof("bytes_written") - 1, event_bevent_bytes_written_prop_read, NULL, NULL},
+#endif
 
 #if LIBEVENT_VERSION_NUMBER >= 0x02010100 && defined(HAVE_EVENT_OPENSSL_LIB)
 	{"allow_ssl_dirty_shutdown", sizeof("allow_ssl_dirty_shutdown") - 1,
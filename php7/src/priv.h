@@ -20,6 +20,9 @@
 
 #ifdef HAVE_EVENT_OPENSSL_LIB
 extern int php_event_ssl_data_index;
+extern int php_event_ssl_host_index;
+extern int php_event_ssl_start_index;
+extern int php_event_ssl_done_index;
 #endif
 
 extern const zend_function_entry php_event_ce_functions[];
@@ -28,6 +31,11 @@ extern const zend_function_entry php_event_config_ce_functions[];
 extern const zend_function_entry php_event_bevent_ce_functions[];
 extern const zend_function_entry php_event_buffer_ce_functions[];
 extern const zend_function_entry php_event_util_ce_functions[];
+extern const zend_function_entry php_event_idle_reaper_ce_functions[];
+extern const zend_function_entry php_event_shared_payload_ce_functions[];
+#ifdef PHP_EVENT_WORKER_POOL
+extern const zend_function_entry php_event_worker_pool_ce_functions[];
+#endif
 extern const zend_function_entry php_event_ssl_context_ce_functions[];
 
 extern zend_class_entry *php_event_ce;
@@ -36,6 +44,11 @@ extern zend_class_entry *php_event_config_ce;
 extern zend_class_entry *php_event_bevent_ce;
 extern zend_class_entry *php_event_buffer_ce;
 extern zend_class_entry *php_event_util_ce;
+extern zend_class_entry *php_event_idle_reaper_ce;
+extern zend_class_entry *php_event_shared_payload_ce;
+#ifdef PHP_EVENT_WORKER_POOL
+extern zend_class_entry *php_event_worker_pool_ce;
+#endif
 #ifdef HAVE_EVENT_OPENSSL_LIB
 extern zend_class_entry *php_event_ssl_context_ce;
 #endif
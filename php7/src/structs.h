@@ -38,10 +38,19 @@ typedef struct _php_event_callback_t {
 	zend_fcall_info_cache fci_cache;
 } php_event_callback_t;
 
+typedef double php_event_timestamp_t;
+
+/* Socket tuning profiles, see php_event_set_socket_profile() */
+enum {
+	PHP_EVENT_SOCKET_PROFILE_LOW_LATENCY = 1,
+	PHP_EVENT_SOCKET_PROFILE_BULK        = 2
+};
+
 /* EventBase object */
 typedef struct _php_event_base_t {
 	struct event_base *base;
 	zend_bool          internal;   /* Whether is obtained with evconnlistener_get_base() */
+	zend_bool          nolock;     /* Whether is created with EVENT_BASE_FLAG_NOLOCK     */
 
 	PHP_EVENT_OBJECT_TAIL;
 } Z_EVENT_X_OBJ_T(base);
@@ -60,14 +69,141 @@ typedef php_event_t Z_EVENT_X_OBJ_T(event);
 /* EventConfig object */
 typedef struct _php_event_config_t {
 	struct event_config *ptr;
+	int                  flags; /* Flags passed to event_config_set_flag() */
 
 	PHP_EVENT_OBJECT_TAIL;
 } Z_EVENT_X_OBJ_T(config);
 
+#ifdef PHP_EVENT_STATS
+/* I/O statistics of EventBufferEvent */
+typedef struct _php_event_bevent_stats_t {
+	zend_ulong                bytes_read;    /* Bytes appended to the input buffer            */
+	zend_ulong                bytes_written; /* Bytes drained from the output buffer          */
+	zend_ulong                read_calls;    /* Number of the read callback invocations       */
+	zend_ulong                write_calls;   /* Number of the write callback invocations      */
+	zend_ulong                event_calls;   /* Number of the event callback invocations      */
+	php_event_timestamp_t     started;       /* Time of creation, or of the connect() call    */
+	php_event_timestamp_t     connected;     /* Time of BEV_EVENT_CONNECTED (incl. handshake) */
+	php_event_timestamp_t     last_read;
+	php_event_timestamp_t     last_write;
+	struct evbuffer_cb_entry *input_cb;
+	struct evbuffer_cb_entry *output_cb;
+} php_event_bevent_stats_t;
+#endif
+
+/* Read coalescing state of EventBufferEvent, see setReadCoalescing() */
+typedef struct _php_event_bevent_coalesce_t {
+	struct event   *timer;     /* Fires max_delay after the first deferred read */
+	struct timeval  tv;        /* max_delay, a common timeout of the base        */
+	size_t          min_bytes; /* Input length releasing the read callback       */
+} php_event_bevent_coalesce_t;
+
+/* Adaptive read sizing state of EventBufferEvent, see setAdaptiveRead() */
+typedef struct _php_event_bevent_read_sizing_t {
+	struct evbuffer_cb_entry *input_cb;
+	size_t                    min_size;       /* Lower bound of the max single read    */
+	size_t                    max_size;       /* Upper bound of the max single read    */
+	size_t                    size;           /* Current max single read               */
+	int                       small_reads;    /* Consecutive reads below size / 4      */
+	zend_ulong                reads;
+	zend_ulong                grows;
+	zend_ulong                shrinks;
+	zend_ulong                syscalls_saved; /* Compared to reading min_size at a time */
+} php_event_bevent_read_sizing_t;
+
+#ifdef PHP_EVENT_SSL_RECORD_SIZING
+/* Default TLS record sizing, see EventBufferEvent::setDynamicRecordSizing() */
+# define PHP_EVENT_SSL_RECORD_SMALL       1400
+# define PHP_EVENT_SSL_RECORD_BOOST_AFTER (1024 * 1024)
+# define PHP_EVENT_SSL_RECORD_IDLE        1.0
+
+/* Dynamic TLS record sizing state of an SSL EventBufferEvent */
+typedef struct _php_event_bevent_record_sizing_t {
+	struct evbuffer_cb_entry *output_cb;
+	size_t                    small_size;  /* Max record payload at the start      */
+	size_t                    boost_after; /* Bytes written with the small records */
+	struct timeval            idle;        /* Idle period dropping back to small   */
+	struct timeval            last_write;
+	size_t                    written;
+	zend_bool                 boosted;     /* Full size records are written        */
+} php_event_bevent_record_sizing_t;
+#endif
+
+/* Number of EventBufferEvent::writePriority() queues */
+#define PHP_EVENT_WRITE_PRIORITIES 4
+/* Queued data is moved to the output buffer while it holds less than this */
+#define PHP_EVENT_WRITE_PRIORITY_WATERMARK 16384
+
+/* Priority output queues of EventBufferEvent. A queue keeps messages as
+ * size_t length followed by the data, so messages are never interleaved */
+typedef struct _php_event_bevent_wprio_t {
+	struct evbuffer          *queues[PHP_EVENT_WRITE_PRIORITIES];
+	size_t                    msgs[PHP_EVENT_WRITE_PRIORITIES];  /* Queued messages */
+	size_t                    bytes[PHP_EVENT_WRITE_PRIORITIES]; /* Queued payload  */
+	struct evbuffer_cb_entry *output_cb;
+	zend_bool                 flushing;
+} php_event_bevent_wprio_t;
+
+/* Write coalescing state of EventBufferEvent, see cork() and setAutoCork() */
+typedef struct _php_event_bevent_cork_t {
+	struct evbuffer_cb_entry *output_cb;
+	struct event             *flush_ev;      /* Releases an automatic cork        */
+	struct timeval            deadline;      /* Auto mode flush deadline          */
+	size_t                    threshold;     /* Auto mode output size, 0 if off   */
+	zend_bool                 corked;        /* Writes are held                   */
+	zend_bool                 auto_corked;   /* Held by the auto mode             */
+	zend_bool                 write_enabled; /* EV_WRITE was enabled when corked  */
+	zend_bool                 tcp_cork;      /* TCP_CORK(TCP_NOPUSH) is on        */
+} php_event_bevent_cork_t;
+
+#ifdef PHP_EVENT_FD_PASSING
+/* Descriptor passing state of EventBufferEvent, see setFdPassing() */
+typedef struct _php_event_bevent_fdpass_t {
+	struct event             *read_ev;  /* Reads the socket with recvmsg() instead of the bufferevent */
+	zend_bool                 reading;  /* EV_READ is enabled                                      */
+	zend_bool                 paused;   /* The input reached the read high watermark               */
+	struct evbuffer_cb_entry *input_cb; /* Resumes reading, when the input is drained              */
+	int                      *fds;      /* Received descriptors not fetched yet                     */
+	size_t                    nfds;
+	size_t                    size;     /* Allocated number of fds                                  */
+} php_event_bevent_fdpass_t;
+#endif
+
+/* Number of timer ticks per idle period of an EventIdleReaper */
+#define PHP_EVENT_IDLE_REAPER_TICKS 8
+/* Wheel slots. Two extra slots keep the current slot and the farthest
+ * deadline (TICKS + 1 ticks ahead) apart */
+#define PHP_EVENT_IDLE_REAPER_SLOTS (PHP_EVENT_IDLE_REAPER_TICKS + 2)
+
+struct _php_event_idle_reaper_t;
+
+/* Entry of a bufferevent in an idle reaper timer wheel.
+ * A slot head is an entry with NULL reaper */
+typedef struct _php_event_idle_entry_t php_event_idle_entry_t;
+struct _php_event_idle_entry_t {
+	php_event_idle_entry_t           *prev;
+	php_event_idle_entry_t           *next;
+	struct _php_event_idle_reaper_t  *reaper;
+	zend_ulong                        tick;      /* Tick of the last activity */
+	struct evbuffer_cb_entry         *input_cb;
+	struct evbuffer_cb_entry         *output_cb;
+};
+
+/* Number of live connections accepted by an EventListener. Shared by the
+ * listener and the EventBufferEvent objects created from its template */
+typedef struct _php_event_conn_counter_t php_event_conn_counter_t;
+struct _php_event_conn_counter_t {
+	size_t     refcount;
+	zend_long  live;
+	void      *owner;                                   /* NULL after the owner is destroyed */
+	void      (*on_close)(php_event_conn_counter_t *c); /* Called when a connection is closed */
+};
+
 /* EventBufferEvent object */
 typedef struct _php_event_bevent_t {
 	struct bufferevent   *bevent;
 	int                   _internal;
+	zend_bool             lock;        /* Whether bevent has a lock (BEV_OPT_THREADSAFE) */
 	zval                  self;        /* Object itself. For callbacks */
 	zval                  data;        /* User callback data           */
 	zval                  input;       /* Input buffer                 */
@@ -76,10 +212,87 @@ typedef struct _php_event_bevent_t {
 	php_event_callback_t  cb_read;
 	php_event_callback_t  cb_write;
 	php_event_callback_t  cb_event;
+#ifdef PHP_EVENT_STATS
+	php_event_bevent_stats_t stats;
+#endif
+	php_event_idle_entry_t idle;
+	php_event_bevent_coalesce_t coalesce;
+	php_event_bevent_read_sizing_t read_sizing;
+	php_event_bevent_wprio_t wprio;
+	php_event_bevent_cork_t cork;
+#ifdef PHP_EVENT_FD_PASSING
+	php_event_bevent_fdpass_t fdpass;
+#endif
+#ifdef PHP_EVENT_SSL_RECORD_SIZING
+	php_event_bevent_record_sizing_t record_sizing;
+#endif
+	zend_bool             owned;       /* self holds a reference until the connection is closed */
+	php_event_conn_counter_t *conns;   /* Counter of the accepting listener, or NULL */
 
 	PHP_EVENT_OBJECT_TAIL;
 } Z_EVENT_X_OBJ_T(bevent);
 
+/* EventIdleReaper object */
+typedef struct _php_event_idle_reaper_t {
+	struct event           *timer;    /* Persistent tick timer                 */
+	struct timeval          tv;       /* Tick interval                         */
+	zval                    base;
+	zval                    data;     /* User custom data passed to callback   */
+	php_event_callback_t    cb;       /* Idle callback                         */
+	zend_ulong              tick;     /* Current tick                          */
+	zend_long               count;    /* Number of watched bufferevents        */
+	php_event_idle_entry_t  slots[PHP_EVENT_IDLE_REAPER_SLOTS];
+	php_event_idle_entry_t  expired;  /* Entries of the slot being processed   */
+
+	PHP_EVENT_OBJECT_TAIL;
+} Z_EVENT_X_OBJ_T(idle_reaper);
+
+/* Bytes added to output buffers by reference, see EventBase::broadcast().
+ * Each buffer holding the block owns a reference */
+typedef struct _php_event_shared_block_t {
+	size_t refcount;
+	size_t len;
+	char   data[1];
+} php_event_shared_block_t;
+
+/* EventSharedPayload object */
+typedef struct _php_event_shared_payload_t {
+	php_event_shared_block_t *block;
+
+	PHP_EVENT_OBJECT_TAIL;
+} Z_EVENT_X_OBJ_T(shared_payload);
+
+#ifdef PHP_EVENT_WORKER_POOL
+struct _php_event_worker_pool_t;
+
+/* Worker process of an EventWorkerPool */
+typedef struct _php_event_worker_t {
+	struct _php_event_worker_pool_t *pool;
+	zend_long                        index;
+	pid_t                            pid;     /* 0, if not running */
+	struct timeval                   started;
+} php_event_worker_t;
+
+/* Minimum lifetime of a worker restarted without a delay, seconds */
+#define PHP_EVENT_WORKER_RESTART_DELAY 1
+
+/* EventWorkerPool object */
+typedef struct _php_event_worker_pool_t {
+	php_event_worker_t *workers;
+	zend_long           count;
+	zend_long           index;        /* Worker index in a worker process, -1 in the supervisor */
+	zend_long           running;      /* Number of running workers */
+	zend_long           pending;      /* Number of delayed restarts */
+	zend_long           restarts;     /* Number of restarted workers */
+	zend_bool           cpu_affinity; /* Whether to pin worker i to CPU i % ncpu */
+	zend_bool           stopping;
+	struct event_base  *sup;          /* Supervisor's event base while run() is in progress */
+	struct event       *sig_ev[3];    /* SIGCHLD, SIGTERM, SIGINT */
+
+	PHP_EVENT_OBJECT_TAIL;
+} Z_EVENT_X_OBJ_T(worker_pool);
+#endif
+
 /* EventBuffer object */
 typedef struct _php_event_buffer_t {
 	zend_bool internal; /* Whether is an internal buffer of a bufferevent */
@@ -101,6 +314,46 @@ typedef struct _php_event_dns_base_t {
 	PHP_EVENT_OBJECT_TAIL;
 } Z_EVENT_X_OBJ_T(dns_base);
 
+/* Length of the buffer for a PROXY protocol header read by an EventListener.
+ * It fits a v1 header, and the fixed part with the address block of a v2
+ * header. The v2 TLVs beyond it are read and discarded */
+#define PHP_EVENT_PROXY_HDR_MAX 536
+
+struct _php_event_listener_t;
+
+/* Accepted connection waiting for a PROXY protocol header */
+typedef struct _php_event_proxy_conn_t php_event_proxy_conn_t;
+struct _php_event_proxy_conn_t {
+	php_event_proxy_conn_t       *prev;
+	php_event_proxy_conn_t       *next;
+	struct _php_event_listener_t *l;
+	evutil_socket_t               fd;
+	struct event                 *ev;
+	struct timeval                deadline;
+	struct sockaddr_storage       addr;     /* Peer address, replaced with the source address from the header */
+	ev_socklen_t                  addr_len;
+	size_t                        len;      /* Bytes of the header read so far */
+	unsigned char                 buf[PHP_EVENT_PROXY_HDR_MAX]; /* Start of the header */
+};
+
+/* Settings of the EventBufferEvent objects created for accepted connections,
+ * see EventListener::setBufferEventTemplate() */
+typedef struct _php_event_bevent_template_t {
+	zend_long             options;
+	zend_long             events;        /* Events enabled on creation */
+	zval                  data;
+	php_event_callback_t  cb_read;
+	php_event_callback_t  cb_write;
+	php_event_callback_t  cb_event;
+	size_t                read_wm[2];    /* Read low and high watermarks  */
+	size_t                write_wm[2];   /* Write low and high watermarks */
+	struct timeval        timeout_read;  /* Zero if not set */
+	struct timeval        timeout_write; /* Zero if not set */
+#ifdef HAVE_EVENT_OPENSSL_LIB
+	zval                  ctx;           /* EventSslContext for the server side of TLS */
+#endif
+} php_event_bevent_template_t;
+
 /* EventListener object */
 typedef struct _php_event_listener_t {
 	struct evconnlistener *listener;
@@ -108,6 +361,23 @@ typedef struct _php_event_listener_t {
 	zval                   data;       /* User custom data passed to callback */
 	php_event_callback_t   cb;         /* Accept callback                     */
 	php_event_callback_t   cb_err;     /* Error callback                      */
+	php_event_callback_t   cb_batch;   /* Batched accept callback             */
+	zval                   base;       /* Event base. For EventBufferEvent objects created from tpl */
+	php_event_bevent_template_t *tpl;  /* Template of accepted connections, or NULL */
+	struct event          *batch_ev;   /* Read event replacing the listener's own one in batch mode */
+	zend_long              batch_max;  /* Max. connections accepted per readiness event */
+	zend_bool              batch_addr; /* Whether to pass peer addresses to cb_batch */
+	zend_bool              disabled;   /* Whether disabled with EventListener::disable() */
+	php_event_conn_counter_t *conns;   /* Live connections created from tpl, or NULL */
+	zend_long              max_conns;  /* Accepting is paused at this number of connections, 0 if off */
+	zend_long              low_conns;  /* ...and resumed at this number */
+	zend_bool              paused;     /* Whether paused by the connection limit */
+	zend_long              pauses;     /* Number of pauses */
+	struct timeval         paused_at;  /* Start of the current pause */
+	struct timeval         paused_time; /* Total time spent in finished pauses */
+	zend_bool              proxy;      /* Whether connections start with a PROXY protocol header */
+	struct timeval         proxy_timeout; /* Header read timeout */
+	php_event_proxy_conn_t *proxy_head; /* Connections waiting for the header */
 
 	PHP_EVENT_OBJECT_TAIL;
 } Z_EVENT_X_OBJ_T(listener);
@@ -119,6 +389,18 @@ struct _php_event_http_cb_t {
 	zval                  data;   /* User custom data passed to callback */
 	zval                  base;
 	php_event_callback_t  cb;
+	int                   methods; /* EventHttpRequest::CMD_* mask of a route, 0 for any */
+};
+
+/* Node of the EventHttp routing tree, see EventHttp::route() */
+typedef struct _php_event_http_route_t php_event_http_route_t;
+struct _php_event_http_route_t {
+	HashTable              *children; /* Static segments: segment => node, or NULL */
+	php_event_http_route_t *param;    /* Child matching any segment, {name}        */
+	char                   *name;     /* Parameter name of a {name} node           */
+	size_t                  name_len;
+	php_event_http_cb_t    *handlers; /* Routes ending at the node                 */
+	php_event_http_cb_t    *prefix;   /* Routes ending with * at the node          */
 };
 
 /* EventHttp object */
@@ -128,6 +410,10 @@ typedef struct _php_event_http_t {
 	zval                  data;      /* User custom data passed to the gen(default) callback */
 	php_event_callback_t  cb;        /* Callback for evhttp_gencb()                          */
 	php_event_http_cb_t  *cb_head;   /* Linked list of attached callbacks                    */
+	php_event_http_route_t *routes;  /* Root of the routing tree, or NULL                    */
+#ifdef HAVE_EVENT_OPENSSL_LIB
+	zval                  ctx;       /* EventSslContext of the HTTPS server                  */
+#endif
 
 	PHP_EVENT_OBJECT_TAIL;
 } Z_EVENT_X_OBJ_T(http);
@@ -176,9 +462,48 @@ enum {
 	PHP_EVENT_OPT_NO_TLSv1_2               = 14,
 	PHP_EVENT_OPT_CIPHER_SERVER_PREFERENCE = 15,
 	PHP_EVENT_OPT_REQUIRE_CLIENT_CERT      = 16,
-	PHP_EVENT_OPT_VERIFY_CLIENT_ONCE       = 17
+	PHP_EVENT_OPT_VERIFY_CLIENT_ONCE       = 17,
+	PHP_EVENT_OPT_SESSION_CACHE_SIZE       = 18,
+	PHP_EVENT_OPT_SESSION_TIMEOUT          = 19,
+	PHP_EVENT_OPT_SESSION_TICKETS          = 20,
+	PHP_EVENT_OPT_TICKET_KEY_LIFETIME      = 21,
+	PHP_EVENT_OPT_CLIENT_SESSION_CACHE     = 22,
+	PHP_EVENT_OPT_KTLS                     = 23,
+	PHP_EVENT_OPT_SHARED_CTX               = 24,
+	PHP_EVENT_OPT_ALPN_PROTOCOLS           = 25,
+	PHP_EVENT_OPT_METRICS                  = 26,
+	PHP_EVENT_OPT_DYNAMIC_RECORDS          = 27
 };
 
+#define PHP_EVENT_SSL_LATENCY_BUCKETS 10
+
+/* Detailed TLS metrics of an EventSslContext(OPT_METRICS) */
+typedef struct _php_event_ssl_metrics_t {
+	zend_long  latency[PHP_EVENT_SSL_LATENCY_BUCKETS]; /* Handshake latency histogram */
+	zend_long  bytes_encrypted;                        /* Record bytes sent           */
+	zend_long  bytes_decrypted;                        /* Record bytes received       */
+	HashTable  alerts_sent;                            /* Fatal alert => count        */
+	HashTable  alerts_received;
+	HashTable  ciphers;                                /* Negotiated cipher => count  */
+	HashTable  protocols;                              /* Negotiated protocol => count */
+} php_event_ssl_metrics_t;
+
+/* Entry of the process-wide cache of the shared SSL_CTX objects */
+typedef struct _php_event_ssl_ctx_cache_entry_t {
+	SSL_CTX *ctx;
+	time_t   mtime[3]; /* Modification times of local_cert, local_pk and cafile */
+} php_event_ssl_ctx_cache_entry_t;
+
+#ifdef PHP_EVENT_SSL_TICKET_KEYS
+/* Session ticket key of an EventSslContext */
+typedef struct _php_event_ssl_ticket_key_t {
+	unsigned char name[16];
+	unsigned char aes_key[32];
+	unsigned char hmac_key[32];
+	zend_bool     set;
+} php_event_ssl_ticket_key_t;
+#endif
+
 enum {
 	PHP_EVENT_SSLv2_CLIENT_METHOD  = 1,
 	PHP_EVENT_SSLv3_CLIENT_METHOD  = 2,
@@ -199,13 +524,36 @@ typedef struct _php_event_ssl_context_t {
 	SSL_CTX   *ctx;
 	HashTable *ht;
 	zend_bool  allow_self_signed;
+	HashTable *sessions;   /* Client session cache, "host:port" => SSL_SESSION * */
+	zend_long  handshakes; /* Completed handshakes                              */
+	zend_long  resumed;    /* Completed handshakes resuming a session           */
+#ifdef PHP_EVENT_SSL_TICKET_KEYS
+	php_event_ssl_ticket_key_t ticket_keys[2];      /* Current and previous keys      */
+	zend_long                  ticket_key_lifetime; /* Seconds, 0 if rotated manually */
+	time_t                     ticket_key_created;
+#endif
+#ifdef PHP_EVENT_SSL_SNI
+	HashTable             *sni;          /* Hostname => EventSslContext          */
+	HashTable             *sni_wildcard; /* Suffix of "*.suffix" => EventSslContext */
+	php_event_callback_t   sni_cb;       /* Loads context of unknown hostname    */
+#endif
+#ifdef PHP_EVENT_SSL_ALPN
+	unsigned char         *alpn;         /* Server protocol list in wire format  */
+	unsigned int           alpn_len;
+#endif
+	php_event_ssl_metrics_t *metrics; /* NULL without OPT_METRICS */
+	zend_bool dynamic_records;        /* OPT_DYNAMIC_RECORDS */
+	zend_long       method;     /* One of EventSslContext::*_METHOD constants         */
+	zend_long       min_proto;  /* Set by setMinProtoVersion(), 0 if not, see reload() */
+	zend_long       max_proto;  /* Set by setMaxProtoVersion(), 0 if not              */
+	time_t          mtime[3];   /* Of the files loaded into the SSL_CTX, see watch() */
+	struct event   *watch_ev;   /* Timer of watch()                                  */
+	zval            watch_base;
 
 	PHP_EVENT_OBJECT_TAIL;
 } Z_EVENT_X_OBJ_T(ssl_context);
 #endif /* HAVE_EVENT_OPENSSL_LIB }}} */
 
-typedef double php_event_timestamp_t;
-
 /* Property handler types */
 typedef zval *(*php_event_prop_read_t)(void *obj, zval *retval);
 typedef int (*php_event_prop_write_t)(void *obj, zval *newval);
@@ -197,6 +197,886 @@ int _php_event_getsockname(evutil_socket_t fd, zval *pzaddr, zval *pzport)/*{{{*
 	return SUCCESS;
 }/*}}}*/
 
+/* Socket option applied by a tuning profile */
+typedef struct {
+	int         level;
+	int         optname;
+	int         optval;
+	const char *name;
+} php_event_sockopt_t;
+
+#define PHP_EVENT_SOCKOPT(level, optname, optval) { (level), (optname), (optval), #optname }
+
+/* Low latency: send small segments immediately, ack without delay and keep
+ * the amount of unsent data in the kernel small */
+static const php_event_sockopt_t php_event_low_latency_profile[] = {
+#ifdef TCP_NODELAY
+	PHP_EVENT_SOCKOPT(IPPROTO_TCP, TCP_NODELAY, 1),
+#endif
+#ifdef TCP_CORK
+	PHP_EVENT_SOCKOPT(IPPROTO_TCP, TCP_CORK, 0),
+#endif
+#ifdef TCP_QUICKACK
+	PHP_EVENT_SOCKOPT(IPPROTO_TCP, TCP_QUICKACK, 1),
+#endif
+#ifdef TCP_NOTSENT_LOWAT
+	PHP_EVENT_SOCKOPT(IPPROTO_TCP, TCP_NOTSENT_LOWAT, 16384),
+#endif
+	{ 0, 0, 0, NULL }
+};
+
+/* Bulk transfer: let the kernel coalesce segments and acks. Buffer sizes are
+ * left to the kernel autotuning, since fixing them disables it */
+static const php_event_sockopt_t php_event_bulk_profile[] = {
+#ifdef TCP_NODELAY
+	PHP_EVENT_SOCKOPT(IPPROTO_TCP, TCP_NODELAY, 0),
+#endif
+#ifdef TCP_QUICKACK
+	PHP_EVENT_SOCKOPT(IPPROTO_TCP, TCP_QUICKACK, 0),
+#endif
+#ifdef TCP_NOTSENT_LOWAT
+	/* 0 means the system-wide default */
+	PHP_EVENT_SOCKOPT(IPPROTO_TCP, TCP_NOTSENT_LOWAT, 0),
+#endif
+	{ 0, 0, 0, NULL }
+};
+
+/* {{{ php_event_set_socket_profile
+ * Applies a predefined set of TCP options to the socket. Options unavailable
+ * on the platform are skipped. Returns FAILURE, if the profile is unknown, or
+ * the socket is not a TCP socket, or any of the options is rejected. */
+int php_event_set_socket_profile(evutil_socket_t fd, zend_long profile)
+{
+	const php_event_sockopt_t *opt;
+	php_sockaddr_storage       sa_storage;
+	struct sockaddr           *sa         = (struct sockaddr *)&sa_storage;
+	socklen_t                  sa_len     = sizeof(php_sockaddr_storage);
+	int                        ret        = SUCCESS;
+
+	switch (profile) {
+		case PHP_EVENT_SOCKET_PROFILE_LOW_LATENCY:
+			opt = php_event_low_latency_profile;
+			break;
+		case PHP_EVENT_SOCKET_PROFILE_BULK:
+			opt = php_event_bulk_profile;
+			break;
+		default:
+			php_error_docref(NULL, E_WARNING, "Unknown socket profile: " ZEND_LONG_FMT, profile);
+			return FAILURE;
+	}
+
+	if (getsockname(fd, sa, &sa_len)) {
+		php_error_docref(NULL, E_WARNING,
+				"Unable to retreive socket name, errno: %d", errno);
+		return FAILURE;
+	}
+
+	if (sa->sa_family != AF_INET
+#if HAVE_IPV6
+			&& sa->sa_family != AF_INET6
+#endif
+	   ) {
+		php_error_docref(NULL, E_WARNING, "Socket profiles apply to TCP sockets only");
+		return FAILURE;
+	}
+
+	for (; opt->name != NULL; opt++) {
+		if (setsockopt(fd, opt->level, opt->optname, (const void *)&opt->optval, sizeof(opt->optval))) {
+			php_error_docref(NULL, E_WARNING,
+					"Unable to set socket option %s, errno: %d", opt->name, errno);
+			ret = FAILURE;
+		}
+	}
+
+	return ret;
+}
+/* }}} */
+
+#ifdef PHP_EVENT_FD_PASSING
+#ifdef MSG_NOSIGNAL
+# define PHP_EVENT_SENDMSG_FLAGS MSG_NOSIGNAL
+#else
+# define PHP_EVENT_SENDMSG_FLAGS 0
+#endif
+
+/* Control message buffer large enough for PHP_EVENT_MAX_PASSED_FDS descriptors */
+typedef union _php_event_fds_cmsg_t {
+	struct cmsghdr hdr;
+	char           buf[CMSG_SPACE(sizeof(int) * PHP_EVENT_MAX_PASSED_FDS)];
+} php_event_fds_cmsg_t;
+
+/* {{{ php_event_send_fds
+ * Sends len bytes of data with nfds descriptors attached as an SCM_RIGHTS
+ * control message. The descriptors travel with the first byte sent. Returns
+ * the number of bytes sent, or -1 on error. */
+ssize_t php_event_send_fds(evutil_socket_t sock, const int *fds, size_t nfds, const char *data, size_t len)
+{
+	struct msghdr         msg;
+	struct iovec          iov;
+	struct cmsghdr       *cmsg;
+	php_event_fds_cmsg_t  control;
+	ssize_t               n;
+
+	PHP_EVENT_ASSERT(nfds <= PHP_EVENT_MAX_PASSED_FDS);
+
+	memset(&msg, 0, sizeof(msg));
+	iov.iov_base   = (void *)data;
+	iov.iov_len    = len;
+	msg.msg_iov    = &iov;
+	msg.msg_iovlen = 1;
+
+	if (nfds) {
+		memset(&control, 0, sizeof(control));
+		msg.msg_control    = control.buf;
+		msg.msg_controllen = CMSG_SPACE(sizeof(int) * nfds);
+
+		cmsg             = CMSG_FIRSTHDR(&msg);
+		cmsg->cmsg_level = SOL_SOCKET;
+		cmsg->cmsg_type  = SCM_RIGHTS;
+		cmsg->cmsg_len   = CMSG_LEN(sizeof(int) * nfds);
+		memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * nfds);
+	}
+
+	do {
+		n = sendmsg(sock, &msg, PHP_EVENT_SENDMSG_FLAGS);
+	} while (n < 0 && errno == EINTR);
+
+	return n;
+}
+/* }}} */
+
+/* {{{ php_event_recv_fds
+ * Receives up to len bytes into buf, and the descriptors passed with them into
+ * fds. *nfds is the capacity of fds on input, and the number of descriptors
+ * received on output. Descriptors beyond the capacity are closed. *truncated
+ * is set, if any descriptor is lost this way or by the kernel (MSG_CTRUNC).
+ * Returns the number of bytes received, 0 on EOF, or -1 on error. */
+ssize_t php_event_recv_fds(evutil_socket_t sock, char *buf, size_t len, int *fds, size_t *nfds, int *truncated)
+{
+	struct msghdr         msg;
+	struct iovec          iov;
+	struct cmsghdr       *cmsg;
+	php_event_fds_cmsg_t  control;
+	size_t                max        = *nfds;
+	size_t                i;
+	size_t                count;
+	int                   fd;
+	int                   flags      = 0;
+	ssize_t               n;
+
+#ifdef MSG_CMSG_CLOEXEC
+	flags |= MSG_CMSG_CLOEXEC;
+#endif
+
+	*nfds      = 0;
+	*truncated = 0;
+
+	memset(&msg, 0, sizeof(msg));
+	iov.iov_base       = buf;
+	iov.iov_len        = len;
+	msg.msg_iov        = &iov;
+	msg.msg_iovlen     = 1;
+	msg.msg_control    = control.buf;
+	msg.msg_controllen = sizeof(control.buf);
+
+	do {
+		n = recvmsg(sock, &msg, flags);
+	} while (n < 0 && errno == EINTR);
+
+	if (n < 0) {
+		return n;
+	}
+
+	if (msg.msg_flags & MSG_CTRUNC) {
+		*truncated = 1;
+	}
+
+	for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+		if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+			continue;
+		}
+
+		count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+		for (i = 0; i < count; i++) {
+			memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+#ifndef MSG_CMSG_CLOEXEC
+			fcntl(fd, F_SETFD, FD_CLOEXEC);
+#endif
+			if (*nfds < max) {
+				fds[(*nfds)++] = fd;
+			} else {
+				close(fd);
+				*truncated = 1;
+			}
+		}
+	}
+
+	return n;
+}
+/* }}} */
+#endif
+
+/* {{{ php_event_bevent_coalesce_free
+ * Frees the read coalescing timer of the bufferevent */
+void php_event_bevent_coalesce_free(php_event_bevent_t *bev)
+{
+	if (bev->coalesce.timer) {
+		event_free(bev->coalesce.timer);
+		bev->coalesce.timer = NULL;
+	}
+	bev->coalesce.min_bytes = 0;
+}
+/* }}} */
+
+/* {{{ php_event_bevent_wprio_flush
+ * Moves whole messages from the priority queues to the output buffer, highest
+ * priority first, while the output holds less than
+ * PHP_EVENT_WRITE_PRIORITY_WATERMARK bytes */
+void php_event_bevent_wprio_flush(php_event_bevent_t *bev)
+{
+	php_event_bevent_wprio_t *wp = &bev->wprio;
+	struct evbuffer          *output;
+	size_t                    n;
+	int                       i;
+
+	if (!bev->bevent || wp->flushing) {
+		return;
+	}
+
+	output       = bufferevent_get_output(bev->bevent);
+	wp->flushing = 1;
+
+	for (i = 0; i < PHP_EVENT_WRITE_PRIORITIES; i++) {
+		while (wp->msgs[i]) {
+			if (evbuffer_get_length(output) >= PHP_EVENT_WRITE_PRIORITY_WATERMARK) {
+				goto done;
+			}
+
+			evbuffer_remove(wp->queues[i], (void *)&n, sizeof(n));
+			evbuffer_remove_buffer(wp->queues[i], output, n);
+
+			wp->msgs[i]--;
+			wp->bytes[i] -= n;
+		}
+	}
+
+done:
+	wp->flushing = 0;
+}
+/* }}} */
+
+/* {{{ _bevent_wprio_output_cb
+ * Refills the output buffer from the priority queues as it drains */
+static void _bevent_wprio_output_cb(struct evbuffer *buf, const struct evbuffer_cb_info *info, void *arg)
+{
+	if (info->n_deleted) {
+		php_event_bevent_wprio_flush((php_event_bevent_t *)arg);
+	}
+}
+/* }}} */
+
+/* {{{ php_event_bevent_wprio_queue
+ * Appends a message to the priority queue prio */
+int php_event_bevent_wprio_queue(php_event_bevent_t *bev, const char *data, size_t len, int prio)
+{
+	php_event_bevent_wprio_t *wp = &bev->wprio;
+
+	PHP_EVENT_ASSERT(bev->bevent);
+	PHP_EVENT_ASSERT(prio >= 0 && prio < PHP_EVENT_WRITE_PRIORITIES);
+
+	if (!wp->queues[prio]) {
+		wp->queues[prio] = evbuffer_new();
+		if (!wp->queues[prio]) {
+			return FAILURE;
+		}
+	}
+
+	if (!wp->output_cb) {
+		wp->output_cb = evbuffer_add_cb(bufferevent_get_output(bev->bevent),
+				_bevent_wprio_output_cb, (void *)bev);
+	}
+
+	if (evbuffer_add(wp->queues[prio], (void *)&len, sizeof(len))
+			|| evbuffer_add(wp->queues[prio], data, len)) {
+		return FAILURE;
+	}
+
+	wp->msgs[prio]++;
+	wp->bytes[prio] += len;
+
+	php_event_bevent_wprio_flush(bev);
+
+	return SUCCESS;
+}
+/* }}} */
+
+/* {{{ php_event_bevent_wprio_free
+ * Discards the priority queues. Must be called before bufferevent_free() */
+void php_event_bevent_wprio_free(php_event_bevent_t *bev)
+{
+	php_event_bevent_wprio_t *wp = &bev->wprio;
+	int                       i;
+
+	if (bev->bevent && wp->output_cb) {
+		evbuffer_remove_cb_entry(bufferevent_get_output(bev->bevent), wp->output_cb);
+	}
+	wp->output_cb = NULL;
+
+	for (i = 0; i < PHP_EVENT_WRITE_PRIORITIES; i++) {
+		if (wp->queues[i]) {
+			evbuffer_free(wp->queues[i]);
+			wp->queues[i] = NULL;
+		}
+		wp->msgs[i]  = 0;
+		wp->bytes[i] = 0;
+	}
+}
+/* }}} */
+
+#if defined(TCP_CORK)
+# define PHP_EVENT_TCP_CORK TCP_CORK
+#elif defined(TCP_NOPUSH)
+# define PHP_EVENT_TCP_CORK TCP_NOPUSH
+#endif
+
+/* {{{ _bevent_set_tcp_cork
+ * Turns TCP_CORK on the socket of the bufferevent on or off. Returns non-zero,
+ * if the option is applied; it is not for non-TCP sockets */
+static int _bevent_set_tcp_cork(php_event_bevent_t *bev, int on)
+{
+#ifdef PHP_EVENT_TCP_CORK
+	evutil_socket_t fd = bufferevent_getfd(bev->bevent);
+
+	if (fd != -1 && setsockopt(fd, IPPROTO_TCP, PHP_EVENT_TCP_CORK, (const void *)&on, sizeof(on)) == 0) {
+		return 1;
+	}
+#endif
+	return 0;
+}
+/* }}} */
+
+/* {{{ _bevent_cork_output_cb
+ * Implements the auto mode, and turns TCP_CORK off as soon as the data held
+ * by an uncorked bufferevent is written */
+static void _bevent_cork_output_cb(struct evbuffer *buf, const struct evbuffer_cb_info *info, void *arg)
+{
+	php_event_bevent_t      *bev = (php_event_bevent_t *)arg;
+	php_event_bevent_cork_t *c   = &bev->cork;
+	size_t                   len;
+
+	if (!bev->bevent) {
+		return;
+	}
+
+	len = evbuffer_get_length(buf);
+
+	if (info->n_added && c->threshold) {
+		if (len >= c->threshold) {
+			if (c->auto_corked) {
+				php_event_bevent_uncork(bev);
+			}
+		} else if (!c->corked) {
+			php_event_bevent_cork(bev);
+			c->auto_corked = 1;
+
+			if (c->deadline.tv_sec || c->deadline.tv_usec) {
+				evtimer_add(c->flush_ev, &c->deadline);
+			} else {
+				/* Flush after the callbacks active in this loop iteration */
+				event_active(c->flush_ev, EV_TIMEOUT, 1);
+			}
+		}
+	}
+
+	if (c->tcp_cork && !c->corked && len == 0) {
+		_bevent_set_tcp_cork(bev, 0);
+		c->tcp_cork = 0;
+	}
+}
+/* }}} */
+
+/* {{{ _bevent_cork_flush_cb
+ * Releases the writes held by the auto mode */
+static void _bevent_cork_flush_cb(evutil_socket_t fd, short what, void *arg)
+{
+	php_event_bevent_t *bev = (php_event_bevent_t *)arg;
+
+	if (bev->bevent && bev->cork.auto_corked) {
+		php_event_bevent_uncork(bev);
+	}
+}
+/* }}} */
+
+/* {{{ php_event_bevent_cork
+ * Holds the writes of the bufferevent until php_event_bevent_uncork() */
+void php_event_bevent_cork(php_event_bevent_t *bev)
+{
+	php_event_bevent_cork_t *c = &bev->cork;
+
+	PHP_EVENT_ASSERT(bev->bevent);
+
+	c->auto_corked = 0;
+
+	if (c->corked) {
+		return;
+	}
+
+	if (!c->output_cb) {
+		c->output_cb = evbuffer_add_cb(bufferevent_get_output(bev->bevent),
+				_bevent_cork_output_cb, (void *)bev);
+	}
+
+	c->corked        = 1;
+	c->write_enabled = (bufferevent_get_enabled(bev->bevent) & EV_WRITE) ? 1 : 0;
+	if (c->write_enabled) {
+		bufferevent_disable(bev->bevent, EV_WRITE);
+	}
+
+	if (!c->tcp_cork) {
+		c->tcp_cork = _bevent_set_tcp_cork(bev, 1);
+	}
+}
+/* }}} */
+
+/* {{{ php_event_bevent_uncork
+ * Releases the writes held by php_event_bevent_cork() */
+void php_event_bevent_uncork(php_event_bevent_t *bev)
+{
+	php_event_bevent_cork_t *c = &bev->cork;
+
+	PHP_EVENT_ASSERT(bev->bevent);
+
+	if (!c->corked) {
+		return;
+	}
+
+	c->corked      = 0;
+	c->auto_corked = 0;
+
+	if (c->flush_ev) {
+		event_del(c->flush_ev);
+	}
+
+	if (c->write_enabled) {
+		bufferevent_enable(bev->bevent, EV_WRITE);
+	}
+
+	/* Otherwise TCP_CORK is turned off when the output is written */
+	if (c->tcp_cork && evbuffer_get_length(bufferevent_get_output(bev->bevent)) == 0) {
+		_bevent_set_tcp_cork(bev, 0);
+		c->tcp_cork = 0;
+	}
+}
+/* }}} */
+
+/* {{{ php_event_bevent_set_auto_cork
+ * Holds writes until the output reaches threshold bytes, or deadline seconds
+ * passed. Zero deadline means the end of the current loop iteration. Zero
+ * threshold turns the auto mode off */
+int php_event_bevent_set_auto_cork(php_event_bevent_t *bev, size_t threshold, double deadline)
+{
+	php_event_bevent_cork_t *c = &bev->cork;
+
+	PHP_EVENT_ASSERT(bev->bevent);
+
+	if (!threshold) {
+		c->threshold = 0;
+		if (c->auto_corked) {
+			php_event_bevent_uncork(bev);
+		}
+		return SUCCESS;
+	}
+
+	if (!c->flush_ev) {
+		c->flush_ev = evtimer_new(bufferevent_get_base(bev->bevent),
+				_bevent_cork_flush_cb, (void *)bev);
+		if (!c->flush_ev) {
+			return FAILURE;
+		}
+	}
+
+	if (!c->output_cb) {
+		c->output_cb = evbuffer_add_cb(bufferevent_get_output(bev->bevent),
+				_bevent_cork_output_cb, (void *)bev);
+	}
+
+	PHP_EVENT_TIMEVAL_SET(c->deadline, deadline);
+	c->threshold = threshold;
+
+	return SUCCESS;
+}
+/* }}} */
+
+/* {{{ php_event_bevent_cork_free
+ * Releases the cork state. Must be called before bufferevent_free() */
+void php_event_bevent_cork_free(php_event_bevent_t *bev)
+{
+	php_event_bevent_cork_t *c = &bev->cork;
+
+	if (c->flush_ev) {
+		event_free(c->flush_ev);
+		c->flush_ev = NULL;
+	}
+
+	if (bev->bevent && c->output_cb) {
+		evbuffer_remove_cb_entry(bufferevent_get_output(bev->bevent), c->output_cb);
+	}
+	c->output_cb   = NULL;
+	c->threshold   = 0;
+	c->corked      = 0;
+	c->auto_corked = 0;
+}
+/* }}} */
+
+#if LIBEVENT_VERSION_NUMBER >= 0x02010100
+/* Number of consecutive small reads shrinking the max single read */
+#define PHP_EVENT_READ_SIZING_SHRINK_AFTER 4
+
+/* {{{ _bevent_read_sizing_cb
+ * Adjusts the max single read of a bufferevent to the observed read sizes.
+ * A read filling the whole budget doubles it, a series of reads filling less
+ * than a quarter of the budget halves it. */
+static void _bevent_read_sizing_cb(struct evbuffer *buf, const struct evbuffer_cb_info *info, void *arg)
+{
+	php_event_bevent_t             *bev = (php_event_bevent_t *)arg;
+	php_event_bevent_read_sizing_t *rs  = &bev->read_sizing;
+	size_t                          n   = info->n_added;
+	size_t                          size;
+
+	if (!n || !bev->bevent) {
+		return;
+	}
+
+	rs->reads++;
+	if (n > rs->min_size) {
+		rs->syscalls_saved += (n - 1) / rs->min_size;
+	}
+
+	size = rs->size;
+
+	if (n >= rs->size) {
+		rs->small_reads = 0;
+		if (rs->size < rs->max_size) {
+			size = rs->size * 2 > rs->max_size ? rs->max_size : rs->size * 2;
+			rs->grows++;
+		}
+	} else if (n <= rs->size / 4) {
+		if (++rs->small_reads >= PHP_EVENT_READ_SIZING_SHRINK_AFTER && rs->size > rs->min_size) {
+			size = rs->size / 2 < rs->min_size ? rs->min_size : rs->size / 2;
+			rs->small_reads = 0;
+			rs->shrinks++;
+		}
+	} else {
+		rs->small_reads = 0;
+	}
+
+	if (size != rs->size && bufferevent_set_max_single_read(bev->bevent, size) == 0) {
+		rs->size = size;
+	}
+}
+/* }}} */
+
+/* {{{ php_event_bevent_read_sizing_attach
+ * Starts the adaptive read sizing. min_size and max_size must be set */
+void php_event_bevent_read_sizing_attach(php_event_bevent_t *bev)
+{
+	php_event_bevent_read_sizing_t *rs = &bev->read_sizing;
+
+	PHP_EVENT_ASSERT(bev->bevent);
+	PHP_EVENT_ASSERT(rs->min_size && rs->min_size <= rs->max_size);
+
+	rs->size        = rs->min_size;
+	rs->small_reads = 0;
+	bufferevent_set_max_single_read(bev->bevent, rs->size);
+
+	if (!rs->input_cb) {
+		rs->input_cb = evbuffer_add_cb(bufferevent_get_input(bev->bevent),
+				_bevent_read_sizing_cb, (void *)bev);
+	}
+}
+/* }}} */
+#endif
+
+/* {{{ php_event_bevent_read_sizing_detach
+ * Stops the adaptive read sizing. Must be called before bufferevent_free() */
+void php_event_bevent_read_sizing_detach(php_event_bevent_t *bev)
+{
+	if (bev->bevent && bev->read_sizing.input_cb) {
+		evbuffer_remove_cb_entry(bufferevent_get_input(bev->bevent), bev->read_sizing.input_cb);
+	}
+	bev->read_sizing.input_cb = NULL;
+}
+/* }}} */
+
+#ifdef PHP_EVENT_SSL_RECORD_SIZING
+/* {{{ _bevent_record_sizing_cb
+ * Switches the max TLS record payload of an SSL bufferevent. Records stay
+ * small until boost_after bytes are written, so the peer can decrypt the first
+ * bytes of a response as soon as a packet or two arrive. Then the records grow
+ * to the maximum to save the per-record overhead of a bulk transfer. Output
+ * idle for longer than the idle period starts with small records again. */
+static void _bevent_record_sizing_cb(struct evbuffer *buf, const struct evbuffer_cb_info *info, void *arg)
+{
+	php_event_bevent_t               *bev = (php_event_bevent_t *)arg;
+	php_event_bevent_record_sizing_t *rs  = &bev->record_sizing;
+	SSL                              *ssl;
+	struct timeval                    now;
+	struct timeval                    deadline;
+
+	if (!bev->bevent || (ssl = bufferevent_openssl_get_ssl(bev->bevent)) == NULL) {
+		return;
+	}
+
+#if LIBEVENT_VERSION_NUMBER >= 0x02000900
+	event_base_gettimeofday_cached(bufferevent_get_base(bev->bevent), &now);
+#else
+	evutil_gettimeofday(&now, NULL);
+#endif
+
+	/* Checked only when the buffer was empty, i.e. no record is pending */
+	if (info->n_added && info->orig_size == 0) {
+		evutil_timeradd(&rs->last_write, &rs->idle, &deadline);
+		if (evutil_timercmp(&now, &deadline, >)) {
+			if (rs->boosted) {
+				SSL_set_max_send_fragment(ssl, rs->small_size);
+				rs->boosted = 0;
+			}
+			rs->written = 0;
+		}
+	}
+
+	if (info->n_deleted) {
+		rs->last_write = now;
+		if (!rs->boosted) {
+			rs->written += info->n_deleted;
+			if (rs->written >= rs->boost_after) {
+				SSL_set_max_send_fragment(ssl, SSL3_RT_MAX_PLAIN_LENGTH);
+				rs->boosted = 1;
+			}
+		}
+	}
+}
+/* }}} */
+
+/* {{{ php_event_bevent_record_sizing_attach
+ * Starts the dynamic TLS record sizing. Returns FAILURE, if bev is not an SSL
+ * bufferevent */
+int php_event_bevent_record_sizing_attach(php_event_bevent_t *bev, size_t small_size, size_t boost_after, double idle)
+{
+	php_event_bevent_record_sizing_t *rs = &bev->record_sizing;
+	SSL                              *ssl;
+
+	PHP_EVENT_ASSERT(bev->bevent);
+	PHP_EVENT_ASSERT(small_size >= 512 && small_size <= SSL3_RT_MAX_PLAIN_LENGTH);
+
+	ssl = bufferevent_openssl_get_ssl(bev->bevent);
+	if (ssl == NULL) {
+		return FAILURE;
+	}
+
+	rs->small_size  = small_size;
+	rs->boost_after = boost_after;
+	PHP_EVENT_TIMEVAL_SET(rs->idle, idle);
+	evutil_timerclear(&rs->last_write);
+	rs->written = 0;
+	rs->boosted = 0;
+	SSL_set_max_send_fragment(ssl, small_size);
+
+	if (!rs->output_cb) {
+		rs->output_cb = evbuffer_add_cb(bufferevent_get_output(bev->bevent),
+				_bevent_record_sizing_cb, (void *)bev);
+	}
+
+	return SUCCESS;
+}
+/* }}} */
+
+/* {{{ php_event_bevent_record_sizing_detach
+ * Stops the dynamic TLS record sizing. Must be called before bufferevent_free() */
+void php_event_bevent_record_sizing_detach(php_event_bevent_t *bev)
+{
+	if (bev->bevent && bev->record_sizing.output_cb) {
+		evbuffer_remove_cb_entry(bufferevent_get_output(bev->bevent), bev->record_sizing.output_cb);
+	}
+	bev->record_sizing.output_cb = NULL;
+}
+/* }}} */
+#endif
+
+#ifdef PHP_EVENT_TCP_INFO
+/* Layout of struct tcp_info as filled by the kernel, up to tcpi_delivery_rate.
+ * The glibc <netinet/tcp.h> copy stops at tcpi_total_retrans, and
+ * <linux/tcp.h> can't be included next to it. */
+typedef struct {
+	uint8_t  tcpi_state;
+	uint8_t  tcpi_ca_state;
+	uint8_t  tcpi_retransmits;
+	uint8_t  tcpi_probes;
+	uint8_t  tcpi_backoff;
+	uint8_t  tcpi_options;
+	uint8_t  tcpi_wscale;
+	uint8_t  tcpi_flags;
+
+	uint32_t tcpi_rto;
+	uint32_t tcpi_ato;
+	uint32_t tcpi_snd_mss;
+	uint32_t tcpi_rcv_mss;
+
+	uint32_t tcpi_unacked;
+	uint32_t tcpi_sacked;
+	uint32_t tcpi_lost;
+	uint32_t tcpi_retrans;
+	uint32_t tcpi_fackets;
+
+	uint32_t tcpi_last_data_sent;
+	uint32_t tcpi_last_ack_sent;
+	uint32_t tcpi_last_data_recv;
+	uint32_t tcpi_last_ack_recv;
+
+	uint32_t tcpi_pmtu;
+	uint32_t tcpi_rcv_ssthresh;
+	uint32_t tcpi_rtt;
+	uint32_t tcpi_rttvar;
+	uint32_t tcpi_snd_ssthresh;
+	uint32_t tcpi_snd_cwnd;
+	uint32_t tcpi_advmss;
+	uint32_t tcpi_reordering;
+
+	uint32_t tcpi_rcv_rtt;
+	uint32_t tcpi_rcv_space;
+
+	uint32_t tcpi_total_retrans;
+
+	uint64_t tcpi_pacing_rate;
+	uint64_t tcpi_max_pacing_rate;
+	uint64_t tcpi_bytes_acked;
+	uint64_t tcpi_bytes_received;
+	uint32_t tcpi_segs_out;
+	uint32_t tcpi_segs_in;
+
+	uint32_t tcpi_notsent_bytes;
+	uint32_t tcpi_min_rtt;
+	uint32_t tcpi_data_segs_in;
+	uint32_t tcpi_data_segs_out;
+
+	uint64_t tcpi_delivery_rate;
+} php_event_tcp_info_t;
+
+/* {{{ php_event_get_tcp_info
+ * Fills retval with a snapshot of the kernel TCP state of the socket.
+ * rtt and rttvar are in microseconds, cwnd and unacked are in segments of
+ * snd_mss bytes, delivery_rate is in bytes per second. */
+int php_event_get_tcp_info(evutil_socket_t fd, zval *retval)
+{
+	php_event_tcp_info_t ti;
+	socklen_t            len = sizeof(ti);
+
+	memset(&ti, 0, sizeof(ti));
+
+	if (getsockopt(fd, IPPROTO_TCP, TCP_INFO, (void *)&ti, &len)) {
+		php_error_docref(NULL, E_WARNING,
+				"Unable to get TCP info, errno: %d", errno);
+		return FAILURE;
+	}
+
+	array_init(retval);
+
+	add_assoc_long(retval, "rtt",         (zend_long)ti.tcpi_rtt);
+	add_assoc_long(retval, "rttvar",      (zend_long)ti.tcpi_rttvar);
+	add_assoc_long(retval, "cwnd",        (zend_long)ti.tcpi_snd_cwnd);
+	add_assoc_long(retval, "snd_mss",     (zend_long)ti.tcpi_snd_mss);
+	add_assoc_long(retval, "retransmits", (zend_long)ti.tcpi_total_retrans);
+	add_assoc_long(retval, "unacked",     (zend_long)ti.tcpi_unacked);
+	/* The field is only filled by kernels since 4.9 */
+	if (len >= offsetof(php_event_tcp_info_t, tcpi_delivery_rate) + sizeof(ti.tcpi_delivery_rate)) {
+		add_assoc_long(retval, "delivery_rate", (zend_long)ti.tcpi_delivery_rate);
+	} else {
+		add_assoc_null(retval, "delivery_rate");
+	}
+
+	return SUCCESS;
+}
+/* }}} */
+#endif
+
+#ifdef PHP_EVENT_STATS
+/* {{{ php_event_bevent_stats_now
+ * Returns the cached time of the event loop the bufferevent is attached to */
+php_event_timestamp_t php_event_bevent_stats_now(struct bufferevent *bevent)
+{
+	struct timeval tv;
+
+#if LIBEVENT_VERSION_NUMBER >= 0x02000900
+	event_base_gettimeofday_cached(bufferevent_get_base(bevent), &tv);
+#else
+	evutil_gettimeofday(&tv, NULL);
+#endif
+
+	return PHP_EVENT_TIMEVAL_TO_DOUBLE(tv);
+}
+/* }}} */
+
+/* {{{ _bevent_input_stats_cb
+ * Counts bytes arriving in the input buffer of a bufferevent */
+static void _bevent_input_stats_cb(struct evbuffer *buf, const struct evbuffer_cb_info *info, void *arg)
+{
+	php_event_bevent_t *bev = (php_event_bevent_t *)arg;
+
+	if (info->n_added && bev->bevent) {
+		bev->stats.bytes_read += info->n_added;
+		bev->stats.last_read   = php_event_bevent_stats_now(bev->bevent);
+	}
+}
+/* }}} */
+
+/* {{{ _bevent_output_stats_cb
+ * Counts bytes leaving the output buffer of a bufferevent */
+static void _bevent_output_stats_cb(struct evbuffer *buf, const struct evbuffer_cb_info *info, void *arg)
+{
+	php_event_bevent_t *bev = (php_event_bevent_t *)arg;
+
+	if (info->n_deleted && bev->bevent) {
+		bev->stats.bytes_written += info->n_deleted;
+		bev->stats.last_write     = php_event_bevent_stats_now(bev->bevent);
+	}
+}
+/* }}} */
+
+/* {{{ php_event_bevent_stats_attach
+ * Starts collecting I/O statistics for bev->bevent */
+void php_event_bevent_stats_attach(php_event_bevent_t *bev)
+{
+	PHP_EVENT_ASSERT(bev->bevent);
+
+	bev->stats.started   = php_event_bevent_stats_now(bev->bevent);
+	bev->stats.input_cb  = evbuffer_add_cb(bufferevent_get_input(bev->bevent),
+			_bevent_input_stats_cb, (void *)bev);
+	bev->stats.output_cb = evbuffer_add_cb(bufferevent_get_output(bev->bevent),
+			_bevent_output_stats_cb, (void *)bev);
+}
+/* }}} */
+
+/* {{{ php_event_bevent_stats_detach
+ * Removes the statistics callbacks. Must be called before bufferevent_free(),
+ * since the buffers may outlive the object */
+void php_event_bevent_stats_detach(php_event_bevent_t *bev)
+{
+	if (!bev->bevent) {
+		return;
+	}
+
+	if (bev->stats.input_cb) {
+		evbuffer_remove_cb_entry(bufferevent_get_input(bev->bevent), bev->stats.input_cb);
+		bev->stats.input_cb = NULL;
+	}
+	if (bev->stats.output_cb) {
+		evbuffer_remove_cb_entry(bufferevent_get_output(bev->bevent), bev->stats.output_cb);
+		bev->stats.output_cb = NULL;
+	}
+}
+/* }}} */
+#endif
+
 /*
  * Local variables:
  * tab-width: 4
@@ -29,6 +29,39 @@
 
 php_socket_t php_event_zval_to_fd(zval *pfd);
 int _php_event_getsockname(evutil_socket_t fd, zval *pzaddr, zval *pzport);
+int php_event_set_socket_profile(evutil_socket_t fd, zend_long profile);
+
+#ifdef PHP_EVENT_FD_PASSING
+ssize_t php_event_send_fds(evutil_socket_t sock, const int *fds, size_t nfds, const char *data, size_t len);
+ssize_t php_event_recv_fds(evutil_socket_t sock, char *buf, size_t len, int *fds, size_t *nfds, int *truncated);
+#endif
+
+void php_event_bevent_coalesce_free(php_event_bevent_t *bev);
+int php_event_bevent_wprio_queue(php_event_bevent_t *bev, const char *data, size_t len, int prio);
+void php_event_bevent_wprio_flush(php_event_bevent_t *bev);
+void php_event_bevent_wprio_free(php_event_bevent_t *bev);
+void php_event_bevent_cork(php_event_bevent_t *bev);
+void php_event_bevent_uncork(php_event_bevent_t *bev);
+int php_event_bevent_set_auto_cork(php_event_bevent_t *bev, size_t threshold, double deadline);
+void php_event_bevent_cork_free(php_event_bevent_t *bev);
+#if LIBEVENT_VERSION_NUMBER >= 0x02010100
+void php_event_bevent_read_sizing_attach(php_event_bevent_t *bev);
+#endif
+void php_event_bevent_read_sizing_detach(php_event_bevent_t *bev);
+#ifdef PHP_EVENT_SSL_RECORD_SIZING
+int php_event_bevent_record_sizing_attach(php_event_bevent_t *bev, size_t small_size, size_t boost_after, double idle);
+void php_event_bevent_record_sizing_detach(php_event_bevent_t *bev);
+#endif
+
+#ifdef PHP_EVENT_TCP_INFO
+int php_event_get_tcp_info(evutil_socket_t fd, zval *retval);
+#endif
+
+#ifdef PHP_EVENT_STATS
+php_event_timestamp_t php_event_bevent_stats_now(struct bufferevent *bevent);
+void php_event_bevent_stats_attach(php_event_bevent_t *bev);
+void php_event_bevent_stats_detach(php_event_bevent_t *bev);
+#endif
 
 static zend_always_inline void php_event_init_callback(php_event_callback_t *cb) {/*{{{*/
 	ZVAL_UNDEF(&cb->func_name);
@@ -38,6 +71,7 @@ static zend_always_inline void php_event_init_callback(php_event_callback_t *cb)
 static zend_always_inline void php_event_free_callback(php_event_callback_t *cb) {/*{{{*/
 	if (!Z_ISUNDEF(cb->func_name)) {
 		zval_ptr_dtor(&cb->func_name);
+		ZVAL_UNDEF(&cb->func_name);
 	}
 }/*}}}*/
 
@@ -134,12 +168,22 @@ Z_EVENT_X_FETCH_OBJ_DECL(event)
 Z_EVENT_X_FETCH_OBJ_DECL(config)
 Z_EVENT_X_FETCH_OBJ_DECL(buffer)
 Z_EVENT_X_FETCH_OBJ_DECL(bevent)
+Z_EVENT_X_FETCH_OBJ_DECL(idle_reaper)
+Z_EVENT_X_FETCH_OBJ_DECL(shared_payload)
+#ifdef PHP_EVENT_WORKER_POOL
+Z_EVENT_X_FETCH_OBJ_DECL(worker_pool)
+#endif
 
 #define Z_EVENT_BASE_OBJ_P(zv)   Z_EVENT_X_OBJ_P(base,   zv)
 #define Z_EVENT_EVENT_OBJ_P(zv)  Z_EVENT_X_OBJ_P(event,  zv)
 #define Z_EVENT_CONFIG_OBJ_P(zv) Z_EVENT_X_OBJ_P(config, zv)
 #define Z_EVENT_BUFFER_OBJ_P(zv) Z_EVENT_X_OBJ_P(buffer, zv)
 #define Z_EVENT_BEVENT_OBJ_P(zv) Z_EVENT_X_OBJ_P(bevent, zv)
+#define Z_EVENT_IDLE_REAPER_OBJ_P(zv) Z_EVENT_X_OBJ_P(idle_reaper, zv)
+#define Z_EVENT_SHARED_PAYLOAD_OBJ_P(zv) Z_EVENT_X_OBJ_P(shared_payload, zv)
+#ifdef PHP_EVENT_WORKER_POOL
+# define Z_EVENT_WORKER_POOL_OBJ_P(zv) Z_EVENT_X_OBJ_P(worker_pool, zv)
+#endif
 
 #ifdef HAVE_EVENT_EXTRA_LIB
 Z_EVENT_X_FETCH_OBJ_DECL(dns_base)
@@ -0,0 +1,46 @@
+--TEST--
+Check for EventBufferEvent::getStats()
+--SKIPIF--
+<?php
+if (!method_exists(EVENT_NS . '\\EventBufferEvent', 'getStats')) {
+	die('skip Event is built without connection statistics');
+}
+?>
+--FILE--
+<?php
+$eventBaseClass = EVENT_NS . '\\EventBase';
+$eventClass = EVENT_NS . '\\Event';
+$eventBufferEventClass = EVENT_NS . '\\EventBufferEvent';
+
+$base = new $eventBaseClass();
+
+$pair = $eventBufferEventClass::createPair($base);
+
+$pair[0]->enable($eventClass::WRITE);
+$pair[1]->enable($eventClass::READ);
+$pair[0]->write("xyz");
+$pair[0]->write("abcd");
+echo $pair[1]->read(10), PHP_EOL;
+$base->loop();
+
+$s0 = $pair[0]->getStats();
+$s1 = $pair[1]->getStats();
+
+var_dump($s0['bytes_written'], $s0['bytes_read']);
+var_dump($s1['bytes_read'], $s1['bytes_written']);
+var_dump($pair[0]->bytes_written, $pair[1]->bytes_read);
+var_dump(is_float($s1['last_read']), $s1['last_write']);
+var_dump($s1['read_callbacks'], $s1['connect_time']);
+?>
+--EXPECT--
+xyzabcd
+int(7)
+int(0)
+int(7)
+int(0)
+int(7)
+int(7)
+bool(true)
+NULL
+int(0)
+NULL
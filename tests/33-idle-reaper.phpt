@@ -0,0 +1,50 @@
+--TEST--
+Check for EventBase::createIdleReaper()
+--SKIPIF--
+<?php
+if (!function_exists('stream_socket_pair')) {
+	die('skip stream_socket_pair() is not available');
+}
+?>
+--FILE--
+<?php
+$eventBaseClass = EVENT_NS . '\\EventBase';
+$eventBufferEventClass = EVENT_NS . '\\EventBufferEvent';
+
+$base = new $eventBaseClass();
+
+$sockets = stream_socket_pair(STREAM_PF_UNIX, STREAM_SOCK_STREAM, STREAM_IPPROTO_IP);
+$bev = new $eventBufferEventClass($base, $sockets[0]);
+
+$start = microtime(true);
+$reaper = $base->createIdleReaper(0.1, function ($b, $arg) use ($bev, $start) {
+	var_dump($b === $bev, $arg);
+	var_dump(microtime(true) - $start >= 0.1);
+}, 'idle');
+
+var_dump($reaper->add($bev));
+var_dump($reaper->add($bev));
+
+// A buffer event of another base is rejected
+$other = new $eventBaseClass();
+$foreign = new $eventBufferEventClass($other, $sockets[1]);
+var_dump(@$reaper->add($foreign));
+var_dump($reaper->getCount());
+
+// The loop exits as soon as there is nothing to watch
+$base->loop();
+
+var_dump($reaper->getCount());
+var_dump($reaper->remove($bev));
+$reaper->free();
+?>
+--EXPECT--
+bool(true)
+bool(true)
+bool(false)
+int(1)
+bool(true)
+string(4) "idle"
+bool(true)
+int(0)
+bool(false)
@@ -0,0 +1,34 @@
+--TEST--
+Check for socket tuning profiles
+--SKIPIF--
+<?php
+if (!class_exists(EVENT_NS . '\\EventListener')) die("skip Event extra functions are disabled");
+if (substr(PHP_OS, 0, 3) == "WIN") die("skip socket pairs are emulated with TCP on Windows");
+?>
+--FILE--
+<?php
+$eventBaseClass = EVENT_NS . '\\EventBase';
+$eventListenerClass = EVENT_NS . '\\EventListener';
+$eventBufferEventClass = EVENT_NS . '\\EventBufferEvent';
+$eventUtilClass = EVENT_NS . '\\EventUtil';
+
+$base = new $eventBaseClass();
+$listener = new $eventListenerClass($base, function() {}, null,
+	$eventListenerClass::OPT_CLOSE_ON_FREE | $eventListenerClass::OPT_REUSEABLE, -1, '127.0.0.1:0');
+var_dump($listener->setSocketProfile($eventUtilClass::SOCKET_PROFILE_LOW_LATENCY));
+
+$listener->getSocketName($address, $port);
+$client = stream_socket_client("tcp://$address:$port");
+var_dump($eventUtilClass::setSocketProfile($client, $eventUtilClass::SOCKET_PROFILE_BULK));
+var_dump($eventUtilClass::setSocketProfile($client, $eventUtilClass::SOCKET_PROFILE_LOW_LATENCY));
+var_dump(@$eventUtilClass::setSocketProfile($client, 100));
+
+$pair = $eventBufferEventClass::createPair($base);
+var_dump(@$pair[0]->setSocketProfile($eventUtilClass::SOCKET_PROFILE_LOW_LATENCY));
+?>
+--EXPECT--
+bool(true)
+bool(true)
+bool(true)
+bool(false)
+bool(false)
@@ -0,0 +1,44 @@
+--TEST--
+Check for EventUtil::getTcpInfo() and EventBufferEvent::getTcpInfo()
+--SKIPIF--
+<?php
+if (!method_exists(EVENT_NS . '\\EventUtil', 'getTcpInfo')) {
+	die('skip TCP_INFO is not supported');
+}
+if (!class_exists(EVENT_NS . '\\EventListener')) die("skip Event extra functions are disabled");
+?>
+--FILE--
+<?php
+$eventBaseClass = EVENT_NS . '\\EventBase';
+$eventListenerClass = EVENT_NS . '\\EventListener';
+$eventBufferEventClass = EVENT_NS . '\\EventBufferEvent';
+$eventUtilClass = EVENT_NS . '\\EventUtil';
+
+$base = new $eventBaseClass();
+$listener = new $eventListenerClass($base, function() {}, null,
+	$eventListenerClass::OPT_CLOSE_ON_FREE | $eventListenerClass::OPT_REUSEABLE, -1, '127.0.0.1:0');
+$listener->getSocketName($address, $port);
+
+$client = stream_socket_client("tcp://$address:$port");
+$info = $eventUtilClass::getTcpInfo($client);
+foreach (['rtt', 'rttvar', 'cwnd', 'snd_mss', 'retransmits', 'unacked'] as $key) {
+	echo $key, ': ', gettype($info[$key]), PHP_EOL;
+}
+var_dump(array_key_exists('delivery_rate', $info));
+
+$bev = new $eventBufferEventClass($base, $client);
+var_dump(is_array($bev->getTcpInfo()));
+
+$pair = $eventBufferEventClass::createPair($base);
+var_dump(@$pair[0]->getTcpInfo());
+?>
+--EXPECT--
+rtt: integer
+rttvar: integer
+cwnd: integer
+snd_mss: integer
+retransmits: integer
+unacked: integer
+bool(true)
+bool(true)
+bool(false)
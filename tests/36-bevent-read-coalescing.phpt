@@ -0,0 +1,66 @@
+--TEST--
+Check for EventBufferEvent::setReadCoalescing()
+--FILE--
+<?php
+$eventBaseClass = EVENT_NS . '\\EventBase';
+$eventClass = EVENT_NS . '\\Event';
+$eventBufferEventClass = EVENT_NS . '\\EventBufferEvent';
+
+$base = new $eventBaseClass();
+$pair = $eventBufferEventClass::createPair($base);
+
+$pair[1]->setCallbacks(function ($bev) use (&$start) {
+	echo $bev->read(100), ' ', (microtime(true) - $start >= 0.04 ? 'deferred' : 'immediate'), PHP_EOL;
+}, NULL, NULL);
+$pair[1]->enable($eventClass::READ);
+$pair[0]->enable($eventClass::WRITE);
+
+var_dump(@$pair[1]->setReadCoalescing(-1, 0.05));
+var_dump($pair[1]->setReadCoalescing(8, 0.05));
+
+$start = microtime(true);
+$pair[0]->write("abc");
+$base->exit(0.2);
+$base->loop();
+
+$start = microtime(true);
+$pair[0]->write("0123456789");
+$base->exit(0.2);
+$base->loop();
+
+var_dump($pair[1]->setReadCoalescing(0, 0));
+$start = microtime(true);
+$pair[0]->write("x");
+$base->exit(0.2);
+$base->loop();
+
+// The held back input is delivered before EOF
+$sockets = stream_socket_pair(STREAM_PF_UNIX, STREAM_SOCK_STREAM, STREAM_IPPROTO_IP);
+$bev = new $eventBufferEventClass($base, $sockets[1], $eventBufferEventClass::OPT_CLOSE_ON_FREE);
+$bev->setCallbacks(function ($bev) {
+	echo $bev->read(100), PHP_EOL;
+}, NULL, function ($bev, $events) use ($base, $eventBufferEventClass) {
+	if ($events & $eventBufferEventClass::EOF) {
+		echo "eof", PHP_EOL;
+		$bev->free();
+		$base->exit();
+	}
+});
+$bev->setReadCoalescing(100, 10);
+$bev->enable($eventClass::READ);
+fwrite($sockets[0], "tail");
+fclose($sockets[0]);
+$start = microtime(true);
+$base->loop();
+var_dump(microtime(true) - $start < 1);
+?>
+--EXPECT--
+bool(false)
+bool(true)
+abc deferred
+0123456789 immediate
+bool(true)
+x immediate
+tail
+eof
+bool(true)
@@ -0,0 +1,73 @@
+--TEST--
+Check for EventBufferEvent max single read/write and adaptive read sizing
+--SKIPIF--
+<?php
+if (!method_exists(EVENT_NS . '\\EventBufferEvent', 'setMaxSingleRead')) {
+	die('skip libevent 2.1.1-alpha or newer required');
+}
+?>
+--FILE--
+<?php
+$eventBaseClass = EVENT_NS . '\\EventBase';
+$eventClass = EVENT_NS . '\\Event';
+$eventBufferEventClass = EVENT_NS . '\\EventBufferEvent';
+
+$base = new $eventBaseClass();
+$sockets = stream_socket_pair(STREAM_PF_UNIX, STREAM_SOCK_STREAM, STREAM_IPPROTO_IP);
+$bev = new $eventBufferEventClass($base, $sockets[1], $eventBufferEventClass::OPT_CLOSE_ON_FREE);
+
+var_dump($bev->setMaxSingleWrite(4096));
+var_dump($bev->getMaxSingleWrite());
+var_dump($bev->setMaxSingleRead(2048));
+var_dump($bev->getMaxSingleRead());
+var_dump(@$bev->setAdaptiveRead(4096, 1024));
+
+var_dump($bev->setAdaptiveRead(1024, 65536));
+var_dump($bev->getMaxSingleRead());
+
+$stats = $bev->getAdaptiveReadStats();
+var_dump($stats['reads'], $stats['grows']);
+
+$received = 0;
+$bev->setCallbacks(function ($bev) use ($base, &$received) {
+	$received += strlen($bev->read(65536));
+	if ($received >= 100000) {
+		$base->exit();
+	}
+}, NULL, NULL);
+$bev->enable($eventClass::READ);
+
+// The socket reads are limited by the max single read, so the sizing is exercised
+fwrite($sockets[0], str_repeat('x', 100000));
+$base->exit(5);
+$base->loop();
+var_dump($received);
+
+$stats = $bev->getAdaptiveReadStats();
+var_dump($stats['enabled'], $stats['reads'] > 1, $stats['grows'] > 0);
+var_dump($stats['size'] > 1024, $stats['syscalls_saved'] > 0);
+var_dump($bev->getMaxSingleRead() == $stats['size']);
+
+var_dump($bev->setAdaptiveRead(0, 0));
+$stats = $bev->getAdaptiveReadStats();
+var_dump($stats['enabled']);
+?>
+--EXPECT--
+bool(true)
+int(4096)
+bool(true)
+int(2048)
+bool(false)
+bool(true)
+int(1024)
+int(0)
+int(0)
+int(100000)
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+bool(false)
@@ -0,0 +1,49 @@
+--TEST--
+Check for EventBufferEvent::writePriority()
+--FILE--
+<?php
+$eventBaseClass = EVENT_NS . '\\EventBase';
+$eventClass = EVENT_NS . '\\Event';
+$eventBufferEventClass = EVENT_NS . '\\EventBufferEvent';
+
+$base = new $eventBaseClass();
+$pair = $eventBufferEventClass::createPair($base);
+
+var_dump($eventBufferEventClass::WRITE_PRIORITIES);
+var_dump(@$pair[0]->writePriority("x", $eventBufferEventClass::WRITE_PRIORITIES));
+
+for ($i = 0; $i < 4; $i++) {
+	$pair[0]->writePriority(str_repeat('b', 10000), 3);
+}
+$pair[0]->writePriority("PING", 0);
+var_dump($pair[0]->getWritePriorityDepths());
+
+$received = '';
+$pair[1]->setCallbacks(function ($bev) use (&$received) {
+	$received .= $bev->read(65536);
+}, NULL, NULL);
+$pair[1]->enable($eventClass::READ);
+$pair[0]->enable($eventClass::WRITE);
+
+$base->exit(0.2);
+$base->loop();
+
+var_dump(strlen($received), strpos($received, "PING"));
+var_dump(array_sum($pair[0]->getWritePriorityDepths()));
+?>
+--EXPECT--
+int(4)
+bool(false)
+array(4) {
+  [0]=>
+  int(4)
+  [1]=>
+  int(0)
+  [2]=>
+  int(0)
+  [3]=>
+  int(20000)
+}
+int(40004)
+int(20000)
+int(0)
@@ -0,0 +1,48 @@
+--TEST--
+Check for EventBufferEvent::cork(), uncork() and setAutoCork()
+--FILE--
+<?php
+$eventBaseClass = EVENT_NS . '\\EventBase';
+$eventClass = EVENT_NS . '\\Event';
+$eventBufferEventClass = EVENT_NS . '\\EventBufferEvent';
+
+$base = new $eventBaseClass();
+$pair = $eventBufferEventClass::createPair($base);
+$pair[0]->enable($eventClass::WRITE);
+$pair[1]->enable($eventClass::READ);
+
+var_dump($pair[0]->cork());
+$pair[0]->write("a");
+$pair[0]->write("b");
+$base->loop($eventBaseClass::LOOP_NONBLOCK);
+var_dump($pair[1]->getInput()->length);
+var_dump($pair[0]->uncork());
+$base->loop($eventBaseClass::LOOP_NONBLOCK);
+echo $pair[1]->read(100), PHP_EOL;
+
+var_dump(@$pair[0]->setAutoCork(-1, 0));
+var_dump($pair[0]->setAutoCork(4, 10.0));
+$pair[0]->write("ab");
+$base->loop($eventBaseClass::LOOP_NONBLOCK);
+var_dump($pair[1]->getInput()->length);
+$pair[0]->write("cdef");
+$base->loop($eventBaseClass::LOOP_NONBLOCK);
+echo $pair[1]->read(100), PHP_EOL;
+
+var_dump($pair[0]->setAutoCork(1024, 0));
+$pair[0]->write("xyz");
+$base->exit(0.1);
+$base->loop();
+echo $pair[1]->read(100), PHP_EOL;
+?>
+--EXPECT--
+bool(true)
+int(0)
+bool(true)
+ab
+bool(false)
+bool(true)
+int(0)
+abcdef
+bool(true)
+xyz
@@ -0,0 +1,47 @@
+--TEST--
+Check for EventBase::broadcast() and EventSharedPayload
+--FILE--
+<?php
+$eventBaseClass = EVENT_NS . '\\EventBase';
+$eventClass = EVENT_NS . '\\Event';
+$eventBufferEventClass = EVENT_NS . '\\EventBufferEvent';
+$eventSharedPayloadClass = EVENT_NS . '\\EventSharedPayload';
+
+$base = new $eventBaseClass();
+
+$a = $eventBufferEventClass::createPair($base);
+$b = $eventBufferEventClass::createPair($base);
+foreach ([$a, $b] as $pair) {
+	$pair[0]->enable($eventClass::WRITE);
+	$pair[1]->enable($eventClass::READ);
+}
+
+$payload = new $eventSharedPayloadClass("hello");
+var_dump($payload->getLength());
+
+$subscribers = ['a' => $a[0], 'b' => $b[0]];
+var_dump($base->broadcast($subscribers, $payload));
+var_dump($base->broadcast($subscribers, "!"));
+unset($payload);
+
+$base->loop($eventBaseClass::LOOP_NONBLOCK);
+echo $a[1]->read(16), PHP_EOL;
+echo $b[1]->read(16), PHP_EOL;
+
+// Slow subscriber: output is not drained
+$b[0]->disable($eventClass::WRITE);
+$b[0]->write(str_repeat('x', 64));
+var_dump($base->broadcast($subscribers, "tick", 32, $skipped));
+var_dump($skipped);
+?>
+--EXPECT--
+int(5)
+int(2)
+int(2)
+hello!
+hello!
+int(1)
+array(1) {
+  [0]=>
+  string(1) "b"
+}
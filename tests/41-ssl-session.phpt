@@ -0,0 +1,60 @@
+--TEST--
+Check for EventSslContext session resumption options
+--SKIPIF--
+<?php
+if (!class_exists(EVENT_NS . '\\EventSslContext')) {
+	die('skip Event is built without SSL support');
+}
+?>
+--FILE--
+<?php
+$eventBaseClass = EVENT_NS . '\\EventBase';
+$eventSslContextClass = EVENT_NS . '\\EventSslContext';
+$eventBufferEventClass = EVENT_NS . '\\EventBufferEvent';
+
+$base = new $eventBaseClass();
+
+$server = new $eventSslContextClass($eventSslContextClass::TLS_SERVER_METHOD, [
+	$eventSslContextClass::OPT_SESSION_CACHE_SIZE => 1024,
+	$eventSslContextClass::OPT_SESSION_TIMEOUT    => 300,
+	$eventSslContextClass::OPT_SESSION_TICKETS    => true,
+]);
+if (method_exists($server, 'rotateTicketKeys')) {
+	var_dump($server->rotateTicketKeys());
+} else {
+	var_dump(true);
+}
+
+$client = new $eventSslContextClass($eventSslContextClass::TLS_CLIENT_METHOD, [
+	$eventSslContextClass::OPT_CLIENT_SESSION_CACHE => true,
+]);
+var_dump($client->getSessionStats());
+
+$bev = $eventBufferEventClass::sslSocket($base, null, $client, $eventBufferEventClass::SSL_CONNECTING);
+var_dump($bev->sslGetSession());
+var_dump($bev->sslSessionReused());
+var_dump(@$bev->sslSetSession("garbage"));
+?>
+--EXPECT--
+bool(true)
+array(8) {
+  ["handshakes"]=>
+  int(0)
+  ["resumed"]=>
+  int(0)
+  ["cache_hits"]=>
+  int(0)
+  ["cache_misses"]=>
+  int(0)
+  ["cache_timeouts"]=>
+  int(0)
+  ["cache_full"]=>
+  int(0)
+  ["cached"]=>
+  int(0)
+  ["client_cached"]=>
+  int(0)
+}
+bool(false)
+bool(false)
+bool(false)
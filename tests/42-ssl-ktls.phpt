@@ -0,0 +1,35 @@
+--TEST--
+Check for EventBufferEvent::sslGetKtlsStatus()
+--SKIPIF--
+<?php
+if (!class_exists(EVENT_NS . '\\EventSslContext')) {
+	die('skip Event is built without SSL support');
+}
+?>
+--FILE--
+<?php
+$eventBaseClass = EVENT_NS . '\\EventBase';
+$eventSslContextClass = EVENT_NS . '\\EventSslContext';
+$eventBufferEventClass = EVENT_NS . '\\EventBufferEvent';
+
+$base = new $eventBaseClass();
+
+$ctx = new $eventSslContextClass($eventSslContextClass::TLS_CLIENT_METHOD, [
+	$eventSslContextClass::OPT_KTLS => true,
+]);
+
+// Not connected yet: the records are not offloaded
+$bev = $eventBufferEventClass::sslSocket($base, null, $ctx, $eventBufferEventClass::SSL_CONNECTING);
+var_dump($bev->sslGetKtlsStatus());
+
+$plain = new $eventBufferEventClass($base);
+var_dump($plain->sslGetKtlsStatus());
+?>
+--EXPECT--
+array(2) {
+  ["send"]=>
+  bool(false)
+  ["recv"]=>
+  bool(false)
+}
+bool(false)
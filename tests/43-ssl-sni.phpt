@@ -0,0 +1,40 @@
+--TEST--
+Check for EventSslContext SNI contexts
+--SKIPIF--
+<?php
+if (!method_exists(EVENT_NS . '\\EventSslContext', 'addSniContext')) {
+	die('skip Event is built without SNI support');
+}
+?>
+--FILE--
+<?php
+$eventSslContextClass = EVENT_NS . '\\EventSslContext';
+
+$server  = new $eventSslContextClass($eventSslContextClass::TLS_SERVER_METHOD, []);
+$example = new $eventSslContextClass($eventSslContextClass::TLS_SERVER_METHOD, []);
+$wild    = new $eventSslContextClass($eventSslContextClass::TLS_SERVER_METHOD, []);
+
+var_dump($server->addSniContext('Example.COM', $example));
+var_dump($server->addSniContext('*.example.com', $wild));
+var_dump(@$server->addSniContext('', $example));
+var_dump(@$server->addSniContext('a.*.example.com', $example));
+var_dump(@$server->addSniContext('self.example.com', $server));
+
+$server->setSniCallback(function ($hostname) use ($example) {
+	return $hostname === 'cold.example.org' ? $example : null;
+});
+$server->setSniCallback(null);
+
+var_dump($server->removeSniContext('example.com'));
+var_dump($server->removeSniContext('*.EXAMPLE.com'));
+var_dump($server->removeSniContext('example.com'));
+?>
+--EXPECT--
+bool(true)
+bool(true)
+bool(false)
+bool(false)
+bool(false)
+bool(true)
+bool(true)
+bool(false)
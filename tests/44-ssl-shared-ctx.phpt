@@ -0,0 +1,38 @@
+--TEST--
+Check for EventSslContext shared SSL_CTX cache
+--SKIPIF--
+<?php
+if (!class_exists(EVENT_NS . '\\EventSslContext')) {
+	die('skip Event is built without SSL support');
+}
+?>
+--FILE--
+<?php
+$eventSslContextClass = EVENT_NS . '\\EventSslContext';
+
+$eventSslContextClass::clearSharedCache();
+
+$options = [
+	$eventSslContextClass::OPT_SHARED_CTX  => true,
+	$eventSslContextClass::OPT_VERIFY_PEER => false,
+	$eventSslContextClass::OPT_CIPHERS     => 'HIGH',
+];
+
+$a = new $eventSslContextClass($eventSslContextClass::TLS_SERVER_METHOD, $options);
+// Same options in another order share the SSL_CTX
+$b = new $eventSslContextClass($eventSslContextClass::TLS_SERVER_METHOD, array_reverse($options, true));
+$c = new $eventSslContextClass($eventSslContextClass::TLS_CLIENT_METHOD, $options);
+// Not shared
+$d = new $eventSslContextClass($eventSslContextClass::TLS_CLIENT_METHOD, []);
+
+var_dump($eventSslContextClass::clearSharedCache());
+var_dump($eventSslContextClass::clearSharedCache());
+
+// The contexts remain usable after invalidation
+var_dump(is_array($a->getSessionStats()), is_array($b->getSessionStats()));
+?>
+--EXPECT--
+int(2)
+int(0)
+bool(true)
+bool(true)
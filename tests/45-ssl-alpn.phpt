@@ -0,0 +1,37 @@
+--TEST--
+Check for EventSslContext::OPT_ALPN_PROTOCOLS and EventBufferEvent::sslGetAlpnProtocol()
+--SKIPIF--
+<?php
+if (!method_exists(EVENT_NS . '\\EventBufferEvent', 'sslGetAlpnProtocol')) {
+	die('skip Event is built without ALPN support');
+}
+?>
+--FILE--
+<?php
+$eventBaseClass = EVENT_NS . '\\EventBase';
+$eventSslContextClass = EVENT_NS . '\\EventSslContext';
+$eventBufferEventClass = EVENT_NS . '\\EventBufferEvent';
+
+$base = new $eventBaseClass();
+
+$server = new $eventSslContextClass($eventSslContextClass::TLS_SERVER_METHOD, [
+	$eventSslContextClass::OPT_ALPN_PROTOCOLS => ['h2', 'http/1.1'],
+]);
+$client = new $eventSslContextClass($eventSslContextClass::TLS_CLIENT_METHOD, [
+	$eventSslContextClass::OPT_ALPN_PROTOCOLS => 'http/1.1,h2',
+]);
+$invalid = @new $eventSslContextClass($eventSslContextClass::TLS_CLIENT_METHOD, [
+	$eventSslContextClass::OPT_ALPN_PROTOCOLS => 'h2,,http/1.1',
+]);
+var_dump(error_get_last()['message']);
+
+$bev = $eventBufferEventClass::sslSocket($base, null, $client, $eventBufferEventClass::SSL_CONNECTING);
+var_dump($bev->sslGetAlpnProtocol());
+
+$pair = $eventBufferEventClass::createPair($base);
+var_dump($pair[0]->sslGetAlpnProtocol());
+?>
+--EXPECTF--
+string(%d) "%sInvalid ALPN protocol list"
+NULL
+bool(false)
@@ -0,0 +1,64 @@
+--TEST--
+Check for EventSslContext::getMetrics()
+--SKIPIF--
+<?php
+if (!class_exists(EVENT_NS . '\\EventSslContext')) {
+	die('skip Event is built without SSL support');
+}
+?>
+--FILE--
+<?php
+$eventSslContextClass = EVENT_NS . '\\EventSslContext';
+
+$ctx = new $eventSslContextClass($eventSslContextClass::TLS_SERVER_METHOD, [
+	$eventSslContextClass::OPT_METRICS => true,
+]);
+
+$m = $ctx->getMetrics(true);
+var_dump($m['handshakes'], $m['full'], $m['resumed']);
+var_dump(array_keys($m['handshake_latency']));
+var_dump(array_sum($m['handshake_latency']));
+var_dump($m['failures'], $m['bytes_encrypted'], $m['bytes_decrypted']);
+var_dump($m['ciphers'], $m['protocols']);
+?>
+--EXPECT--
+int(0)
+int(0)
+int(0)
+array(10) {
+  [0]=>
+  int(1)
+  [1]=>
+  int(5)
+  [2]=>
+  int(10)
+  [3]=>
+  int(25)
+  [4]=>
+  int(50)
+  [5]=>
+  int(100)
+  [6]=>
+  int(250)
+  [7]=>
+  int(500)
+  [8]=>
+  int(1000)
+  [9]=>
+  string(4) "+Inf"
+}
+int(0)
+array(2) {
+  ["sent"]=>
+  array(0) {
+  }
+  ["received"]=>
+  array(0) {
+  }
+}
+int(0)
+int(0)
+array(0) {
+}
+array(0) {
+}
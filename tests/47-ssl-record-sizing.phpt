@@ -0,0 +1,36 @@
+--TEST--
+Check for EventBufferEvent::setDynamicRecordSizing()
+--SKIPIF--
+<?php
+if (!method_exists(EVENT_NS . '\\EventBufferEvent', 'setDynamicRecordSizing')) {
+	die('skip Event is built without dynamic TLS record sizing');
+}
+?>
+--FILE--
+<?php
+$eventBaseClass = EVENT_NS . '\\EventBase';
+$eventSslContextClass = EVENT_NS . '\\EventSslContext';
+$eventBufferEventClass = EVENT_NS . '\\EventBufferEvent';
+
+$base = new $eventBaseClass();
+
+$ctx = new $eventSslContextClass($eventSslContextClass::TLS_CLIENT_METHOD, [
+	$eventSslContextClass::OPT_DYNAMIC_RECORDS => true,
+]);
+
+$bev = $eventBufferEventClass::sslSocket($base, null, $ctx, $eventBufferEventClass::SSL_CONNECTING);
+var_dump($bev->setDynamicRecordSizing());
+var_dump($bev->setDynamicRecordSizing(4096, 65536, 0.5));
+var_dump(@$bev->setDynamicRecordSizing(100));
+var_dump($bev->setDynamicRecordSizing(0));
+
+// Not an SSL buffer event
+$bev = new $eventBufferEventClass($base);
+var_dump($bev->setDynamicRecordSizing());
+?>
+--EXPECT--
+bool(true)
+bool(true)
+bool(false)
+bool(true)
+bool(false)
@@ -0,0 +1,42 @@
+--TEST--
+Check for EventSslContext::reload() and EventSslContext::watch()
+--SKIPIF--
+<?php
+if (!class_exists(EVENT_NS . '\\EventSslContext')) {
+	die('skip Event is built without SSL support');
+}
+?>
+--FILE--
+<?php
+$eventBaseClass = EVENT_NS . '\\EventBase';
+$eventSslContextClass = EVENT_NS . '\\EventSslContext';
+$eventBufferEventClass = EVENT_NS . '\\EventBufferEvent';
+
+$base = new $eventBaseClass();
+
+$ctx = new $eventSslContextClass($eventSslContextClass::TLS_SERVER_METHOD, [
+	$eventSslContextClass::OPT_SESSION_TIMEOUT => 300,
+]);
+var_dump($ctx->reload());
+
+// The current SSL_CTX is kept, if the files can't be loaded
+var_dump(@$ctx->reload([
+	$eventSslContextClass::OPT_LOCAL_CERT => __DIR__ . '/missing-cert.pem',
+	$eventSslContextClass::OPT_LOCAL_PK   => __DIR__ . '/missing-key.pem',
+]));
+$bev = $eventBufferEventClass::sslSocket($base, null, $ctx, $eventBufferEventClass::SSL_ACCEPTING);
+var_dump($bev instanceof $eventBufferEventClass);
+
+var_dump($ctx->watch($base, 0.01));
+var_dump($base->loop($eventBaseClass::LOOP_ONCE));
+var_dump($ctx->watch($base, 0));
+var_dump(@$ctx->watch($base, -1));
+?>
+--EXPECT--
+bool(true)
+bool(false)
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+bool(false)
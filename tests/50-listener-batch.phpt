@@ -0,0 +1,44 @@
+--TEST--
+Check for EventListener::setBatchCallback()
+--SKIPIF--
+<?php
+if (!class_exists(EVENT_NS . '\\EventListener')) die("skip Event extra functions are disabled");
+if (!method_exists(EVENT_NS . '\\EventListener', 'setBatchCallback')) die("skip batched accept is not supported");
+?>
+--FILE--
+<?php
+$eventBaseClass = EVENT_NS . '\\EventBase';
+$eventListenerClass = EVENT_NS . '\\EventListener';
+$eventBufferEventClass = EVENT_NS . '\\EventBufferEvent';
+
+$base = new $eventBaseClass();
+$listener = new $eventListenerClass($base, function () {
+	echo "accept callback must not be called\n";
+}, 'data', $eventListenerClass::OPT_CLOSE_ON_FREE | $eventListenerClass::OPT_REUSEABLE, -1, '127.0.0.1:0');
+$listener->getSocketName($address, $port);
+
+var_dump(@$listener->setBatchCallback(function () {}, 0));
+var_dump($listener->setBatchCallback(function ($l, $fds, $addresses, $data) use ($base, $eventBufferEventClass) {
+	echo count($fds), ' ', count($addresses), ' ', $addresses[0][0], ' ', $data, PHP_EOL;
+	foreach ($fds as $fd) {
+		$bev = new $eventBufferEventClass($base, $fd, $eventBufferEventClass::OPT_CLOSE_ON_FREE);
+		$bev->free();
+	}
+}, 2, true));
+
+$clients = [];
+for ($i = 0; $i < 3; $i++) {
+	$clients[] = stream_socket_client("tcp://$address:$port");
+}
+
+$base->loop($eventBaseClass::LOOP_ONCE);
+$base->loop($eventBaseClass::LOOP_ONCE);
+
+var_dump($listener->setBatchCallback(null));
+?>
+--EXPECT--
+bool(false)
+bool(true)
+2 2 127.0.0.1 data
+1 1 127.0.0.1 data
+bool(true)
@@ -0,0 +1,56 @@
+--TEST--
+Check for EventListener::setBufferEventTemplate()
+--SKIPIF--
+<?php
+if (!class_exists(EVENT_NS . '\\EventListener')) die("skip Event extra functions are disabled");
+?>
+--FILE--
+<?php
+$eventBaseClass = EVENT_NS . '\\EventBase';
+$eventListenerClass = EVENT_NS . '\\EventListener';
+$eventBufferEventClass = EVENT_NS . '\\EventBufferEvent';
+
+$base = new $eventBaseClass();
+$listener = new $eventListenerClass($base, function ($listener, $bev, $address, $data) use ($eventBufferEventClass) {
+	// The buffer event is not stored, but lives until the connection is closed
+	var_dump($bev instanceof $eventBufferEventClass, $data);
+}, 'listener', $eventListenerClass::OPT_CLOSE_ON_FREE | $eventListenerClass::OPT_REUSEABLE, -1, '127.0.0.1:0');
+$listener->getSocketName($address, $port);
+
+var_dump(@$listener->setBufferEventTemplate(0, null, null, null, null, ['read_highmark' => -1]));
+var_dump($listener->setBufferEventTemplate(0,
+	function ($bev, $arg) use ($base) {
+		$data = $bev->read(1024);
+		echo "$arg: $data\n";
+		$bev->write(strtoupper($data));
+		$base->exit();
+	},
+	null,
+	function ($bev, $events, $arg) use ($base, $eventBufferEventClass) {
+		if ($events & $eventBufferEventClass::EOF) {
+			echo "$arg: EOF\n";
+			$base->exit();
+		}
+	},
+	'bev', ['timeout_read' => 5]));
+
+$client = stream_socket_client("tcp://$address:$port");
+fwrite($client, "ping");
+$base->loop();
+$base->loop($eventBaseClass::LOOP_NONBLOCK);
+echo fread($client, 4), PHP_EOL;
+
+fclose($client);
+$base->loop();
+
+var_dump($listener->setBufferEventTemplate(null));
+?>
+--EXPECT--
+bool(false)
+bool(true)
+bool(true)
+string(8) "listener"
+bev: ping
+PING
+bev: EOF
+bool(true)
@@ -0,0 +1,44 @@
+--TEST--
+Check for EventWorkerPool
+--SKIPIF--
+<?php
+if (!class_exists(EVENT_NS . '\\EventWorkerPool')) {
+	die('skip Event is built without worker pool support');
+}
+?>
+--FILE--
+<?php
+$eventBaseClass = EVENT_NS . '\\EventBase';
+$eventWorkerPoolClass = EVENT_NS . '\\EventWorkerPool';
+$eventExceptionClass = EVENT_NS . '\\EventException';
+
+$marker = sys_get_temp_dir() . '/event-52-worker-pool.' . getmypid();
+@unlink($marker);
+
+$base = new $eventBaseClass();
+$pool = new $eventWorkerPoolClass(2, false);
+
+$index = $pool->run($base);
+if ($index >= 0) {
+	// Worker 1 fails once, and should be restarted
+	if ($index == 1 && !file_exists($marker)) {
+		touch($marker);
+		exit(1);
+	}
+	exit(0);
+}
+
+var_dump($index);
+var_dump($pool->getRestarts());
+@unlink($marker);
+
+try {
+	new $eventWorkerPoolClass(0);
+} catch (\Exception $e) {
+	var_dump($e instanceof $eventExceptionClass);
+}
+?>
+--EXPECT--
+int(-1)
+int(1)
+bool(true)
@@ -0,0 +1,67 @@
+--TEST--
+Check for EventListener::setMaxConnections()
+--SKIPIF--
+<?php
+if (!class_exists(EVENT_NS . '\\EventListener')) die("skip Event extra functions are disabled");
+?>
+--FILE--
+<?php
+$eventBaseClass = EVENT_NS . '\\EventBase';
+$eventListenerClass = EVENT_NS . '\\EventListener';
+$eventBufferEventClass = EVENT_NS . '\\EventBufferEvent';
+
+$accepted = 0;
+$base = new $eventBaseClass();
+$listener = new $eventListenerClass($base, function ($listener, $bev, $address, $data) use ($base, &$accepted) {
+	++$accepted;
+	$base->exit();
+}, null, $eventListenerClass::OPT_CLOSE_ON_FREE | $eventListenerClass::OPT_REUSEABLE, -1, '127.0.0.1:0');
+$listener->getSocketName($address, $port);
+
+$listener->setBufferEventTemplate(0, null, null, function ($bev, $events, $arg) use ($base, $eventBufferEventClass) {
+	if ($events & $eventBufferEventClass::EOF) {
+		$base->exit();
+	}
+});
+var_dump(@$listener->setMaxConnections(2, 2));
+var_dump($listener->setMaxConnections(1));
+
+$c1 = stream_socket_client("tcp://$address:$port");
+$base->loop();
+$stats = $listener->getConnectionStats();
+var_dump($accepted, $stats['connections'], $stats['paused']);
+
+// Waits in the backlog
+$c2 = stream_socket_client("tcp://$address:$port");
+$base->loop($eventBaseClass::LOOP_NONBLOCK);
+var_dump($accepted);
+
+fclose($c1);
+$base->loop();
+$stats = $listener->getConnectionStats();
+var_dump($stats['connections'], $stats['paused']);
+
+$base->loop();
+$stats = $listener->getConnectionStats();
+var_dump($accepted, $stats['connections'], $stats['paused'], $stats['pauses'], is_float($stats['paused_time']));
+
+var_dump($listener->setMaxConnections(0));
+$stats = $listener->getConnectionStats();
+var_dump($stats['paused']);
+?>
+--EXPECT--
+bool(false)
+bool(true)
+int(1)
+int(1)
+bool(true)
+int(1)
+int(0)
+bool(false)
+int(2)
+int(1)
+bool(true)
+int(2)
+bool(true)
+bool(true)
+bool(false)
@@ -0,0 +1,89 @@
+--TEST--
+Check for EventListener::setProxyProtocol()
+--SKIPIF--
+<?php
+if (!class_exists(EVENT_NS . '\\EventListener')) die("skip Event extra functions are disabled");
+?>
+--FILE--
+<?php
+$eventBaseClass = EVENT_NS . '\\EventBase';
+$eventListenerClass = EVENT_NS . '\\EventListener';
+$eventBufferEventClass = EVENT_NS . '\\EventBufferEvent';
+$eventClass = EVENT_NS . '\\Event';
+
+$accepted = null;
+$base = new $eventBaseClass();
+$listener = new $eventListenerClass($base, function ($listener, $fd, $address, $data) use ($base, &$accepted) {
+	var_dump($address);
+	$accepted = $fd;
+	$base->exit();
+}, null, $eventListenerClass::OPT_CLOSE_ON_FREE | $eventListenerClass::OPT_REUSEABLE, -1, '127.0.0.1:0');
+$listener->getSocketName($address, $port);
+
+var_dump(@$listener->setProxyProtocol(true, 0));
+var_dump($listener->setProxyProtocol(true, 2));
+
+// v1
+$c1 = stream_socket_client("tcp://$address:$port");
+fwrite($c1, "PROXY TCP4 192.0.2.1 198.51.100.1 56324 443\r\nGET");
+$base->loop();
+
+// The payload following the header is intact
+$bev = new $eventBufferEventClass($base, $accepted, $eventBufferEventClass::OPT_CLOSE_ON_FREE);
+$bev->enable($eventClass::READ);
+$base->loop($eventBaseClass::LOOP_NONBLOCK);
+var_dump($bev->read(16));
+
+// v2, sent in two parts
+$c2 = stream_socket_client("tcp://$address:$port");
+$hdr = "\x0D\x0A\x0D\x0A\x00\x0D\x0A\x51\x55\x49\x54\x0A" . "\x21\x11\x00\x0C"
+	. inet_pton('203.0.113.7') . inet_pton('198.51.100.1') . pack('nn', 4242, 443);
+fwrite($c2, substr($hdr, 0, 10));
+$base->loop($eventBaseClass::LOOP_NONBLOCK);
+fwrite($c2, substr($hdr, 10));
+$base->loop();
+
+// v2 with TLVs longer than the buffer; the payload following them is intact
+$c4 = stream_socket_client("tcp://$address:$port");
+$tlv = "\x04" . pack('n', 2000) . str_repeat("\0", 2000);
+$hdr = "\x0D\x0A\x0D\x0A\x00\x0D\x0A\x51\x55\x49\x54\x0A" . "\x21\x11" . pack('n', 12 + strlen($tlv))
+	. inet_pton('203.0.113.8') . inet_pton('198.51.100.1') . pack('nn', 4343, 443) . $tlv;
+fwrite($c4, $hdr . "GET");
+$base->loop();
+$bev = new $eventBufferEventClass($base, $accepted, $eventBufferEventClass::OPT_CLOSE_ON_FREE);
+$bev->enable($eventClass::READ);
+$base->loop($eventBaseClass::LOOP_NONBLOCK);
+var_dump($bev->read(16));
+
+// Malformed header: the connection is closed without the accept callback
+$c3 = stream_socket_client("tcp://$address:$port");
+fwrite($c3, "X");
+$base->exit(0.5);
+$base->loop();
+var_dump(fread($c3, 1), feof($c3));
+?>
+--EXPECT--
+bool(false)
+bool(true)
+array(2) {
+  [0]=>
+  string(9) "192.0.2.1"
+  [1]=>
+  int(56324)
+}
+string(3) "GET"
+array(2) {
+  [0]=>
+  string(11) "203.0.113.7"
+  [1]=>
+  int(4242)
+}
+array(2) {
+  [0]=>
+  string(11) "203.0.113.8"
+  [1]=>
+  int(4343)
+}
+string(3) "GET"
+string(0) ""
+bool(true)
@@ -0,0 +1,71 @@
+--TEST--
+Check for EventUtil::sendFds(), recvFds() and EventBufferEvent::setFdPassing()
+--SKIPIF--
+<?php
+if (!method_exists(EVENT_NS . '\\EventUtil', 'sendFds')) {
+	die('skip Event is built without descriptor passing support');
+}
+?>
+--FILE--
+<?php
+$eventBaseClass = EVENT_NS . '\\EventBase';
+$eventClass = EVENT_NS . '\\Event';
+$eventUtilClass = EVENT_NS . '\\EventUtil';
+$eventBufferEventClass = EVENT_NS . '\\EventBufferEvent';
+
+$pair = stream_socket_pair(STREAM_PF_UNIX, STREAM_SOCK_STREAM, STREAM_IPPROTO_IP);
+
+$tmp = tmpfile();
+fwrite($tmp, "passed");
+fflush($tmp);
+
+var_dump($eventUtilClass::sendFds($pair[0], [$tmp], "hello"));
+var_dump($eventUtilClass::recvFds($pair[1], $fds));
+var_dump(count($fds));
+
+$f = fopen('php://fd/' . $fds[0], 'r');
+fseek($f, 0);
+var_dump(fread($f, 16));
+fclose($f);
+
+$base = new $eventBaseClass();
+$bev = new $eventBufferEventClass($base, $pair[1], 0, function ($bev) use ($base) {
+	echo $bev->read(16), PHP_EOL;
+	var_dump(count($bev->fetchFds()));
+	var_dump($bev->fetchFds());
+	$base->exit();
+});
+var_dump($bev->setFdPassing(true));
+$bev->enable($eventClass::READ);
+var_dump(($bev->getEnabled() & $eventClass::READ) != 0);
+
+$eventUtilClass::sendFds($pair[0], [$tmp, $tmp], "world");
+$base->loop();
+
+// The read callback waits for the low watermark
+$bev->setWatermark($eventClass::READ, 8, 0);
+$eventUtilClass::sendFds($pair[0], [$tmp], "abc");
+$base->loop($eventBaseClass::LOOP_NONBLOCK);
+echo "low watermark", PHP_EOL;
+fwrite($pair[0], "defgh");
+$base->loop();
+
+var_dump(@$eventUtilClass::sendFds($pair[0], [$tmp], ""));
+?>
+--EXPECT--
+int(5)
+string(5) "hello"
+int(1)
+string(6) "passed"
+bool(true)
+bool(true)
+world
+int(2)
+array(0) {
+}
+low watermark
+abcdefgh
+int(1)
+array(0) {
+}
+bool(false)
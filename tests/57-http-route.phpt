@@ -0,0 +1,95 @@
+--TEST--
+Check for EventHttp::route()
+--SKIPIF--
+<?php
+if (!class_exists(EVENT_NS . '\\EventHttp')) {
+	die("skip Event extra functions are disabled");
+}
+?>
+--FILE--
+<?php
+$eventBaseClass = EVENT_NS . '\\EventBase';
+$eventHttpClass = EVENT_NS . '\\EventHttp';
+$eventHttpConnectionClass = EVENT_NS . '\\EventHttpConnection';
+$eventHttpRequestClass = EVENT_NS . '\\EventHttpRequest';
+
+$base = new $eventBaseClass();
+$http = new $eventHttpClass($base);
+
+$handler = function ($req, $arg, $params) {
+	ksort($params);
+	$req->sendReply(200, "OK");
+	echo $req->getUri(), " => $arg ", json_encode($params), PHP_EOL;
+};
+
+var_dump($http->route('/users/{id}', $handler, 0, 'user'));
+var_dump($http->route('/users/me', $handler, 0, 'me'));
+var_dump($http->route('/users/{id}/posts/{post}', $handler, 0, 'post'));
+var_dump($http->route('/static/*', $handler, $eventHttpRequestClass::CMD_GET, 'static'));
+
+var_dump(@$http->route('users', $handler));
+var_dump(@$http->route('/a/*/b', $handler));
+var_dump(@$http->route('/users/{name}', $handler));
+var_dump(@$http->route('/users/me', $handler));
+
+$socket = stream_socket_server('tcp://127.0.0.1:0');
+list($host, $port) = explode(':', stream_socket_get_name($socket, false));
+$http->accept($socket);
+
+$uris = [
+	'/users/42',
+	'/users/me',
+	'/users/a%20b/posts/7',
+	'/static/css/site.css',
+	'/missing',
+];
+$requests = [];
+foreach ($uris as $uri) {
+	$requests[] = [$eventHttpRequestClass::CMD_GET, $uri, $uri];
+}
+$requests[] = [$eventHttpRequestClass::CMD_POST, '/static/x', 'POST /static/x'];
+
+$codes = [];
+$pending = count($requests);
+$objects = [];
+
+$conn = new $eventHttpConnectionClass($base, NULL, $host, (int) $port);
+foreach ($requests as $r) {
+	$key = $r[2];
+	$req = new $eventHttpRequestClass(function ($req) use ($base, $key, &$codes, &$pending) {
+		$codes[$key] = $req ? $req->getResponseCode() : 0;
+		if (--$pending == 0) {
+			$base->exit();
+		}
+	});
+	$conn->makeRequest($req, $r[0], $r[1]);
+	$objects[] = $req;
+}
+
+$base->dispatch();
+
+ksort($codes);
+print_r($codes);
+?>
+--EXPECT--
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+bool(false)
+bool(false)
+bool(false)
+bool(false)
+/users/42 => user {"id":"42"}
+/users/me => me []
+/users/a%20b/posts/7 => post {"id":"a b","post":"7"}
+/static/css/site.css => static {"*":"css\/site.css"}
+Array
+(
+    [/missing] => 404
+    [/static/css/site.css] => 200
+    [/users/42] => 200
+    [/users/a%20b/posts/7] => 200
+    [/users/me] => 200
+    [POST /static/x] => 405
+)
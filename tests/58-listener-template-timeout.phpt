@@ -0,0 +1,47 @@
+--TEST--
+Check that template buffer events are released on timeouts
+--SKIPIF--
+<?php
+if (!class_exists(EVENT_NS . '\\EventListener')) die("skip Event extra functions are disabled");
+?>
+--FILE--
+<?php
+$eventBaseClass = EVENT_NS . '\\EventBase';
+$eventClass = EVENT_NS . '\\Event';
+$eventListenerClass = EVENT_NS . '\\EventListener';
+
+$base = new $eventBaseClass();
+$listener = new $eventListenerClass($base, function ($listener, $bev, $address, $data) use ($base) {
+	$base->exit();
+}, null, $eventListenerClass::OPT_CLOSE_ON_FREE | $eventListenerClass::OPT_REUSEABLE, -1, '127.0.0.1:0');
+$listener->getSocketName($address, $port);
+
+// No event callback, so nothing but the timeout ends the connection
+var_dump($listener->setBufferEventTemplate(0, null, null, null, null, ['timeout_read' => 0.1]));
+var_dump($listener->setMaxConnections(10));
+
+$c = stream_socket_client("tcp://$address:$port");
+$base->loop();
+$stats = $listener->getConnectionStats();
+var_dump($stats['connections']);
+
+$timer = $eventClass::timer($base, function () use ($base) {
+	$base->exit();
+});
+$timer->addTimer(0.5);
+$base->loop();
+
+$stats = $listener->getConnectionStats();
+var_dump($stats['connections']);
+
+// The server side is closed
+stream_set_timeout($c, 1);
+var_dump(fread($c, 1), feof($c));
+?>
+--EXPECT--
+bool(true)
+bool(true)
+int(1)
+int(0)
+string(0) ""
+bool(true)
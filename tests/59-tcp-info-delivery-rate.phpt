@@ -0,0 +1,30 @@
+--TEST--
+Check that EventUtil::getTcpInfo() reports delivery_rate on Linux
+--SKIPIF--
+<?php
+if (!method_exists(EVENT_NS . '\\EventUtil', 'getTcpInfo')) {
+	die('skip TCP_INFO is not supported');
+}
+if (PHP_OS !== 'Linux') die('skip Linux only');
+if (version_compare(php_uname('r'), '4.9', '<')) die('skip Linux 4.9+ is required');
+if (!class_exists(EVENT_NS . '\\EventListener')) die("skip Event extra functions are disabled");
+?>
+--FILE--
+<?php
+$eventBaseClass = EVENT_NS . '\\EventBase';
+$eventListenerClass = EVENT_NS . '\\EventListener';
+$eventUtilClass = EVENT_NS . '\\EventUtil';
+
+$base = new $eventBaseClass();
+$listener = new $eventListenerClass($base, function() {}, null,
+	$eventListenerClass::OPT_CLOSE_ON_FREE | $eventListenerClass::OPT_REUSEABLE, -1, '127.0.0.1:0');
+$listener->getSocketName($address, $port);
+
+$client = stream_socket_client("tcp://$address:$port");
+$info = $eventUtilClass::getTcpInfo($client);
+echo gettype($info['delivery_rate']), PHP_EOL;
+var_dump($info['delivery_rate'] >= 0);
+?>
+--EXPECT--
+integer
+bool(true)
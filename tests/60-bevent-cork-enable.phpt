@@ -0,0 +1,41 @@
+--TEST--
+Check for EventBufferEvent::enable() and disable() on a corked buffer event
+--FILE--
+<?php
+$eventBaseClass = EVENT_NS . '\\EventBase';
+$eventClass = EVENT_NS . '\\Event';
+$eventBufferEventClass = EVENT_NS . '\\EventBufferEvent';
+
+$base = new $eventBaseClass();
+$pair = $eventBufferEventClass::createPair($base);
+$pair[0]->enable($eventClass::WRITE);
+$pair[1]->enable($eventClass::READ);
+
+$pair[0]->cork();
+var_dump((bool)($pair[0]->getEnabled() & $eventClass::WRITE));
+var_dump($pair[0]->disable($eventClass::WRITE));
+var_dump((bool)($pair[0]->getEnabled() & $eventClass::WRITE));
+$pair[0]->write("ab");
+$pair[0]->uncork();
+$base->loop($eventBaseClass::LOOP_NONBLOCK);
+var_dump($pair[1]->getInput()->length);
+
+$pair[0]->cork();
+var_dump($pair[0]->enable($eventClass::WRITE));
+var_dump((bool)($pair[0]->getEnabled() & $eventClass::WRITE));
+$pair[0]->write("cd");
+$base->loop($eventBaseClass::LOOP_NONBLOCK);
+var_dump($pair[1]->getInput()->length);
+$pair[0]->uncork();
+$base->loop($eventBaseClass::LOOP_NONBLOCK);
+echo $pair[1]->read(100), PHP_EOL;
+?>
+--EXPECT--
+bool(true)
+bool(true)
+bool(false)
+int(0)
+bool(true)
+bool(true)
+int(0)
+abcd